@@ -0,0 +1,401 @@
+#include "ff.h"
+#include <string.h>
+#include "diskio.h"
+#include "tkc/mem.h"
+#include "diskio_dev.h"
+#include "diskio_cache.h"
+
+#define DISKIO_CACHE_NIL 0xFFFFFFFF
+
+typedef struct _diskio_cache_entry_t {
+  DWORD sector;
+  /*哈希表中同一个桶的下一项。*/
+  uint32_t hnext;
+  /*LRU链表，head为最近使用的项。*/
+  uint32_t prev;
+  uint32_t next;
+  BYTE valid;
+  BYTE dirty;
+} diskio_cache_entry_t;
+
+typedef struct _diskio_cache_t {
+  diskio_dev_t dev;
+  UINT ss;
+  uint32_t nr;
+  uint32_t hash_mask;
+  uint32_t* buckets;
+  uint32_t head;
+  uint32_t tail;
+  diskio_cache_entry_t* entries;
+  /*每项占FF_MAX_SS字节。*/
+  BYTE* data;
+  /*合并相邻的脏扇区时使用。*/
+  BYTE* run;
+  diskio_cache_stats_t stats;
+} diskio_cache_t;
+
+static DRESULT diskio_cache_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count);
+
+static diskio_cache_t* diskio_cache_get(BYTE pdrv) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return (dev != NULL && dev->read == diskio_cache_read) ? (diskio_cache_t*)dev : NULL;
+}
+
+#define DISKIO_CACHE_DATA(cache, i) ((cache)->data + (size_t)(i)*FF_MAX_SS)
+#define DISKIO_CACHE_HASH(cache, sector) ((sector) & (cache)->hash_mask)
+
+static uint32_t diskio_cache_lookup(diskio_cache_t* cache, DWORD sector) {
+  uint32_t i = cache->buckets[DISKIO_CACHE_HASH(cache, sector)];
+
+  while (i != DISKIO_CACHE_NIL && cache->entries[i].sector != sector) {
+    i = cache->entries[i].hnext;
+  }
+
+  return i;
+}
+
+static void diskio_cache_hash_remove(diskio_cache_t* cache, uint32_t i) {
+  uint32_t* p = cache->buckets + DISKIO_CACHE_HASH(cache, cache->entries[i].sector);
+
+  while (*p != i) {
+    p = &(cache->entries[*p].hnext);
+  }
+  *p = cache->entries[i].hnext;
+}
+
+static void diskio_cache_hash_insert(diskio_cache_t* cache, uint32_t i) {
+  uint32_t* p = cache->buckets + DISKIO_CACHE_HASH(cache, cache->entries[i].sector);
+
+  cache->entries[i].hnext = *p;
+  *p = i;
+}
+
+static void diskio_cache_touch(diskio_cache_t* cache, uint32_t i) {
+  diskio_cache_entry_t* e = cache->entries + i;
+
+  if (cache->head == i) {
+    return;
+  }
+
+  /*从链表中取下(i不是head，所以prev有效)。*/
+  cache->entries[e->prev].next = e->next;
+  if (e->next != DISKIO_CACHE_NIL) {
+    cache->entries[e->next].prev = e->prev;
+  } else {
+    cache->tail = e->prev;
+  }
+
+  e->prev = DISKIO_CACHE_NIL;
+  e->next = cache->head;
+  cache->entries[cache->head].prev = i;
+  cache->head = i;
+}
+
+/*把i和相邻的脏扇区合并为一次写，最多DISKIO_CACHE_MAX_RUN个扇区。*/
+static DRESULT diskio_cache_flush_run(diskio_cache_t* cache, uint32_t i) {
+  UINT k = 0;
+  UINT n = 0;
+  DRESULT res = RES_OK;
+  uint32_t run[DISKIO_CACHE_MAX_RUN];
+  DWORD start = cache->entries[i].sector;
+  diskio_dev_t* impl = cache->dev.impl;
+
+  while (n + 1 < DISKIO_CACHE_MAX_RUN && start > 0) {
+    uint32_t j = diskio_cache_lookup(cache, start - 1);
+    if (j == DISKIO_CACHE_NIL || !cache->entries[j].dirty) {
+      break;
+    }
+    start--;
+    n++;
+  }
+
+  for (n = 0; n < DISKIO_CACHE_MAX_RUN; n++) {
+    uint32_t j = diskio_cache_lookup(cache, start + n);
+    if (j == DISKIO_CACHE_NIL || !cache->entries[j].dirty) {
+      break;
+    }
+    run[n] = j;
+  }
+
+  if (n == 1) {
+    res = impl->write(impl, DISKIO_CACHE_DATA(cache, run[0]), start, 1);
+  } else {
+    for (k = 0; k < n; k++) {
+      memcpy(cache->run + k * cache->ss, DISKIO_CACHE_DATA(cache, run[k]), cache->ss);
+    }
+    res = impl->write(impl, cache->run, start, n);
+  }
+
+  cache->stats.dev_writes++;
+  cache->stats.dev_write_sectors += n;
+  if (res == RES_OK) {
+    for (k = 0; k < n; k++) {
+      cache->entries[run[k]].dirty = 0;
+    }
+  }
+
+  return res;
+}
+
+static DRESULT diskio_cache_flush(diskio_cache_t* cache) {
+  uint32_t i = 0;
+
+  for (i = 0; i < cache->nr; i++) {
+    diskio_cache_entry_t* e = cache->entries + i;
+    if (e->valid && e->dirty && diskio_cache_flush_run(cache, i) != RES_OK) {
+      return RES_ERROR;
+    }
+  }
+
+  return RES_OK;
+}
+
+/*取出最久没有使用的项(脏扇区先写回)，用于保存sector。*/
+static uint32_t diskio_cache_alloc(diskio_cache_t* cache, DWORD sector) {
+  uint32_t i = cache->tail;
+  diskio_cache_entry_t* e = cache->entries + i;
+
+  if (e->valid) {
+    if (e->dirty) {
+      cache->stats.evictions++;
+      if (diskio_cache_flush_run(cache, i) != RES_OK) {
+        return DISKIO_CACHE_NIL;
+      }
+    }
+    diskio_cache_hash_remove(cache, i);
+  }
+
+  e->sector = sector;
+  e->valid = 1;
+  e->dirty = 0;
+  diskio_cache_hash_insert(cache, i);
+  diskio_cache_touch(cache, i);
+
+  return i;
+}
+
+static DSTATUS diskio_cache_status(diskio_dev_t* dev) {
+  return dev->impl->status(dev->impl);
+}
+
+static DSTATUS diskio_cache_initialize(diskio_dev_t* dev) {
+  DSTATUS stat = dev->impl->initialize(dev->impl);
+#if FF_MAX_SS != FF_MIN_SS
+  diskio_cache_t* cache = (diskio_cache_t*)dev;
+  WORD ss = FF_MAX_SS;
+
+  if (stat == 0 && dev->impl->ioctl(dev->impl, GET_SECTOR_SIZE, &ss) == RES_OK) {
+    cache->ss = ss;
+  }
+#endif /*FF_MAX_SS != FF_MIN_SS*/
+
+  return stat;
+}
+
+static DRESULT diskio_cache_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count) {
+  UINT k = 0;
+  UINT misses = 0;
+  DRESULT res = RES_OK;
+  diskio_cache_t* cache = (diskio_cache_t*)dev;
+
+  if (count == 1) {
+    uint32_t i = diskio_cache_lookup(cache, sector);
+    if (i != DISKIO_CACHE_NIL) {
+      cache->stats.read_hits++;
+      memcpy(buff, DISKIO_CACHE_DATA(cache, i), cache->ss);
+      diskio_cache_touch(cache, i);
+      return RES_OK;
+    }
+
+    cache->stats.read_misses++;
+    cache->stats.dev_reads++;
+    res = dev->impl->read(dev->impl, buff, sector, 1);
+    if (res == RES_OK) {
+      i = diskio_cache_alloc(cache, sector);
+      if (i != DISKIO_CACHE_NIL) {
+        memcpy(DISKIO_CACHE_DATA(cache, i), buff, cache->ss);
+      }
+    }
+
+    return res;
+  }
+
+  /*多个扇区直接从设备读取(不放入缓存)，再用缓存中的扇区(可能还没有写回)覆盖。*/
+  for (k = 0; k < count; k++) {
+    misses += diskio_cache_lookup(cache, sector + k) == DISKIO_CACHE_NIL;
+  }
+  cache->stats.read_hits += count - misses;
+  cache->stats.read_misses += misses;
+
+  if (misses > 0) {
+    cache->stats.dev_reads++;
+    res = dev->impl->read(dev->impl, buff, sector, count);
+    if (res != RES_OK) {
+      return res;
+    }
+  }
+
+  for (k = 0; k < count; k++) {
+    uint32_t i = diskio_cache_lookup(cache, sector + k);
+    if (i != DISKIO_CACHE_NIL) {
+      memcpy(buff + k * cache->ss, DISKIO_CACHE_DATA(cache, i), cache->ss);
+    }
+  }
+
+  return RES_OK;
+}
+
+static DRESULT diskio_cache_write(diskio_dev_t* dev, const BYTE* buff, DWORD sector, UINT count) {
+  UINT k = 0;
+  DRESULT res = RES_OK;
+  diskio_cache_t* cache = (diskio_cache_t*)dev;
+
+  if (count == 1) {
+    uint32_t i = diskio_cache_lookup(cache, sector);
+    if (i != DISKIO_CACHE_NIL) {
+      cache->stats.write_hits++;
+      diskio_cache_touch(cache, i);
+    } else {
+      cache->stats.write_misses++;
+      i = diskio_cache_alloc(cache, sector);
+      if (i == DISKIO_CACHE_NIL) {
+        return RES_ERROR;
+      }
+    }
+
+    memcpy(DISKIO_CACHE_DATA(cache, i), buff, cache->ss);
+    cache->entries[i].dirty = 1;
+
+    return RES_OK;
+  }
+
+  /*多个扇区直接写入设备，缓存中的扇区更新为新的数据。*/
+  cache->stats.dev_writes++;
+  cache->stats.dev_write_sectors += count;
+  res = dev->impl->write(dev->impl, buff, sector, count);
+  if (res == RES_OK) {
+    for (k = 0; k < count; k++) {
+      uint32_t i = diskio_cache_lookup(cache, sector + k);
+      if (i != DISKIO_CACHE_NIL) {
+        memcpy(DISKIO_CACHE_DATA(cache, i), buff + k * cache->ss, cache->ss);
+        cache->entries[i].dirty = 0;
+      }
+    }
+  }
+
+  return res;
+}
+
+static DRESULT diskio_cache_ioctl(diskio_dev_t* dev, BYTE cmd, void* buff) {
+  diskio_cache_t* cache = (diskio_cache_t*)dev;
+
+  if (cmd == CTRL_SYNC) {
+    cache->stats.syncs++;
+    if (diskio_cache_flush(cache) != RES_OK) {
+      return RES_ERROR;
+    }
+  }
+
+  return dev->impl->ioctl(dev->impl, cmd, buff);
+}
+
+static void diskio_cache_destroy(diskio_cache_t* cache) {
+  TKMEM_FREE(cache->buckets);
+  TKMEM_FREE(cache->entries);
+  TKMEM_FREE(cache->data);
+  TKMEM_FREE(cache->run);
+  TKMEM_FREE(cache);
+}
+
+DRESULT diskio_cache_wrap(BYTE pdrv, UINT sectors) {
+  uint32_t i = 0;
+  uint32_t buckets = 1;
+  diskio_cache_t* cache = NULL;
+  diskio_dev_t* impl = diskio_get_dev(pdrv);
+
+  if (impl == NULL || sectors == 0 || sectors >= DISKIO_CACHE_NIL / 2) {
+    return RES_PARERR;
+  }
+
+  while (buckets < sectors) {
+    buckets <<= 1;
+  }
+
+  cache = TKMEM_ZALLOC(diskio_cache_t);
+  if (cache == NULL) {
+    return RES_ERROR;
+  }
+
+  cache->buckets = (uint32_t*)TKMEM_ALLOC(buckets * sizeof(uint32_t));
+  cache->entries = TKMEM_ZALLOCN(diskio_cache_entry_t, sectors);
+  cache->data = (BYTE*)TKMEM_ALLOC((size_t)sectors * FF_MAX_SS);
+  cache->run = (BYTE*)TKMEM_ALLOC(DISKIO_CACHE_MAX_RUN * FF_MAX_SS);
+  if (cache->buckets == NULL || cache->entries == NULL || cache->data == NULL ||
+      cache->run == NULL) {
+    diskio_cache_destroy(cache);
+    return RES_ERROR;
+  }
+
+  memset(cache->buckets, 0xff, buckets * sizeof(uint32_t));
+  for (i = 0; i < sectors; i++) {
+    cache->entries[i].hnext = DISKIO_CACHE_NIL;
+    cache->entries[i].prev = i > 0 ? i - 1 : DISKIO_CACHE_NIL;
+    cache->entries[i].next = i + 1 < sectors ? i + 1 : DISKIO_CACHE_NIL;
+  }
+
+  cache->nr = sectors;
+  cache->ss = FF_MAX_SS;
+  cache->head = 0;
+  cache->tail = sectors - 1;
+  cache->hash_mask = buckets - 1;
+  cache->dev.status = diskio_cache_status;
+  cache->dev.initialize = diskio_cache_initialize;
+  cache->dev.read = diskio_cache_read;
+  cache->dev.write = diskio_cache_write;
+  cache->dev.ioctl = diskio_cache_ioctl;
+  cache->dev.impl = impl;
+
+  return diskio_set_dev(pdrv, &(cache->dev));
+}
+
+DRESULT diskio_cache_unwrap(BYTE pdrv) {
+  diskio_cache_t* cache = diskio_cache_get(pdrv);
+
+  if (cache == NULL) {
+    return RES_PARERR;
+  }
+
+  if (diskio_cache_flush(cache) != RES_OK) {
+    return RES_ERROR;
+  }
+
+  diskio_set_dev(pdrv, cache->dev.impl);
+  diskio_cache_destroy(cache);
+
+  return RES_OK;
+}
+
+DRESULT diskio_cache_get_stats(BYTE pdrv, diskio_cache_stats_t* stats) {
+  diskio_cache_t* cache = diskio_cache_get(pdrv);
+
+  if (cache == NULL || stats == NULL) {
+    return RES_PARERR;
+  }
+
+  *stats = cache->stats;
+
+  return RES_OK;
+}
+
+DRESULT diskio_cache_reset_stats(BYTE pdrv) {
+  diskio_cache_t* cache = diskio_cache_get(pdrv);
+
+  if (cache == NULL) {
+    return RES_PARERR;
+  }
+
+  memset(&(cache->stats), 0x00, sizeof(cache->stats));
+
+  return RES_OK;
+}
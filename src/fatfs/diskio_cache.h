@@ -0,0 +1,132 @@
+#ifndef _DISKIO_CACHE_H_
+#define _DISKIO_CACHE_H_
+
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_dev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 回写时一次最多合并的扇区数。
+ */
+#ifndef DISKIO_CACHE_MAX_RUN
+#define DISKIO_CACHE_MAX_RUN 32
+#endif /*DISKIO_CACHE_MAX_RUN*/
+
+/**
+ * @class diskio_cache_stats_t
+ * 扇区缓存的统计信息。
+ */
+typedef struct _diskio_cache_stats_t {
+  /**
+   * @property {uint64_t} read_hits
+   * @annotation ["readable"]
+   * 读扇区时命中的次数(按扇区计)。
+   */
+  uint64_t read_hits;
+  /**
+   * @property {uint64_t} read_misses
+   * @annotation ["readable"]
+   * 读扇区时没有命中的次数(按扇区计)。
+   */
+  uint64_t read_misses;
+  /**
+   * @property {uint64_t} write_hits
+   * @annotation ["readable"]
+   * 写单个扇区时扇区已经在缓存中的次数(覆盖还没有写回的数据，省掉一次写)。
+   */
+  uint64_t write_hits;
+  /**
+   * @property {uint64_t} write_misses
+   * @annotation ["readable"]
+   * 写单个扇区时扇区不在缓存中的次数。
+   */
+  uint64_t write_misses;
+  /**
+   * @property {uint64_t} evictions
+   * @annotation ["readable"]
+   * 淘汰脏扇区的次数。
+   */
+  uint64_t evictions;
+  /**
+   * @property {uint64_t} dev_reads
+   * @annotation ["readable"]
+   * 调用下层设备读的次数。
+   */
+  uint64_t dev_reads;
+  /**
+   * @property {uint64_t} dev_writes
+   * @annotation ["readable"]
+   * 调用下层设备写的次数。
+   */
+  uint64_t dev_writes;
+  /**
+   * @property {uint64_t} dev_write_sectors
+   * @annotation ["readable"]
+   * 写入下层设备的扇区数。
+   */
+  uint64_t dev_write_sectors;
+  /**
+   * @property {uint64_t} syncs
+   * @annotation ["readable"]
+   * CTRL_SYNC的次数。
+   */
+  uint64_t syncs;
+} diskio_cache_stats_t;
+
+/**
+ * @method diskio_cache_wrap
+ * 在物理驱动器当前的驱动前面加一层LRU回写缓存。
+ *
+ * 单个扇区的读写(FatFs的FAT和目录扇区都经过扇区窗口，每次一个扇区)经过缓存，
+ * 脏扇区在淘汰或者CTRL_SYNC(f_sync/f_close/f_unmount等)时写回，相邻的脏扇区合并为一次写。
+ * 多个扇区的读写(大块的文件数据)直接访问设备，不占用缓存。
+ * > 需要先用f_mount卸载该驱动器上的卷。没有同步的数据在掉电时丢失，和没有缓存时一样，
+ * > 调用f_sync之后数据才是安全的。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {UINT} sectors 缓存的扇区数。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_cache_wrap(BYTE pdrv, UINT sectors);
+
+/**
+ * @method diskio_cache_unwrap
+ * 写回脏扇区，去掉缓存，恢复原来的驱动。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_cache_unwrap(BYTE pdrv);
+
+/**
+ * @method diskio_cache_get_stats
+ * 获取缓存的统计信息。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {diskio_cache_stats_t*} stats 用于返回统计信息。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_cache_get_stats(BYTE pdrv, diskio_cache_stats_t* stats);
+
+/**
+ * @method diskio_cache_reset_stats
+ * 清空缓存的统计信息。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_cache_reset_stats(BYTE pdrv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_dev.h"
+#include "diskio_ramdisk.h"
+
+static diskio_dev_t* s_devs[FF_VOLUMES];
+
+DRESULT diskio_set_dev(BYTE pdrv, diskio_dev_t* dev) {
+  if (pdrv >= FF_VOLUMES) {
+    return RES_PARERR;
+  }
+
+  s_devs[pdrv] = dev;
+
+  return RES_OK;
+}
+
+diskio_dev_t* diskio_get_dev(BYTE pdrv) {
+  if (pdrv >= FF_VOLUMES) {
+    return NULL;
+  }
+
+  if (s_devs[pdrv] != NULL) {
+    return s_devs[pdrv];
+  }
+
+#ifdef WITH_RAM_DISK
+  return ramdisk_get_dev(pdrv);
+#else
+  return NULL;
+#endif /*WITH_RAM_DISK*/
+}
+
+#ifdef WITH_DISKIO_DEV
+DWORD get_fattime(void) {
+  return 0;
+}
+
+DSTATUS ff_disk_status(BYTE pdrv) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return dev != NULL ? dev->status(dev) : (STA_NOINIT | STA_NODISK);
+}
+
+DSTATUS ff_disk_initialize(BYTE pdrv) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return dev != NULL ? dev->initialize(dev) : (STA_NOINIT | STA_NODISK);
+}
+
+DRESULT ff_disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return dev != NULL ? dev->read(dev, buff, sector, count) : RES_NOTRDY;
+}
+
+DRESULT ff_disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return dev != NULL ? dev->write(dev, buff, sector, count) : RES_NOTRDY;
+}
+
+DRESULT ff_disk_ioctl(BYTE pdrv, BYTE cmd, void* buff) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  return dev != NULL ? dev->ioctl(dev, cmd, buff) : RES_NOTRDY;
+}
+#endif /*WITH_DISKIO_DEV*/
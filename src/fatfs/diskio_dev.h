@@ -0,0 +1,76 @@
+#ifndef _DISKIO_DEV_H_
+#define _DISKIO_DEV_H_
+
+#include "ff.h"
+#include "diskio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 定义WITH_DISKIO_DEV时，本模块提供FatFs的ff_disk_xxx和get_fattime，根据物理驱动器号分发到diskio_dev_t。
+ * 定义了WITH_RAM_DISK时缺省定义。自己提供diskio驱动和get_fattime的移植不要定义这两个宏，
+ * 否则链接时符号重复。
+ */
+#if defined(WITH_RAM_DISK) && !defined(WITH_DISKIO_DEV)
+#define WITH_DISKIO_DEV 1
+#endif /*WITH_RAM_DISK*/
+
+/**
+ * @class diskio_dev_t
+ * 块设备驱动。ff_disk_xxx根据物理驱动器号调用对应驱动的函数。
+ *
+ * 具体的驱动把diskio_dev_t作为结构的第一个成员，函数的dev参数即为驱动对象本身。
+ * 驱动可以层层包装(如在设备前面加一层缓存)。
+ */
+typedef struct _diskio_dev_t diskio_dev_t;
+
+typedef DSTATUS (*diskio_dev_status_t)(diskio_dev_t* dev);
+typedef DSTATUS (*diskio_dev_initialize_t)(diskio_dev_t* dev);
+typedef DRESULT (*diskio_dev_read_t)(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count);
+typedef DRESULT (*diskio_dev_write_t)(diskio_dev_t* dev, const BYTE* buff, DWORD sector,
+                                      UINT count);
+typedef DRESULT (*diskio_dev_ioctl_t)(diskio_dev_t* dev, BYTE cmd, void* buff);
+
+struct _diskio_dev_t {
+  diskio_dev_status_t status;
+  diskio_dev_initialize_t initialize;
+  diskio_dev_read_t read;
+  diskio_dev_write_t write;
+  diskio_dev_ioctl_t ioctl;
+  /*被包装的驱动(如缓存下面的设备)，没有时为NULL。*/
+  diskio_dev_t* impl;
+};
+
+/**
+ * @method diskio_set_dev
+ * 设置物理驱动器的驱动。
+ * > 需要先用f_mount卸载该驱动器上的卷。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号(0到FF_VOLUMES-1)。
+ * @param {diskio_dev_t*} dev 驱动对象，为NULL时恢复缺省的驱动(定义了WITH_RAM_DISK时为RAM disk)。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_set_dev(BYTE pdrv, diskio_dev_t* dev);
+
+/**
+ * @method diskio_get_dev
+ * 获取物理驱动器当前使用的驱动。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {diskio_dev_t*} 返回驱动对象，没有驱动时返回NULL。
+ */
+diskio_dev_t* diskio_get_dev(BYTE pdrv);
+
+#ifdef WITH_DISKIO_DEV
+DWORD get_fattime(void);
+#endif /*WITH_DISKIO_DEV*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,371 @@
+#if defined(LINUX) && !defined(_GNU_SOURCE)
+/*O_DIRECT*/
+#define _GNU_SOURCE 1
+#endif /*LINUX*/
+
+#include "ff.h"
+#include <string.h>
+#include "diskio.h"
+#include "tkc/mem.h"
+#include "tkc/time_now.h"
+#include "diskio_dev.h"
+#include "diskio_file.h"
+
+#if defined(LINUX) || defined(MACOS)
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct _diskio_file_t {
+  diskio_dev_t dev;
+  int fd;
+  BYTE flags;
+  WORD sector_size;
+  DWORD sector_count;
+  /*以DISKIO_FILE_DIRECT打开时，用于不对齐的缓冲区的中转。*/
+  BYTE* bounce;
+  diskio_file_stats_t stats;
+} diskio_file_t;
+
+static DRESULT diskio_file_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count);
+
+/*查找驱动器的映像文件驱动，wrapped为TRUE时也查找被包装(如加了缓存)的驱动。*/
+static diskio_file_t* diskio_file_get(BYTE pdrv, int wrapped) {
+  diskio_dev_t* dev = diskio_get_dev(pdrv);
+
+  while (wrapped && dev != NULL && dev->read != diskio_file_read) {
+    dev = dev->impl;
+  }
+
+  return (dev != NULL && dev->read == diskio_file_read) ? (diskio_file_t*)dev : NULL;
+}
+
+static int diskio_file_pread_all(int fd, BYTE* buff, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t ret = pread(fd, buff, size, offset);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    } else if (ret <= 0) {
+      return -1;
+    }
+    buff += ret;
+    size -= ret;
+    offset += ret;
+  }
+
+  return 0;
+}
+
+static int diskio_file_pwrite_all(int fd, const BYTE* buff, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t ret = pwrite(fd, buff, size, offset);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    } else if (ret <= 0) {
+      return -1;
+    }
+    buff += ret;
+    size -= ret;
+    offset += ret;
+  }
+
+  return 0;
+}
+
+static int diskio_file_is_aligned(diskio_file_t* file, const BYTE* buff) {
+  return file->bounce == NULL || ((uintptr_t)buff % DISKIO_FILE_ALIGN) == 0;
+}
+
+static void diskio_file_init_stats(diskio_file_stats_t* stats) {
+  memset(stats, 0x00, sizeof(*stats));
+  fs_latency_init(&(stats->read_latency));
+  fs_latency_init(&(stats->write_latency));
+  fs_latency_init(&(stats->sync_latency));
+}
+
+static DSTATUS diskio_file_status(diskio_dev_t* dev) {
+  return ((diskio_file_t*)dev)->fd >= 0 ? 0 : STA_NOINIT;
+}
+
+static DSTATUS diskio_file_initialize(diskio_dev_t* dev) {
+  return diskio_file_status(dev);
+}
+
+static DRESULT diskio_file_check_range(diskio_file_t* file, DWORD sector, UINT count) {
+  if (sector >= file->sector_count || count > file->sector_count - sector) {
+    return RES_PARERR;
+  }
+
+  return RES_OK;
+}
+
+static DRESULT diskio_file_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count) {
+  int ret = 0;
+  diskio_file_t* file = (diskio_file_t*)dev;
+  size_t size = (size_t)count * file->sector_size;
+  off_t offset = (off_t)sector * file->sector_size;
+  uint64_t start = time_now_us();
+
+  if (diskio_file_check_range(file, sector, count) != RES_OK) {
+    return RES_PARERR;
+  }
+
+  if (diskio_file_is_aligned(file, buff)) {
+    ret = diskio_file_pread_all(file->fd, buff, size, offset);
+  } else {
+    size_t done = 0;
+    while (ret == 0 && done < size) {
+      size_t n = tk_min(size - done, DISKIO_FILE_BOUNCE_SIZE);
+      ret = diskio_file_pread_all(file->fd, file->bounce, n, offset + done);
+      if (ret == 0) {
+        memcpy(buff + done, file->bounce, n);
+      }
+      done += n;
+    }
+  }
+
+  file->stats.reads++;
+  file->stats.read_sectors += count;
+  file->stats.errors += ret != 0;
+  fs_latency_add(&(file->stats.read_latency), time_now_us() - start);
+
+  return ret == 0 ? RES_OK : RES_ERROR;
+}
+
+static DRESULT diskio_file_write(diskio_dev_t* dev, const BYTE* buff, DWORD sector, UINT count) {
+  int ret = 0;
+  diskio_file_t* file = (diskio_file_t*)dev;
+  size_t size = (size_t)count * file->sector_size;
+  off_t offset = (off_t)sector * file->sector_size;
+  uint64_t start = time_now_us();
+
+  if (diskio_file_check_range(file, sector, count) != RES_OK) {
+    return RES_PARERR;
+  }
+
+  if (diskio_file_is_aligned(file, buff)) {
+    ret = diskio_file_pwrite_all(file->fd, buff, size, offset);
+  } else {
+    size_t done = 0;
+    while (ret == 0 && done < size) {
+      size_t n = tk_min(size - done, DISKIO_FILE_BOUNCE_SIZE);
+      memcpy(file->bounce, buff + done, n);
+      ret = diskio_file_pwrite_all(file->fd, file->bounce, n, offset + done);
+      done += n;
+    }
+  }
+
+  file->stats.writes++;
+  file->stats.write_sectors += count;
+  file->stats.errors += ret != 0;
+  fs_latency_add(&(file->stats.write_latency), time_now_us() - start);
+
+  return ret == 0 ? RES_OK : RES_ERROR;
+}
+
+static DRESULT diskio_file_sync(diskio_file_t* file) {
+  int ret = 0;
+  uint64_t start = time_now_us();
+
+#ifdef MACOS
+  ret = fsync(file->fd);
+#else
+  ret = fdatasync(file->fd);
+#endif /*MACOS*/
+
+  file->stats.syncs++;
+  file->stats.errors += ret != 0;
+  fs_latency_add(&(file->stats.sync_latency), time_now_us() - start);
+
+  return ret == 0 ? RES_OK : RES_ERROR;
+}
+
+static DRESULT diskio_file_ioctl(diskio_dev_t* dev, BYTE cmd, void* buff) {
+  DRESULT res = RES_OK;
+  diskio_file_t* file = (diskio_file_t*)dev;
+
+  switch (cmd) {
+    case CTRL_SYNC:
+      res = diskio_file_sync(file);
+      break;
+    case GET_SECTOR_SIZE:
+      *(WORD*)buff = file->sector_size;
+      break;
+    case GET_BLOCK_SIZE:
+      *(DWORD*)buff = 1;
+      break;
+    case GET_SECTOR_COUNT:
+      *(DWORD*)buff = file->sector_count;
+      break;
+    default:
+      res = RES_PARERR;
+      break;
+  }
+
+  return res;
+}
+
+static void diskio_file_destroy(diskio_file_t* file) {
+  if (file->fd >= 0) {
+    close(file->fd);
+  }
+  if (file->bounce != NULL) {
+    free(file->bounce);
+  }
+  TKMEM_FREE(file);
+}
+
+static int diskio_file_open_fd(const char* filename, BYTE flags) {
+  int fd = -1;
+  int oflags = O_RDWR | O_CREAT;
+
+#ifdef O_DIRECT
+  if (flags & DISKIO_FILE_DIRECT) {
+    oflags |= O_DIRECT;
+  }
+#endif /*O_DIRECT*/
+
+  fd = open(filename, oflags, 0644);
+#if defined(F_NOCACHE) && !defined(O_DIRECT)
+  if (fd >= 0 && (flags & DISKIO_FILE_DIRECT) && fcntl(fd, F_NOCACHE, 1) != 0) {
+    close(fd);
+    fd = -1;
+  }
+#endif /*F_NOCACHE*/
+
+  return fd;
+}
+
+DRESULT diskio_file_open(BYTE pdrv, const char* filename, DWORD sector_count, WORD sector_size,
+                         BYTE flags) {
+  off_t size = 0;
+  off_t file_size = 0;
+  diskio_dev_t* dev = NULL;
+  diskio_file_t* file = NULL;
+
+  if (pdrv >= FF_VOLUMES || filename == NULL || sector_size < FF_MIN_SS ||
+      sector_size > FF_MAX_SS || (sector_size & (sector_size - 1)) != 0) {
+    return RES_PARERR;
+  }
+
+  /*加了缓存时，缓存仍然指向下面的驱动，不能替换。*/
+  dev = diskio_get_dev(pdrv);
+  if (dev != NULL && dev->impl != NULL) {
+    return RES_NOTRDY;
+  }
+
+  file = TKMEM_ZALLOC(diskio_file_t);
+  if (file == NULL) {
+    return RES_ERROR;
+  }
+
+  file->fd = diskio_file_open_fd(filename, flags);
+  if (file->fd < 0) {
+    diskio_file_destroy(file);
+    return RES_ERROR;
+  }
+
+  /*块设备的st_size为0，用lseek获取大小。*/
+  file_size = lseek(file->fd, 0, SEEK_END);
+  if (sector_count == 0) {
+    sector_count = (DWORD)(file_size / sector_size);
+  }
+  size = (off_t)sector_count * sector_size;
+
+  if (size == 0 || (file_size < size && ftruncate(file->fd, size) != 0)) {
+    diskio_file_destroy(file);
+    return RES_ERROR;
+  }
+
+  if ((flags & DISKIO_FILE_DIRECT) &&
+      posix_memalign((void**)&(file->bounce), DISKIO_FILE_ALIGN, DISKIO_FILE_BOUNCE_SIZE) != 0) {
+    file->bounce = NULL;
+    diskio_file_destroy(file);
+    return RES_ERROR;
+  }
+
+  file->flags = flags;
+  file->sector_size = sector_size;
+  file->sector_count = sector_count;
+  file->dev.status = diskio_file_status;
+  file->dev.initialize = diskio_file_initialize;
+  file->dev.read = diskio_file_read;
+  file->dev.write = diskio_file_write;
+  file->dev.ioctl = diskio_file_ioctl;
+  diskio_file_init_stats(&(file->stats));
+
+  diskio_file_close(pdrv);
+
+  return diskio_set_dev(pdrv, &(file->dev));
+}
+
+DRESULT diskio_file_close(BYTE pdrv) {
+  diskio_file_t* file = diskio_file_get(pdrv, 0);
+
+  if (file == NULL) {
+    /*映像文件被缓存包装着，先用diskio_cache_unwrap去掉缓存。*/
+    return diskio_file_get(pdrv, 1) != NULL ? RES_NOTRDY : RES_PARERR;
+  }
+
+  diskio_set_dev(pdrv, NULL);
+  diskio_file_destroy(file);
+
+  return RES_OK;
+}
+
+DRESULT diskio_file_get_stats(BYTE pdrv, diskio_file_stats_t* stats) {
+  diskio_file_t* file = diskio_file_get(pdrv, 1);
+
+  if (file == NULL || stats == NULL) {
+    return RES_PARERR;
+  }
+
+  *stats = file->stats;
+
+  return RES_OK;
+}
+
+DRESULT diskio_file_reset_stats(BYTE pdrv) {
+  diskio_file_t* file = diskio_file_get(pdrv, 1);
+
+  if (file == NULL) {
+    return RES_PARERR;
+  }
+
+  diskio_file_init_stats(&(file->stats));
+
+  return RES_OK;
+}
+
+#else
+DRESULT diskio_file_open(BYTE pdrv, const char* filename, DWORD sector_count, WORD sector_size,
+                         BYTE flags) {
+  (void)pdrv;
+  (void)filename;
+  (void)sector_count;
+  (void)sector_size;
+  (void)flags;
+
+  return RES_NOTRDY;
+}
+
+DRESULT diskio_file_close(BYTE pdrv) {
+  (void)pdrv;
+
+  return RES_PARERR;
+}
+
+DRESULT diskio_file_get_stats(BYTE pdrv, diskio_file_stats_t* stats) {
+  (void)pdrv;
+  (void)stats;
+
+  return RES_PARERR;
+}
+
+DRESULT diskio_file_reset_stats(BYTE pdrv) {
+  (void)pdrv;
+
+  return RES_PARERR;
+}
+#endif /*LINUX || MACOS*/
@@ -0,0 +1,147 @@
+#ifndef _DISKIO_FILE_H_
+#define _DISKIO_FILE_H_
+
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_dev.h"
+#include "../fs_latency.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 以DISKIO_FILE_DIRECT打开时，缓冲区和读写长度的对齐要求。
+ */
+#ifndef DISKIO_FILE_ALIGN
+#define DISKIO_FILE_ALIGN 4096
+#endif /*DISKIO_FILE_ALIGN*/
+
+/**
+ * 以DISKIO_FILE_DIRECT打开时，对齐的中转缓冲区的大小(字节)。
+ */
+#ifndef DISKIO_FILE_BOUNCE_SIZE
+#define DISKIO_FILE_BOUNCE_SIZE (64 * 1024)
+#endif /*DISKIO_FILE_BOUNCE_SIZE*/
+
+/**
+ * 绕过主机的页缓存(Linux为O_DIRECT，MacOS为F_NOCACHE)。
+ */
+#define DISKIO_FILE_DIRECT 1
+
+/**
+ * @class diskio_file_stats_t
+ * 映像文件的读写统计，用于观察FatFs合并扇区读写的效果。
+ */
+typedef struct _diskio_file_stats_t {
+  /**
+   * @property {uint64_t} reads
+   * @annotation ["readable"]
+   * disk_read的调用次数。
+   */
+  uint64_t reads;
+  /**
+   * @property {uint64_t} read_sectors
+   * @annotation ["readable"]
+   * 读取的扇区数(read_sectors/reads为每次读取的平均扇区数)。
+   */
+  uint64_t read_sectors;
+  /**
+   * @property {uint64_t} writes
+   * @annotation ["readable"]
+   * disk_write的调用次数。
+   */
+  uint64_t writes;
+  /**
+   * @property {uint64_t} write_sectors
+   * @annotation ["readable"]
+   * 写入的扇区数。
+   */
+  uint64_t write_sectors;
+  /**
+   * @property {uint64_t} syncs
+   * @annotation ["readable"]
+   * CTRL_SYNC的次数。
+   */
+  uint64_t syncs;
+  /**
+   * @property {uint64_t} errors
+   * @annotation ["readable"]
+   * 失败的次数。
+   */
+  uint64_t errors;
+  /**
+   * @property {fs_latency_t} read_latency
+   * @annotation ["readable"]
+   * 每次读取的延迟。
+   */
+  fs_latency_t read_latency;
+  /**
+   * @property {fs_latency_t} write_latency
+   * @annotation ["readable"]
+   * 每次写入的延迟。
+   */
+  fs_latency_t write_latency;
+  /**
+   * @property {fs_latency_t} sync_latency
+   * @annotation ["readable"]
+   * 每次同步的延迟。
+   */
+  fs_latency_t sync_latency;
+} diskio_file_stats_t;
+
+/**
+ * @method diskio_file_open
+ * 打开映像文件(或者块设备)，作为物理驱动器的驱动。
+ * 文件不存在时创建，比需要的小时扩展。每次多扇区的读写对应一次pread/pwrite，CTRL_SYNC对应fdatasync。
+ * > 只在Linux/MacOS上可用。需要先用f_mount卸载该驱动器上的卷。
+ * > 驱动器加了缓存(diskio_cache_wrap)时返回RES_NOTRDY，需要先用diskio_cache_unwrap去掉缓存。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {const char*} filename 映像文件名。
+ * @param {DWORD} sector_count 扇区数，为0时使用文件的大小。
+ * @param {WORD} sector_size 扇区大小(2的幂，在FF_MIN_SS和FF_MAX_SS之间)。
+ * @param {BYTE} flags 为0或者DISKIO_FILE_DIRECT。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_file_open(BYTE pdrv, const char* filename, DWORD sector_count, WORD sector_size,
+                         BYTE flags);
+
+/**
+ * @method diskio_file_close
+ * 关闭映像文件，物理驱动器恢复缺省的驱动。
+ * > 加了缓存时，需要先用diskio_cache_unwrap去掉缓存，否则返回RES_NOTRDY，什么也不做。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_file_close(BYTE pdrv);
+
+/**
+ * @method diskio_file_get_stats
+ * 获取映像文件的读写统计(加了缓存时为缓存下面的实际读写)。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {diskio_file_stats_t*} stats 用于返回统计信息。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_file_get_stats(BYTE pdrv, diskio_file_stats_t* stats);
+
+/**
+ * @method diskio_file_reset_stats
+ * 清空映像文件的读写统计。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT diskio_file_reset_stats(BYTE pdrv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,54 +1,231 @@
 #include "ff.h"
 #include <string.h>
 #include "diskio.h"
+#include "tkc/mem.h"
 #include "fatfs_diskio.h"
+#include "diskio_dev.h"
+#include "diskio_ramdisk.h"
 
 #ifdef WITH_RAM_DISK
 /*
  * https://github.com/David-Croose/FatFS_MinGW
+ *
+ * 每个物理驱动器有独立的存储空间，在运行时分配(或者映射主机文件)。
  */
-#define CFG_RAMDISK_SIZE (1000 * 1024)
-#define CFG_RAMDISK_SECTOR_SIZE (512)
-#define RAMDISK_SECTOR_TOTAL ((CFG_RAMDISK_SIZE) / (CFG_RAMDISK_SECTOR_SIZE))
+#if defined(LINUX) || defined(MACOS)
+#define RAMDISK_WITH_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /*LINUX || MACOS*/
 
-static unsigned char rambuf[RAMDISK_SECTOR_TOTAL][CFG_RAMDISK_SECTOR_SIZE];
+typedef struct _ramdisk_t {
+  diskio_dev_t dev;
+  BYTE* data;
+  DWORD sector_count;
+  WORD sector_size;
+  /*data是否映射的主机文件。*/
+  BYTE mapped;
+} ramdisk_t;
 
-int RAM_disk_status(void) {
-  return 0;
+static ramdisk_t s_ramdisks[FF_VOLUMES];
+
+static ramdisk_t* ramdisk_get(BYTE pdrv) {
+  return pdrv < FF_VOLUMES ? s_ramdisks + pdrv : NULL;
 }
 
-int RAM_disk_initialize(void) {
-  return 0;
+static BYTE ramdisk_pdrv(diskio_dev_t* dev) {
+  return (BYTE)((ramdisk_t*)dev - s_ramdisks);
 }
 
-int RAM_disk_read(unsigned char* buff, unsigned int sector, unsigned int count) {
-  memcpy(buff, &rambuf[sector], count * CFG_RAMDISK_SECTOR_SIZE);
-  return 0;
+static int ramdisk_sector_size_is_valid(WORD sector_size) {
+  return sector_size >= FF_MIN_SS && sector_size <= FF_MAX_SS &&
+         (sector_size & (sector_size - 1)) == 0;
+}
+
+DRESULT ramdisk_destroy(BYTE pdrv) {
+  ramdisk_t* disk = ramdisk_get(pdrv);
+
+  if (disk == NULL) {
+    return RES_PARERR;
+  }
+
+  if (disk->data != NULL) {
+#ifdef RAMDISK_WITH_MMAP
+    if (disk->mapped) {
+      munmap(disk->data, (size_t)disk->sector_count * disk->sector_size);
+    } else
+#endif /*RAMDISK_WITH_MMAP*/
+    {
+      TKMEM_FREE(disk->data);
+    }
+  }
+  disk->data = NULL;
+  disk->sector_count = 0;
+  disk->sector_size = 0;
+  disk->mapped = 0;
+
+  return RES_OK;
+}
+
+DRESULT ramdisk_create(BYTE pdrv, DWORD sector_count, WORD sector_size) {
+  ramdisk_t* disk = ramdisk_get(pdrv);
+
+  if (disk == NULL || sector_count == 0 || !ramdisk_sector_size_is_valid(sector_size)) {
+    return RES_PARERR;
+  }
+
+  ramdisk_destroy(pdrv);
+  /*calloc得到的大块内存由系统按页清零，没有写过的扇区不占用物理内存。*/
+  disk->data = (BYTE*)TKMEM_CALLOC(sector_count, sector_size);
+  if (disk->data == NULL) {
+    return RES_ERROR;
+  }
+  disk->sector_count = sector_count;
+  disk->sector_size = sector_size;
+
+  return RES_OK;
+}
+
+DRESULT ramdisk_create_file(BYTE pdrv, const char* filename, DWORD sector_count,
+                            WORD sector_size) {
+#ifdef RAMDISK_WITH_MMAP
+  int fd = -1;
+  off_t size = 0;
+  struct stat st;
+  void* data = NULL;
+  ramdisk_t* disk = ramdisk_get(pdrv);
+
+  if (disk == NULL || filename == NULL || !ramdisk_sector_size_is_valid(sector_size)) {
+    return RES_PARERR;
+  }
+
+  fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return RES_ERROR;
+  }
+
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return RES_ERROR;
+  }
+
+  if (sector_count == 0) {
+    sector_count = (DWORD)(st.st_size / sector_size);
+  }
+  size = (off_t)sector_count * sector_size;
+
+  if (size == 0 || (st.st_size < size && ftruncate(fd, size) != 0)) {
+    close(fd);
+    return RES_ERROR;
+  }
+
+  data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  /*映射建立后不再需要文件描述符。*/
+  close(fd);
+  if (data == MAP_FAILED) {
+    return RES_ERROR;
+  }
+
+  ramdisk_destroy(pdrv);
+  disk->data = (BYTE*)data;
+  disk->sector_count = sector_count;
+  disk->sector_size = sector_size;
+  disk->mapped = 1;
+
+  return RES_OK;
+#else
+  (void)pdrv;
+  (void)filename;
+  (void)sector_count;
+  (void)sector_size;
+
+  return RES_NOTRDY;
+#endif /*RAMDISK_WITH_MMAP*/
 }
 
-int RAM_disk_write(const unsigned char* buff, unsigned int sector, unsigned int count) {
-  memcpy(&rambuf[sector], buff, count * CFG_RAMDISK_SECTOR_SIZE);
+static ramdisk_t* ramdisk_get_range(diskio_dev_t* dev, DWORD sector, UINT count) {
+  ramdisk_t* disk = (ramdisk_t*)dev;
+
+  if (disk->data == NULL || sector >= disk->sector_count ||
+      count > disk->sector_count - sector) {
+    return NULL;
+  }
+
+  return disk;
+}
+
+static DSTATUS ramdisk_status(diskio_dev_t* dev) {
+  ramdisk_t* disk = (ramdisk_t*)dev;
+
+  return disk->data != NULL ? 0 : STA_NOINIT;
+}
+
+static DSTATUS ramdisk_initialize(diskio_dev_t* dev) {
+  ramdisk_t* disk = (ramdisk_t*)dev;
+
+  /*没有用ramdisk_create创建的驱动器，使用缺省的大小。*/
+  if (disk->data == NULL &&
+      ramdisk_create(ramdisk_pdrv(dev), CFG_RAMDISK_SIZE / CFG_RAMDISK_SECTOR_SIZE,
+                     CFG_RAMDISK_SECTOR_SIZE) != RES_OK) {
+    return STA_NOINIT;
+  }
+
   return 0;
 }
 
-int RAM_disk_ioctl(unsigned char cmd, void* buff) {
-  int res;
+static DRESULT ramdisk_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count) {
+  ramdisk_t* disk = ramdisk_get_range(dev, sector, count);
+
+  if (disk == NULL) {
+    return RES_PARERR;
+  }
+
+  memcpy(buff, disk->data + (size_t)sector * disk->sector_size,
+         (size_t)count * disk->sector_size);
+
+  return RES_OK;
+}
+
+static DRESULT ramdisk_write(diskio_dev_t* dev, const BYTE* buff, DWORD sector, UINT count) {
+  ramdisk_t* disk = ramdisk_get_range(dev, sector, count);
+
+  if (disk == NULL) {
+    return RES_PARERR;
+  }
+
+  memcpy(disk->data + (size_t)sector * disk->sector_size, buff,
+         (size_t)count * disk->sector_size);
+
+  return RES_OK;
+}
+
+static DRESULT ramdisk_ioctl(diskio_dev_t* dev, BYTE cmd, void* buff) {
+  DRESULT res = RES_OK;
+  ramdisk_t* disk = (ramdisk_t*)dev;
+
+  if (disk->data == NULL) {
+    return RES_NOTRDY;
+  }
 
   switch (cmd) {
     case CTRL_SYNC:
-      res = RES_OK;
+#ifdef RAMDISK_WITH_MMAP
+      if (disk->mapped &&
+          msync(disk->data, (size_t)disk->sector_count * disk->sector_size, MS_SYNC) != 0) {
+        res = RES_ERROR;
+      }
+#endif /*RAMDISK_WITH_MMAP*/
       break;
     case GET_SECTOR_SIZE:
-      *(DWORD*)buff = CFG_RAMDISK_SECTOR_SIZE;
-      res = RES_OK;
+      *(WORD*)buff = disk->sector_size;
       break;
     case GET_BLOCK_SIZE:
-      *(WORD*)buff = 1;
-      res = RES_OK;
+      *(DWORD*)buff = 1;
       break;
     case GET_SECTOR_COUNT:
-      *(DWORD*)buff = RAMDISK_SECTOR_TOTAL;
-      res = RES_OK;
+      *(DWORD*)buff = disk->sector_count;
       break;
     default:
       res = RES_PARERR;
@@ -58,28 +235,22 @@ int RAM_disk_ioctl(unsigned char cmd, void* buff) {
   return res;
 }
 
-DWORD get_fattime(void) {
-  return 0;
-}
+diskio_dev_t* ramdisk_get_dev(BYTE pdrv) {
+  ramdisk_t* disk = ramdisk_get(pdrv);
 
-DSTATUS ff_disk_status(BYTE pdrv) {
-  return RAM_disk_status();
-}
-
-DSTATUS ff_disk_initialize(BYTE pdrv) {
-  return RAM_disk_initialize();
-}
-
-DRESULT ff_disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count) {
-  return RAM_disk_read(buff, sector, count);
-}
+  if (disk == NULL) {
+    return NULL;
+  }
 
-DRESULT ff_disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count) {
-  return RAM_disk_write(buff, sector, count);
-}
+  if (disk->dev.read == NULL) {
+    disk->dev.status = ramdisk_status;
+    disk->dev.initialize = ramdisk_initialize;
+    disk->dev.read = ramdisk_read;
+    disk->dev.write = ramdisk_write;
+    disk->dev.ioctl = ramdisk_ioctl;
+  }
 
-DRESULT ff_disk_ioctl(BYTE pdrv, BYTE cmd, void* buff) {
-  return RAM_disk_ioctl(cmd, buff);
+  return &(disk->dev);
 }
 
 #endif /*WITH_RAM_DISK*/
@@ -1,11 +1,80 @@
 #ifndef _RAMDISK_H_
 #define _RAMDISK_H_
 
-int RAM_disk_status(void);
-int RAM_disk_initialize(void);
-int RAM_disk_read(unsigned char* buff, unsigned int sector, unsigned int count);
-int RAM_disk_write(const unsigned char* buff, unsigned int sector, unsigned int count);
-int RAM_disk_ioctl(unsigned char cmd, void* buff);
-DWORD get_fattime(void);
+#include "ff.h"
+#include "diskio.h"
+#include "diskio_dev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 没有调用ramdisk_create创建的驱动器，第一次访问时自动创建的RAM disk的大小。
+ */
+#ifndef CFG_RAMDISK_SIZE
+#define CFG_RAMDISK_SIZE (1000 * 1024)
+#endif /*CFG_RAMDISK_SIZE*/
+
+/**
+ * 自动创建的RAM disk的扇区大小。
+ */
+#ifndef CFG_RAMDISK_SECTOR_SIZE
+#define CFG_RAMDISK_SECTOR_SIZE (512)
+#endif /*CFG_RAMDISK_SECTOR_SIZE*/
+
+/**
+ * @method ramdisk_create
+ * 为物理驱动器创建RAM disk，存储空间在运行时分配(已经存在时先销毁)。
+ * > 每个驱动器(0到FF_VOLUMES-1)相互独立，可以同时挂载多个RAM disk。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {DWORD} sector_count 扇区数。
+ * @param {WORD} sector_size 扇区大小(2的幂，在FF_MIN_SS和FF_MAX_SS之间)。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT ramdisk_create(BYTE pdrv, DWORD sector_count, WORD sector_size);
+
+/**
+ * @method ramdisk_create_file
+ * 为物理驱动器创建用主机文件映射(mmap)的RAM disk，写入的数据保存在文件中。
+ * 文件不存在时创建，比需要的小时扩展(稀疏文件)。
+ * > 只在支持mmap的平台(Linux/MacOS)上可用。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ * @param {const char*} filename 映像文件名。
+ * @param {DWORD} sector_count 扇区数，为0时使用文件的大小。
+ * @param {WORD} sector_size 扇区大小(2的幂，在FF_MIN_SS和FF_MAX_SS之间)。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT ramdisk_create_file(BYTE pdrv, const char* filename, DWORD sector_count,
+                            WORD sector_size);
+
+/**
+ * @method ramdisk_destroy
+ * 释放物理驱动器的存储空间(映射文件时解除映射)。
+ * > 需要先用f_mount卸载该驱动器上的卷。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {DRESULT} 返回RES_OK表示成功，否则表示失败。
+ */
+DRESULT ramdisk_destroy(BYTE pdrv);
+
+/**
+ * @method ramdisk_get_dev
+ * 获取物理驱动器的RAM disk驱动(没有用diskio_set_dev设置其它驱动时使用)。
+ * @annotation ["global"]
+ * @param {BYTE} pdrv 物理驱动器号。
+ *
+ * @return {diskio_dev_t*} 返回驱动对象。
+ */
+diskio_dev_t* ramdisk_get_dev(BYTE pdrv);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,168 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "ff.h"
+#include "diskio.h"
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "fs_os_fatfs.h"
+#include "fatfs/diskio_ramdisk.h"
+
+/*
+ * 比较统计空闲簇的三种方式，每种方式输出一行JSON：
+ * getfree_scan: f_getfree逐个表项扫描FAT(先让缓存的free_clst失效)。
+ * rescan: os_fs_fatfs_rescan_free按字统计。
+ * disk_info: fs_get_disk_info直接使用缓存的free_clst。
+ *
+ * 比较在大文件(约占1/4空间)中随机定位并读取一个扇区的两种方式：
+ * seek_chain: f_lseek沿FAT链定位，耗时随文件大小增加。
+ * seek_clmt: fs_file_seek第一次远距离定位时创建簇链映射表，之后耗时和文件大小无关。
+ *
+ * RAM disk的大小(MB)可以用参数指定，缺省为1G(FM_FAT格式化为FAT16，FM_FAT32格式化为FAT32)。
+ */
+
+#define DEFAULT_DISK_MB 1024
+#define SCAN_ROUNDS 16
+#define INFO_ROUNDS 10000
+#define WRITE_BLOCK_SIZE 32768
+#define SEEK_ROUNDS 1000
+
+static uint8_t s_buff[WRITE_BLOCK_SIZE];
+
+static const char* fat_type_name(BYTE fs_type) {
+  switch (fs_type) {
+    case FS_FAT12:
+      return "fat12";
+    case FS_FAT16:
+      return "fat16";
+    case FS_FAT32:
+      return "fat32";
+    default:
+      return "unknown";
+  }
+}
+
+static void bench_dump(FATFS* ffs, const char* test, uint32_t ops, uint64_t us) {
+  us = tk_max(us, 1);
+  printf("{\"fs\":\"%s\",\"clusters\":%u,\"test\":\"%s\",\"ops\":%u,\"us\":%llu,"
+         "\"us_per_op\":%.3f}\n",
+         fat_type_name(ffs->fs_type), (uint32_t)(ffs->n_fatent - 2), test, ops,
+         (unsigned long long)us, (double)us / ops);
+  fflush(stdout);
+}
+
+/*写一个占用约1/4空间的文件，让FAT中既有空闲簇也有已分配的簇。*/
+static void bench_fill(fs_t* fs, FATFS* ffs) {
+  uint32_t i = 0;
+  fs_file_t* fp = fs_open_file(fs, "0:/fill.bin", "wb");
+  uint64_t size = (uint64_t)(ffs->n_fatent - 2) * ffs->csize * FF_MAX_SS / 4;
+
+  assert(fp != NULL);
+  memset(s_buff, 0x55, sizeof(s_buff));
+  for (i = 0; i < size / sizeof(s_buff); i++) {
+    assert(fs_file_write(fp, s_buff, sizeof(s_buff)) == sizeof(s_buff));
+  }
+  fs_file_close(fp);
+}
+
+/*两种方式使用相同的随机位置序列。*/
+static FSIZE_t bench_seek_offset(uint32_t* seed, FSIZE_t size) {
+  *seed = *seed * 1103515245 + 12345;
+  return ((FSIZE_t)(*seed >> 4) * FF_MAX_SS) % (size - FF_MAX_SS);
+}
+
+static void bench_seek(fs_t* fs, FATFS* ffs) {
+  FIL fil;
+  UINT br = 0;
+  uint32_t i = 0;
+  uint32_t seed = 1;
+  uint64_t start = 0;
+  fs_file_t* fp = NULL;
+
+  assert(f_open(&fil, "0:/fill.bin", FA_READ) == FR_OK);
+  start = time_now_us();
+  for (i = 0; i < SEEK_ROUNDS; i++) {
+    assert(f_lseek(&fil, bench_seek_offset(&seed, f_size(&fil))) == FR_OK);
+    assert(f_read(&fil, s_buff, FF_MAX_SS, &br) == FR_OK && br == FF_MAX_SS);
+  }
+  bench_dump(ffs, "seek_chain", SEEK_ROUNDS, time_now_us() - start);
+
+  seed = 1;
+  fp = fs_open_file(fs, "0:/fill.bin", "rb");
+  assert(fp != NULL);
+  start = time_now_us();
+  for (i = 0; i < SEEK_ROUNDS; i++) {
+    assert(fs_file_seek(fp, (int32_t)bench_seek_offset(&seed, f_size(&fil))) == RET_OK);
+    assert(fs_file_read(fp, s_buff, FF_MAX_SS) == FF_MAX_SS);
+  }
+  bench_dump(ffs, "seek_clmt", SEEK_ROUNDS, time_now_us() - start);
+
+  fs_file_close(fp);
+  f_close(&fil);
+}
+
+static void bench_format(fs_t* fs, BYTE fmt) {
+  FATFS fatfs;
+  DWORD nclst = 0;
+  uint32_t i = 0;
+  uint64_t start = 0;
+  FATFS* ffs = NULL;
+  int32_t free_kb = 0;
+  int32_t total_kb = 0;
+  uint32_t free_clst = 0;
+  static BYTE s_work[WRITE_BLOCK_SIZE];
+
+  if (f_mkfs("0:", fmt, 0, s_work, sizeof(s_work)) != FR_OK) {
+    return;
+  }
+  assert(f_mount(&fatfs, "0:", 1) == FR_OK);
+  assert(f_getfree("0:", &nclst, &ffs) == FR_OK);
+  bench_fill(fs, ffs);
+
+  start = time_now_us();
+  for (i = 0; i < SCAN_ROUNDS; i++) {
+    ffs->free_clst = 0xFFFFFFFF;
+    assert(f_getfree("0:", &nclst, &ffs) == FR_OK);
+  }
+  bench_dump(ffs, "getfree_scan", SCAN_ROUNDS, time_now_us() - start);
+
+  start = time_now_us();
+  for (i = 0; i < SCAN_ROUNDS; i++) {
+    assert(os_fs_fatfs_rescan_free("0:", &free_clst) == RET_OK);
+  }
+  bench_dump(ffs, "rescan", SCAN_ROUNDS, time_now_us() - start);
+  assert(free_clst == nclst);
+
+  start = time_now_us();
+  for (i = 0; i < INFO_ROUNDS; i++) {
+    assert(fs_get_disk_info(fs, "0:", &free_kb, &total_kb) == RET_OK);
+  }
+  bench_dump(ffs, "disk_info", INFO_ROUNDS, time_now_us() - start);
+  assert(free_kb == (int32_t)((uint64_t)nclst * ffs->csize * FF_MAX_SS / 1024));
+
+  bench_seek(fs, ffs);
+
+  assert(f_mount(0, "0:", 0) == FR_OK);
+}
+
+int main(int argc, char* argv[]) {
+  fs_t* fs = NULL;
+  uint32_t disk_mb = argc > 1 ? tk_atoi(argv[1]) : DEFAULT_DISK_MB;
+
+  platform_prepare();
+
+  if (ramdisk_create(0, disk_mb * (1024 * 1024 / FF_MAX_SS), FF_MAX_SS) != RES_OK) {
+    printf("create %uM ramdisk failed\n", disk_mb);
+    return 1;
+  }
+
+  fs = os_fs_fatfs();
+  bench_format(fs, FM_FAT);
+  bench_format(fs, FM_FAT32);
+  ramdisk_destroy(0);
+
+  return 0;
+}
@@ -4,13 +4,462 @@
 
 #include "ff.h"
 #include "tkc/fs.h"
+#include "tkc/mem.h"
 #include "tkc/utils.h"
 #include "tkc/thread.h"
 #include "tkc/platform.h"
+#include "fs_file_ext.h"
+#include "fs_os_fatfs.h"
+#include "fatfs/diskio_file.h"
+#include "fatfs/diskio_cache.h"
+#include "fatfs/diskio_ramdisk.h"
 
 extern void test_fs(fs_t* fs);
 extern void test_fs_wait(void);
-extern fs_t* os_fs_fatfs(void);
+extern uint32_t test_fs_borrow(fs_t* fs, const char* filename, const char* mode);
+extern void test_fs_iovec(fs_t* fs, const char* filename);
+extern void test_fs_pread(fs_t* fs, const char* filename);
+extern void test_fs_pwrite_gap(fs_t* fs, const char* filename);
+extern void test_fs_allocate(fs_t* fs, const char* filename, uint32_t size);
+extern void test_fs_truncate(fs_t* fs, const char* filename, uint32_t size);
+extern void test_fs_pread_threads(fs_t* fs, const char* filename);
+
+static void test_disk_info(fs_t* fs) {
+  DWORD nclst = 0;
+  FATFS* ffs = NULL;
+  uint32_t free_clst = 0;
+  int32_t free_kb = 0;
+  int32_t total_kb = 0;
+  int32_t free_kb2 = 0;
+  fs_file_t* fp = NULL;
+  char buff[4096];
+
+  assert(fs_get_disk_info(fs, "0:", &free_kb, &total_kb) == RET_OK);
+  assert(total_kb > 0 && free_kb > 0 && free_kb <= total_kb);
+
+  /*按字统计的结果和f_getfree逐个表项扫描的结果一致。*/
+  assert(f_getfree("0:", &nclst, &ffs) == FR_OK);
+  ffs->free_clst = 0xFFFFFFFF;
+  assert(f_getfree("0:", &nclst, &ffs) == FR_OK);
+  assert(os_fs_fatfs_rescan_free("0:", &free_clst) == RET_OK);
+  assert(free_clst == nclst);
+  assert(os_fs_fatfs_rescan_free(NULL, NULL) == RET_OK);
+  assert(os_fs_fatfs_rescan_free("2:", NULL) != RET_OK);
+
+  memset(buff, 0x55, sizeof(buff));
+  fp = fs_open_file(fs, "0:/disk_info.bin", "wb");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+  fs_file_close(fp);
+
+  assert(fs_get_disk_info(fs, "0:", &free_kb2, &total_kb) == RET_OK);
+  assert(free_kb2 <= free_kb - (int32_t)(sizeof(buff) / 1024));
+  assert(os_fs_fatfs_rescan_free("0:", &free_clst) == RET_OK);
+  assert(f_getfree("0:", &nclst, &ffs) == FR_OK && nclst == free_clst);
+
+  assert(fs_remove_file(fs, "0:/disk_info.bin") == RET_OK);
+  assert(fs_get_disk_info(fs, "0:", &free_kb2, &total_kb) == RET_OK);
+  assert(free_kb2 == free_kb);
+}
+
+static void write_text(fs_t* fs, const char* filename, const char* text) {
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, text, strlen(text)) == strlen(text));
+  fs_file_close(fp);
+}
+
+static void check_text(fs_t* fs, const char* filename, const char* text) {
+  char buff[32];
+  fs_file_t* fp = fs_open_file(fs, filename, "rb");
+  assert(fp != NULL);
+  memset(buff, 0x00, sizeof(buff));
+  assert(fs_file_read(fp, buff, sizeof(buff)) == strlen(text));
+  assert(strcmp(buff, text) == 0);
+  fs_file_close(fp);
+}
+
+/*1号驱动器使用64M的RAM disk，和0号驱动器同时挂载，互不影响。*/
+static void test_ramdisk_drives(fs_t* fs) {
+  FATFS fatfs;
+  int32_t free_kb = 0;
+  int32_t total_kb = 0;
+  BYTE work[FF_MAX_SS];
+
+  assert(ramdisk_create(1, 64, 100) == RES_PARERR);
+  assert(ramdisk_create(FF_VOLUMES, 64, FF_MAX_SS) == RES_PARERR);
+  assert(ramdisk_create(1, 64 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+
+  assert(f_mkfs("1:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  write_text(fs, "1:/ramdisk.txt", "drive1");
+  write_text(fs, "0:/ramdisk.txt", "drive0");
+  check_text(fs, "1:/ramdisk.txt", "drive1");
+  check_text(fs, "0:/ramdisk.txt", "drive0");
+
+  assert(fs_get_disk_info(fs, "1:", &free_kb, &total_kb) == RET_OK);
+  assert(total_kb > 60 * 1024 && total_kb < 64 * 1024);
+  assert(fs_get_disk_info(fs, "0:", &free_kb, &total_kb) == RET_OK);
+  assert(total_kb < 1000);
+
+  assert(fs_remove_file(fs, "0:/ramdisk.txt") == RET_OK);
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(ramdisk_destroy(1) == RES_OK);
+}
+
+/*映射主机文件的RAM disk，卸载后重新映射，数据仍然存在。*/
+static void test_ramdisk_file(fs_t* fs) {
+#if defined(LINUX) || defined(MACOS)
+  FATFS fatfs;
+  BYTE work[FF_MAX_SS];
+  const char* image = "ramdisk.img";
+
+  remove(image);
+  assert(ramdisk_create_file(2, image, 0, FF_MAX_SS) == RES_ERROR);
+  assert(ramdisk_create_file(2, image, 4 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+  assert(f_mkfs("2:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "2:", 0) == FR_OK);
+  write_text(fs, "2:/persist.txt", "persist");
+  assert(f_mount(0, "2:", 0) == FR_OK);
+  assert(ramdisk_destroy(2) == RES_OK);
+
+  assert(ramdisk_create_file(2, image, 0, FF_MAX_SS) == RES_OK);
+  assert(f_mount(&fatfs, "2:", 0) == FR_OK);
+  check_text(fs, "2:/persist.txt", "persist");
+  assert(f_mount(0, "2:", 0) == FR_OK);
+  assert(ramdisk_destroy(2) == RES_OK);
+  remove(image);
+#else
+  (void)fs;
+#endif /*LINUX || MACOS*/
+}
+
+/*映像文件作为1号驱动器，多扇区的读写合并为一次pread/pwrite。*/
+static void test_diskio_file(fs_t* fs, BYTE flags) {
+#if defined(LINUX) || defined(MACOS)
+  FATFS fatfs;
+  uint32_t i = 0;
+  fs_file_t* fp = NULL;
+  BYTE work[FF_MAX_SS];
+  diskio_file_stats_t stats;
+  const uint32_t size = 64 * 1024;
+  const char* image = "diskio.img";
+  uint8_t* buff = (uint8_t*)TKMEM_ALLOC(size);
+  uint8_t* data = (uint8_t*)TKMEM_ALLOC(size);
+
+  for (i = 0; i < size; i++) {
+    data[i] = (uint8_t)(i * 7);
+  }
+
+  remove(image);
+  assert(diskio_file_open(1, image, 0, FF_MAX_SS, flags) == RES_ERROR);
+  if (diskio_file_open(1, image, 16 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS, flags) != RES_OK) {
+    /*部分文件系统(如tmpfs)不支持O_DIRECT。*/
+    assert(flags & DISKIO_FILE_DIRECT);
+    remove(image);
+    TKMEM_FREE(buff);
+    TKMEM_FREE(data);
+    return;
+  }
+
+  assert(f_mkfs("1:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  assert(diskio_file_reset_stats(1) == RES_OK);
+  fp = fs_open_file(fs, "1:/diskio.bin", "wb");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, data, size) == size);
+  assert(fs_file_sync(fp) == RET_OK);
+  fs_file_close(fp);
+
+  assert(diskio_file_get_stats(1, &stats) == RES_OK);
+  assert(stats.syncs > 0 && stats.errors == 0);
+  assert(stats.write_sectors >= size / FF_MAX_SS);
+  assert(stats.writes < stats.write_sectors);
+  assert(stats.write_latency.count == stats.writes);
+
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(diskio_file_close(1) == RES_OK);
+  assert(diskio_file_close(1) == RES_PARERR);
+
+  /*重新打开映像文件，数据仍然存在。*/
+  assert(diskio_file_open(1, image, 0, FF_MAX_SS, flags) == RES_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  fp = fs_open_file(fs, "1:/diskio.bin", "rb");
+  assert(fp != NULL);
+  assert(diskio_file_reset_stats(1) == RES_OK);
+  assert(fs_file_read(fp, buff, size) == size);
+  assert(memcmp(buff, data, size) == 0);
+  fs_file_close(fp);
+  assert(diskio_file_get_stats(1, &stats) == RES_OK);
+  assert(stats.reads < stats.read_sectors);
+
+  /*加了缓存时不能关闭或者替换映像文件。*/
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(diskio_cache_wrap(1, 8) == RES_OK);
+  assert(diskio_file_close(1) == RES_NOTRDY);
+  assert(diskio_file_open(1, image, 0, FF_MAX_SS, flags) == RES_NOTRDY);
+  assert(diskio_file_get_stats(1, &stats) == RES_OK);
+  assert(diskio_cache_unwrap(1) == RES_OK);
+  assert(diskio_file_close(1) == RES_OK);
+  remove(image);
+  TKMEM_FREE(buff);
+  TKMEM_FREE(data);
+#else
+  (void)fs;
+  (void)flags;
+#endif /*LINUX || MACOS*/
+}
+
+static void create_small_files(fs_t* fs, uint32_t nr) {
+  uint32_t i = 0;
+  char text[32];
+  char filename[MAX_PATH + 1];
+
+  for (i = 0; i < nr; i++) {
+    tk_snprintf(filename, MAX_PATH, "1:/small%u.txt", i);
+    tk_snprintf(text, sizeof(text), "small file %u", i);
+    write_text(fs, filename, text);
+  }
+}
+
+static void check_small_files(fs_t* fs, uint32_t nr) {
+  uint32_t i = 0;
+  char text[32];
+  char filename[MAX_PATH + 1];
+
+  for (i = 0; i < nr; i++) {
+    tk_snprintf(filename, MAX_PATH, "1:/small%u.txt", i);
+    tk_snprintf(text, sizeof(text), "small file %u", i);
+    check_text(fs, filename, text);
+  }
+}
+
+static void write_blocks(fs_t* fs, const char* filename, uint32_t size, uint32_t bs) {
+  uint32_t i = 0;
+  uint8_t buff[256];
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+
+  assert(fp != NULL && bs <= sizeof(buff));
+  for (i = 0; i < size; i += bs) {
+    uint32_t k = 0;
+    uint32_t n = tk_min(bs, size - i);
+    for (k = 0; k < n; k++) {
+      buff[k] = (uint8_t)((i + k) * 13);
+    }
+    assert(fs_file_write(fp, buff, n) == n);
+  }
+  fs_file_close(fp);
+}
+
+static void check_blocks(fs_t* fs, const char* filename, uint32_t size) {
+  uint32_t i = 0;
+  uint8_t* buff = (uint8_t*)TKMEM_ALLOC(size);
+  fs_file_t* fp = fs_open_file(fs, filename, "rb");
+
+  assert(fp != NULL && buff != NULL);
+  assert(fs_file_read(fp, buff, size) == size);
+  for (i = 0; i < size; i++) {
+    assert(buff[i] == (uint8_t)(i * 13));
+  }
+  fs_file_close(fp);
+  TKMEM_FREE(buff);
+}
+
+/*缓存比FAT和目录的扇区少，反复淘汰和写回，去掉缓存后直接读设备，数据一致。*/
+static void test_diskio_cache(fs_t* fs) {
+  FATFS fatfs;
+  BYTE work[FF_MAX_SS];
+  diskio_cache_stats_t stats;
+
+  assert(diskio_cache_wrap(FF_VOLUMES, 8) == RES_PARERR);
+  assert(diskio_cache_unwrap(1) == RES_PARERR);
+  assert(ramdisk_create(1, 16 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+  assert(diskio_cache_wrap(1, 0) == RES_PARERR);
+  assert(diskio_cache_wrap(1, 8) == RES_OK);
+
+  assert(f_mkfs("1:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  assert(diskio_cache_reset_stats(1) == RES_OK);
+  create_small_files(fs, 100);
+  check_small_files(fs, 100);
+
+  assert(diskio_cache_get_stats(1, &stats) == RES_OK);
+  assert(stats.read_hits > 0 && stats.write_hits > 0 && stats.syncs > 0);
+  assert(stats.dev_write_sectors < stats.write_hits + stats.write_misses);
+
+  /*小块写入一个文件，中间不同步，脏扇区被淘汰，相邻的数据扇区合并写回。*/
+  assert(diskio_cache_reset_stats(1) == RES_OK);
+  write_blocks(fs, "1:/big.bin", 32 * 1024, 100);
+  assert(diskio_cache_get_stats(1, &stats) == RES_OK);
+  assert(stats.evictions > 0 && stats.dev_writes < stats.dev_write_sectors);
+  check_blocks(fs, "1:/big.bin", 32 * 1024);
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(diskio_cache_unwrap(1) == RES_OK);
+
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  check_small_files(fs, 100);
+  check_blocks(fs, "1:/big.bin", 32 * 1024);
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(ramdisk_destroy(1) == RES_OK);
+}
+
+static void write_words(fs_file_t* fp, uint32_t start, uint32_t count) {
+  uint32_t i = 0;
+  uint32_t words[512];
+
+  assert(count <= ARRAY_SIZE(words));
+  for (i = 0; i < count; i++) {
+    words[i] = start + i;
+  }
+  assert(fs_file_write(fp, words, count * 4) == (int32_t)(count * 4));
+}
+
+static void check_word(fs_file_t* fp, uint32_t index) {
+  uint32_t word = 0;
+
+  assert(fs_file_seek(fp, index * 4) == RET_OK);
+  assert(fs_file_read(fp, &word, 4) == 4 && word == index);
+}
+
+/*两个文件交替写入，簇链很碎，映射表需要重新分配。映射表模式下扩展文件后，定位和读写仍然正确。*/
+static void test_fast_seek(fs_t* fs) {
+  FATFS fatfs;
+  uint32_t i = 0;
+  uint32_t seed = 1;
+  BYTE work[FF_MAX_SS];
+  fs_file_t* fp = NULL;
+  fs_file_t* other = NULL;
+  uint32_t words = 512 * 1024 / 4;
+  uint32_t value = 0xffffffff;
+
+  assert(ramdisk_create(1, 16 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+  assert(f_mkfs("1:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+
+  fp = fs_open_file(fs, "1:/seek.bin", "wb");
+  other = fs_open_file(fs, "1:/other.bin", "wb");
+  assert(fp != NULL && other != NULL);
+  for (i = 0; i < words; i += 512) {
+    write_words(fp, i, 512);
+    write_words(other, i, 512);
+  }
+  fs_file_close(other);
+  fs_file_close(fp);
+
+  fp = fs_open_file(fs, "1:/seek.bin", "r+");
+  assert(fp != NULL);
+  for (i = 0; i < 1000; i++) {
+    seed = seed * 1103515245 + 12345;
+    check_word(fp, (seed >> 8) % words);
+  }
+  check_word(fp, 0);
+  check_word(fp, words - 1);
+
+  assert(fs_file_seek(fp, 100 * 1024) == RET_OK);
+  write_words(fp, 100 * 1024 / 4, 16);
+  assert(fs_file_pwrite(fp, &value, 4, 200 * 1024) == 4);
+  assert(fs_file_seek(fp, words * 4) == RET_OK);
+  write_words(fp, words, 512);
+  check_word(fp, 10);
+  check_word(fp, words + 511);
+  check_word(fp, words - 1);
+  assert(fs_file_pread(fp, &value, 4, 200 * 1024) == 4 && value == 0xffffffff);
+  value = 0;
+  assert(fs_file_pwrite(fp, &value, 4, (words + 512) * 4) == 4);
+  assert(fs_file_size(fp) == (words + 513) * 4);
+  check_word(fp, 12345);
+  assert(fs_file_truncate(fp, 0) == RET_OK);
+  assert(fs_file_size(fp) == 0);
+  write_words(fp, 0, 512);
+  check_word(fp, 511);
+  fs_file_close(fp);
+
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(ramdisk_destroy(1) == RES_OK);
+}
+
+/*返回文件的簇链片段数。*/
+static uint32_t file_fragments(const char* filename) {
+  FIL fil;
+  DWORD cltbl[512];
+
+  assert(f_open(&fil, filename, FA_READ) == FR_OK);
+  cltbl[0] = ARRAY_SIZE(cltbl);
+  fil.cltbl = cltbl;
+  assert(f_lseek(&fil, CREATE_LINKMAP) == FR_OK);
+  assert(f_close(&fil) == FR_OK);
+
+  return (cltbl[0] - 2) / 2;
+}
+
+/*两个文件交替写入时簇链很碎，预先分配的文件是连续的。*/
+static void test_allocate_contiguous(fs_t* fs) {
+  FATFS fatfs;
+  uint32_t i = 0;
+  BYTE work[FF_MAX_SS];
+  fs_file_t* fp = NULL;
+  fs_file_t* other = NULL;
+  uint32_t size = 256 * 1024;
+
+  assert(ramdisk_create(1, 16 * 1024 * 1024 / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+  assert(f_mkfs("1:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+
+  fp = fs_open_file(fs, "1:/a.bin", "wb");
+  other = fs_open_file(fs, "1:/b.bin", "wb");
+  assert(fp != NULL && other != NULL);
+  for (i = 0; i < 128; i++) {
+    write_words(fp, i, 512);
+    write_words(other, i, 512);
+  }
+  fs_file_close(other);
+  fs_file_close(fp);
+  assert(file_fragments("1:/a.bin") > 1);
+  assert(fs_remove_file(fs, "1:/b.bin") == RET_OK);
+
+  fp = fs_open_file(fs, "1:/c.bin", "wb");
+  assert(fp != NULL);
+  assert(fs_file_allocate(fp, size) == RET_OK);
+  assert(fs_file_size(fp) == size);
+  for (i = 0; i < size / 2048; i++) {
+    write_words(fp, i * 512, 512);
+  }
+  fs_file_close(fp);
+  assert(file_fragments("1:/c.bin") == 1);
+
+  fp = fs_open_file(fs, "1:/d.bin", "wb");
+  assert(fp != NULL);
+  for (i = 0; i < size / 2048; i++) {
+    write_words(fp, i * 512, 512);
+  }
+  fs_file_close(fp);
+
+  /*不为空的文件扩展簇链。*/
+  fp = fs_open_file(fs, "1:/d.bin", "r+");
+  assert(fp != NULL);
+  assert(fs_file_allocate(fp, size * 2) == RET_OK);
+  assert(fs_file_size(fp) == size * 2 && fs_file_tell(fp) == 0);
+  check_word(fp, size / 4 - 1);
+  fs_file_close(fp);
+
+  /*重新挂载后f_expand从头查找，分配到c.bin用过的簇，预先分配的部分要读出为0。*/
+  assert(fs_remove_file(fs, "1:/c.bin") == RET_OK);
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(f_mount(&fatfs, "1:", 0) == FR_OK);
+  fp = fs_open_file(fs, "1:/e.bin", "wb+");
+  assert(fp != NULL);
+  assert(fs_file_allocate(fp, size) == RET_OK);
+  assert(fs_file_size(fp) == size && fs_file_tell(fp) == 0);
+  for (i = 0; i < size; i += sizeof(work)) {
+    assert(fs_file_read(fp, work, sizeof(work)) == sizeof(work));
+    assert(work[0] == 0 && work[sizeof(work) / 2] == 0 && work[sizeof(work) - 1] == 0);
+  }
+  fs_file_close(fp);
+  assert(file_fragments("1:/e.bin") == 1);
+
+  assert(f_mount(0, "1:", 0) == FR_OK);
+  assert(ramdisk_destroy(1) == RES_OK);
+}
 
 int main(int argc, char* argv[]) {
   FATFS fatfs;
@@ -26,6 +475,25 @@ int main(int argc, char* argv[]) {
   test_fs(fs);
   test_fs_wait();
 
+  /*扇区缓冲区中的数据直接借出。*/
+  assert(test_fs_borrow(fs, "0:/borrow.bin", "rb") > 0);
+  test_fs_iovec(fs, "0:/iovec.bin");
+  test_fs_pread(fs, "0:/pread.bin");
+  test_fs_pwrite_gap(fs, "0:/gap.bin");
+  test_fs_allocate(fs, "0:/allocate.bin", 64 * 1024);
+  test_fs_truncate(fs, "0:/truncate.bin", 64 * 1024);
+  test_disk_info(fs);
+  test_ramdisk_drives(fs);
+  test_ramdisk_file(fs);
+  test_diskio_file(fs, 0);
+  test_diskio_file(fs, DISKIO_FILE_DIRECT);
+  test_diskio_cache(fs);
+  test_fast_seek(fs);
+  test_allocate_contiguous(fs);
+#ifdef WITH_FS_MT
+  test_fs_pread_threads(fs, "0:/pread.bin");
+#endif /*WITH_FS_MT*/
+
   assert(f_mount(0, "0:", 0) == FR_OK);
 
   return 0;
@@ -0,0 +1,444 @@
+/**
+ * File:   fs_async.c
+ * Author: AWTK Develop Team
+ * Brief:  asynchronous fs requests executed by a worker pool
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include "tkc/time_now.h"
+#include "fs_async.h"
+
+#ifdef WITH_FS_MT
+#include "tkc/mutex.h"
+#include "tkc/thread.h"
+#include "tkc/semaphore.h"
+#endif /*WITH_FS_MT*/
+
+#ifdef WITH_FS_MT
+typedef struct _fs_async_worker_t {
+  fs_async_t* async;
+  tk_thread_t* thread;
+  /*正在操作的文件，同一个文件的请求不会同时执行。*/
+  fs_file_t* busy;
+} fs_async_worker_t;
+#endif /*WITH_FS_MT*/
+
+struct _fs_async_t {
+  fs_t* fs;
+  uint32_t workers_nr;
+#ifdef WITH_FS_MT
+  bool_t quit;
+  tk_mutex_t* mutex;
+  tk_semaphore_t* sem;
+  fs_async_worker_t* workers;
+  fs_async_req_t* first;
+  fs_async_req_t* last;
+#endif /*WITH_FS_MT*/
+};
+
+/*打开和获取信息的请求不属于任何文件，可以以任意顺序执行。*/
+static fs_file_t* fs_async_req_key(fs_async_req_t* req) {
+  if (req->type == FS_ASYNC_REQ_OPEN || req->type == FS_ASYNC_REQ_STAT) {
+    return NULL;
+  }
+
+  return req->file;
+}
+
+static void fs_async_req_exec(fs_async_t* async, fs_async_req_t* req) {
+  req->start_us = time_now_us();
+
+  switch (req->type) {
+    case FS_ASYNC_REQ_OPEN: {
+      req->file = fs_open_file(async->fs, req->name, req->mode);
+      req->ret = req->file != NULL ? RET_OK : RET_FAIL;
+      break;
+    }
+    case FS_ASYNC_REQ_READ: {
+      req->size = fs_file_read(req->file, req->buffer, req->capacity);
+      req->ret = req->size >= 0 ? RET_OK : RET_FAIL;
+      break;
+    }
+    case FS_ASYNC_REQ_WRITE: {
+      req->size = fs_file_write(req->file, req->buffer, req->capacity);
+      req->ret = req->size >= 0 ? RET_OK : RET_FAIL;
+      break;
+    }
+    case FS_ASYNC_REQ_SYNC: {
+      req->ret = fs_file_sync(req->file);
+      break;
+    }
+    case FS_ASYNC_REQ_CLOSE: {
+      req->ret = fs_file_close(req->file);
+      break;
+    }
+    case FS_ASYNC_REQ_STAT: {
+      req->ret = fs_stat(async->fs, req->name, &(req->stat));
+      break;
+    }
+    default: {
+      req->ret = RET_NOT_IMPL;
+      break;
+    }
+  }
+
+  req->done_us = time_now_us();
+}
+
+/*通知调用者。之后请求对象可能已经被销毁，不能再访问。*/
+static void fs_async_req_complete(fs_async_req_t* req) {
+  if (req->on_done != NULL) {
+    req->on_done(req->ctx, req);
+    fs_async_req_destroy(req);
+  }
+#ifdef WITH_FS_MT
+  else {
+    tk_semaphore_post(req->done_sem);
+  }
+#endif /*WITH_FS_MT*/
+}
+
+#ifdef WITH_FS_MT
+static bool_t fs_async_is_busy(fs_async_t* async, fs_file_t* key) {
+  uint32_t i = 0;
+
+  for (i = 0; i < async->workers_nr; i++) {
+    if (async->workers[i].busy == key) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*取出第一个可以执行的请求：文件正在被其它线程操作时跳过该文件的所有请求，以保证同一个文件的请求按顺序执行。*/
+static fs_async_req_t* fs_async_pick(fs_async_t* async) {
+  fs_async_req_t* prev = NULL;
+  fs_async_req_t* iter = async->first;
+
+  while (iter != NULL) {
+    fs_file_t* key = fs_async_req_key(iter);
+
+    if (key == NULL || !fs_async_is_busy(async, key)) {
+      if (prev == NULL) {
+        async->first = iter->next;
+      } else {
+        prev->next = iter->next;
+      }
+
+      if (async->last == iter) {
+        async->last = prev;
+      }
+      iter->next = NULL;
+
+      return iter;
+    }
+
+    prev = iter;
+    iter = iter->next;
+  }
+
+  return NULL;
+}
+
+static void* fs_async_worker_main(void* args) {
+  fs_async_worker_t* worker = (fs_async_worker_t*)args;
+  fs_async_t* async = worker->async;
+
+  tk_mutex_lock(async->mutex);
+  while (!(async->quit && async->first == NULL)) {
+    fs_async_req_t* req = fs_async_pick(async);
+
+    if (req == NULL) {
+      tk_mutex_unlock(async->mutex);
+      tk_semaphore_wait(async->sem, 0xffffffff);
+      tk_mutex_lock(async->mutex);
+      continue;
+    }
+
+    worker->busy = fs_async_req_key(req);
+    tk_mutex_unlock(async->mutex);
+
+    fs_async_req_exec(async, req);
+    fs_async_req_complete(req);
+
+    tk_mutex_lock(async->mutex);
+    worker->busy = NULL;
+    if (async->first != NULL) {
+      /*该文件后续的请求可能在等待，唤醒其它工作线程。*/
+      tk_semaphore_post(async->sem);
+    }
+  }
+  tk_mutex_unlock(async->mutex);
+
+  /*让其它等待的线程也能看到退出标志。*/
+  tk_semaphore_post(async->sem);
+
+  return NULL;
+}
+#endif /*WITH_FS_MT*/
+
+fs_async_t* fs_async_create(fs_t* fs, uint32_t workers_nr) {
+  fs_async_t* async = NULL;
+  return_value_if_fail(fs != NULL, NULL);
+
+  async = TKMEM_ZALLOC(fs_async_t);
+  return_value_if_fail(async != NULL, NULL);
+
+  async->fs = fs;
+#ifdef WITH_FS_MT
+  if (workers_nr > 0) {
+    uint32_t i = 0;
+
+    async->workers_nr = workers_nr;
+    async->mutex = tk_mutex_create();
+    async->sem = tk_semaphore_create(0, NULL);
+    async->workers = TKMEM_ZALLOCN(fs_async_worker_t, workers_nr);
+    if (async->mutex == NULL || async->sem == NULL || async->workers == NULL) {
+      fs_async_destroy(async);
+      return NULL;
+    }
+
+    for (i = 0; i < workers_nr; i++) {
+      fs_async_worker_t* worker = async->workers + i;
+
+      worker->async = async;
+      worker->thread = tk_thread_create(fs_async_worker_main, worker);
+      if (worker->thread == NULL) {
+        fs_async_destroy(async);
+        return NULL;
+      }
+
+      tk_thread_set_name(worker->thread, "fs_async");
+      if (tk_thread_start(worker->thread) != RET_OK) {
+        tk_thread_destroy(worker->thread);
+        worker->thread = NULL;
+        fs_async_destroy(async);
+        return NULL;
+      }
+    }
+  }
+#endif /*WITH_FS_MT*/
+
+  return async;
+}
+
+static fs_async_req_t* fs_async_req_create(fs_async_t* async, fs_async_req_type_t type,
+                                           fs_async_on_done_t on_done, void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(async != NULL, NULL);
+
+  req = TKMEM_ZALLOC(fs_async_req_t);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->type = type;
+  req->ret = RET_FAIL;
+  req->size = -1;
+  req->on_done = on_done;
+  req->ctx = ctx;
+  req->submit_us = time_now_us();
+
+#ifdef WITH_FS_MT
+  if (on_done == NULL) {
+    req->done_sem = tk_semaphore_create(0, NULL);
+    if (req->done_sem == NULL) {
+      TKMEM_FREE(req);
+      return NULL;
+    }
+  }
+#endif /*WITH_FS_MT*/
+
+  return req;
+}
+
+/*有回调函数时，请求对象在执行完成后被自动销毁，返回值只用于表示提交成功。*/
+static fs_async_req_t* fs_async_submit(fs_async_t* async, fs_async_req_t* req) {
+  return_value_if_fail(req != NULL, NULL);
+
+#ifdef WITH_FS_MT
+  if (async->workers_nr > 0) {
+    tk_mutex_lock(async->mutex);
+    if (async->last == NULL) {
+      async->first = req;
+    } else {
+      async->last->next = req;
+    }
+    async->last = req;
+    tk_mutex_unlock(async->mutex);
+    tk_semaphore_post(async->sem);
+
+    return req;
+  }
+#endif /*WITH_FS_MT*/
+
+  fs_async_req_exec(async, req);
+  fs_async_req_complete(req);
+
+  return req;
+}
+
+fs_async_req_t* fs_async_open(fs_async_t* async, const char* name, const char* mode,
+                              fs_async_on_done_t on_done, void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(name != NULL && mode != NULL && strlen(mode) < sizeof(req->mode), NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_OPEN, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->name = tk_strdup(name);
+  tk_strncpy(req->mode, mode, sizeof(req->mode) - 1);
+  if (req->name == NULL) {
+    fs_async_req_destroy(req);
+    return NULL;
+  }
+
+  return fs_async_submit(async, req);
+}
+
+fs_async_req_t* fs_async_read(fs_async_t* async, fs_file_t* file, void* buffer, uint32_t size,
+                              fs_async_on_done_t on_done, void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(file != NULL && buffer != NULL, NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_READ, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->file = file;
+  req->buffer = buffer;
+  req->capacity = size;
+
+  return fs_async_submit(async, req);
+}
+
+fs_async_req_t* fs_async_write(fs_async_t* async, fs_file_t* file, const void* buffer,
+                               uint32_t size, fs_async_on_done_t on_done, void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(file != NULL && buffer != NULL, NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_WRITE, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->file = file;
+  req->buffer = (void*)buffer;
+  req->capacity = size;
+
+  return fs_async_submit(async, req);
+}
+
+fs_async_req_t* fs_async_sync(fs_async_t* async, fs_file_t* file, fs_async_on_done_t on_done,
+                              void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(file != NULL, NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_SYNC, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->file = file;
+
+  return fs_async_submit(async, req);
+}
+
+fs_async_req_t* fs_async_close(fs_async_t* async, fs_file_t* file, fs_async_on_done_t on_done,
+                               void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(file != NULL, NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_CLOSE, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->file = file;
+
+  return fs_async_submit(async, req);
+}
+
+fs_async_req_t* fs_async_stat(fs_async_t* async, const char* name, fs_async_on_done_t on_done,
+                              void* ctx) {
+  fs_async_req_t* req = NULL;
+  return_value_if_fail(name != NULL, NULL);
+
+  req = fs_async_req_create(async, FS_ASYNC_REQ_STAT, on_done, ctx);
+  return_value_if_fail(req != NULL, NULL);
+
+  req->name = tk_strdup(name);
+  if (req->name == NULL) {
+    fs_async_req_destroy(req);
+    return NULL;
+  }
+
+  return fs_async_submit(async, req);
+}
+
+ret_t fs_async_req_wait(fs_async_req_t* req, uint32_t timeout_ms) {
+  return_value_if_fail(req != NULL && req->on_done == NULL, RET_BAD_PARAMS);
+
+#ifdef WITH_FS_MT
+  return tk_semaphore_wait(req->done_sem, timeout_ms);
+#else
+  return RET_OK;
+#endif /*WITH_FS_MT*/
+}
+
+ret_t fs_async_req_destroy(fs_async_req_t* req) {
+  return_value_if_fail(req != NULL, RET_BAD_PARAMS);
+
+#ifdef WITH_FS_MT
+  if (req->done_sem != NULL) {
+    tk_semaphore_destroy(req->done_sem);
+  }
+#endif /*WITH_FS_MT*/
+  TKMEM_FREE(req->name);
+  TKMEM_FREE(req);
+
+  return RET_OK;
+}
+
+ret_t fs_async_destroy(fs_async_t* async) {
+  return_value_if_fail(async != NULL, RET_BAD_PARAMS);
+
+#ifdef WITH_FS_MT
+  if (async->workers != NULL && async->mutex != NULL && async->sem != NULL) {
+    uint32_t i = 0;
+
+    tk_mutex_lock(async->mutex);
+    async->quit = TRUE;
+    tk_mutex_unlock(async->mutex);
+    tk_semaphore_post(async->sem);
+
+    for (i = 0; i < async->workers_nr; i++) {
+      tk_thread_t* thread = async->workers[i].thread;
+      if (thread != NULL) {
+        tk_thread_join(thread);
+        tk_thread_destroy(thread);
+      }
+    }
+  }
+
+  TKMEM_FREE(async->workers);
+  if (async->sem != NULL) {
+    tk_semaphore_destroy(async->sem);
+  }
+  if (async->mutex != NULL) {
+    tk_mutex_destroy(async->mutex);
+  }
+#endif /*WITH_FS_MT*/
+  TKMEM_FREE(async);
+
+  return RET_OK;
+}
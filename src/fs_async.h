@@ -0,0 +1,286 @@
+/**
+ * File:   fs_async.h
+ * Author: AWTK Develop Team
+ * Brief:  asynchronous fs requests executed by a worker pool
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_ASYNC_H
+#define TK_FS_ASYNC_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * @enum fs_async_req_type_t
+ * @prefix FS_ASYNC_REQ_
+ * 异步请求的类型。
+ */
+typedef enum _fs_async_req_type_t {
+  /**
+   * @const FS_ASYNC_REQ_OPEN
+   * 打开文件。
+   */
+  FS_ASYNC_REQ_OPEN = 0,
+  /**
+   * @const FS_ASYNC_REQ_READ
+   * 读取数据。
+   */
+  FS_ASYNC_REQ_READ,
+  /**
+   * @const FS_ASYNC_REQ_WRITE
+   * 写入数据。
+   */
+  FS_ASYNC_REQ_WRITE,
+  /**
+   * @const FS_ASYNC_REQ_SYNC
+   * 同步文件。
+   */
+  FS_ASYNC_REQ_SYNC,
+  /**
+   * @const FS_ASYNC_REQ_CLOSE
+   * 关闭文件。
+   */
+  FS_ASYNC_REQ_CLOSE,
+  /**
+   * @const FS_ASYNC_REQ_STAT
+   * 获取文件信息。
+   */
+  FS_ASYNC_REQ_STAT
+} fs_async_req_type_t;
+
+struct _fs_async_req_t;
+typedef struct _fs_async_req_t fs_async_req_t;
+
+/**
+ * 请求完成的回调函数，在工作线程中调用。
+ * 回调函数返回后请求对象会被自动销毁。
+ */
+typedef ret_t (*fs_async_on_done_t)(void* ctx, fs_async_req_t* req);
+
+/**
+ * @class fs_async_req_t
+ * 异步请求。
+ *
+ * 请求完成后(回调函数中或者fs_async_req_wait返回RET_OK后)可以读取结果。
+ */
+struct _fs_async_req_t {
+  /**
+   * @property {fs_async_req_type_t} type
+   * @annotation ["readable"]
+   * 请求的类型。
+   */
+  fs_async_req_type_t type;
+  /**
+   * @property {fs_file_t*} file
+   * @annotation ["readable"]
+   * 操作的文件。FS_ASYNC_REQ_OPEN请求完成后为打开的文件(失败时为NULL)。
+   */
+  fs_file_t* file;
+  /**
+   * @property {ret_t} ret
+   * @annotation ["readable"]
+   * 执行结果。
+   */
+  ret_t ret;
+  /**
+   * @property {int32_t} size
+   * @annotation ["readable"]
+   * 读写请求实际读写的字节数(失败时为-1)。
+   */
+  int32_t size;
+  /**
+   * @property {fs_stat_info_t} stat
+   * @annotation ["readable"]
+   * FS_ASYNC_REQ_STAT请求的结果。
+   */
+  fs_stat_info_t stat;
+  /**
+   * @property {uint64_t} submit_us
+   * @annotation ["readable"]
+   * 提交的时间(微秒)。
+   */
+  uint64_t submit_us;
+  /**
+   * @property {uint64_t} start_us
+   * @annotation ["readable"]
+   * 开始执行的时间(微秒)。
+   */
+  uint64_t start_us;
+  /**
+   * @property {uint64_t} done_us
+   * @annotation ["readable"]
+   * 执行完成的时间(微秒)。
+   */
+  uint64_t done_us;
+
+  /*private*/
+  void* buffer;
+  uint32_t capacity;
+  char* name;
+  char mode[8];
+  fs_async_on_done_t on_done;
+  void* ctx;
+  struct _tk_semaphore_t* done_sem;
+  fs_async_req_t* next;
+};
+
+/**
+ * @class fs_async_t
+ * 异步fs。
+ *
+ * 请求放入队列，由工作线程执行，调用者(如GUI线程)不会因为底层文件系统耗时的操作(如spiffs的垃圾回收)而阻塞。
+ * 同一个文件的请求按提交的顺序依次执行，不同文件的请求可以由不同的工作线程并行执行。
+ *
+ * 请求有两种使用方式：
+ * * 指定on_done：请求完成后在工作线程中调用on_done，然后自动销毁请求，调用者不能再使用提交函数返回的对象。
+ * * on_done为NULL：调用者用fs_async_req_wait等待请求完成，读取结果后调用fs_async_req_destroy销毁请求。
+ *
+ * > 有多个工作线程，或者其它线程也会直接调用fs时，fs需要是线程安全的(经过fs_mt_wrap包装)。
+ * > 没有定义WITH_FS_MT时，请求在调用者的线程中立即执行。
+ */
+typedef struct _fs_async_t fs_async_t;
+
+/**
+ * @method fs_async_create
+ * 创建异步fs。
+ * @annotation ["constructor"]
+ * @param {fs_t*} fs 执行请求的fs对象。
+ * @param {uint32_t} workers_nr 工作线程的个数，为0时在调用者的线程中立即执行请求。
+ *
+ * @return {fs_async_t*} 返回异步fs对象。
+ */
+fs_async_t* fs_async_create(fs_t* fs, uint32_t workers_nr);
+
+/**
+ * @method fs_async_open
+ * 提交打开文件的请求。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {const char*} name 文件名。
+ * @param {const char*} mode 打开方式。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_open(fs_async_t* async, const char* name, const char* mode,
+                              fs_async_on_done_t on_done, void* ctx);
+
+/**
+ * @method fs_async_read
+ * 提交读取数据的请求。
+ * > 请求完成前buffer必须保持有效。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {fs_file_t*} file 文件对象。
+ * @param {void*} buffer 用于返回数据的缓冲区。
+ * @param {uint32_t} size 缓冲区大小。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_read(fs_async_t* async, fs_file_t* file, void* buffer, uint32_t size,
+                              fs_async_on_done_t on_done, void* ctx);
+
+/**
+ * @method fs_async_write
+ * 提交写入数据的请求。
+ * > 请求完成前buffer必须保持有效。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const void*} buffer 数据缓冲区。
+ * @param {uint32_t} size 数据长度。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_write(fs_async_t* async, fs_file_t* file, const void* buffer,
+                               uint32_t size, fs_async_on_done_t on_done, void* ctx);
+
+/**
+ * @method fs_async_sync
+ * 提交同步文件的请求。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {fs_file_t*} file 文件对象。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_sync(fs_async_t* async, fs_file_t* file, fs_async_on_done_t on_done,
+                              void* ctx);
+
+/**
+ * @method fs_async_close
+ * 提交关闭文件的请求。
+ * > 在该文件之前提交的请求都执行完成后才关闭文件，之后不能再提交该文件的请求。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {fs_file_t*} file 文件对象。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_close(fs_async_t* async, fs_file_t* file, fs_async_on_done_t on_done,
+                               void* ctx);
+
+/**
+ * @method fs_async_stat
+ * 提交获取文件信息的请求。
+ * @param {fs_async_t*} async 异步fs对象。
+ * @param {const char*} name 文件名。
+ * @param {fs_async_on_done_t} on_done 完成时的回调函数(可以为NULL)。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {fs_async_req_t*} 返回请求对象，失败返回NULL。
+ */
+fs_async_req_t* fs_async_stat(fs_async_t* async, const char* name, fs_async_on_done_t on_done,
+                              void* ctx);
+
+/**
+ * @method fs_async_req_wait
+ * 等待请求完成(只用于on_done为NULL的请求)。
+ * @param {fs_async_req_t*} req 请求对象。
+ * @param {uint32_t} timeout_ms 超时时间(毫秒)，0xffffffff表示一直等待。
+ *
+ * @return {ret_t} 返回RET_OK表示请求已经完成，RET_TIMEOUT表示超时。
+ */
+ret_t fs_async_req_wait(fs_async_req_t* req, uint32_t timeout_ms);
+
+/**
+ * @method fs_async_req_destroy
+ * 销毁请求对象(只用于on_done为NULL的请求，必须在请求完成后调用)。
+ * @param {fs_async_req_t*} req 请求对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_async_req_destroy(fs_async_req_t* req);
+
+/**
+ * @method fs_async_destroy
+ * 执行完队列中所有的请求，然后销毁异步fs对象。
+ * @param {fs_async_t*} async 异步fs对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_async_destroy(fs_async_t* async);
+
+END_C_DECLS
+
+#endif /*TK_FS_ASYNC_H*/
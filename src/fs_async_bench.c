@@ -0,0 +1,115 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "spiffs/spiffs.h"
+#include "fs_async.h"
+#include "fs_latency.h"
+
+#define FLASH_SIZE (128 * 1024)
+#define FILES_NR 4
+#define ROUNDS_NR 200
+#define RECORDS_NR 64
+#define RECORD_SIZE 64
+
+extern fs_t* os_fs_spiffs(void);
+extern ret_t os_fs_spiffs_set(spiffs* fs);
+s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size);
+
+static uint8_t s_record[RECORD_SIZE];
+
+/*只有一个工作线程，回调函数不会并发执行。*/
+static ret_t on_write_done(void* ctx, fs_async_req_t* req) {
+  fs_latency_t* done = (fs_latency_t*)ctx;
+
+  assert(req->size == RECORD_SIZE);
+  fs_latency_add(done, req->done_us - req->submit_us);
+
+  return RET_OK;
+}
+
+static void latency_dump(const char* path, fs_latency_t* latency) {
+  log_debug("%s\t%llu\t%llu\t%llu\t%llu\t%llu\n", path, (unsigned long long)latency->count,
+            (unsigned long long)fs_latency_avg(latency),
+            (unsigned long long)fs_latency_percentile(latency, 500),
+            (unsigned long long)fs_latency_percentile(latency, 990),
+            (unsigned long long)latency->max);
+}
+
+/*
+ * 反复重写几个日志文件，旧的页面被删除，空间用完后spiffs在写入时做垃圾回收。
+ * 统计调用者(如GUI线程)被阻塞的时间。
+ */
+static void bench(fs_t* fs, fs_async_t* async) {
+  uint32_t i = 0;
+  uint32_t r = 0;
+  fs_latency_t caller;
+  fs_latency_t done;
+  char filename[MAX_PATH + 1];
+
+  fs_latency_init(&caller);
+  fs_latency_init(&done);
+  for (r = 0; r < ROUNDS_NR; r++) {
+    fs_file_t* fp = NULL;
+
+    tk_snprintf(filename, MAX_PATH, "log%u.bin", r % FILES_NR);
+    fp = fs_open_file(fs, filename, "wb");
+    assert(fp != NULL);
+
+    for (i = 0; i < RECORDS_NR; i++) {
+      uint64_t start = time_now_us();
+      if (async == NULL) {
+        assert(fs_file_write(fp, s_record, sizeof(s_record)) == sizeof(s_record));
+      } else {
+        assert(fs_async_write(async, fp, s_record, sizeof(s_record), on_write_done, &done) != NULL);
+      }
+      fs_latency_add(&caller, time_now_us() - start);
+    }
+
+    if (async == NULL) {
+      fs_file_close(fp);
+    } else {
+      fs_async_req_t* req = fs_async_close(async, fp, NULL, NULL);
+      assert(req != NULL && fs_async_req_wait(req, 0xffffffff) == RET_OK);
+      fs_async_req_destroy(req);
+    }
+  }
+
+  latency_dump(async == NULL ? "sync" : "async(caller)", &caller);
+  if (async != NULL) {
+    latency_dump("async(done)", &done);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  spiffs myfs;
+  fs_t* fs = NULL;
+  fs_async_t* async = NULL;
+  static uint8_t flash[FLASH_SIZE];
+
+  platform_prepare();
+  memset(s_record, 'r', sizeof(s_record));
+  memset(flash, 0xff, sizeof(flash));
+  if (fs_mount_ram(&myfs, flash, sizeof(flash)) != 0) {
+    assert(SPIFFS_format(&myfs) == 0);
+    assert(fs_mount_ram(&myfs, flash, sizeof(flash)) == 0);
+  }
+  os_fs_spiffs_set(&myfs);
+  fs = os_fs_spiffs();
+
+  log_debug("path\tcalls\tavg_us\tp50_us\tp99_us\tmax_us\n");
+  bench(fs, NULL);
+
+  async = fs_async_create(fs, 1);
+  assert(async != NULL);
+  bench(fs, async);
+  fs_async_destroy(async);
+
+  log_debug("gc runs: %u\n", (unsigned)myfs.stats_gc_runs);
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/mutex.h"
+#include "tkc/platform.h"
+#include "fs_async.h"
+#include "fs_latency.h"
+
+#define FILES_NR 4
+#define RECORDS_NR 200
+#define RECORD_SIZE 6
+
+extern fs_t* os_fs_posix(void);
+
+typedef struct _test_ctx_t {
+  tk_mutex_t* mutex;
+  uint32_t done;
+  uint32_t failed;
+} test_ctx_t;
+
+static ret_t on_write_done(void* ctx, fs_async_req_t* req) {
+  test_ctx_t* test = (test_ctx_t*)ctx;
+
+  tk_mutex_lock(test->mutex);
+  test->done++;
+  if (req->ret != RET_OK || req->size != RECORD_SIZE) {
+    test->failed++;
+  }
+  tk_mutex_unlock(test->mutex);
+
+  return RET_OK;
+}
+
+static void test_basic(fs_t* fs, uint32_t workers_nr) {
+  char buff[32];
+  fs_file_t* file = NULL;
+  fs_async_req_t* req = NULL;
+  fs_async_t* async = fs_async_create(fs, workers_nr);
+  assert(async != NULL);
+
+  req = fs_async_open(async, "async.txt", "wb+", NULL, NULL);
+  assert(req != NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK);
+  assert(req->ret == RET_OK && req->file != NULL);
+  file = req->file;
+  fs_async_req_destroy(req);
+
+  req = fs_async_write(async, file, "hello", 5, NULL, NULL);
+  assert(req != NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK);
+  assert(req->ret == RET_OK && req->size == 5);
+  assert(req->submit_us <= req->start_us && req->start_us <= req->done_us);
+  fs_async_req_destroy(req);
+
+  req = fs_async_sync(async, file, NULL, NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK && req->ret == RET_OK);
+  fs_async_req_destroy(req);
+
+  assert(fs_file_seek(file, 0) == RET_OK);
+  memset(buff, 0x00, sizeof(buff));
+  req = fs_async_read(async, file, buff, sizeof(buff), NULL, NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK);
+  assert(req->size == 5 && strcmp(buff, "hello") == 0);
+  fs_async_req_destroy(req);
+
+  req = fs_async_close(async, file, NULL, NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK && req->ret == RET_OK);
+  fs_async_req_destroy(req);
+
+  req = fs_async_stat(async, "async.txt", NULL, NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK);
+  assert(req->ret == RET_OK && req->stat.size == 5);
+  fs_async_req_destroy(req);
+
+  req = fs_async_open(async, "not_exist/async.txt", "rb", NULL, NULL);
+  assert(fs_async_req_wait(req, 0xffffffff) == RET_OK);
+  assert(req->ret != RET_OK && req->file == NULL);
+  fs_async_req_destroy(req);
+
+  assert(fs_async_destroy(async) == RET_OK);
+  assert(fs_remove_file(fs, "async.txt") == RET_OK);
+}
+
+/*多个文件交错提交，每个文件的写入顺序保持不变。*/
+static void test_order(fs_t* fs, uint32_t workers_nr) {
+  uint32_t i = 0;
+  uint32_t f = 0;
+  test_ctx_t ctx;
+  char filename[MAX_PATH + 1];
+  fs_file_t* files[FILES_NR];
+  static char records[RECORDS_NR][RECORD_SIZE + 1];
+  fs_async_t* async = fs_async_create(fs, workers_nr);
+  assert(async != NULL);
+
+  memset(&ctx, 0x00, sizeof(ctx));
+  ctx.mutex = tk_mutex_create();
+  for (i = 0; i < RECORDS_NR; i++) {
+    tk_snprintf(records[i], sizeof(records[i]), "%05u\n", i);
+  }
+
+  for (f = 0; f < FILES_NR; f++) {
+    tk_snprintf(filename, MAX_PATH, "async%u.txt", f);
+    files[f] = fs_open_file(fs, filename, "wb");
+    assert(files[f] != NULL);
+  }
+
+  for (i = 0; i < RECORDS_NR; i++) {
+    for (f = 0; f < FILES_NR; f++) {
+      assert(fs_async_write(async, files[f], records[i], RECORD_SIZE, on_write_done, &ctx) != NULL);
+    }
+  }
+
+  for (f = 0; f < FILES_NR; f++) {
+    fs_async_req_t* req = fs_async_close(async, files[f], NULL, NULL);
+    assert(fs_async_req_wait(req, 0xffffffff) == RET_OK && req->ret == RET_OK);
+    fs_async_req_destroy(req);
+  }
+  assert(fs_async_destroy(async) == RET_OK);
+  assert(ctx.done == RECORDS_NR * FILES_NR && ctx.failed == 0);
+  tk_mutex_destroy(ctx.mutex);
+
+  for (f = 0; f < FILES_NR; f++) {
+    char buff[RECORD_SIZE];
+    fs_file_t* fp = NULL;
+
+    tk_snprintf(filename, MAX_PATH, "async%u.txt", f);
+    fp = fs_open_file(fs, filename, "rb");
+    assert(fp != NULL);
+    for (i = 0; i < RECORDS_NR; i++) {
+      assert(fs_file_read(fp, buff, RECORD_SIZE) == RECORD_SIZE);
+      assert(memcmp(buff, records[i], RECORD_SIZE) == 0);
+    }
+    fs_file_close(fp);
+    assert(fs_remove_file(fs, filename) == RET_OK);
+  }
+}
+
+static void test_latency(void) {
+  fs_latency_t latency;
+
+  fs_latency_init(&latency);
+  assert(fs_latency_percentile(&latency, 500) == 0);
+  assert(fs_latency_bucket_of(0) == 0);
+  assert(fs_latency_bucket_of(1) == 1);
+  assert(fs_latency_bucket_of(2) == 2);
+  assert(fs_latency_bucket_of(3) == 2);
+  assert(fs_latency_bucket_of(1024) == 11);
+
+  fs_latency_add(&latency, 10);
+  fs_latency_add(&latency, 10);
+  fs_latency_add(&latency, 1000);
+  assert(latency.count == 3 && latency.max == 1000);
+  assert(fs_latency_avg(&latency) == 340);
+  assert(fs_latency_percentile(&latency, 500) == 15);
+  assert(fs_latency_percentile(&latency, 990) == 1000);
+  assert(fs_latency_percentile(&latency, 1000) == 1000);
+}
+
+int main(int argc, char* argv[]) {
+  fs_t* fs = os_fs_posix();
+  platform_prepare();
+
+  test_latency();
+  test_basic(fs, 0);
+  test_basic(fs, 2);
+  test_order(fs, 0);
+  test_order(fs, 1);
+  test_order(fs, 4);
+
+  return 0;
+}
@@ -0,0 +1,663 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "ff.h"
+#include "diskio.h"
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/thread.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "spiffs/spiffs.h"
+#include "fatfs/diskio_cache.h"
+#include "fatfs/diskio_file.h"
+#include "fatfs/diskio_ramdisk.h"
+#include "fs_mt.h"
+#include "fs_latency.h"
+#include "fs_file_ext.h"
+
+/*
+ * 对posix/fatfs/spiffs三种适配器(分别在不加锁和fs_mt_wrap加锁时)运行相同的测试，
+ * 每个测试输出一行JSON，方便脚本收集结果跟踪性能变化：
+ * {"fs":"posix","mt":0,"test":"seq_write","bs":4096,"ops":1024,"bytes":4194304,"us":2000,
+ *  "mb_s":2097.15,"ops_s":512000,"p50_us":1,"p99_us":3}
+ */
+
+#define MAX_BLOCK_SIZE 32768
+#define RAND_BLOCK_SIZE 4096
+#define SMALL_FILE_SIZE 256
+#define MT_THREADS_NR 4
+#define SPIFFS_FLASH_SIZE (1024 * 1024)
+#define FATFS_DISK_SIZE (64 * 1024 * 1024)
+#define FATFS_IMAGE "fs_bench.img"
+#define FATFS_CACHE_SECTORS 64
+
+extern fs_t* os_fs_posix(void);
+extern fs_t* os_fs_fatfs(void);
+extern fs_t* os_fs_spiffs(void);
+extern ret_t os_fs_spiffs_set(spiffs* fs);
+s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size);
+
+typedef struct _bench_fs_t {
+  const char* name;
+  /*格式化并挂载文件系统，每组测试都从空的文件系统开始。*/
+  fs_t* (*mount)(void);
+  void (*unmount)(void);
+  /*测试文件所在的目录，为NULL时不创建目录(spiffs没有目录)。*/
+  const char* dir;
+  /*文件名前缀。*/
+  const char* prefix;
+  /*列目录时使用的路径。*/
+  const char* list;
+  /*顺序读写的文件大小。*/
+  uint32_t file_size;
+  /*顺序读写的最大块大小。spiffs每次写入最多回收SPIFFS_GC_MAX_RUNS个块，一次写入太多会返回空间不足。*/
+  uint32_t max_bs;
+  uint32_t rand_ops;
+  uint32_t small_files;
+  uint32_t mt_ops;
+} bench_fs_t;
+
+typedef struct _bench_result_t {
+  const char* fs;
+  bool_t mt;
+  const char* test;
+  uint32_t bs;
+  uint32_t ops;
+  uint64_t bytes;
+  uint64_t us;
+  fs_latency_t latency;
+} bench_result_t;
+
+typedef struct _bench_thread_ctx_t {
+  fs_file_t* fp;
+  uint32_t id;
+  uint32_t ops;
+  uint32_t region_blocks;
+  fs_t* fs;
+  const char* filename;
+  fs_latency_t latency;
+} bench_thread_ctx_t;
+
+static uint8_t s_buff[MAX_BLOCK_SIZE];
+static uint32_t s_seed = 1;
+
+static uint32_t bench_rand(void) {
+  s_seed = s_seed * 1103515245 + 12345;
+
+  return (s_seed >> 16) & 0x7fff;
+}
+
+static void bench_result_init(bench_result_t* r, const bench_fs_t* bfs, bool_t mt,
+                              const char* test, uint32_t bs) {
+  memset(r, 0x00, sizeof(*r));
+  r->fs = bfs->name;
+  r->mt = mt;
+  r->test = test;
+  r->bs = bs;
+  fs_latency_init(&(r->latency));
+}
+
+static void bench_result_add(bench_result_t* r, uint64_t start, uint32_t bytes) {
+  r->ops++;
+  r->bytes += bytes;
+  fs_latency_add(&(r->latency), time_now_us() - start);
+}
+
+static void bench_result_dump(bench_result_t* r) {
+  uint64_t us = tk_max(r->us, 1);
+
+  printf("{\"fs\":\"%s\",\"mt\":%d,\"test\":\"%s\",\"bs\":%u,\"ops\":%u,\"bytes\":%llu,"
+         "\"us\":%llu,\"mb_s\":%.2f,\"ops_s\":%.0f,\"p50_us\":%llu,\"p99_us\":%llu}\n",
+         r->fs, r->mt ? 1 : 0, r->test, r->bs, r->ops, (unsigned long long)r->bytes,
+         (unsigned long long)r->us, (double)r->bytes / us, (double)r->ops * 1000000 / us,
+         (unsigned long long)fs_latency_percentile(&(r->latency), 500),
+         (unsigned long long)fs_latency_percentile(&(r->latency), 990));
+  fflush(stdout);
+}
+
+static void bench_seq(fs_t* fs, const bench_fs_t* bfs, bool_t mt, uint32_t bs) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  fs_file_t* fp = NULL;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+  uint32_t nr = bfs->file_size / bs;
+
+  tk_snprintf(filename, MAX_PATH, "%sseq.bin", bfs->prefix);
+
+  bench_result_init(&r, bfs, mt, "seq_write", bs);
+  start = time_now_us();
+  fp = fs_open_file(fs, filename, "wb");
+  assert(fp != NULL);
+  for (i = 0; i < nr; i++) {
+    uint64_t op_start = time_now_us();
+    assert(fs_file_write(fp, s_buff, bs) == bs);
+    bench_result_add(&r, op_start, bs);
+  }
+  fs_file_sync(fp);
+  fs_file_close(fp);
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  bench_result_init(&r, bfs, mt, "seq_read", bs);
+  start = time_now_us();
+  fp = fs_open_file(fs, filename, "rb");
+  assert(fp != NULL);
+  for (i = 0; i < nr; i++) {
+    uint64_t op_start = time_now_us();
+    assert(fs_file_read(fp, s_buff, bs) == bs);
+    bench_result_add(&r, op_start, bs);
+  }
+  fs_file_close(fp);
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+}
+
+/*在bench_seq写入的文件中随机读写4K的块。*/
+static void bench_random(fs_t* fs, const bench_fs_t* bfs, bool_t mt) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  fs_file_t* fp = NULL;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+  uint32_t blocks = bfs->file_size / RAND_BLOCK_SIZE;
+
+  tk_snprintf(filename, MAX_PATH, "%sseq.bin", bfs->prefix);
+  fp = fs_open_file(fs, filename, "rb+");
+  assert(fp != NULL);
+
+  bench_result_init(&r, bfs, mt, "rand_read", RAND_BLOCK_SIZE);
+  start = time_now_us();
+  for (i = 0; i < bfs->rand_ops; i++) {
+    uint64_t op_start = time_now_us();
+    assert(fs_file_seek(fp, (bench_rand() % blocks) * RAND_BLOCK_SIZE) == RET_OK);
+    assert(fs_file_read(fp, s_buff, RAND_BLOCK_SIZE) == RAND_BLOCK_SIZE);
+    bench_result_add(&r, op_start, RAND_BLOCK_SIZE);
+  }
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  bench_result_init(&r, bfs, mt, "rand_write", RAND_BLOCK_SIZE);
+  start = time_now_us();
+  for (i = 0; i < bfs->rand_ops; i++) {
+    uint64_t op_start = time_now_us();
+    assert(fs_file_seek(fp, (bench_rand() % blocks) * RAND_BLOCK_SIZE) == RET_OK);
+    assert(fs_file_write(fp, s_buff, RAND_BLOCK_SIZE) == RAND_BLOCK_SIZE);
+    bench_result_add(&r, op_start, RAND_BLOCK_SIZE);
+  }
+  fs_file_sync(fp);
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  fs_file_close(fp);
+}
+
+/*创建/列目录/删除大量的小文件。*/
+static void bench_small_files(fs_t* fs, const bench_fs_t* bfs, bool_t mt) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+
+  bench_result_init(&r, bfs, mt, "small_create", SMALL_FILE_SIZE);
+  start = time_now_us();
+  for (i = 0; i < bfs->small_files; i++) {
+    fs_file_t* fp = NULL;
+    uint64_t op_start = time_now_us();
+
+    tk_snprintf(filename, MAX_PATH, "%ss%u.bin", bfs->prefix, i);
+    fp = fs_open_file(fs, filename, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, s_buff, SMALL_FILE_SIZE) == SMALL_FILE_SIZE);
+    fs_file_close(fp);
+    bench_result_add(&r, op_start, SMALL_FILE_SIZE);
+  }
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  bench_result_init(&r, bfs, mt, "dir_list", 0);
+  start = time_now_us();
+  for (i = 0; i < 16; i++) {
+    fs_item_t item;
+    uint32_t nr = 0;
+    uint64_t op_start = time_now_us();
+    fs_dir_t* dir = fs_open_dir(fs, bfs->list);
+    assert(dir != NULL);
+
+    while (fs_dir_read(dir, &item) == RET_OK && item.name[0] != '\0') {
+      nr++;
+    }
+    fs_dir_close(dir);
+    assert(nr >= bfs->small_files);
+    bench_result_add(&r, op_start, 0);
+  }
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  bench_result_init(&r, bfs, mt, "small_remove", 0);
+  start = time_now_us();
+  for (i = 0; i < bfs->small_files; i++) {
+    uint64_t op_start = time_now_us();
+
+    tk_snprintf(filename, MAX_PATH, "%ss%u.bin", bfs->prefix, i);
+    assert(fs_remove_file(fs, filename) == RET_OK);
+    bench_result_add(&r, op_start, 0);
+  }
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+}
+
+/*多个线程共用一个文件句柄，在各自的区域中交替pwrite/pread，并查询文件信息。*/
+static void* bench_mt_thread(void* args) {
+  uint32_t i = 0;
+  uint8_t buff[RAND_BLOCK_SIZE];
+  fs_stat_info_t st;
+  bench_thread_ctx_t* ctx = (bench_thread_ctx_t*)args;
+  uint64_t base = (uint64_t)ctx->id * ctx->region_blocks * RAND_BLOCK_SIZE;
+
+  memset(buff, ctx->id, sizeof(buff));
+  for (i = 0; i < ctx->ops; i++) {
+    uint64_t start = time_now_us();
+    uint64_t offset = base + (i % ctx->region_blocks) * RAND_BLOCK_SIZE;
+
+    switch (i % 3) {
+      case 0: {
+        assert(fs_file_pwrite(ctx->fp, buff, sizeof(buff), offset) == sizeof(buff));
+        break;
+      }
+      case 1: {
+        assert(fs_file_pread(ctx->fp, buff, sizeof(buff), offset) == sizeof(buff));
+        break;
+      }
+      default: {
+        assert(fs_stat(ctx->fs, ctx->filename, &st) == RET_OK);
+        break;
+      }
+    }
+    fs_latency_add(&(ctx->latency), time_now_us() - start);
+  }
+
+  return NULL;
+}
+
+static void bench_mt_mix(fs_t* fs, const bench_fs_t* bfs) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  fs_file_t* fp = NULL;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+  bench_thread_ctx_t ctx[MT_THREADS_NR];
+  tk_thread_t* threads[MT_THREADS_NR];
+
+  tk_snprintf(filename, MAX_PATH, "%sseq.bin", bfs->prefix);
+  fp = fs_open_file(fs, filename, "rb+");
+  assert(fp != NULL);
+
+  bench_result_init(&r, bfs, TRUE, "mt_mix", RAND_BLOCK_SIZE);
+  start = time_now_us();
+  for (i = 0; i < MT_THREADS_NR; i++) {
+    memset(ctx + i, 0x00, sizeof(ctx[i]));
+    ctx[i].fp = fp;
+    ctx[i].fs = fs;
+    ctx[i].id = i;
+    ctx[i].ops = bfs->mt_ops;
+    ctx[i].filename = filename;
+    ctx[i].region_blocks = bfs->file_size / RAND_BLOCK_SIZE / MT_THREADS_NR;
+    fs_latency_init(&(ctx[i].latency));
+    threads[i] = tk_thread_create(bench_mt_thread, ctx + i);
+    tk_thread_set_stack_size(threads[i], 0xc000);
+    tk_thread_start(threads[i]);
+  }
+
+  for (i = 0; i < MT_THREADS_NR; i++) {
+    tk_thread_join(threads[i]);
+    tk_thread_destroy(threads[i]);
+    fs_latency_merge(&(r.latency), &(ctx[i].latency));
+    r.ops += ctx[i].ops;
+    r.bytes += (uint64_t)(ctx[i].ops - ctx[i].ops / 3) * RAND_BLOCK_SIZE;
+  }
+  r.us = time_now_us() - start;
+  bench_result_dump(&r);
+
+  fs_file_close(fp);
+}
+
+/*spiffs的文件描述符有限，每次追加日志都重新打开。*/
+static void bench_append_log(fs_t* fs, const char* logname) {
+  fs_file_t* log = fs_open_file(fs, logname, "a");
+
+  assert(log != NULL);
+  assert(fs_file_write(log, s_buff, SMALL_FILE_SIZE) == SMALL_FILE_SIZE);
+  fs_file_close(log);
+}
+
+/*
+ * 录像等定长的文件和日志交替写入(日志每次追加一小段)，比较不预先分配和用fs_file_allocate
+ * 预先分配时的顺序写入和之后读取的速度。不预先分配时，fatfs逐簇分配，两个文件的簇交错在一起。
+ */
+static void bench_prealloc(fs_t* fs, const bench_fs_t* bfs, bool_t mt) {
+  uint32_t i = 0;
+  uint32_t k = 0;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+  char logname[MAX_PATH + 1];
+  uint32_t bs = bfs->max_bs;
+  uint32_t nr = bfs->file_size / bs;
+  static const char* s_tests[2][2] = {{"interleave_write", "interleave_read"},
+                                      {"prealloc_write", "prealloc_read"}};
+
+  tk_snprintf(filename, MAX_PATH, "%scapture.bin", bfs->prefix);
+  tk_snprintf(logname, MAX_PATH, "%scapture.log", bfs->prefix);
+  for (k = 0; k < 2; k++) {
+    uint64_t start = time_now_us();
+    fs_file_t* fp = fs_open_file(fs, filename, "wb");
+    assert(fp != NULL);
+
+    bench_result_init(&r, bfs, mt, s_tests[k][0], bs);
+    if (k == 1) {
+      assert(fs_file_allocate(fp, bfs->file_size) == RET_OK);
+    }
+    for (i = 0; i < nr; i++) {
+      uint64_t op_start = time_now_us();
+      assert(fs_file_write(fp, s_buff, bs) == bs);
+      bench_result_add(&r, op_start, bs);
+      bench_append_log(fs, logname);
+    }
+    fs_file_sync(fp);
+    fs_file_close(fp);
+    r.us = time_now_us() - start;
+    bench_result_dump(&r);
+
+    bench_result_init(&r, bfs, mt, s_tests[k][1], bs);
+    start = time_now_us();
+    fp = fs_open_file(fs, filename, "rb");
+    assert(fp != NULL && fs_file_size(fp) == bfs->file_size);
+    for (i = 0; i < nr; i++) {
+      uint64_t op_start = time_now_us();
+      assert(fs_file_read(fp, s_buff, bs) == bs);
+      bench_result_add(&r, op_start, bs);
+    }
+    fs_file_close(fp);
+    r.us = time_now_us() - start;
+    bench_result_dump(&r);
+
+    assert(fs_remove_file(fs, filename) == RET_OK);
+    assert(fs_remove_file(fs, logname) == RET_OK);
+  }
+}
+
+/*把日志段的前size个字节复制到新文件，再用新文件替换日志段(不能截断时的做法)。*/
+static uint32_t bench_shrink_by_copy(fs_t* fs, const bench_fs_t* bfs, const char* filename,
+                                     uint32_t size) {
+  uint32_t done = 0;
+  char tmpname[MAX_PATH + 1];
+  fs_file_t* from = fs_open_file(fs, filename, "rb");
+  fs_file_t* to = NULL;
+
+  tk_snprintf(tmpname, MAX_PATH, "%ssegment.tmp", bfs->prefix);
+  to = fs_open_file(fs, tmpname, "wb");
+  assert(from != NULL && to != NULL);
+  assert(fs_file_allocate(to, size) == RET_OK);
+  while (done < size) {
+    uint32_t n = tk_min(size - done, bfs->max_bs);
+    assert(fs_file_read(from, s_buff, n) == n);
+    assert(fs_file_write(to, s_buff, n) == n);
+    done += n;
+  }
+  fs_file_close(from);
+  fs_file_close(to);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+  assert(fs_file_rename(fs, tmpname, filename) == RET_OK);
+
+  return done;
+}
+
+/*
+ * 日志分段写入：每段先用fs_file_allocate预先分配，写入四分之三左右时切换到下一段，
+ * 切换时把当前段缩小到实际写入的大小。比较复制到新文件和用fs_file_truncate截断两种缩小方式，
+ * ops为切换的次数，bytes为切换时复制的字节数，延迟为每次切换的时间。
+ */
+static void bench_log_rotate(fs_t* fs, const bench_fs_t* bfs, bool_t mt) {
+  uint32_t i = 0;
+  uint32_t k = 0;
+  uint32_t seg = 0;
+  bench_result_t r;
+  char filename[MAX_PATH + 1];
+  uint32_t seg_size = bfs->file_size / 4;
+  static const char* s_tests[2] = {"rotate_copy", "rotate_truncate"};
+
+  for (k = 0; k < 2; k++) {
+    uint64_t start = time_now_us();
+
+    bench_result_init(&r, bfs, mt, s_tests[k], SMALL_FILE_SIZE);
+    for (seg = 0; seg < 4; seg++) {
+      uint32_t written = 0;
+      uint64_t op_start = 0;
+      fs_file_t* fp = NULL;
+
+      tk_snprintf(filename, MAX_PATH, "%ssegment.%u", bfs->prefix, seg);
+      fp = fs_open_file(fs, filename, "wb");
+      assert(fp != NULL);
+      assert(fs_file_allocate(fp, seg_size) == RET_OK);
+      for (i = 0; written < seg_size / 4 * 3 + seg * 100; i++) {
+        uint32_t n = SMALL_FILE_SIZE - (i % 7);
+        assert(fs_file_write(fp, s_buff, n) == n);
+        written += n;
+      }
+
+      op_start = time_now_us();
+      if (k == 0) {
+        fs_file_close(fp);
+        r.bytes += bench_shrink_by_copy(fs, bfs, filename, written);
+      } else {
+        assert(fs_file_truncate(fp, written) == RET_OK);
+        fs_file_close(fp);
+      }
+      bench_result_add(&r, op_start, 0);
+
+      fp = fs_open_file(fs, filename, "rb");
+      assert(fp != NULL && fs_file_size(fp) == written);
+      fs_file_close(fp);
+    }
+    r.us = time_now_us() - start;
+    bench_result_dump(&r);
+
+    for (seg = 0; seg < 4; seg++) {
+      tk_snprintf(filename, MAX_PATH, "%ssegment.%u", bfs->prefix, seg);
+      assert(fs_remove_file(fs, filename) == RET_OK);
+    }
+  }
+}
+
+static void bench_run(fs_t* fs, const bench_fs_t* bfs, bool_t mt) {
+  uint32_t bs = 0;
+  char filename[MAX_PATH + 1];
+
+  if (bfs->dir != NULL && !fs_dir_exist(fs, bfs->dir)) {
+    assert(fs_create_dir(fs, bfs->dir) == RET_OK);
+  }
+
+  for (bs = 512; bs <= bfs->max_bs; bs *= 8) {
+    bench_seq(fs, bfs, mt, bs);
+  }
+  bench_random(fs, bfs, mt);
+  bench_small_files(fs, bfs, mt);
+  if (mt) {
+    bench_mt_mix(fs, bfs);
+  }
+  bench_prealloc(fs, bfs, mt);
+  bench_log_rotate(fs, bfs, mt);
+
+  tk_snprintf(filename, MAX_PATH, "%sseq.bin", bfs->prefix);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+  if (bfs->dir != NULL) {
+    assert(fs_remove_dir(fs, bfs->dir) == RET_OK);
+  }
+}
+
+static FATFS s_fatfs;
+static spiffs s_spiffs;
+static uint8_t s_flash[SPIFFS_FLASH_SIZE];
+
+/*RAM disk的内存在第一次写入时才真正分配(缺页)，先整个写一遍，避免测试结果受簇位置的影响。*/
+static void bench_fatfs_touch(void) {
+  DWORD sector = 0;
+  DWORD nr = sizeof(s_buff) / FF_MAX_SS;
+
+  for (sector = 0; sector < FATFS_DISK_SIZE / FF_MAX_SS; sector += nr) {
+    assert(disk_write(0, s_buff, sector, nr) == RES_OK);
+  }
+}
+
+static fs_t* bench_fatfs_mount(void) {
+  BYTE work[FF_MAX_SS];
+
+  assert(ramdisk_create(0, FATFS_DISK_SIZE / FF_MAX_SS, FF_MAX_SS) == RES_OK);
+  bench_fatfs_touch();
+  assert(f_mkfs("0:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&s_fatfs, "0:", 0) == FR_OK);
+
+  return os_fs_fatfs();
+}
+
+static void bench_fatfs_unmount(void) {
+  assert(f_mount(0, "0:", 0) == FR_OK);
+  assert(ramdisk_destroy(0) == RES_OK);
+}
+
+#if defined(LINUX) || defined(MACOS)
+/*fatfs运行在主机的映像文件上，结束时输出一行diskio的统计，观察FatFs合并扇区读写的效果。*/
+static fs_t* bench_fatfs_file_mount(void) {
+  BYTE work[FF_MAX_SS];
+
+  remove(FATFS_IMAGE);
+  assert(diskio_file_open(0, FATFS_IMAGE, FATFS_DISK_SIZE / FF_MAX_SS, FF_MAX_SS, 0) == RES_OK);
+  assert(f_mkfs("0:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&s_fatfs, "0:", 0) == FR_OK);
+  assert(diskio_file_reset_stats(0) == RES_OK);
+
+  return os_fs_fatfs();
+}
+
+static void bench_print_diskio(const char* name) {
+  diskio_file_stats_t stats;
+
+  assert(diskio_file_get_stats(0, &stats) == RES_OK);
+  printf("{\"fs\":\"%s\",\"test\":\"diskio\",\"reads\":%llu,\"read_sectors\":%llu,"
+         "\"writes\":%llu,\"write_sectors\":%llu,\"syncs\":%llu,\"read_p99_us\":%llu,"
+         "\"write_p99_us\":%llu,\"sync_p99_us\":%llu}\n",
+         name, (unsigned long long)stats.reads, (unsigned long long)stats.read_sectors,
+         (unsigned long long)stats.writes, (unsigned long long)stats.write_sectors,
+         (unsigned long long)stats.syncs,
+         (unsigned long long)fs_latency_percentile(&(stats.read_latency), 990),
+         (unsigned long long)fs_latency_percentile(&(stats.write_latency), 990),
+         (unsigned long long)fs_latency_percentile(&(stats.sync_latency), 990));
+  fflush(stdout);
+}
+
+static void bench_fatfs_file_unmount(void) {
+  assert(f_mount(0, "0:", 0) == FR_OK);
+  bench_print_diskio("fatfs_file");
+
+  assert(diskio_file_close(0) == RES_OK);
+  remove(FATFS_IMAGE);
+}
+
+/*在映像文件前面加扇区缓存，和fatfs_file对比实际的读写次数。*/
+static fs_t* bench_fatfs_cache_mount(void) {
+  bench_fatfs_file_mount();
+  assert(f_mount(0, "0:", 0) == FR_OK);
+  assert(diskio_cache_wrap(0, FATFS_CACHE_SECTORS) == RES_OK);
+  assert(f_mount(&s_fatfs, "0:", 0) == FR_OK);
+  assert(diskio_file_reset_stats(0) == RES_OK);
+
+  return os_fs_fatfs();
+}
+
+static void bench_fatfs_cache_unmount(void) {
+  diskio_cache_stats_t stats;
+
+  assert(f_mount(0, "0:", 0) == FR_OK);
+  bench_print_diskio("fatfs_cache");
+
+  assert(diskio_cache_get_stats(0, &stats) == RES_OK);
+  printf("{\"fs\":\"fatfs_cache\",\"test\":\"cache\",\"read_hits\":%llu,"
+         "\"read_misses\":%llu,\"write_hits\":%llu,\"write_misses\":%llu,"
+         "\"evictions\":%llu,\"dev_writes\":%llu,\"dev_write_sectors\":%llu}\n",
+         (unsigned long long)stats.read_hits, (unsigned long long)stats.read_misses,
+         (unsigned long long)stats.write_hits, (unsigned long long)stats.write_misses,
+         (unsigned long long)stats.evictions, (unsigned long long)stats.dev_writes,
+         (unsigned long long)stats.dev_write_sectors);
+  fflush(stdout);
+
+  assert(diskio_cache_unwrap(0) == RES_OK);
+  assert(diskio_file_close(0) == RES_OK);
+  remove(FATFS_IMAGE);
+}
+#endif /*LINUX || MACOS*/
+
+static fs_t* bench_spiffs_mount(void) {
+  memset(s_flash, 0xff, sizeof(s_flash));
+  if (fs_mount_ram(&s_spiffs, s_flash, sizeof(s_flash)) != 0) {
+    assert(SPIFFS_format(&s_spiffs) == 0);
+    assert(fs_mount_ram(&s_spiffs, s_flash, sizeof(s_flash)) == 0);
+  }
+  os_fs_spiffs_set(&s_spiffs);
+
+  return os_fs_spiffs();
+}
+
+static void bench_spiffs_unmount(void) {
+  SPIFFS_unmount(&s_spiffs);
+}
+
+static const bench_fs_t s_bench_fs[] = {
+    {"posix", os_fs_posix, NULL, "fs_bench", "fs_bench/", "fs_bench", 4 * 1024 * 1024,
+     MAX_BLOCK_SIZE, 1024, 256, 1024},
+    {"fatfs", bench_fatfs_mount, bench_fatfs_unmount, "0:/bench", "0:/bench/", "0:/bench",
+     4 * 1024 * 1024, MAX_BLOCK_SIZE, 1024, 256, 1024},
+#if defined(LINUX) || defined(MACOS)
+    {"fatfs_file", bench_fatfs_file_mount, bench_fatfs_file_unmount, "0:/bench", "0:/bench/",
+     "0:/bench", 4 * 1024 * 1024, MAX_BLOCK_SIZE, 1024, 256, 1024},
+    {"fatfs_cache", bench_fatfs_cache_mount, bench_fatfs_cache_unmount, "0:/bench", "0:/bench/",
+     "0:/bench", 4 * 1024 * 1024, MAX_BLOCK_SIZE, 1024, 256, 1024},
+#endif /*LINUX || MACOS*/
+    {"spiffs", bench_spiffs_mount, bench_spiffs_unmount, NULL, "", "/", 64 * 1024, 4096, 64, 32,
+     32}};
+
+int main(int argc, char* argv[]) {
+  uint32_t i = 0;
+  uint32_t mt = 0;
+  const char* only = argc > 1 ? argv[1] : NULL;
+
+  platform_prepare();
+  memset(s_buff, 'b', sizeof(s_buff));
+
+  for (i = 0; i < ARRAY_SIZE(s_bench_fs); i++) {
+    const bench_fs_t* bfs = s_bench_fs + i;
+
+    if (only != NULL && !tk_str_eq(only, bfs->name)) {
+      continue;
+    }
+
+    for (mt = 0; mt < 2; mt++) {
+      fs_t* fs = bfs->mount();
+      fs_t* raw = fs_mt_get_impl(fs);
+
+      /*没有定义WITH_FS_MT时只有不加锁的版本。*/
+      if (!mt) {
+        bench_run(raw, bfs, FALSE);
+      } else if (raw != fs) {
+        bench_run(fs, bfs, TRUE);
+      }
+
+      if (bfs->unmount != NULL) {
+        bfs->unmount();
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * File:   fs_file_ext.c
+ * Author: AWTK Develop Team
+ * Brief:  optional extension of fs_file_t
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "fs_file_ext.h"
+
+typedef struct _fs_file_ext_entry_t {
+  const fs_file_vtable_t* vt;
+  const fs_file_ext_vtable_t* ext;
+} fs_file_ext_entry_t;
+
+#if defined(__GNUC__)
+#define FS_FILE_EXT_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FS_FILE_EXT_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define FS_FILE_EXT_CAS(p, expected, v) \
+  __atomic_compare_exchange_n((p), (expected), (v), 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#else
+/*不支持原子操作的编译器，需要在创建其它线程之前注册。*/
+#define FS_FILE_EXT_LOAD(p) (*(p))
+#define FS_FILE_EXT_FETCH_ADD(p, v) ((*(p) += (v)) - (v))
+#define FS_FILE_EXT_CAS(p, expected, v) \
+  (*(p) == *(expected) ? (*(p) = (v), TRUE) : (*(expected) = *(p), FALSE))
+#endif
+
+/*已经写完的表项数*/
+static uint32_t s_fs_file_ext_nr;
+/*已经分配的表项数*/
+static uint32_t s_fs_file_ext_reserved;
+static fs_file_ext_entry_t s_fs_file_ext[FS_FILE_EXT_MAX];
+
+/*
+ * 可以在多个线程中同时注册：先分配表项，写完后按分配的顺序增加计数，查找时不会看到没有写完的表项。
+ * 同一个vt同时注册时可能占用两个表项，查找时使用第一个，结果相同。
+ */
+ret_t fs_file_ext_register(const fs_file_vtable_t* vt, const fs_file_ext_vtable_t* ext) {
+  uint32_t i = 0;
+  uint32_t nr = FS_FILE_EXT_LOAD(&s_fs_file_ext_nr);
+  return_value_if_fail(vt != NULL && ext != NULL, RET_BAD_PARAMS);
+
+  for (i = 0; i < nr; i++) {
+    if (s_fs_file_ext[i].vt == vt) {
+      if (s_fs_file_ext[i].ext != ext) {
+        s_fs_file_ext[i].ext = ext;
+      }
+      return RET_OK;
+    }
+  }
+
+  i = FS_FILE_EXT_FETCH_ADD(&s_fs_file_ext_reserved, 1);
+  return_value_if_fail(i < FS_FILE_EXT_MAX, RET_OOM);
+
+  s_fs_file_ext[i].vt = vt;
+  s_fs_file_ext[i].ext = ext;
+  for (nr = i; !FS_FILE_EXT_CAS(&s_fs_file_ext_nr, &nr, i + 1); nr = i) {
+  }
+
+  return RET_OK;
+}
+
+const fs_file_ext_vtable_t* fs_file_ext_get(fs_file_t* file) {
+  uint32_t i = 0;
+  uint32_t nr = FS_FILE_EXT_LOAD(&s_fs_file_ext_nr);
+  return_value_if_fail(file != NULL, NULL);
+
+  for (i = 0; i < nr; i++) {
+    if (s_fs_file_ext[i].vt == file->vt) {
+      return s_fs_file_ext[i].ext;
+    }
+  }
+
+  return NULL;
+}
+
+ret_t fs_file_map(fs_file_t* file, const void** data, uint32_t* size) {
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(data != NULL && size != NULL, RET_BAD_PARAMS);
+
+  *data = NULL;
+  *size = 0;
+  if (ext == NULL || ext->map == NULL) {
+    return RET_NOT_IMPL;
+  }
+
+  return ext->map(file, data, size);
+}
+
+int32_t fs_file_borrow(fs_file_t* file, uint32_t size, void* scratch, const void** data) {
+  int32_t ret = 0;
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(scratch != NULL && data != NULL, -1);
+
+  *data = NULL;
+  if (ext != NULL && ext->borrow != NULL) {
+    return ext->borrow(file, size, scratch, data);
+  }
+
+  ret = fs_file_read(file, scratch, size);
+  if (ret >= 0) {
+    *data = scratch;
+  }
+
+  return ret;
+}
+
+ret_t fs_file_release(fs_file_t* file, const void* data) {
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL, RET_BAD_PARAMS);
+
+  if (ext != NULL && ext->release != NULL) {
+    return ext->release(file, data);
+  }
+
+  return RET_OK;
+}
+
+int32_t fs_file_readv_by(fs_file_t* file, fs_file_read_t read, const fs_iovec_t* iov,
+                         uint32_t iovcnt) {
+  uint32_t i = 0;
+  int32_t done = 0;
+  return_value_if_fail(read != NULL && (iov != NULL || iovcnt == 0), -1);
+
+  for (i = 0; i < iovcnt; i++) {
+    int32_t ret = read(file, iov[i].base, iov[i].size);
+    if (ret < 0) {
+      return done > 0 ? done : -1;
+    }
+
+    done += ret;
+    if ((uint32_t)ret < iov[i].size) {
+      break;
+    }
+  }
+
+  return done;
+}
+
+int32_t fs_file_writev_by(fs_file_t* file, fs_file_write_t write, const fs_iovec_t* iov,
+                          uint32_t iovcnt) {
+  uint32_t i = 0;
+  int32_t done = 0;
+  return_value_if_fail(write != NULL && (iov != NULL || iovcnt == 0), -1);
+
+  for (i = 0; i < iovcnt; i++) {
+    int32_t ret = write(file, iov[i].base, iov[i].size);
+    if (ret < 0) {
+      return done > 0 ? done : -1;
+    }
+
+    done += ret;
+    if ((uint32_t)ret < iov[i].size) {
+      break;
+    }
+  }
+
+  return done;
+}
+
+int32_t fs_file_readv(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL && (iov != NULL || iovcnt == 0), -1);
+
+  if (ext != NULL && ext->readv != NULL) {
+    return ext->readv(file, iov, iovcnt);
+  }
+
+  return fs_file_readv_by(file, fs_file_read, iov, iovcnt);
+}
+
+int32_t fs_file_writev(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL && (iov != NULL || iovcnt == 0), -1);
+
+  if (ext != NULL && ext->writev != NULL) {
+    return ext->writev(file, iov, iovcnt);
+  }
+
+  return fs_file_writev_by(file, fs_file_write, iov, iovcnt);
+}
+
+int32_t fs_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset) {
+  int32_t ret = 0;
+  int64_t pos = 0;
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL && buffer != NULL, -1);
+
+  if (ext != NULL && ext->pread != NULL) {
+    return ext->pread(file, buffer, size, offset);
+  }
+
+  pos = fs_file_tell(file);
+  return_value_if_fail(pos >= 0 && offset <= 0x7fffffff, -1);
+  if ((int64_t)offset >= fs_file_size(file)) {
+    return 0;
+  }
+
+  if (fs_file_seek(file, (int32_t)offset) != RET_OK) {
+    return -1;
+  }
+  ret = fs_file_read(file, buffer, size);
+  if (fs_file_seek(file, (int32_t)pos) != RET_OK) {
+    return -1;
+  }
+
+  return ret;
+}
+
+int32_t fs_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size, uint64_t offset) {
+  int32_t ret = 0;
+  int64_t pos = 0;
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL && buffer != NULL, -1);
+
+  if (ext != NULL && ext->pwrite != NULL) {
+    return ext->pwrite(file, buffer, size, offset);
+  }
+
+  pos = fs_file_tell(file);
+  return_value_if_fail(pos >= 0 && offset <= 0x7fffffff, -1);
+
+  if (fs_file_seek(file, (int32_t)offset) != RET_OK) {
+    return -1;
+  }
+  ret = fs_file_write(file, buffer, size);
+  if (fs_file_seek(file, (int32_t)pos) != RET_OK) {
+    return -1;
+  }
+
+  return ret;
+}
+
+ret_t fs_file_allocate(fs_file_t* file, uint64_t size) {
+  const fs_file_ext_vtable_t* ext = fs_file_ext_get(file);
+  return_value_if_fail(file != NULL, RET_BAD_PARAMS);
+
+  if (ext == NULL || ext->allocate == NULL) {
+    return RET_NOT_IMPL;
+  }
+
+  return ext->allocate(file, size);
+}
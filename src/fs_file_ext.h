@@ -0,0 +1,255 @@
+/**
+ * File:   fs_file_ext.h
+ * Author: AWTK Develop Team
+ * Brief:  optional extension of fs_file_t
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_FILE_EXT_H
+#define TK_FS_FILE_EXT_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 最多可以注册的扩展虚表个数。
+ */
+#ifndef FS_FILE_EXT_MAX
+#define FS_FILE_EXT_MAX 8
+#endif /*FS_FILE_EXT_MAX*/
+
+/**
+ * @class fs_iovec_t
+ * fs_file_readv/fs_file_writev使用的数据块。
+ */
+typedef struct _fs_iovec_t {
+  /**
+   * @property {void*} base
+   * 数据块的起始地址。
+   */
+  void* base;
+  /**
+   * @property {uint32_t} size
+   * 数据块的长度。
+   */
+  uint32_t size;
+} fs_iovec_t;
+
+typedef ret_t (*fs_file_map_t)(fs_file_t* file, const void** data, uint32_t* size);
+typedef int32_t (*fs_file_borrow_t)(fs_file_t* file, uint32_t size, void* scratch,
+                                    const void** data);
+typedef ret_t (*fs_file_release_t)(fs_file_t* file, const void* data);
+typedef int32_t (*fs_file_readv_t)(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt);
+typedef int32_t (*fs_file_writev_t)(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt);
+typedef int32_t (*fs_file_pread_t)(fs_file_t* file, void* buffer, uint32_t size,
+                                   uint64_t offset);
+typedef int32_t (*fs_file_pwrite_t)(fs_file_t* file, const void* buffer, uint32_t size,
+                                    uint64_t offset);
+typedef ret_t (*fs_file_allocate_t)(fs_file_t* file, uint64_t size);
+
+/**
+ * @class fs_file_ext_vtable_t
+ * fs_file_t的扩展虚表。
+ *
+ * fs_file_vtable_t由awtk定义，无法增加新的函数。适配器把扩展虚表与自己的fs_file_vtable_t
+ * 关联起来(fs_file_ext_register)，fs_file_map等函数根据file->vt找到扩展虚表，
+ * 没有注册或者没有实现的函数返回RET_NOT_IMPL。
+ */
+typedef struct _fs_file_ext_vtable_t {
+  fs_file_map_t map;
+  fs_file_borrow_t borrow;
+  fs_file_release_t release;
+  fs_file_readv_t readv;
+  fs_file_writev_t writev;
+  fs_file_pread_t pread;
+  fs_file_pwrite_t pwrite;
+  fs_file_allocate_t allocate;
+} fs_file_ext_vtable_t;
+
+/**
+ * @method fs_file_ext_register
+ * 注册扩展虚表。
+ * > 一般在获取fs对象时调用，重复注册同一个vt会被忽略。
+ * @annotation ["global"]
+ * @param {const fs_file_vtable_t*} vt 文件虚表。
+ * @param {const fs_file_ext_vtable_t*} ext 扩展虚表。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_file_ext_register(const fs_file_vtable_t* vt, const fs_file_ext_vtable_t* ext);
+
+/**
+ * @method fs_file_ext_get
+ * 获取文件对象的扩展虚表。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ *
+ * @return {const fs_file_ext_vtable_t*} 返回扩展虚表，没有注册时返回NULL。
+ */
+const fs_file_ext_vtable_t* fs_file_ext_get(fs_file_t* file);
+
+/**
+ * @method fs_file_map
+ * 获取整个文件内容的只读视图(不拷贝数据)。
+ * > 视图在文件关闭前有效。目前只有posix适配器以内存映射方式打开的只读文件支持。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const void**} data 返回文件内容的起始地址。
+ * @param {uint32_t*} size 返回文件内容的长度。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，不支持时返回RET_NOT_IMPL。
+ */
+ret_t fs_file_map(fs_file_t* file, const void** data, uint32_t* size);
+
+/**
+ * @method fs_file_borrow
+ * 从当前位置借用最多size字节的数据，并把文件位置向后移动返回的字节数(与fs_file_read相同)。
+ *
+ * 如果适配器已经在内存中缓存了当前位置的数据(posix的内存映射和预读缓冲区，fatfs的扇区缓冲区)，
+ * data直接指向缓存，不拷贝数据，否则把数据读入scratch，data指向scratch。
+ * 返回的字节数可能小于size，返回0才表示到了文件末尾。
+ *
+ * > 返回值不小于0时必须调用fs_file_release归还，归还前不能调用该文件的其它函数。
+ * > 经过fs_mt包装的文件，借用期间一直持有该文件自己的锁(全局模式下也不持有全局锁)，
+ * > 其它线程使用该文件时等到归还，本线程和其它线程仍然可以访问其它文件和名字空间。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {uint32_t} size 最多借用的字节数。
+ * @param {void*} scratch 不能直接借用时使用的缓冲区，长度不小于size。
+ * @param {const void**} data 返回数据的起始地址。
+ *
+ * @return {int32_t} 返回借到的字节数，失败返回-1。
+ */
+int32_t fs_file_borrow(fs_file_t* file, uint32_t size, void* scratch, const void** data);
+
+/**
+ * @method fs_file_release
+ * 归还fs_file_borrow借用的数据。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const void*} data fs_file_borrow返回的地址。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_file_release(fs_file_t* file, const void* data);
+
+/**
+ * @method fs_file_readv
+ * 依次读取数据到多个数据块中。
+ * > 没有实现readv的适配器逐块调用fs_file_read。经过fs_mt包装的文件，整个调用只加一次锁。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const fs_iovec_t*} iov 数据块数组。
+ * @param {uint32_t} iovcnt 数据块个数。
+ *
+ * @return {int32_t} 返回实际读取的字节数，读取失败且没有读到任何数据时返回-1。
+ */
+int32_t fs_file_readv(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt);
+
+/**
+ * @method fs_file_writev
+ * 依次写入多个数据块(如记录的头部、内容和校验)。
+ * > 没有实现writev的适配器逐块调用fs_file_write。经过fs_mt包装的文件，整个调用只加一次锁。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const fs_iovec_t*} iov 数据块数组。
+ * @param {uint32_t} iovcnt 数据块个数。
+ *
+ * @return {int32_t} 返回实际写入的字节数，写入失败且没有写入任何数据时返回-1。
+ */
+int32_t fs_file_writev(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt);
+
+/**
+ * @method fs_file_pread
+ * 从指定位置读取数据，不改变文件的当前位置。
+ * > 没有实现pread的适配器用seek/read/seek实现，此时多个线程共享同一个文件对象需要经过fs_mt包装。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {void*} buffer 用于返回数据的缓冲区。
+ * @param {uint32_t} size 缓冲区大小。
+ * @param {uint64_t} offset 读取的位置。
+ *
+ * @return {int32_t} 返回实际读取的字节数，位置在文件末尾之后时返回0，失败返回-1。
+ */
+int32_t fs_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset);
+
+/**
+ * @method fs_file_pwrite
+ * 在指定位置写入数据，不改变文件的当前位置。
+ * offset在文件末尾之后时，中间的部分读出为0(spiffs不支持空洞，返回失败)。
+ * > 没有实现pwrite的适配器用seek/write/seek实现，此时多个线程共享同一个文件对象需要经过fs_mt包装。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象。
+ * @param {const void*} buffer 数据缓冲区。
+ * @param {uint32_t} size 数据长度。
+ * @param {uint64_t} offset 写入的位置。
+ *
+ * @return {int32_t} 返回实际写入的字节数，失败返回-1。
+ */
+int32_t fs_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size, uint64_t offset);
+
+/**
+ * @method fs_file_allocate
+ * 预先为文件分配size字节的存储空间，之后顺序写入不再逐簇(逐页)分配。
+ *
+ * * fatfs: 文件为空时用f_expand分配连续的簇，否则(或者没有足够大的连续空间时)扩展簇链。
+ *   新分配的部分都要写一遍0，耗时与写入同样多的数据相当。
+ * * posix: posix_fallocate(MacOS为F_PREALLOCATE)。
+ * * spiffs: 不能预先分配页，提前做垃圾回收，保证有足够的已擦除的页。
+ *
+ * > fatfs和posix分配后文件大小变为size，新分配的部分读出为0，写完后可以用fs_file_truncate
+ * > 截掉没有用到的部分。spiffs的文件大小不变。size不大于文件大小时什么也不做。读写位置不变。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 文件对象(以写方式打开)。
+ * @param {uint64_t} size 预先分配的大小。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，不支持时返回RET_NOT_IMPL。
+ */
+ret_t fs_file_allocate(fs_file_t* file, uint64_t size);
+
+/**
+ * @method fs_file_readv_by
+ * 用指定的读函数逐块实现readv，供适配器使用。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 传给read的文件对象。
+ * @param {fs_file_read_t} read 读函数。
+ * @param {const fs_iovec_t*} iov 数据块数组。
+ * @param {uint32_t} iovcnt 数据块个数。
+ *
+ * @return {int32_t} 返回实际读取的字节数，读取失败且没有读到任何数据时返回-1。
+ */
+int32_t fs_file_readv_by(fs_file_t* file, fs_file_read_t read, const fs_iovec_t* iov,
+                         uint32_t iovcnt);
+
+/**
+ * @method fs_file_writev_by
+ * 用指定的写函数逐块实现writev，供适配器使用。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 传给write的文件对象。
+ * @param {fs_file_write_t} write 写函数。
+ * @param {const fs_iovec_t*} iov 数据块数组。
+ * @param {uint32_t} iovcnt 数据块个数。
+ *
+ * @return {int32_t} 返回实际写入的字节数，写入失败且没有写入任何数据时返回-1。
+ */
+int32_t fs_file_writev_by(fs_file_t* file, fs_file_write_t write, const fs_iovec_t* iov,
+                          uint32_t iovcnt);
+
+END_C_DECLS
+
+#endif /*TK_FS_FILE_EXT_H*/
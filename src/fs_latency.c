@@ -0,0 +1,104 @@
+/**
+ * File:   fs_latency.c
+ * Author: AWTK Develop Team
+ * Brief:  log-bucketed latency histogram
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include "tkc/utils.h"
+#include "fs_latency.h"
+
+ret_t fs_latency_init(fs_latency_t* latency) {
+  return_value_if_fail(latency != NULL, RET_BAD_PARAMS);
+
+  memset(latency, 0x00, sizeof(*latency));
+
+  return RET_OK;
+}
+
+uint32_t fs_latency_bucket_of(uint64_t us) {
+  uint32_t i = 0;
+
+  while (us > 0 && i < FS_LATENCY_BUCKETS_NR - 1) {
+    us >>= 1;
+    i++;
+  }
+
+  return i;
+}
+
+ret_t fs_latency_add(fs_latency_t* latency, uint64_t us) {
+  return_value_if_fail(latency != NULL, RET_BAD_PARAMS);
+
+  latency->count++;
+  latency->sum += us;
+  if (us > latency->max) {
+    latency->max = us;
+  }
+  latency->buckets[fs_latency_bucket_of(us)]++;
+
+  return RET_OK;
+}
+
+ret_t fs_latency_merge(fs_latency_t* latency, const fs_latency_t* src) {
+  uint32_t i = 0;
+  return_value_if_fail(latency != NULL && src != NULL, RET_BAD_PARAMS);
+
+  latency->count += src->count;
+  latency->sum += src->sum;
+  if (src->max > latency->max) {
+    latency->max = src->max;
+  }
+  for (i = 0; i < FS_LATENCY_BUCKETS_NR; i++) {
+    latency->buckets[i] += src->buckets[i];
+  }
+
+  return RET_OK;
+}
+
+uint64_t fs_latency_percentile(const fs_latency_t* latency, uint32_t permille) {
+  uint32_t i = 0;
+  uint64_t seen = 0;
+  uint64_t target = 0;
+  return_value_if_fail(latency != NULL, 0);
+
+  if (latency->count == 0) {
+    return 0;
+  }
+
+  /*向上取整，保证p100落在最后一个非空的桶。*/
+  target = (latency->count * tk_min(permille, 1000) + 999) / 1000;
+  if (target == 0) {
+    target = 1;
+  }
+
+  for (i = 0; i < FS_LATENCY_BUCKETS_NR; i++) {
+    seen += latency->buckets[i];
+    if (seen >= target) {
+      uint64_t upper = i == 0 ? 0 : ((uint64_t)1 << i) - 1;
+      return i == FS_LATENCY_BUCKETS_NR - 1 ? latency->max : tk_min(upper, latency->max);
+    }
+  }
+
+  return latency->max;
+}
+
+uint64_t fs_latency_avg(const fs_latency_t* latency) {
+  return_value_if_fail(latency != NULL, 0);
+
+  return latency->count > 0 ? latency->sum / latency->count : 0;
+}
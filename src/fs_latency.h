@@ -0,0 +1,125 @@
+/**
+ * File:   fs_latency.h
+ * Author: AWTK Develop Team
+ * Brief:  log-bucketed latency histogram
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_LATENCY_H
+#define TK_FS_LATENCY_H
+
+#include "tkc/types_def.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 桶的个数。第i个桶(i>0)记录[2^(i-1), 2^i)微秒的样本，第0个桶记录0微秒的样本。
+ */
+#define FS_LATENCY_BUCKETS_NR 32
+
+/**
+ * @class fs_latency_t
+ * 按2的幂分桶的延迟直方图(单位为微秒)。
+ */
+typedef struct _fs_latency_t {
+  /**
+   * @property {uint64_t} count
+   * @annotation ["readable"]
+   * 样本数。
+   */
+  uint64_t count;
+  /**
+   * @property {uint64_t} sum
+   * @annotation ["readable"]
+   * 样本的总和。
+   */
+  uint64_t sum;
+  /**
+   * @property {uint64_t} max
+   * @annotation ["readable"]
+   * 最大的样本。
+   */
+  uint64_t max;
+  /**
+   * @property {uint64_t*} buckets
+   * @annotation ["readable"]
+   * 各个桶的样本数。
+   */
+  uint64_t buckets[FS_LATENCY_BUCKETS_NR];
+} fs_latency_t;
+
+/**
+ * @method fs_latency_init
+ * 初始化(清空)直方图。
+ * @param {fs_latency_t*} latency 直方图。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_latency_init(fs_latency_t* latency);
+
+/**
+ * @method fs_latency_add
+ * 增加一个样本(非线程安全)。
+ * @param {fs_latency_t*} latency 直方图。
+ * @param {uint64_t} us 延迟(微秒)。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_latency_add(fs_latency_t* latency, uint64_t us);
+
+/**
+ * @method fs_latency_merge
+ * 把src中的样本合并到latency中。
+ * @param {fs_latency_t*} latency 直方图。
+ * @param {const fs_latency_t*} src 另外一个直方图。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_latency_merge(fs_latency_t* latency, const fs_latency_t* src);
+
+/**
+ * @method fs_latency_bucket_of
+ * 计算样本所在的桶。
+ * @param {uint64_t} us 延迟(微秒)。
+ *
+ * @return {uint32_t} 返回桶的序号。
+ */
+uint32_t fs_latency_bucket_of(uint64_t us);
+
+/**
+ * @method fs_latency_percentile
+ * 估算百分位数。
+ * > 结果是所在桶的上界(不超过max)，误差在2倍以内。
+ * @param {const fs_latency_t*} latency 直方图。
+ * @param {uint32_t} permille 千分位(如500表示p50，990表示p99)。
+ *
+ * @return {uint64_t} 返回延迟(微秒)，没有样本时返回0。
+ */
+uint64_t fs_latency_percentile(const fs_latency_t* latency, uint32_t permille);
+
+/**
+ * @method fs_latency_avg
+ * 计算平均值。
+ * @param {const fs_latency_t*} latency 直方图。
+ *
+ * @return {uint64_t} 返回平均延迟(微秒)，没有样本时返回0。
+ */
+uint64_t fs_latency_avg(const fs_latency_t* latency);
+
+END_C_DECLS
+
+#endif /*TK_FS_LATENCY_H*/
@@ -23,54 +23,150 @@
 #include "tkc/mem.h"
 #include "tkc/utils.h"
 #include "tkc/mutex.h"
+#include "tkc/rwlock.h"
+#include "tkc/platform.h"
 #include <stdarg.h>
 #include "fs_mt.h"
+#include "fs_printf.h"
+#include "fs_file_ext.h"
 
 #ifdef WITH_FS_MT
-static fs_t* s_fs_impl;
-static tk_mutex_t* s_fs_mutex;
+typedef struct _fs_mt_t {
+  fs_t fs;
+  fs_t* impl;
+  tk_mutex_t* mutex;
+  tk_rwlock_t* ns_lock;
+  uint32_t open_nr;
+  fs_mt_lock_mode_t lock_mode;
+} fs_mt_t;
+
+typedef struct _fs_mt_file_t {
+  fs_file_t fs_file;
+  fs_mt_t* mt;
+  tk_mutex_t* mutex;
+} fs_mt_file_t;
+
+typedef struct _fs_mt_dir_t {
+  fs_dir_t fs_dir;
+  fs_mt_t* mt;
+  tk_mutex_t* mutex;
+} fs_mt_dir_t;
+
+/*
+ * 全局模式：所有调用共用 mt->mutex，文件的读写还要先加文件自己的锁。
+ * 文件粒度模式：名字空间操作使用读写锁(创建/删除/改名为写，查询为读)，
+ * 文件/目录的读写先加各自的锁再加名字空间读锁，不同文件的 I/O 可以并行。
+ */
+static ret_t fs_mt_ns_lock(fs_mt_t* mt, bool_t write) {
+  if (mt->lock_mode == FS_MT_LOCK_GLOBAL) {
+    return tk_mutex_lock(mt->mutex);
+  }
 
-#if defined(LINUX) || defined(WIN32) || defined(MACOS) || defined(HAS_STDIO)
-#include <stdio.h>
-#else
-extern int vsnprintf(char* s, size_t n, const char* format, va_list arg);
-#endif
+  return write ? tk_rwlock_wlock(mt->ns_lock) : tk_rwlock_rlock(mt->ns_lock);
+}
+
+static ret_t fs_mt_ns_unlock(fs_mt_t* mt, bool_t write) {
+  if (mt->lock_mode == FS_MT_LOCK_GLOBAL) {
+    return tk_mutex_unlock(mt->mutex);
+  }
+
+  return write ? tk_rwlock_wunlock(mt->ns_lock) : tk_rwlock_runlock(mt->ns_lock);
+}
+
+/*
+ * 对象锁：先加文件/目录自己的锁(全局模式下目录没有自己的锁)，再加名字空间的读锁(全局模式下是全局锁)。
+ * 加锁的顺序总是先对象后名字空间，借用时可以只持有文件自己的锁。
+ */
+static ret_t fs_mt_obj_lock(fs_mt_t* mt, tk_mutex_t* mutex) {
+  if (mutex != NULL && tk_mutex_lock(mutex) != RET_OK) {
+    return RET_FAIL;
+  }
+
+  if (fs_mt_ns_lock(mt, FALSE) != RET_OK) {
+    if (mutex != NULL) {
+      tk_mutex_unlock(mutex);
+    }
+    return RET_FAIL;
+  }
+
+  return RET_OK;
+}
+
+static ret_t fs_mt_obj_unlock(fs_mt_t* mt, tk_mutex_t* mutex) {
+  ret_t ret = fs_mt_ns_unlock(mt, FALSE);
+
+  if (mutex != NULL) {
+    tk_mutex_unlock(mutex);
+  }
+
+  return ret;
+}
+
+#define fs_mt_file_lock(file) \
+  fs_mt_obj_lock(((fs_mt_file_t*)(file))->mt, ((fs_mt_file_t*)(file))->mutex)
+#define fs_mt_file_unlock(file) \
+  fs_mt_obj_unlock(((fs_mt_file_t*)(file))->mt, ((fs_mt_file_t*)(file))->mutex)
+#define fs_mt_dir_lock(dir) \
+  fs_mt_obj_lock(((fs_mt_dir_t*)(dir))->mt, ((fs_mt_dir_t*)(dir))->mutex)
+#define fs_mt_dir_unlock(dir) \
+  fs_mt_obj_unlock(((fs_mt_dir_t*)(dir))->mt, ((fs_mt_dir_t*)(dir))->mutex)
+
+/*调用者已持有名字空间锁，文件粒度模式下名字空间可能只持有读锁，需要另外保护计数。*/
+static void fs_mt_open_nr_inc(fs_mt_t* mt) {
+  if (mt->lock_mode == FS_MT_LOCK_PER_FILE) {
+    tk_mutex_lock(mt->mutex);
+    mt->open_nr++;
+    tk_mutex_unlock(mt->mutex);
+  } else {
+    mt->open_nr++;
+  }
+}
+
+static void fs_mt_open_nr_dec(fs_mt_t* mt) {
+  if (mt->lock_mode == FS_MT_LOCK_PER_FILE) {
+    tk_mutex_lock(mt->mutex);
+    mt->open_nr--;
+    tk_mutex_unlock(mt->mutex);
+  } else {
+    mt->open_nr--;
+  }
+}
 
 static int32_t fs_mt_file_read(fs_file_t* file, void* buffer, uint32_t size) {
   int32_t result = 0;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_read((fs_file_t*)(file->data), buffer, size);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
 }
 
-int32_t fs_mt_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+static int32_t fs_mt_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
   int32_t result = 0;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_write((fs_file_t*)(file->data), buffer, size);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
 }
 
-int32_t fs_mt_file_printf(fs_file_t* file, const char* const format, va_list args) {
-  int32_t n = 0;
-  char buffer[256];
-  /*FIXME*/
-  n = vsnprintf(buffer, sizeof(buffer), format, args);
-  return_value_if_fail(n >= 0, 0);
+static int32_t fs_mt_file_printf(fs_file_t* file, const char* const format, va_list args) {
+  int32_t result = 0;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_vprintf_stream((fs_file_t*)(file->data), fs_file_write, format, args);
+    fs_mt_file_unlock(file);
+  }
 
-  return fs_mt_file_write(file, buffer, n);
+  return result;
 }
 
 static ret_t fs_mt_file_seek(fs_file_t* file, int32_t offset) {
   ret_t result = RET_FAIL;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_seek((fs_file_t*)(file->data), offset);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -78,9 +174,9 @@ static ret_t fs_mt_file_seek(fs_file_t* file, int32_t offset) {
 
 static int64_t fs_mt_file_tell(fs_file_t* file) {
   int64_t result = -1;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_tell((fs_file_t*)(file->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -88,9 +184,9 @@ static int64_t fs_mt_file_tell(fs_file_t* file) {
 
 static int64_t fs_mt_file_size(fs_file_t* file) {
   int64_t result = -1;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_size((fs_file_t*)(file->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -98,9 +194,9 @@ static int64_t fs_mt_file_size(fs_file_t* file) {
 
 static ret_t fs_mt_file_stat(fs_file_t* file, fs_stat_info_t* fst) {
   ret_t result = RET_FAIL;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_stat((fs_file_t*)(file->data), fst);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -108,9 +204,9 @@ static ret_t fs_mt_file_stat(fs_file_t* file, fs_stat_info_t* fst) {
 
 static ret_t fs_mt_file_sync(fs_file_t* file) {
   ret_t result = RET_FAIL;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_sync((fs_file_t*)(file->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -118,19 +214,114 @@ static ret_t fs_mt_file_sync(fs_file_t* file) {
 
 static ret_t fs_mt_file_truncate(fs_file_t* file, int32_t size) {
   ret_t result = RET_FAIL;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_truncate((fs_file_t*)(file->data), size);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
   }
 
   return result;
 }
 
-bool_t fs_mt_file_eof(fs_file_t* file) {
+static bool_t fs_mt_file_eof(fs_file_t* file) {
   bool_t result = TRUE;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_file_lock(file) == RET_OK) {
     result = fs_file_eof((fs_file_t*)(file->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+static ret_t fs_mt_file_map(fs_file_t* file, const void** data, uint32_t* size) {
+  ret_t result = RET_FAIL;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_map((fs_file_t*)(file->data), data, size);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+/*
+ * 借用期间只持有文件自己的锁，fs_mt_file_release时释放。全局模式下也不持有全局锁，
+ * 其它线程和本线程仍然可以访问其它文件和名字空间。
+ */
+static int32_t fs_mt_file_borrow(fs_file_t* file, uint32_t size, void* scratch,
+                                 const void** data) {
+  int32_t result = -1;
+  fs_mt_t* mt = ((fs_mt_file_t*)file)->mt;
+
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_borrow((fs_file_t*)(file->data), size, scratch, data);
+    if (result < 0) {
+      fs_mt_file_unlock(file);
+    } else {
+      fs_mt_ns_unlock(mt, FALSE);
+    }
+  }
+
+  return result;
+}
+
+static ret_t fs_mt_file_release(fs_file_t* file, const void* data) {
+  ret_t result = RET_FAIL;
+  fs_mt_t* mt = ((fs_mt_file_t*)file)->mt;
+
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_file_release((fs_file_t*)(file->data), data);
+    fs_mt_ns_unlock(mt, FALSE);
+  }
+  tk_mutex_unlock(((fs_mt_file_t*)file)->mutex);
+
+  return result;
+}
+
+static int32_t fs_mt_file_readv(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  int32_t result = -1;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_readv((fs_file_t*)(file->data), iov, iovcnt);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+static int32_t fs_mt_file_writev(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  int32_t result = -1;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_writev((fs_file_t*)(file->data), iov, iovcnt);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+static int32_t fs_mt_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset) {
+  int32_t result = -1;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_pread((fs_file_t*)(file->data), buffer, size, offset);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+static int32_t fs_mt_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size,
+                                 uint64_t offset) {
+  int32_t result = -1;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_pwrite((fs_file_t*)(file->data), buffer, size, offset);
+    fs_mt_file_unlock(file);
+  }
+
+  return result;
+}
+
+static ret_t fs_mt_file_allocate(fs_file_t* file, uint64_t size) {
+  ret_t result = RET_FAIL;
+  if (fs_mt_file_lock(file) == RET_OK) {
+    result = fs_file_allocate((fs_file_t*)(file->data), size);
+    fs_mt_file_unlock(file);
   }
 
   return result;
@@ -138,21 +329,27 @@ bool_t fs_mt_file_eof(fs_file_t* file) {
 
 static ret_t fs_mt_file_close(fs_file_t* file) {
   ret_t result = RET_FAIL;
+  fs_mt_t* mt = ((fs_mt_file_t*)file)->mt;
+  tk_mutex_t* mutex = ((fs_mt_file_t*)file)->mutex;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
     result = fs_file_close((fs_file_t*)(file->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_open_nr_dec(mt);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
+  tk_mutex_destroy(mutex);
+  TKMEM_FREE(file);
+
   return result;
 }
 
 static ret_t fs_mt_dir_rewind(fs_dir_t* dir) {
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_dir_lock(dir) == RET_OK) {
     result = fs_dir_rewind((fs_dir_t*)(dir->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_dir_unlock(dir);
   }
 
   return result;
@@ -161,9 +358,9 @@ static ret_t fs_mt_dir_rewind(fs_dir_t* dir) {
 static ret_t fs_mt_dir_read(fs_dir_t* dir, fs_item_t* item) {
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_dir_lock(dir) == RET_OK) {
     result = fs_dir_read((fs_dir_t*)(dir->data), item);
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_dir_unlock(dir);
   }
 
   return result;
@@ -171,12 +368,20 @@ static ret_t fs_mt_dir_read(fs_dir_t* dir, fs_item_t* item) {
 
 static ret_t fs_mt_dir_close(fs_dir_t* dir) {
   ret_t result = RET_FAIL;
+  fs_mt_t* mt = ((fs_mt_dir_t*)dir)->mt;
+  tk_mutex_t* mutex = ((fs_mt_dir_t*)dir)->mutex;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
     result = fs_dir_close((fs_dir_t*)(dir->data));
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_open_nr_dec(mt);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
+  if (mutex != NULL) {
+    tk_mutex_destroy(mutex);
+  }
+  TKMEM_FREE(dir);
+
   return result;
 }
 
@@ -192,50 +397,79 @@ static const fs_file_vtable_t s_file_vtable = {.read = fs_mt_file_read,
                                                .eof = fs_mt_file_eof,
                                                .close = fs_mt_file_close};
 
+static const fs_file_ext_vtable_t s_file_ext_vtable = {.map = fs_mt_file_map,
+                                                       .borrow = fs_mt_file_borrow,
+                                                       .release = fs_mt_file_release,
+                                                       .readv = fs_mt_file_readv,
+                                                       .writev = fs_mt_file_writev,
+                                                       .pread = fs_mt_file_pread,
+                                                       .pwrite = fs_mt_file_pwrite,
+                                                       .allocate = fs_mt_file_allocate};
+
 static fs_file_t* fs_mt_open_file(fs_t* fs, const char* name, const char* mode) {
-  fs_file_t* file = TKMEM_ZALLOC(fs_file_t);
+  /*只读方式打开不会修改名字空间，用读锁即可。*/
+  bool_t write = mode == NULL || mode[0] != 'r' || strchr(mode, '+') != NULL;
+  fs_mt_t* mt = (fs_mt_t*)fs;
+  fs_mt_file_t* mt_file = TKMEM_ZALLOC(fs_mt_file_t);
+  fs_file_t* file = (fs_file_t*)mt_file;
   return_value_if_fail(file != NULL, NULL);
 
   file->vt = &s_file_vtable;
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    file->data = fs_open_file(s_fs_impl, name, mode);
-    if (file->data == NULL) {
-      TKMEM_FREE(file);
+  mt_file->mt = mt;
+  /*全局模式下文件也有自己的锁，借用时只持有它。*/
+  mt_file->mutex = tk_mutex_create();
+  if (mt_file->mutex == NULL) {
+    TKMEM_FREE(file);
+    return NULL;
+  }
+
+  if (fs_mt_ns_lock(mt, write) == RET_OK) {
+    file->data = fs_open_file(mt->impl, name, mode);
+    if (file->data != NULL) {
+      fs_mt_open_nr_inc(mt);
     }
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_ns_unlock(mt, write);
+  }
+
+  if (file->data == NULL) {
+    tk_mutex_destroy(mt_file->mutex);
+    TKMEM_FREE(file);
   }
 
   return file;
 }
 
 static ret_t fs_mt_remove_file(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_remove_file(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    result = fs_remove_file(mt->impl, name);
+    fs_mt_ns_unlock(mt, TRUE);
   }
 
   return result;
 }
 
 static bool_t fs_mt_file_exist(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   bool_t result = FALSE;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_file_exist(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_file_exist(mt->impl, name);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_file_rename(fs_t* fs, const char* name, const char* new_name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_file_rename(s_fs_impl, name, new_name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    result = fs_file_rename(mt->impl, name, new_name);
+    fs_mt_ns_unlock(mt, TRUE);
   }
 
   return result;
@@ -245,71 +479,94 @@ static const fs_dir_vtable_t s_dir_vtable = {
     .read = fs_mt_dir_read, .rewind = fs_mt_dir_rewind, .close = fs_mt_dir_close};
 
 static fs_dir_t* fs_mt_open_dir(fs_t* fs, const char* name) {
-  fs_dir_t* dir = TKMEM_ZALLOC(fs_dir_t);
+  fs_mt_t* mt = (fs_mt_t*)fs;
+  fs_mt_dir_t* mt_dir = TKMEM_ZALLOC(fs_mt_dir_t);
+  fs_dir_t* dir = (fs_dir_t*)mt_dir;
   return_value_if_fail(dir != NULL, NULL);
   dir->vt = &(s_dir_vtable);
+  mt_dir->mt = mt;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    dir->data = fs_open_dir(s_fs_impl, name);
-    if (dir->data == NULL) {
+  if (mt->lock_mode == FS_MT_LOCK_PER_FILE) {
+    mt_dir->mutex = tk_mutex_create();
+    if (mt_dir->mutex == NULL) {
       TKMEM_FREE(dir);
+      return NULL;
+    }
+  }
+
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    dir->data = fs_open_dir(mt->impl, name);
+    if (dir->data != NULL) {
+      fs_mt_open_nr_inc(mt);
     }
-    tk_mutex_unlock(s_fs_mutex);
+    fs_mt_ns_unlock(mt, FALSE);
+  }
+
+  if (dir->data == NULL) {
+    if (mt_dir->mutex != NULL) {
+      tk_mutex_destroy(mt_dir->mutex);
+    }
+    TKMEM_FREE(dir);
   }
 
   return dir;
 }
 
 static ret_t fs_mt_remove_dir(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_remove_dir(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    result = fs_remove_dir(mt->impl, name);
+    fs_mt_ns_unlock(mt, TRUE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_create_dir(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_create_dir(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    result = fs_create_dir(mt->impl, name);
+    fs_mt_ns_unlock(mt, TRUE);
   }
 
   return result;
 }
 
 static bool_t fs_mt_dir_exist(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   bool_t result = FALSE;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_dir_exist(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_dir_exist(mt->impl, name);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_dir_rename(fs_t* fs, const char* name, const char* new_name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_dir_rename(s_fs_impl, name, new_name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    result = fs_dir_rename(mt->impl, name, new_name);
+    fs_mt_ns_unlock(mt, TRUE);
   }
 
   return result;
 }
 
 static int32_t fs_mt_get_file_size(fs_t* fs, const char* name) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   int32_t result = 0;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_file_size(s_fs_impl, name);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_file_size(mt->impl, name);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
@@ -317,101 +574,262 @@ static int32_t fs_mt_get_file_size(fs_t* fs, const char* name) {
 
 static ret_t fs_mt_get_disk_info(fs_t* fs, const char* volume, int32_t* free_kb,
                                  int32_t* total_kb) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_disk_info(s_fs_impl, volume, free_kb, total_kb);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_disk_info(mt->impl, volume, free_kb, total_kb);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_get_exe(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_exe(s_fs_impl, path);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_exe(mt->impl, path);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_get_user_storage_path(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_user_storage_path(s_fs_impl, path);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_user_storage_path(mt->impl, path);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_get_temp_path(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_temp_path(s_fs_impl, path);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_temp_path(mt->impl, path);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_get_cwd(fs_t* fs, char cwd[MAX_PATH + 1]) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_get_cwd(s_fs_impl, cwd);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_get_cwd(mt->impl, cwd);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
 static ret_t fs_mt_stat(fs_t* fs, const char* name, fs_stat_info_t* fst) {
+  fs_mt_t* mt = (fs_mt_t*)fs;
   ret_t result = RET_FAIL;
 
-  if (tk_mutex_lock(s_fs_mutex) == RET_OK) {
-    result = fs_stat(s_fs_impl, name, fst);
-    tk_mutex_unlock(s_fs_mutex);
+  if (fs_mt_ns_lock(mt, FALSE) == RET_OK) {
+    result = fs_stat(mt->impl, name, fst);
+    fs_mt_ns_unlock(mt, FALSE);
   }
 
   return result;
 }
 
-static const fs_t s_os_fs_mt = {.open_file = fs_mt_open_file,
-                                .remove_file = fs_mt_remove_file,
-                                .file_exist = fs_mt_file_exist,
-                                .file_rename = fs_mt_file_rename,
+static const fs_t s_fs_mt_vtable = {.open_file = fs_mt_open_file,
+                                    .remove_file = fs_mt_remove_file,
+                                    .file_exist = fs_mt_file_exist,
+                                    .file_rename = fs_mt_file_rename,
+
+                                    .open_dir = fs_mt_open_dir,
+                                    .remove_dir = fs_mt_remove_dir,
+                                    .create_dir = fs_mt_create_dir,
+                                    .dir_exist = fs_mt_dir_exist,
+                                    .dir_rename = fs_mt_dir_rename,
+
+                                    .get_file_size = fs_mt_get_file_size,
+                                    .get_disk_info = fs_mt_get_disk_info,
+                                    .get_cwd = fs_mt_get_cwd,
+                                    .get_exe = fs_mt_get_exe,
+                                    .get_user_storage_path = fs_mt_get_user_storage_path,
+                                    .get_temp_path = fs_mt_get_temp_path,
+                                    .stat = fs_mt_stat};
+
+static fs_mt_t* fs_mt_cast(fs_t* fs) {
+  return_value_if_fail(fs != NULL && fs->open_file == fs_mt_open_file, NULL);
+
+  return (fs_mt_t*)fs;
+}
+
+static ret_t fs_mt_destroy(fs_mt_t* mt) {
+  if (mt->mutex != NULL) {
+    tk_mutex_destroy(mt->mutex);
+  }
 
-                                .open_dir = fs_mt_open_dir,
-                                .remove_dir = fs_mt_remove_dir,
-                                .create_dir = fs_mt_create_dir,
-                                .dir_exist = fs_mt_dir_exist,
-                                .dir_rename = fs_mt_dir_rename,
+  if (mt->ns_lock != NULL) {
+    tk_rwlock_destroy(mt->ns_lock);
+  }
+  TKMEM_FREE(mt);
 
-                                .get_file_size = fs_mt_get_file_size,
-                                .get_disk_info = fs_mt_get_disk_info,
-                                .get_cwd = fs_mt_get_cwd,
-                                .get_exe = fs_mt_get_exe,
-                                .get_user_storage_path = fs_mt_get_user_storage_path,
-                                .get_temp_path = fs_mt_get_temp_path,
-                                .stat = fs_mt_stat};
+  return RET_OK;
+}
 
 fs_t* fs_mt_wrap(fs_t* impl) {
-  s_fs_impl = impl;
+  fs_mt_t* mt = NULL;
+  return_value_if_fail(impl != NULL, NULL);
+
+  mt = TKMEM_ZALLOC(fs_mt_t);
+  return_value_if_fail(mt != NULL, NULL);
+
+  fs_file_ext_register(&s_file_vtable, &s_file_ext_vtable);
+  mt->fs = s_fs_mt_vtable;
+  mt->impl = impl;
+  mt->lock_mode = FS_MT_LOCK_GLOBAL;
+  mt->mutex = tk_mutex_create();
+  mt->ns_lock = tk_rwlock_create();
+
+  if (mt->mutex == NULL || mt->ns_lock == NULL) {
+    fs_mt_destroy(mt);
+    return NULL;
+  }
+
+  return (fs_t*)mt;
+}
+
+#if defined(__GNUC__)
+#define FS_MT_LOAD_PTR(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FS_MT_STORE_PTR(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define FS_MT_CAS_PTR(p, expected, v) \
+  __atomic_compare_exchange_n((p), (expected), (v), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+/*不支持原子操作的编译器，需要在创建其它线程之前先调用一次。*/
+#define FS_MT_LOAD_PTR(p) (*(p))
+#define FS_MT_STORE_PTR(p, v) (*(p) = (v))
+#define FS_MT_CAS_PTR(p, expected, v) \
+  (*(p) == *(expected) ? (*(p) = (v), TRUE) : (*(expected) = *(p), FALSE))
+#endif
+
+/*正在创建包装对象时*mt的值。*/
+static fs_t s_fs_mt_creating;
+
+fs_t* fs_mt_wrap_once(fs_t** mt, fs_t* impl) {
+  fs_t* fs = NULL;
+  return_value_if_fail(mt != NULL && impl != NULL, NULL);
+
+  fs = FS_MT_LOAD_PTR(mt);
+  if (fs == NULL) {
+    if (FS_MT_CAS_PTR(mt, &fs, &s_fs_mt_creating)) {
+      fs = fs_mt_wrap(impl);
+      FS_MT_STORE_PTR(mt, fs);
+      return fs;
+    }
+  }
+
+  /*其它线程正在创建，等它完成(只在第一次调用时发生)。*/
+  while (fs == &s_fs_mt_creating) {
+    sleep_ms(1);
+    fs = FS_MT_LOAD_PTR(mt);
+  }
+
+  return fs;
+}
+
+fs_t* fs_mt_unwrap(fs_t* fs) {
+  fs_t* impl = NULL;
+  fs_mt_t* mt = fs_mt_cast(fs);
+  return_value_if_fail(mt != NULL, NULL);
+
+  if (tk_mutex_lock(mt->mutex) == RET_OK) {
+    uint32_t open_nr = mt->open_nr;
+    tk_mutex_unlock(mt->mutex);
+    return_value_if_fail(open_nr == 0, NULL);
+  }
+
+  impl = mt->impl;
+  fs_mt_destroy(mt);
+
+  return impl;
+}
+
+fs_t* fs_mt_get_impl(fs_t* fs) {
+  return_value_if_fail(fs != NULL, NULL);
+
+  return fs->open_file == fs_mt_open_file ? ((fs_mt_t*)fs)->impl : fs;
+}
+
+ret_t fs_mt_set_lock_mode(fs_t* fs, fs_mt_lock_mode_t mode) {
+  ret_t ret = RET_OK;
+  fs_mt_t* mt = fs_mt_cast(fs);
+  return_value_if_fail(mt != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(mode == FS_MT_LOCK_GLOBAL || mode == FS_MT_LOCK_PER_FILE, RET_BAD_PARAMS);
+
+  /*已打开的文件创建时的锁与新模式不匹配，不允许切换。*/
+  if (tk_rwlock_wlock(mt->ns_lock) == RET_OK) {
+    if (tk_mutex_lock(mt->mutex) == RET_OK) {
+      if (mt->open_nr == 0) {
+        mt->lock_mode = mode;
+      } else {
+        ret = RET_BUSY;
+      }
+      tk_mutex_unlock(mt->mutex);
+    }
+    tk_rwlock_wunlock(mt->ns_lock);
+  }
+
+  return ret;
+}
 
-  if (s_fs_mutex == NULL) {
-    s_fs_mutex = tk_mutex_create();
+ret_t fs_mt_exec_exclusive(fs_t* fs, fs_mt_exclusive_func_t func, void* ctx) {
+  ret_t ret = RET_FAIL;
+  fs_mt_t* mt = NULL;
+  return_value_if_fail(fs != NULL && func != NULL, RET_BAD_PARAMS);
+
+  if (fs->open_file != fs_mt_open_file) {
+    return func(ctx);
   }
 
-  return (fs_t*)&s_os_fs_mt;
+  /*文件粒度模式下文件的I/O持有名字空间的读锁，持有写锁时所有调用都已经返回。*/
+  mt = (fs_mt_t*)fs;
+  if (fs_mt_ns_lock(mt, TRUE) == RET_OK) {
+    ret = func(ctx);
+    fs_mt_ns_unlock(mt, TRUE);
+  }
+
+  return ret;
 }
 #else
 fs_t* fs_mt_wrap(fs_t* impl) {
   return impl;
 }
+
+fs_t* fs_mt_wrap_once(fs_t** mt, fs_t* impl) {
+  return impl;
+}
+
+fs_t* fs_mt_unwrap(fs_t* fs) {
+  return fs;
+}
+
+fs_t* fs_mt_get_impl(fs_t* fs) {
+  return fs;
+}
+
+ret_t fs_mt_set_lock_mode(fs_t* fs, fs_mt_lock_mode_t mode) {
+  return RET_NOT_IMPL;
+}
+
+ret_t fs_mt_exec_exclusive(fs_t* fs, fs_mt_exclusive_func_t func, void* ctx) {
+  return_value_if_fail(func != NULL, RET_BAD_PARAMS);
+
+  return func(ctx);
+}
 #endif /*WITH_FS_MT*/
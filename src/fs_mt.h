@@ -22,13 +22,33 @@
 #ifndef TK_FS_OS_MT_H
 #define TK_FS_OS_MT_H
 
-#include "tkc/str.h"
+#include "tkc/fs.h"
 
 BEGIN_C_DECLS
 
+/**
+ * @enum fs_mt_lock_mode_t
+ * @prefix FS_MT_LOCK_
+ * 多线程fs的加锁方式。
+ */
+typedef enum _fs_mt_lock_mode_t {
+  /**
+   * @const FS_MT_LOCK_GLOBAL
+   * 所有调用共用一把锁(缺省)。
+   */
+  FS_MT_LOCK_GLOBAL = 0,
+  /**
+   * @const FS_MT_LOCK_PER_FILE
+   * 每个打开的文件/目录各有一把锁，名字空间使用读写锁，不同文件的I/O可以并行。
+   * 要求被包装的fs本身可以并发访问不同的文件(如posix，或者打开FF_FS_REENTRANT的fatfs)。
+   */
+  FS_MT_LOCK_PER_FILE
+} fs_mt_lock_mode_t;
+
 /**
  * @method fs_mt_wrap
  * 把fs对象包装成可以多线程访问的fs对象。
+ * > 每次调用都会创建一个新的包装对象，各自拥有自己的锁。不再使用时调用fs_mt_unwrap销毁。
  * @annotation ["global"]
  * @param {fs_t*} fs fs对象。
  *
@@ -36,6 +56,72 @@ BEGIN_C_DECLS
  */
 fs_t* fs_mt_wrap(fs_t* impl);
 
+/**
+ * @method fs_mt_wrap_once
+ * 第一次调用时用fs_mt_wrap包装impl并保存到*mt，之后直接返回*mt。
+ * 多个线程同时第一次调用时只创建一个包装对象，其它线程等待创建完成(用于os_fs_xxx的全局对象)。
+ * > 编译器不支持原子操作时没有保护，需要在创建其它线程之前先调用一次。
+ * @annotation ["global"]
+ * @param {fs_t**} mt 保存包装对象的变量，初始值为NULL。
+ * @param {fs_t*} impl 被包装的fs对象。
+ *
+ * @return {fs_t*} 可以多线程访问的fs对象，失败返回NULL。
+ */
+fs_t* fs_mt_wrap_once(fs_t** mt, fs_t* impl);
+
+/**
+ * @method fs_mt_unwrap
+ * 销毁fs_mt_wrap创建的包装对象。
+ * > 调用前需要关闭通过该对象打开的全部文件/目录。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_mt_wrap返回的fs对象。
+ *
+ * @return {fs_t*} 返回被包装的fs对象，失败返回NULL。
+ */
+fs_t* fs_mt_unwrap(fs_t* fs);
+
+/**
+ * @method fs_mt_get_impl
+ * 获取被包装的fs对象(不销毁包装对象)。
+ * > 直接使用被包装的fs对象时没有加锁，只能在单线程中使用(如对比加锁的开销)。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs对象。
+ *
+ * @return {fs_t*} fs是fs_mt_wrap返回的对象时返回被包装的fs对象，否则返回fs本身。
+ */
+fs_t* fs_mt_get_impl(fs_t* fs);
+
+/**
+ * @method fs_mt_set_lock_mode
+ * 设置加锁方式。
+ * > 只能在没有打开的文件/目录，且没有其它线程访问时调用。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_mt_wrap返回的fs对象。
+ * @param {fs_mt_lock_mode_t} mode 加锁方式。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，返回RET_BUSY表示还有打开的文件/目录。
+ */
+ret_t fs_mt_set_lock_mode(fs_t* fs, fs_mt_lock_mode_t mode);
+
+/**
+ * 独占执行的回调函数。
+ */
+typedef ret_t (*fs_mt_exclusive_func_t)(void* ctx);
+
+/**
+ * @method fs_mt_exec_exclusive
+ * 在其它线程都不能访问文件系统的情况下执行func，用于在fs接口之外直接操作被包装的文件系统
+ * (如spiffs的增量垃圾回收)。
+ * > func中不能再通过fs调用(锁不可重入)。没有定义WITH_FS_MT或者fs不是fs_mt_wrap返回的对象时直接调用func。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs对象。
+ * @param {fs_mt_exclusive_func_t} func 回调函数。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {ret_t} 返回func的返回值，加锁失败时返回RET_FAIL。
+ */
+ret_t fs_mt_exec_exclusive(fs_t* fs, fs_mt_exclusive_func_t func, void* ctx);
+
 END_C_DECLS
 
 #endif /*TK_FS_OS_MT_H*/
@@ -0,0 +1,104 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/thread.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "fs_mt.h"
+
+#define BLOCK_SIZE 4096
+#define DURATION_MS 1000
+#define MAX_THREADS 8
+
+extern fs_t* os_fs_posix(void);
+
+typedef struct _bench_ctx_t {
+  fs_t* fs;
+  uint32_t id;
+  uint64_t end_ms;
+  uint32_t ops;
+} bench_ctx_t;
+
+static void* bench_thread(void* args) {
+  char filename[MAX_PATH + 1];
+  uint8_t buff[BLOCK_SIZE];
+  bench_ctx_t* ctx = (bench_ctx_t*)args;
+  fs_t* fs = ctx->fs;
+  fs_file_t* fp = NULL;
+
+  tk_snprintf(filename, MAX_PATH, "fs_mt_bench/%u.bin", ctx->id);
+  fp = fs_open_file(fs, filename, "wb+");
+  assert(fp != NULL);
+  memset(buff, ctx->id, sizeof(buff));
+
+  while (time_now_ms() < ctx->end_ms) {
+    assert(fs_file_seek(fp, 0) == RET_OK);
+    assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+    assert(fs_file_seek(fp, 0) == RET_OK);
+    assert(fs_file_read(fp, buff, sizeof(buff)) == sizeof(buff));
+    assert(fs_file_exist(fs, filename));
+    ctx->ops++;
+  }
+
+  fs_file_close(fp);
+  fs_remove_file(fs, filename);
+
+  return NULL;
+}
+
+static uint32_t bench_run(fs_t* fs, uint32_t nr) {
+  uint32_t i = 0;
+  uint32_t ops = 0;
+  bench_ctx_t ctx[MAX_THREADS];
+  tk_thread_t* threads[MAX_THREADS];
+  uint64_t end_ms = time_now_ms() + DURATION_MS;
+
+  for (i = 0; i < nr; i++) {
+    ctx[i].fs = fs;
+    ctx[i].id = i;
+    ctx[i].ops = 0;
+    ctx[i].end_ms = end_ms;
+    threads[i] = tk_thread_create(bench_thread, ctx + i);
+    tk_thread_set_stack_size(threads[i], 0xc000);
+    tk_thread_start(threads[i]);
+  }
+
+  for (i = 0; i < nr; i++) {
+    tk_thread_join(threads[i]);
+    tk_thread_destroy(threads[i]);
+    ops += ctx[i].ops;
+  }
+
+  return ops * 1000 / DURATION_MS;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t nr = 0;
+  fs_t* fs = os_fs_posix();
+  platform_prepare();
+
+  if (!fs_dir_exist(fs, "fs_mt_bench")) {
+    assert(fs_create_dir(fs, "fs_mt_bench") == RET_OK);
+  }
+
+  log_debug("threads\tglobal(ops/s)\tper_file(ops/s)\n");
+  for (nr = 1; nr <= MAX_THREADS; nr *= 2) {
+    uint32_t global = 0;
+    uint32_t per_file = 0;
+
+    assert(fs_mt_set_lock_mode(fs, FS_MT_LOCK_GLOBAL) == RET_OK);
+    global = bench_run(fs, nr);
+    assert(fs_mt_set_lock_mode(fs, FS_MT_LOCK_PER_FILE) == RET_OK);
+    per_file = bench_run(fs, nr);
+
+    log_debug("%u\t%u\t%u\n", nr, global, per_file);
+  }
+
+  assert(fs_mt_set_lock_mode(fs, FS_MT_LOCK_GLOBAL) == RET_OK);
+  assert(fs_remove_dir(fs, "fs_mt_bench") == RET_OK);
+
+  return 0;
+}
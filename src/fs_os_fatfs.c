@@ -24,21 +24,26 @@
 #endif /*WIN32_LEAN_AND_MEAN*/
 
 #include "ff.h"
+#include "diskio.h"
 #include "tkc/fs.h"
 #include "tkc/mem.h"
 #include "tkc/utils.h"
 #include <stdarg.h>
 
 #include "fs_mt.h"
+#include "fs_printf.h"
+#include "fs_file_ext.h"
 #include "fs_os_conf.h"
-
-#if defined(LINUX) || defined(WIN32) || defined(MACOS) || defined(HAS_STDIO)
-#include <stdio.h>
-#endif
+#include "fs_os_fatfs.h"
 
 typedef struct _fs_file_ff_t {
   fs_file_t fs_file;
   FIL file;
+#if FF_USE_FASTSEEK
+  /*簇链映射表(CLMT)，第一次远距离定位时创建，关闭文件时释放。*/
+  DWORD* cltbl;
+  UINT cltbl_size;
+#endif /*FF_USE_FASTSEEK*/
 } fs_file_ff_t;
 
 static const TCHAR* path_from_utf8(TCHAR path[MAX_PATH + 1], const char* utf8_path) {
@@ -63,6 +68,84 @@ static inline ret_t fresult_to_ret(FRESULT ret) {
   }
 }
 
+#if FF_MAX_SS == FF_MIN_SS
+#define FS_FF_SS(fs) ((UINT)FF_MAX_SS)
+#else
+#define FS_FF_SS(fs) ((UINT)((fs)->ssize))
+#endif /*FF_MAX_SS == FF_MIN_SS*/
+
+#define FS_FF_SECTOR_SIZE(fp) FS_FF_SS((fp)->obj.fs)
+
+#if FF_USE_FASTSEEK
+/*文件的簇链可能变化(扩展或者截断)时，放弃映射表，回到沿FAT链定位的方式。*/
+static void fs_ff_drop_clmt(fs_file_ff_t* ff) {
+  ff->file.cltbl = NULL;
+}
+
+/*创建映射表，表不够大时按FatFs返回的所需大小重新分配。失败时仍然沿FAT链定位。*/
+static void fs_ff_build_clmt(fs_file_ff_t* ff) {
+  FRESULT ret = FR_OK;
+  FIL* fp = &(ff->file);
+  UINT size = tk_max(ff->cltbl_size, FS_OS_FATFS_CLMT_SIZE);
+
+  do {
+    if (size > ff->cltbl_size) {
+      DWORD* cltbl = TKMEM_REALLOCT(DWORD, ff->cltbl, size);
+      if (cltbl == NULL) {
+        return;
+      }
+      ff->cltbl = cltbl;
+      ff->cltbl_size = size;
+    }
+
+    ff->cltbl[0] = ff->cltbl_size;
+    fp->cltbl = ff->cltbl;
+    ret = f_lseek(fp, CREATE_LINKMAP);
+    if (ret != FR_OK) {
+      fp->cltbl = NULL;
+      size = ff->cltbl[0];
+    }
+  } while (ret == FR_NOT_ENOUGH_CORE && size > ff->cltbl_size);
+}
+
+/*沿FAT链定位需要经过的簇数(向后定位时从文件头开始)。*/
+static DWORD fs_ff_seek_distance(FIL* fp, FSIZE_t ofs) {
+  DWORD to = 0;
+  DWORD from = 0;
+  FSIZE_t bcs = (FSIZE_t)fp->obj.fs->csize * FS_FF_SECTOR_SIZE(fp);
+
+  if (ofs == 0) {
+    return 0;
+  }
+
+  to = (DWORD)((ofs - 1) / bcs);
+  if (fp->fptr == 0) {
+    return to;
+  }
+
+  from = (DWORD)((fp->fptr - 1) / bcs);
+  return to >= from ? to - from : to;
+}
+#endif /*FF_USE_FASTSEEK*/
+
+/*
+ * 定位超出文件大小时(写模式下扩展文件)需要沿FAT链定位。在文件内部远距离定位时，
+ * 创建簇链映射表，之后每次定位只查表，不再随文件大小变慢。
+ */
+static FRESULT fs_ff_lseek(fs_file_ff_t* ff, FSIZE_t ofs) {
+  FIL* fp = &(ff->file);
+
+#if FF_USE_FASTSEEK
+  if (ofs > f_size(fp)) {
+    fs_ff_drop_clmt(ff);
+  } else if (fp->cltbl == NULL && fs_ff_seek_distance(fp, ofs) >= FS_OS_FATFS_FASTSEEK_CLUSTERS) {
+    fs_ff_build_clmt(ff);
+  }
+#endif /*FF_USE_FASTSEEK*/
+
+  return f_lseek(fp, ofs);
+}
+
 static int32_t fs_os_file_read(fs_file_t* file, void* buffer, uint32_t size) {
   UINT br = 0;
   FIL* fp = &(((fs_file_ff_t*)file)->file);
@@ -75,10 +158,18 @@ static int32_t fs_os_file_read(fs_file_t* file, void* buffer, uint32_t size) {
   }
 }
 
-int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+static int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
   UINT bw = 0;
+  FRESULT ret = FR_OK;
   FIL* fp = &(((fs_file_ff_t*)file)->file);
-  FRESULT ret = f_write(fp, buffer, size, &bw);
+
+#if FF_USE_FASTSEEK
+  /*映射表模式下f_write不能分配新的簇。*/
+  if (fp->cltbl != NULL && fp->fptr + size > f_size(fp)) {
+    fs_ff_drop_clmt((fs_file_ff_t*)file);
+  }
+#endif /*FF_USE_FASTSEEK*/
+  ret = f_write(fp, buffer, size, &bw);
 
   if (ret == FR_OK) {
     return (int32_t)bw;
@@ -87,20 +178,12 @@ int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
   }
 }
 
-int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
-  int32_t n = 0;
-  char buffer[256] = {0};
-  n = tk_vsnprintf(buffer, sizeof(buffer), format, args);
-  return_value_if_fail(n >= 0, 0);
-
-  return fs_os_file_write(file, buffer, n);
+static int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
+  return fs_file_vprintf_stream(file, fs_os_file_write, format, args);
 }
 
 static ret_t fs_os_file_seek(fs_file_t* file, int32_t offset) {
-  FIL* fp = &(((fs_file_ff_t*)file)->file);
-  FRESULT ret = f_lseek(fp, offset);
-
-  return fresult_to_ret(ret);
+  return fresult_to_ret(fs_ff_lseek((fs_file_ff_t*)file, offset));
 }
 
 static int64_t fs_os_file_tell(fs_file_t* file) {
@@ -130,18 +213,61 @@ static ret_t fs_os_file_sync(fs_file_t* file) {
   return f_sync(fp) == 0 ? RET_OK : RET_FAIL;
 }
 
+/*
+ * 从from开始写入0，直到size(文件不够大时扩展到size)。新分配的簇内容不确定，截断扩展文件、
+ * pwrite越过文件末尾和预先分配时都用它把新的部分填0。
+ */
+static FRESULT fs_ff_fill_zero(fs_file_ff_t* ff, FSIZE_t from, FSIZE_t size) {
+  UINT bw = 0;
+  FIL* fp = &(ff->file);
+  static const BYTE s_zeros[FF_MIN_SS];
+  FRESULT ret = FR_OK;
+
+#if FF_USE_FASTSEEK
+  /*映射表模式下f_write不能分配新的簇。*/
+  fs_ff_drop_clmt(ff);
+#endif /*FF_USE_FASTSEEK*/
+  ret = f_lseek(fp, from);
+  while (ret == FR_OK && f_tell(fp) < size) {
+    UINT n = (UINT)tk_min(size - f_tell(fp), sizeof(s_zeros));
+    ret = f_write(fp, s_zeros, n, &bw);
+    if (ret == FR_OK && bw < n) {
+      /*磁盘已满。*/
+      ret = FR_DENIED;
+    }
+  }
+
+  return ret;
+}
+
 static ret_t fs_os_file_truncate(fs_file_t* file, int32_t size) {
+  FRESULT ret = FR_OK;
   FIL* fp = &(((fs_file_ff_t*)file)->file);
-
-  if (size == 0) {
-    return fresult_to_ret(f_truncate(fp));
+  FSIZE_t pos = f_tell(fp);
+  return_value_if_fail(size >= 0, RET_BAD_PARAMS);
+
+#if FF_USE_FASTSEEK
+  fs_ff_drop_clmt((fs_file_ff_t*)file);
+#endif /*FF_USE_FASTSEEK*/
+  if ((FSIZE_t)size > f_size(fp)) {
+    ret = fs_ff_fill_zero((fs_file_ff_t*)file, f_size(fp), (FSIZE_t)size);
   } else {
-    assert(!"not impl");
-    return RET_NOT_IMPL;
+    /*f_truncate在当前的读写位置截断。*/
+    ret = f_lseek(fp, (FSIZE_t)size);
+    if (ret == FR_OK) {
+      ret = f_truncate(fp);
+    }
   }
+
+  /*和ftruncate一样保持读写位置，但不超过文件末尾(写模式下越过末尾定位会扩展文件)。*/
+  if (f_lseek(fp, tk_min(pos, f_size(fp))) != FR_OK) {
+    return RET_FAIL;
+  }
+
+  return fresult_to_ret(ret);
 }
 
-bool_t fs_os_file_eof(fs_file_t* file) {
+static bool_t fs_os_file_eof(fs_file_t* file) {
   FIL* fp = &(((fs_file_ff_t*)file)->file);
 
   return f_eof(fp);
@@ -151,6 +277,9 @@ static ret_t fs_os_file_close(fs_file_t* file) {
   FIL* fp = &(((fs_file_ff_t*)file)->file);
 
   f_close(fp);
+#if FF_USE_FASTSEEK
+  TKMEM_FREE(((fs_file_ff_t*)file)->cltbl);
+#endif /*FF_USE_FASTSEEK*/
   TKMEM_FREE(file);
 
   return RET_OK;
@@ -220,6 +349,136 @@ static ret_t fs_os_dir_close(fs_dir_t* dir) {
   return RET_OK;
 }
 
+/*fatfs没有pread/pwrite，保存并恢复fptr。调用者(fs_mt)保证期间没有其它线程使用该文件。*/
+static int32_t fs_os_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset) {
+  UINT br = 0;
+  FRESULT ret = FR_OK;
+  FIL* fp = &(((fs_file_ff_t*)file)->file);
+  FSIZE_t pos = f_tell(fp);
+
+  if (offset >= f_size(fp)) {
+    return 0;
+  }
+
+  if (fs_ff_lseek((fs_file_ff_t*)file, (FSIZE_t)offset) != FR_OK) {
+    return -1;
+  }
+  ret = f_read(fp, buffer, size, &br);
+  if (fs_ff_lseek((fs_file_ff_t*)file, pos) != FR_OK || ret != FR_OK) {
+    return -1;
+  }
+
+  return (int32_t)br;
+}
+
+static int32_t fs_os_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size,
+                                 uint64_t offset) {
+  int32_t bw = 0;
+  FIL* fp = &(((fs_file_ff_t*)file)->file);
+  FSIZE_t pos = f_tell(fp);
+
+  /*与posix的pwrite一致，文件末尾到offset之间的空洞读出为0。*/
+  if (offset > f_size(fp) &&
+      fs_ff_fill_zero((fs_file_ff_t*)file, f_size(fp), (FSIZE_t)offset) != FR_OK) {
+    fs_ff_lseek((fs_file_ff_t*)file, pos);
+    return -1;
+  }
+
+  if (fs_ff_lseek((fs_file_ff_t*)file, (FSIZE_t)offset) != FR_OK) {
+    return -1;
+  }
+  bw = fs_os_file_write(file, buffer, size);
+  if (fs_ff_lseek((fs_file_ff_t*)file, pos) != FR_OK || bw < 0) {
+    return -1;
+  }
+
+  return bw;
+}
+
+/*
+ * 空文件用f_expand分配连续的簇。文件不为空或者没有足够大的连续空间时，从文件末尾写0扩展簇链
+ * (不保证连续)。新分配的簇中是以前的数据，两种方式都把新的部分填0，与posix_fallocate一致。
+ */
+static ret_t fs_os_file_allocate(fs_file_t* file, uint64_t size) {
+  FRESULT ret = FR_OK;
+  FSIZE_t from = 0;
+  FIL* fp = &(((fs_file_ff_t*)file)->file);
+  FSIZE_t pos = f_tell(fp);
+  return_value_if_fail(size <= (FSIZE_t)0xFFFFFFFF, RET_BAD_PARAMS);
+
+  if (size <= f_size(fp)) {
+    return RET_OK;
+  }
+  return_value_if_fail(fp->flag & FA_WRITE, RET_BAD_PARAMS);
+
+  from = f_size(fp);
+  if (from == 0) {
+    /*f_expand分配连续的簇并把文件大小设为size，之后从头写0。*/
+    ret = f_expand(fp, (FSIZE_t)size, 1);
+    if (ret != FR_OK && ret != FR_DENIED) {
+      return RET_FAIL;
+    }
+  }
+
+  ret = fs_ff_fill_zero((fs_file_ff_t*)file, from, (FSIZE_t)size);
+  if (f_lseek(fp, pos) != FR_OK) {
+    return RET_FAIL;
+  }
+
+  return fresult_to_ret(ret);
+}
+
+#if !FF_FS_TINY
+/*
+ * fptr不在扇区边界上时，fp->buf中一定是当前扇区的数据(f_read/f_write/f_lseek都维护这一点)，
+ * 直接借出扇区中剩余的数据。在扇区边界上时，先读1个字节，让f_read把扇区读入fp->buf。
+ */
+static int32_t fs_os_file_borrow(fs_file_t* file, uint32_t size, void* scratch,
+                                 const void** data) {
+  UINT br = 0;
+  UINT n = 0;
+  UINT offset = 0;
+  FSIZE_t remain = 0;
+  FIL* fp = &(((fs_file_ff_t*)file)->file);
+  UINT ss = FS_FF_SECTOR_SIZE(fp);
+
+  offset = (UINT)(fp->fptr % ss);
+  remain = fp->obj.objsize - fp->fptr;
+  if (size == 0 || remain == 0 || fp->err != FR_OK || !(fp->flag & FA_READ) ||
+      (offset == 0 && size >= ss)) {
+    /*整扇区的读由f_read直接读入scratch，同样没有额外的拷贝。*/
+    *data = scratch;
+    return fs_os_file_read(file, scratch, size);
+  }
+
+  if (offset == 0) {
+    BYTE c = 0;
+    if (f_read(fp, &c, 1, &br) != FR_OK || br != 1) {
+      return -1;
+    }
+    n = (UINT)tk_min(size, tk_min(ss, remain));
+    fp->fptr += n - 1;
+  } else {
+    n = (UINT)tk_min(size, tk_min(ss - offset, remain));
+    fp->fptr += n;
+  }
+  *data = fp->buf + offset;
+
+  return (int32_t)n;
+}
+
+#endif /*!FF_FS_TINY*/
+
+/*借用的数据在下一次操作该文件之前一直有效，不需要额外处理。*/
+static const fs_file_ext_vtable_t s_file_ext_vtable = {
+#if !FF_FS_TINY
+    .borrow = fs_os_file_borrow,
+#endif /*!FF_FS_TINY*/
+    .pread = fs_os_file_pread,
+    .pwrite = fs_os_file_pwrite,
+    .allocate = fs_os_file_allocate,
+};
+
 static const fs_file_vtable_t s_file_vtable = {.read = fs_os_file_read,
                                                .write = fs_os_file_write,
                                                .printf = fs_os_file_printf,
@@ -428,15 +687,208 @@ static int32_t fs_os_get_file_size(fs_t* fs, const char* name) {
   }
 }
 
+/*根据卷名(如"0:"，为NULL或""时表示当前驱动器)找到挂载的FATFS对象。*/
+static FATFS* fs_ff_find_volume(const char* volume) {
+  FF_DIR dir;
+  FATFS* fs = NULL;
+  TCHAR path[MAX_PATH + 1];
+
+  if (f_opendir(&dir, path_from_utf8(path, volume != NULL ? volume : "")) == FR_OK) {
+    fs = dir.obj.fs;
+    f_closedir(&dir);
+  }
+
+  return fs;
+}
+
+/*
+ * 统计FAT16/FAT32中值为0的表项，每次处理8个字节(4个FAT16表项或者2个FAT32表项)：
+ * 对每个表项(lane)，低位非0时(x & low) + low会向最高位进位，再或上x本身，
+ * 最高位为0当且仅当整个表项为0。取反后把每个lane的最高位移到最低位累加，最后把各个lane相加。
+ * 判断是否为0与字节序无关，FAT32表项的高4位是保留位，用按字节构造的掩码去掉。
+ * size不超过FS_OS_FATFS_SCAN_SECTORS个扇区，每个lane的累加值不会溢出。
+ */
+static uint32_t fs_ff_count_zero_entries(const uint8_t* buff, uint32_t size, uint32_t entry_size) {
+  uint64_t x = 0;
+  uint32_t i = 0;
+  uint32_t n = 0;
+  uint64_t acc = 0;
+  uint64_t mask = ~(uint64_t)0;
+  uint32_t shift = entry_size * 8 - 1;
+  uint64_t high = entry_size == 2 ? 0x8000800080008000ULL : 0x8000000080000000ULL;
+  uint64_t low = ~high;
+  static const uint8_t s_fat32_mask[8] = {0xff, 0xff, 0xff, 0x0f, 0xff, 0xff, 0xff, 0x0f};
+
+  if (entry_size == 4) {
+    memcpy(&mask, s_fat32_mask, sizeof(mask));
+  }
+
+  for (i = 0; i + sizeof(x) <= size; i += sizeof(x)) {
+    memcpy(&x, buff + i, sizeof(x));
+    x &= mask;
+    acc += (~(((x & low) + low) | x | low)) >> shift;
+  }
+
+  if (entry_size == 2) {
+    n = (uint32_t)((acc * 0x0001000100010001ULL) >> 48);
+  } else {
+    n = (uint32_t)(acc & 0xffffffff) + (uint32_t)(acc >> 32);
+  }
+
+  for (; i < size; i += entry_size) {
+    const uint8_t* p = buff + i;
+    if (entry_size == 2) {
+      n += (p[0] | p[1]) == 0;
+    } else {
+      n += (p[0] | p[1] | p[2] | (p[3] & 0x0f)) == 0;
+    }
+  }
+
+  return n;
+}
+
+/*统计FAT12中值为0的表项，每3个字节存放两个12位的表项。*/
+static uint32_t fs_ff_count_zero_fat12(const uint8_t* buff, uint32_t entries) {
+  uint32_t i = 0;
+  uint32_t n = 0;
+  const uint8_t* p = buff;
+
+  for (i = 0; i + 1 < entries; i += 2, p += 3) {
+    n += (p[0] | (p[1] & 0x0f)) == 0;
+    n += ((p[1] & 0xf0) | p[2]) == 0;
+  }
+
+  if (i < entries) {
+    n += (p[0] | (p[1] & 0x0f)) == 0;
+  }
+
+  return n;
+}
+
+/*
+ * 重新统计空闲簇，结果保存到fs->free_clst。
+ * 和f_getfree一样统计全部n_fatent个表项(0号和1号表项总是非0)，但每次用disk_read读取多个扇区，
+ * 并按字比较，而不是经过扇区窗口逐个表项读取。
+ */
+static FRESULT fs_ff_count_free(FATFS* fs) {
+  DWORD n = 0;
+  DWORD done = 0;
+  DWORD count = 0;
+  DWORD nfree = 0;
+  uint32_t bytes = 0;
+  uint8_t* buff = NULL;
+  FRESULT res = FR_OK;
+  UINT ss = FS_FF_SS(fs);
+  DWORD sect = fs->fatbase;
+  uint32_t batch_size = ss * FS_OS_FATFS_SCAN_SECTORS;
+  uint32_t entry_size = fs->fs_type == FS_FAT16 ? 2 : 4;
+  DWORD batch_entries = fs->fs_type == FS_FAT12 ? batch_size / 3 * 2 : batch_size / entry_size;
+
+  if (fs->fs_type != FS_FAT12 && fs->fs_type != FS_FAT16 && fs->fs_type != FS_FAT32) {
+    return FR_INVALID_PARAMETER;
+  }
+
+  buff = (uint8_t*)TKMEM_ALLOC(batch_size);
+  return_value_if_fail(buff != NULL, FR_NOT_ENOUGH_CORE);
+
+  while (done < fs->n_fatent) {
+    n = tk_min(fs->n_fatent - done, batch_entries);
+    bytes = fs->fs_type == FS_FAT12 ? (n * 3 + 1) / 2 : n * entry_size;
+    count = (bytes + ss - 1) / ss;
+
+    if (disk_read(fs->pdrv, buff, sect, count) != RES_OK) {
+      res = FR_DISK_ERR;
+      break;
+    }
+
+    /*扇区窗口中可能有还没有写回的修改，以窗口中的数据为准。*/
+    if (fs->winsect >= sect && fs->winsect < sect + count) {
+      memcpy(buff + (fs->winsect - sect) * ss, fs->win, ss);
+    }
+
+    if (fs->fs_type == FS_FAT12) {
+      nfree += fs_ff_count_zero_fat12(buff, n);
+    } else {
+      nfree += fs_ff_count_zero_entries(buff, bytes, entry_size);
+    }
+
+    done += n;
+    sect += count;
+  }
+  TKMEM_FREE(buff);
+
+  if (res == FR_OK) {
+    fs->free_clst = nfree;
+    fs->fsi_flag |= 1;
+  }
+
+  return res;
+}
+
 static ret_t fs_os_get_disk_info(fs_t* fs, const char* volume, int32_t* free_kb,
                                  int32_t* total_kb) {
-  /*TODO*/
+  DWORD nclst = 0;
+  uint64_t cluster_size = 0;
+  FATFS* ffs = NULL;
+  TCHAR path[MAX_PATH + 1];
+  return_value_if_fail(free_kb != NULL && total_kb != NULL, RET_BAD_PARAMS);
+
   *free_kb = 0;
   *total_kb = 0;
-  (void)fs;
-  assert(!"fs_os_get_disk_info not supported yet");
+  ffs = fs_ff_find_volume(volume);
+  return_value_if_fail(ffs != NULL, RET_FAIL);
+
+  /*
+   * free_clst有效时(来自FSINFO或者之前的统计，FatFs在分配和释放簇时同步更新)，
+   * f_getfree直接返回。挂载后第一次调用(FAT12/16没有FSINFO)时先按字统计，
+   * 避免f_getfree逐个表项扫描FAT。
+   */
+  if (ffs->free_clst > ffs->n_fatent - 2) {
+    fs_ff_count_free(ffs);
+  }
 
-  return RET_NOT_IMPL;
+  if (f_getfree(path_from_utf8(path, volume != NULL ? volume : ""), &nclst, &ffs) != FR_OK) {
+    return RET_FAIL;
+  }
+
+  cluster_size = (uint64_t)ffs->csize * FS_FF_SS(ffs);
+  *free_kb = (int32_t)(nclst * cluster_size / 1024);
+  *total_kb = (int32_t)((ffs->n_fatent - 2) * cluster_size / 1024);
+
+  return RET_OK;
+}
+
+typedef struct _os_fs_fatfs_rescan_ctx_t {
+  const char* volume;
+  uint32_t free_clst;
+} os_fs_fatfs_rescan_ctx_t;
+
+/*在fs_mt的锁内查找卷并扫描FAT，期间其它线程不会修改FAT和扇区窗口。*/
+static ret_t os_fs_fatfs_rescan_free_locked(void* ctx) {
+  os_fs_fatfs_rescan_ctx_t* rescan = (os_fs_fatfs_rescan_ctx_t*)ctx;
+  FATFS* ffs = fs_ff_find_volume(rescan->volume);
+  return_value_if_fail(ffs != NULL, RET_FAIL);
+
+  if (fs_ff_count_free(ffs) != FR_OK) {
+    return RET_FAIL;
+  }
+  rescan->free_clst = ffs->free_clst;
+
+  return RET_OK;
+}
+
+ret_t os_fs_fatfs_rescan_free(const char* volume, uint32_t* free_clst) {
+  os_fs_fatfs_rescan_ctx_t rescan = {volume, 0};
+
+  if (fs_mt_exec_exclusive(os_fs_fatfs(), os_fs_fatfs_rescan_free_locked, &rescan) != RET_OK) {
+    return RET_FAIL;
+  }
+
+  if (free_clst != NULL) {
+    *free_clst = rescan.free_clst;
+  }
+
+  return RET_OK;
 }
 
 static ret_t fs_os_get_exe(fs_t* fs, char path[MAX_PATH + 1]) {
@@ -509,8 +961,11 @@ static const fs_t s_os_fs = {.open_file = fs_os_open_file,
                              .stat = fs_os_stat};
 
 fs_t* os_fs_fatfs(void) {
+  fs_file_ext_register(&s_file_vtable, &s_file_ext_vtable);
 #ifdef WITH_FS_MT
-  return fs_mt_wrap((fs_t*)&s_os_fs);
+  static fs_t* s_os_fs_mt = NULL;
+
+  return fs_mt_wrap_once(&s_os_fs_mt, (fs_t*)&s_os_fs);
 #else
   return (fs_t*)&s_os_fs;
 #endif /*WITH_FS_MT*/
@@ -0,0 +1,84 @@
+/**
+ * File:   fs_os_fatfs.h
+ * Author: AWTK Develop Team
+ * Brief:  fatfs implemented fs
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_OS_FATFS_H
+#define TK_FS_OS_FATFS_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 统计空闲簇时每次从磁盘读取的扇区数。
+ * 必须是3的倍数(FAT12的两个表项占3个字节，这样表项不会跨两次读取)。
+ */
+#ifndef FS_OS_FATFS_SCAN_SECTORS
+#define FS_OS_FATFS_SCAN_SECTORS 12
+#endif /*FS_OS_FATFS_SCAN_SECTORS*/
+
+#if FS_OS_FATFS_SCAN_SECTORS % 3 != 0
+#error "FS_OS_FATFS_SCAN_SECTORS must be a multiple of 3"
+#endif /*FS_OS_FATFS_SCAN_SECTORS % 3 != 0*/
+
+/**
+ * 定位时沿FAT链需要经过的簇数达到该值时，为文件创建簇链映射表(FatFs的快速定位)。
+ * 之后在文件内的定位只查表，不再随文件大小变慢。文件扩展或者截断时放弃映射表，下次远距离定位时重建。
+ */
+#ifndef FS_OS_FATFS_FASTSEEK_CLUSTERS
+#define FS_OS_FATFS_FASTSEEK_CLUSTERS 8
+#endif /*FS_OS_FATFS_FASTSEEK_CLUSTERS*/
+
+/**
+ * 簇链映射表的初始大小(DWORD数)。每个连续的片段占2项，不够时按需要的大小重新分配。
+ */
+#ifndef FS_OS_FATFS_CLMT_SIZE
+#define FS_OS_FATFS_CLMT_SIZE 32
+#endif /*FS_OS_FATFS_CLMT_SIZE*/
+
+/**
+ * @method os_fs_fatfs
+ * 获取fatfs实现的fs对象。
+ *
+ * fs_get_disk_info使用FatFs缓存的空闲簇数(FSINFO或者之前统计的结果)，重复调用不扫描FAT。
+ * @annotation ["global"]
+ *
+ * @return {fs_t*} 返回fs对象。
+ */
+fs_t* os_fs_fatfs(void);
+
+/**
+ * @method os_fs_fatfs_rescan_free
+ * 重新统计卷的空闲簇数，并更新FatFs缓存的值(FAT32在同步时写回FSINFO)。
+ *
+ * 缓存的值不可信时(如FSINFO被其它系统写坏)使用。一次读取多个扇区，按字统计值为0的表项，
+ * 比f_getfree逐个表项的扫描快得多。
+ * > 在os_fs_fatfs()的fs_mt锁内扫描(与fs_mt_exec_exclusive相同)，期间其它线程通过os_fs_fatfs()的访问会等待。
+ * @annotation ["global"]
+ * @param {const char*} volume 卷名(如"0:")，为NULL时表示当前驱动器。
+ * @param {uint32_t*} free_clst 用于返回空闲簇数(可以为NULL)。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_fatfs_rescan_free(const char* volume, uint32_t* free_clst);
+
+END_C_DECLS
+
+#endif /*TK_FS_OS_FATFS_H*/
@@ -28,7 +28,12 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <fcntl.h>    
+#define FS_OS_POSIX_HAS_MMAP 1
+#define FS_OS_POSIX_HAS_UIO 1
+#define FS_OS_POSIX_HAS_PREAD 1
 #elif defined(WIN32)
 #include <windows.h>
 #include <io.h>        
@@ -39,6 +44,7 @@
 #include <stdlib.h> 
 #include "platforms/pc/dirent.inc"
 #define fsync(fd) 0
+#define ftruncate _chsize
 #define getcwd _getcwd
 #elif defined(RT_THREAD)
 #include <dfs_posix.h>
@@ -49,53 +55,221 @@
 #include "tkc/utils.h"
 
 #include "fs_mt.h"
+#include "fs_printf.h"
+#include "fs_file_ext.h"
 #include "fs_os_conf.h"
+#include "fs_os_posix.h"
 
 typedef struct _fs_file_posix_t {
   fs_file_t fs_file;
   int file;
+
+  /*用户态缓冲(以"B"标志打开时启用)*/
+  uint8_t* rbuf;
+  uint32_t rbuf_size;
+  uint32_t rpos;
+  uint32_t rlen;
+  uint8_t* wbuf;
+  uint32_t wbuf_size;
+  uint32_t wlen;
+
+  /*内存映射(只读打开且文件较大时启用)*/
+  uint8_t* map;
+  uint32_t map_size;
+  uint32_t map_pos;
 } fs_file_posix_t;
 
+static uint32_t s_read_ahead_size = FS_OS_POSIX_READ_AHEAD_SIZE;
+static uint32_t s_write_behind_size = FS_OS_POSIX_WRITE_BEHIND_SIZE;
+static uint32_t s_mmap_threshold = FS_OS_POSIX_MMAP_THRESHOLD;
 
-static int32_t fs_os_file_read(fs_file_t* file, void* buffer, uint32_t size) {
-  int fd = ((fs_file_posix_t*)file)->file;
+static ret_t fs_os_file_flush(fs_file_posix_t* ff) {
+  uint32_t offset = 0;
 
-  return (int32_t)read(fd, buffer, size);
+  while (offset < ff->wlen) {
+    int32_t ret = (int32_t)write(ff->file, ff->wbuf + offset, ff->wlen - offset);
+    if (ret <= 0) {
+      /*保留没有写出的数据。*/
+      memmove(ff->wbuf, ff->wbuf + offset, ff->wlen - offset);
+      ff->wlen -= offset;
+      return RET_FAIL;
+    }
+    offset += ret;
+  }
+  ff->wlen = 0;
+
+  return RET_OK;
 }
 
-int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
-  int fd = ((fs_file_posix_t*)file)->file;
-  return (int32_t)write(fd, buffer, size);
+/*丢弃预读的数据，并把内核中的文件位置退回到逻辑位置。*/
+static ret_t fs_os_file_drop_read_ahead(fs_file_posix_t* ff) {
+  int32_t unread = (int32_t)(ff->rlen - ff->rpos);
+
+  ff->rpos = 0;
+  ff->rlen = 0;
+  if (unread > 0 && lseek(ff->file, -unread, SEEK_CUR) < 0) {
+    return RET_FAIL;
+  }
+
+  return RET_OK;
+}
+
+static ret_t fs_os_file_sync_buffer(fs_file_posix_t* ff) {
+  if (ff->wlen > 0) {
+    return fs_os_file_flush(ff);
+  }
+
+  if (ff->rlen > 0) {
+    return fs_os_file_drop_read_ahead(ff);
+  }
+
+  return RET_OK;
+}
+
+static int32_t fs_os_file_read(fs_file_t* file, void* buffer, uint32_t size) {
+  int32_t ret = 0;
+  uint32_t done = 0;
+  uint8_t* p = (uint8_t*)buffer;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL) {
+    uint32_t n = tk_min(size, ff->map_size - ff->map_pos);
+    memcpy(buffer, ff->map + ff->map_pos, n);
+    ff->map_pos += n;
+    return (int32_t)n;
+  }
+
+  if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+    return -1;
+  }
+
+  if (ff->rbuf == NULL) {
+    return (int32_t)read(ff->file, buffer, size);
+  }
+
+  while (done < size) {
+    uint32_t avail = ff->rlen - ff->rpos;
+
+    if (avail > 0) {
+      uint32_t n = tk_min(avail, size - done);
+      memcpy(p + done, ff->rbuf + ff->rpos, n);
+      ff->rpos += n;
+      done += n;
+      continue;
+    }
+
+    if (size - done >= ff->rbuf_size) {
+      /*大块读不经过缓冲区。*/
+      ret = (int32_t)read(ff->file, p + done, size - done);
+      if (ret > 0) {
+        done += ret;
+      }
+      break;
+    }
+
+    ret = (int32_t)read(ff->file, ff->rbuf, ff->rbuf_size);
+    ff->rpos = 0;
+    ff->rlen = ret > 0 ? ret : 0;
+    if (ret <= 0) {
+      break;
+    }
+  }
+
+  if (done == 0 && ret < 0) {
+    return -1;
+  }
+
+  return (int32_t)done;
 }
 
-int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
-  int32_t n = 0;
-  char buffer[256] = {0};
-  n = tk_vsnprintf(buffer, sizeof(buffer), format, args);
-  return_value_if_fail(n >= 0, 0);
+static int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+  return_value_if_fail(ff->map == NULL, -1);
 
-  return fs_os_file_write(file, buffer, n);
+  if (ff->rlen > 0 && fs_os_file_drop_read_ahead(ff) != RET_OK) {
+    return -1;
+  }
+
+  if (ff->wbuf == NULL) {
+    return (int32_t)write(ff->file, buffer, size);
+  }
+
+  if (ff->wlen + size > ff->wbuf_size && fs_os_file_flush(ff) != RET_OK) {
+    return -1;
+  }
+
+  if (size >= ff->wbuf_size) {
+    /*大块写不经过缓冲区。*/
+    return (int32_t)write(ff->file, buffer, size);
+  }
+
+  /*合并小块写，缓冲区满、seek、读、sync或者close时写出。*/
+  memcpy(ff->wbuf + ff->wlen, buffer, size);
+  ff->wlen += size;
+
+  return (int32_t)size;
+}
+
+static int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
+  return fs_file_vprintf_stream(file, fs_os_file_write, format, args);
 }
 
 static ret_t fs_os_file_seek(fs_file_t* file, int32_t offset) {
-  int fd = ((fs_file_posix_t*)file)->file;
-  int32_t ret = (int32_t)lseek(fd, offset, SEEK_SET);
+  int32_t ret = 0;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL) {
+    return_value_if_fail(offset >= 0 && (uint32_t)offset <= ff->map_size, RET_FAIL);
+    ff->map_pos = offset;
+    return RET_OK;
+  }
+
+  if (ff->rlen > 0 && ff->wlen == 0) {
+    /*目标位置还在预读窗口内，保留预读的数据。*/
+    int64_t end = lseek(ff->file, 0, SEEK_CUR);
+    int64_t start = end - ff->rlen;
+
+    if (end >= 0 && offset >= start && offset <= end) {
+      ff->rpos = (uint32_t)(offset - start);
+      return RET_OK;
+    }
+  }
+
+  if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+    return RET_FAIL;
+  }
+  ff->rpos = 0;
+  ff->rlen = 0;
+
+  ret = (int32_t)lseek(ff->file, offset, SEEK_SET);
 
   return ret == offset ? RET_OK : RET_FAIL;
 }
 
 static int64_t fs_os_file_tell(fs_file_t* file) {
-  int fd = ((fs_file_posix_t*)file)->file;
+  int64_t pos = 0;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
 
-  (void)fd;
-  assert(!"not supported yet");
-  return 0;
+  if (ff->map != NULL) {
+    return ff->map_pos;
+  }
+
+  pos = lseek(ff->file, 0, SEEK_CUR);
+  if (pos < 0) {
+    return -1;
+  }
+
+  return pos - (int64_t)(ff->rlen - ff->rpos) + ff->wlen;
 }
 
 static int64_t fs_os_file_size(fs_file_t* file) {
   struct stat buf;
   int fd = ((fs_file_posix_t*)file)->file;
 
+  if (((fs_file_posix_t*)file)->wlen > 0) {
+    fs_os_file_flush((fs_file_posix_t*)file);
+  }
+
   if (fstat(fd, &buf) == 0) {
     return buf.st_size;
   }
@@ -132,6 +306,10 @@ static ret_t fs_os_file_stat(fs_file_t* file, fs_stat_info_t* fst) {
   struct stat buf;
   int fd = ((fs_file_posix_t*)file)->file;
 
+  if (((fs_file_posix_t*)file)->wlen > 0) {
+    fs_os_file_flush((fs_file_posix_t*)file);
+  }
+
   memset(fst, 0x00, sizeof(fs_stat_info_t));
   if (fstat(fd, &buf) == 0) {
     return fs_stat_info_from_stat(fst, &buf);
@@ -142,26 +320,60 @@ static ret_t fs_os_file_stat(fs_file_t* file, fs_stat_info_t* fst) {
 
 static ret_t fs_os_file_sync(fs_file_t* file) {
   int fd = ((fs_file_posix_t*)file)->file;
+
+  if (fs_os_file_sync_buffer((fs_file_posix_t*)file) != RET_OK) {
+    return RET_FAIL;
+  }
+
   return fsync(fd) == 0 ? RET_OK : RET_FAIL;
 }
 
 static ret_t fs_os_file_truncate(fs_file_t* file, int32_t size) {
-  assert(!"not impl");
-  return RET_NOT_IMPL;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+  return_value_if_fail(size >= 0, RET_BAD_PARAMS);
+
+  /*先写出缓冲的数据，丢弃预读的数据，ftruncate不改变读写位置。*/
+  if (fs_os_file_sync_buffer(ff) != RET_OK) {
+    return RET_FAIL;
+  }
+
+  return ftruncate(ff->file, (off_t)size) == 0 ? RET_OK : RET_FAIL;
 }
 
-bool_t fs_os_file_eof(fs_file_t* file) {
-  assert(!"not impl");
-  return FALSE;
+static bool_t fs_os_file_eof(fs_file_t* file) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL) {
+    return ff->map_pos >= ff->map_size;
+  }
+
+  return fs_os_file_tell(file) >= fs_os_file_size(file);
 }
 
 static ret_t fs_os_file_close(fs_file_t* file) {
-  int fd = ((fs_file_posix_t*)file)->file;
+  ret_t ret = RET_OK;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
 
-  close(fd);
+  if (ff->wlen > 0) {
+    ret = fs_os_file_flush(ff);
+  }
+
+#ifdef FS_OS_POSIX_HAS_MMAP
+  if (ff->map != NULL) {
+    munmap(ff->map, ff->map_size);
+  }
+#endif /*FS_OS_POSIX_HAS_MMAP*/
+
+  close(ff->file);
+  /*rbuf和wbuf是一次分配的。*/
+  if (ff->rbuf != NULL) {
+    TKMEM_FREE(ff->rbuf);
+  } else if (ff->wbuf != NULL) {
+    TKMEM_FREE(ff->wbuf);
+  }
   TKMEM_FREE(file);
 
-  return RET_OK;
+  return ret;
 }
 
 typedef struct _fs_dir_posix_t {
@@ -214,6 +426,220 @@ static ret_t fs_os_dir_close(fs_dir_t* dir) {
   return RET_OK;
 }
 
+static ret_t fs_os_file_map(fs_file_t* file, const void** data, uint32_t* size) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map == NULL) {
+    return RET_NOT_IMPL;
+  }
+
+  *data = ff->map;
+  *size = ff->map_size;
+
+  return RET_OK;
+}
+
+static int32_t fs_os_file_borrow(fs_file_t* file, uint32_t size, void* scratch,
+                                 const void** data) {
+  uint32_t n = 0;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL) {
+    n = tk_min(size, ff->map_size - ff->map_pos);
+    *data = ff->map + ff->map_pos;
+    ff->map_pos += n;
+    return (int32_t)n;
+  }
+
+  if (ff->rbuf != NULL) {
+    if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+      return -1;
+    }
+
+    /*预读缓冲区为空时，小块借用先填充缓冲区，大块借用直接读入scratch。*/
+    if (ff->rpos == ff->rlen && size < ff->rbuf_size) {
+      int32_t ret = (int32_t)read(ff->file, ff->rbuf, ff->rbuf_size);
+      ff->rpos = 0;
+      ff->rlen = ret > 0 ? ret : 0;
+      if (ret < 0) {
+        return -1;
+      }
+    }
+
+    if (ff->rpos < ff->rlen) {
+      n = tk_min(size, ff->rlen - ff->rpos);
+      *data = ff->rbuf + ff->rpos;
+      ff->rpos += n;
+      return (int32_t)n;
+    }
+  }
+
+  *data = scratch;
+  return fs_os_file_read(file, scratch, size);
+}
+
+#ifdef FS_OS_POSIX_HAS_UIO
+/*每次系统调用最多提交的数据块个数。*/
+#define FS_OS_POSIX_IOV_NR 16
+
+static int32_t fs_os_file_rwv(int fd, const fs_iovec_t* iov, uint32_t iovcnt, bool_t is_write) {
+  uint32_t i = 0;
+  int32_t done = 0;
+  struct iovec vec[FS_OS_POSIX_IOV_NR];
+
+  while (i < iovcnt) {
+    uint32_t n = 0;
+    ssize_t ret = 0;
+    ssize_t expected = 0;
+
+    for (n = 0; n < ARRAY_SIZE(vec) && i + n < iovcnt; n++) {
+      vec[n].iov_base = iov[i + n].base;
+      vec[n].iov_len = iov[i + n].size;
+      expected += iov[i + n].size;
+    }
+
+    ret = is_write ? writev(fd, vec, n) : readv(fd, vec, n);
+    if (ret < 0) {
+      return done > 0 ? done : -1;
+    }
+
+    done += (int32_t)ret;
+    if (ret < expected) {
+      break;
+    }
+    i += n;
+  }
+
+  return done;
+}
+
+static int32_t fs_os_file_readv(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL || ff->rbuf != NULL) {
+    /*数据已经(或者将要)在内存中，逐块拷贝。*/
+    return fs_file_readv_by(file, fs_os_file_read, iov, iovcnt);
+  }
+
+  if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+    return -1;
+  }
+
+  return fs_os_file_rwv(ff->file, iov, iovcnt, FALSE);
+}
+
+static int32_t fs_os_file_writev(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  uint32_t i = 0;
+  uint32_t total = 0;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+  return_value_if_fail(ff->map == NULL, -1);
+
+  for (i = 0; i < iovcnt; i++) {
+    total += iov[i].size;
+  }
+
+  if (ff->wbuf != NULL && total < ff->wbuf_size) {
+    /*小记录合并到写缓冲区中。*/
+    return fs_file_writev_by(file, fs_os_file_write, iov, iovcnt);
+  }
+
+  if (fs_os_file_sync_buffer(ff) != RET_OK) {
+    return -1;
+  }
+
+  return fs_os_file_rwv(ff->file, iov, iovcnt, TRUE);
+}
+#endif /*FS_OS_POSIX_HAS_UIO*/
+
+#ifdef FS_OS_POSIX_HAS_PREAD
+static int32_t fs_os_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+
+  if (ff->map != NULL) {
+    uint32_t n = 0;
+    if (offset >= ff->map_size) {
+      return 0;
+    }
+    n = tk_min(size, ff->map_size - (uint32_t)offset);
+    memcpy(buffer, ff->map + offset, n);
+    return (int32_t)n;
+  }
+
+  /*预读缓冲区中的数据与文件一致，只需要先写出写缓冲区。*/
+  if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+    return -1;
+  }
+
+  return (int32_t)pread(ff->file, buffer, size, (off_t)offset);
+}
+
+static int32_t fs_os_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size,
+                                 uint64_t offset) {
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+  return_value_if_fail(ff->map == NULL, -1);
+
+  /*写入的位置可能在预读窗口内，先丢弃预读的数据。*/
+  if (fs_os_file_sync_buffer(ff) != RET_OK) {
+    return -1;
+  }
+
+  return (int32_t)pwrite(ff->file, buffer, size, (off_t)offset);
+}
+#endif /*FS_OS_POSIX_HAS_PREAD*/
+
+#if defined(LINUX) || defined(MACOS)
+/*写缓冲区中的数据先写出，分配不影响预读缓冲区中已有的数据。*/
+static ret_t fs_os_file_allocate(fs_file_t* file, uint64_t size) {
+  struct stat st;
+  fs_file_posix_t* ff = (fs_file_posix_t*)file;
+  return_value_if_fail(ff->map == NULL, RET_BAD_PARAMS);
+
+  if (ff->wlen > 0 && fs_os_file_flush(ff) != RET_OK) {
+    return RET_FAIL;
+  }
+  if (fstat(ff->file, &st) != 0) {
+    return RET_FAIL;
+  }
+  if ((uint64_t)st.st_size >= size) {
+    return RET_OK;
+  }
+
+#ifdef MACOS
+  {
+    /*先尝试连续分配。*/
+    fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0,
+                      (off_t)(size - st.st_size), 0};
+    if (fcntl(ff->file, F_PREALLOCATE, &store) != 0) {
+      store.fst_flags = F_ALLOCATEALL;
+      if (fcntl(ff->file, F_PREALLOCATE, &store) != 0) {
+        return RET_FAIL;
+      }
+    }
+    return ftruncate(ff->file, (off_t)size) == 0 ? RET_OK : RET_FAIL;
+  }
+#else
+  return posix_fallocate(ff->file, 0, (off_t)size) == 0 ? RET_OK : RET_FAIL;
+#endif /*MACOS*/
+}
+#endif /*LINUX || MACOS*/
+
+/*借用的数据在下一次操作该文件之前一直有效，不需要额外处理。*/
+static const fs_file_ext_vtable_t s_file_ext_vtable = {
+    .map = fs_os_file_map,
+    .borrow = fs_os_file_borrow,
+#ifdef FS_OS_POSIX_HAS_UIO
+    .readv = fs_os_file_readv,
+    .writev = fs_os_file_writev,
+#endif /*FS_OS_POSIX_HAS_UIO*/
+#ifdef FS_OS_POSIX_HAS_PREAD
+    .pread = fs_os_file_pread,
+    .pwrite = fs_os_file_pwrite,
+#endif /*FS_OS_POSIX_HAS_PREAD*/
+#if defined(LINUX) || defined(MACOS)
+    .allocate = fs_os_file_allocate,
+#endif /*LINUX || MACOS*/
+};
+
 static const fs_file_vtable_t s_file_vtable = {.read = fs_os_file_read,
                                                .write = fs_os_file_write,
                                                .printf = fs_os_file_printf,
@@ -288,16 +714,99 @@ static uint32_t mode_from_str(fs_t* fs, const char* filename, const char* mode)
   }
 }
 
+static ret_t fs_file_init_buffer(fs_file_posix_t* ff, const char* mode) {
+  bool_t update = strchr(mode, '+') != NULL;
+  uint32_t rsize = (mode[0] == 'r' || update) ? s_read_ahead_size : 0;
+  uint32_t wsize = (mode[0] != 'r' || update) ? s_write_behind_size : 0;
+  uint8_t* buff = NULL;
+
+  if (rsize + wsize == 0) {
+    return RET_OK;
+  }
+
+  buff = (uint8_t*)TKMEM_ALLOC(rsize + wsize);
+  return_value_if_fail(buff != NULL, RET_OOM);
+
+  if (rsize > 0) {
+    ff->rbuf = buff;
+    ff->rbuf_size = rsize;
+  }
+
+  if (wsize > 0) {
+    ff->wbuf = buff + rsize;
+    ff->wbuf_size = wsize;
+  }
+
+  return RET_OK;
+}
+
+static ret_t fs_file_init_map(fs_file_posix_t* ff) {
+#ifdef FS_OS_POSIX_HAS_MMAP
+  void* map = NULL;
+  struct stat st;
+
+  if (s_mmap_threshold == 0 || fstat(ff->file, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return RET_NOT_IMPL;
+  }
+
+  if (st.st_size < s_mmap_threshold || st.st_size > 0x7fffffff) {
+    return RET_NOT_IMPL;
+  }
+
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, ff->file, 0);
+  if (map == MAP_FAILED) {
+    return RET_FAIL;
+  }
+
+  ff->map = (uint8_t*)map;
+  ff->map_size = (uint32_t)st.st_size;
+  ff->map_pos = 0;
+
+  return RET_OK;
+#else
+  return RET_NOT_IMPL;
+#endif /*FS_OS_POSIX_HAS_MMAP*/
+}
+
 static fs_file_t* fs_os_open_file(fs_t* fs, const char* name, const char* mode) {
   int fd = -1;
+  uint32_t i = 0;
   fs_file_t* file = NULL;
+  bool_t mapped = FALSE;
+  bool_t buffered = FALSE;
+  char std_mode[8];
   return_value_if_fail(name != NULL && mode != NULL, NULL);
   file = fs_file_create();
   return_value_if_fail(file != NULL, NULL);
 
+  /*去掉扩展的"B"/"M"标志，剩下的是标准的fopen模式。*/
+  for (; *mode != '\0' && i < sizeof(std_mode) - 1; mode++) {
+    if (*mode == 'B') {
+      buffered = TRUE;
+    } else if (*mode == 'M') {
+      mapped = TRUE;
+    } else {
+      std_mode[i++] = *mode;
+    }
+  }
+  std_mode[i] = '\0';
+  mode = std_mode;
+
   fd = open(name, mode_from_str(fs, name, mode));
   if (fd >= 0) {
     ((fs_file_posix_t*)file)->file = fd;
+    if (mapped && (tk_str_eq(mode, "r") || tk_str_eq(mode, "rb"))) {
+      /*指定了"M"的只读打开的大文件使用内存映射，失败时退回到read。*/
+      if (fs_file_init_map((fs_file_posix_t*)file) == RET_OK) {
+        return file;
+      }
+    }
+
+    if (buffered && fs_file_init_buffer((fs_file_posix_t*)file, mode) != RET_OK) {
+      close(fd);
+      TKMEM_FREE(file);
+      return NULL;
+    }
     return file;
   } else {
     log_warn("open %s %s failed\n", name, mode);
@@ -496,9 +1005,25 @@ static const fs_t s_os_fs = {.open_file = fs_os_open_file,
                              .get_temp_path = fs_os_get_temp_path,
                              .stat = fs_os_stat};
 
+ret_t os_fs_posix_set_buffer_size(uint32_t read_ahead, uint32_t write_behind) {
+  s_read_ahead_size = read_ahead;
+  s_write_behind_size = write_behind;
+
+  return RET_OK;
+}
+
+ret_t os_fs_posix_set_mmap_threshold(uint32_t size) {
+  s_mmap_threshold = size;
+
+  return RET_OK;
+}
+
 fs_t* os_fs_posix(void) {
+  fs_file_ext_register(&s_file_vtable, &s_file_ext_vtable);
 #ifdef WITH_FS_MT
-  return fs_mt_wrap((fs_t*)&s_os_fs);
+  static fs_t* s_os_fs_mt = NULL;
+
+  return fs_mt_wrap_once(&s_os_fs_mt, (fs_t*)&s_os_fs);
 #else
   return (fs_t*)&s_os_fs;
 #endif /*WITH_FS_MT*/
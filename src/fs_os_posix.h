@@ -0,0 +1,91 @@
+/**
+ * File:   fs_os_posix.h
+ * Author: AWTK Develop Team
+ * Brief:  posix implemented fs
+ *
+ * Copyright (c) 2024 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_OS_POSIX_H
+#define TK_FS_OS_POSIX_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 以"B"标志(如"wB"、"rb+B")打开文件时，缺省的预读缓冲区大小。
+ */
+#ifndef FS_OS_POSIX_READ_AHEAD_SIZE
+#define FS_OS_POSIX_READ_AHEAD_SIZE 4096
+#endif /*FS_OS_POSIX_READ_AHEAD_SIZE*/
+
+/**
+ * 以"B"标志打开文件时，缺省的写缓冲区大小。
+ */
+#ifndef FS_OS_POSIX_WRITE_BEHIND_SIZE
+#define FS_OS_POSIX_WRITE_BEHIND_SIZE 4096
+#endif /*FS_OS_POSIX_WRITE_BEHIND_SIZE*/
+
+/**
+ * 以"rM"/"rbM"打开不小于该长度的文件时使用内存映射，为0时不使用。
+ */
+#ifndef FS_OS_POSIX_MMAP_THRESHOLD
+#define FS_OS_POSIX_MMAP_THRESHOLD (16 * 1024)
+#endif /*FS_OS_POSIX_MMAP_THRESHOLD*/
+
+/**
+ * @method os_fs_posix
+ * 获取posix实现的fs对象。
+ *
+ * 打开模式在标准的fopen模式之外，可以附加"B"标志，启用用户态的读写缓冲：
+ * 小块写先合并到写缓冲区，在缓冲区满、seek、读、sync或者close时才写出；
+ * 读先经过预读缓冲区。
+ *
+ * 只读打开时还可以附加"M"标志("rM"/"rbM")，文件较大时(见os_fs_posix_set_mmap_threshold)
+ * 使用内存映射读取，并可以用fs_file_map直接访问文件内容。
+ * > 映射期间文件被截断(其它进程或者其它文件对象)时，访问映射中超出新长度的部分会触发SIGBUS，
+ * > 所以内存映射需要用"M"显式打开，只用于打开期间不会被修改的文件(如只读的资源文件)。
+ * @annotation ["global"]
+ *
+ * @return {fs_t*} 返回fs对象。
+ */
+fs_t* os_fs_posix(void);
+
+/**
+ * @method os_fs_posix_set_buffer_size
+ * 设置以"B"标志打开文件时的缓冲区大小(只影响之后打开的文件)。
+ * @annotation ["global"]
+ * @param {uint32_t} read_ahead 预读缓冲区大小，为0时不预读。
+ * @param {uint32_t} write_behind 写缓冲区大小，为0时直接写。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_posix_set_buffer_size(uint32_t read_ahead, uint32_t write_behind);
+
+/**
+ * @method os_fs_posix_set_mmap_threshold
+ * 设置使用内存映射的文件长度阈值(只影响之后打开的文件)。
+ * @annotation ["global"]
+ * @param {uint32_t} size 以"rM"/"rbM"打开不小于该长度的文件时使用内存映射，为0时不使用。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_posix_set_mmap_threshold(uint32_t size);
+
+END_C_DECLS
+
+#endif /*TK_FS_OS_POSIX_H*/
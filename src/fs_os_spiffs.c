@@ -25,20 +25,21 @@
 
 #include "tkc/fs.h"
 #include "spiffs/spiffs.h"
+#include "spiffs/spiffs_nucleus.h"
 #include "tkc/mem.h"
 #include "tkc/utils.h"
+#include "tkc/time_now.h"
 #include <stdarg.h>
 
 #include "fs_mt.h"
+#include "fs_printf.h"
+#include "fs_file_ext.h"
 #include "fs_os_conf.h"
-
-#if defined(LINUX) || defined(WIN32) || defined(MACOS) || defined(HAS_STDIO)
-#include <stdio.h>
-#else
-extern int vsnprintf(char* s, size_t n, const char* format, va_list arg);
-#endif
+#include "fs_os_spiffs.h"
 
 static spiffs* sfs = NULL;
+/*os_fs_spiffs_gc_step回收一个块的耗时的估计值(微秒)，更换sfs时清零。*/
+static uint32_t s_gc_step_us = 0;
 
 typedef struct _fs_file_spiffs_t {
   fs_file_t fs_file;
@@ -51,26 +52,20 @@ static int32_t fs_os_file_read(fs_file_t* file, void* buffer, uint32_t size) {
   return SPIFFS_read(sfs, fp, buffer, size);
 }
 
-int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+static int32_t fs_os_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
   spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
 
   return SPIFFS_write(sfs, fp, (void*)buffer, size);
 }
 
-int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
-  int32_t n = 0;
-  char buffer[256];
-  /*FIXME*/
-  n = vsnprintf(buffer, sizeof(buffer), format, args);
-  return_value_if_fail(n >= 0, 0);
-
-  return fs_os_file_write(file, buffer, n);
+static int32_t fs_os_file_printf(fs_file_t* file, const char* const format, va_list args) {
+  return fs_file_vprintf_stream(file, fs_os_file_write, format, args);
 }
 
 static ret_t fs_os_file_seek(fs_file_t* file, int32_t offset) {
   spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
 
-  return SPIFFS_lseek(sfs, fp, offset, 0) == 0 ? RET_OK : RET_FAIL;
+  return SPIFFS_lseek(sfs, fp, offset, SPIFFS_SEEK_SET) >= 0 ? RET_OK : RET_FAIL;
 }
 
 static int64_t fs_os_file_tell(fs_file_t* file) {
@@ -119,11 +114,38 @@ static ret_t fs_os_file_sync(fs_file_t* file) {
 }
 
 static ret_t fs_os_file_truncate(fs_file_t* file, int32_t size) {
-  /*TODO*/
-  return RET_OK;
+  s32_t pos = 0;
+  spiffs_stat st;
+  static const u8_t s_zeros[64];
+  spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
+  return_value_if_fail(size >= 0, RET_BAD_PARAMS);
+
+  if (SPIFFS_fstat(sfs, fp, &st) != SPIFFS_OK) {
+    return RET_FAIL;
+  }
+
+  if ((u32_t)size <= st.size) {
+    return SPIFFS_ftruncate(sfs, fp, (u32_t)size) == SPIFFS_OK ? RET_OK : RET_FAIL;
+  }
+
+  /*变大时在末尾补0，保持读写位置不变。*/
+  pos = SPIFFS_tell(sfs, fp);
+  if (pos < 0 || SPIFFS_lseek(sfs, fp, 0, SPIFFS_SEEK_END) < 0) {
+    return RET_FAIL;
+  }
+  while (st.size < (u32_t)size) {
+    s32_t n = (s32_t)tk_min((u32_t)size - st.size, sizeof(s_zeros));
+    if (SPIFFS_write(sfs, fp, (void*)s_zeros, n) != n) {
+      SPIFFS_lseek(sfs, fp, pos, SPIFFS_SEEK_SET);
+      return RET_FAIL;
+    }
+    st.size += n;
+  }
+
+  return SPIFFS_lseek(sfs, fp, pos, SPIFFS_SEEK_SET) >= 0 ? RET_OK : RET_FAIL;
 }
 
-bool_t fs_os_file_eof(fs_file_t* file) {
+static bool_t fs_os_file_eof(fs_file_t* file) {
   spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
 
   return SPIFFS_eof(sfs, fp);
@@ -137,6 +159,74 @@ static ret_t fs_os_file_close(fs_file_t* file) {
   return RET_OK;
 }
 
+/*spiffs没有pread/pwrite，保存并恢复读写位置。调用者(fs_mt)保证期间没有其它线程使用该文件。*/
+static int32_t fs_os_file_pread(fs_file_t* file, void* buffer, uint32_t size, uint64_t offset) {
+  s32_t ret = 0;
+  spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
+  s32_t pos = SPIFFS_tell(sfs, fp);
+  return_value_if_fail(pos >= 0 && offset <= 0x7fffffff, -1);
+
+  ret = SPIFFS_lseek(sfs, fp, (s32_t)offset, SPIFFS_SEEK_SET);
+  if (ret >= 0) {
+    ret = SPIFFS_read(sfs, fp, buffer, size);
+  } else if (ret == SPIFFS_ERR_END_OF_OBJECT) {
+    /*位置在文件末尾之后。*/
+    ret = 0;
+  }
+
+  if (SPIFFS_lseek(sfs, fp, pos, SPIFFS_SEEK_SET) < 0 || ret < 0) {
+    return -1;
+  }
+
+  return ret;
+}
+
+static int32_t fs_os_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size,
+                                 uint64_t offset) {
+  s32_t ret = 0;
+  spiffs_file fp = (((fs_file_spiffs_t*)file)->file);
+  s32_t pos = SPIFFS_tell(sfs, fp);
+  return_value_if_fail(pos >= 0 && offset <= 0x7fffffff, -1);
+
+  /*spiffs不支持空洞，位置不能在文件末尾之后。*/
+  ret = SPIFFS_lseek(sfs, fp, (s32_t)offset, SPIFFS_SEEK_SET);
+  if (ret >= 0) {
+    ret = SPIFFS_write(sfs, fp, (void*)buffer, size);
+  }
+
+  if (SPIFFS_lseek(sfs, fp, pos, SPIFFS_SEEK_SET) < 0 || ret < 0) {
+    return -1;
+  }
+
+  return ret;
+}
+
+/*
+ * spiffs不能预先分配页，提前做垃圾回收，让之后的写入不用在中途等待擦除。
+ * SPIFFS_gc每次最多回收SPIFFS_GC_MAX_RUNS个块，只要还在回收已删除的页就继续。
+ */
+static ret_t fs_os_file_allocate(fs_file_t* file, uint64_t size) {
+  s32_t ret = SPIFFS_OK;
+  u32_t deleted = 0;
+  int64_t fsize = fs_os_file_size(file);
+  return_value_if_fail(size <= 0x7fffffff, RET_BAD_PARAMS);
+
+  if ((int64_t)size <= fsize) {
+    return RET_OK;
+  }
+
+  do {
+    deleted = sfs->stats_p_deleted;
+    ret = SPIFFS_gc(sfs, (u32_t)(size - fsize));
+  } while (ret == SPIFFS_ERR_FULL && sfs->stats_p_deleted < deleted);
+
+  return ret == SPIFFS_OK ? RET_OK : RET_FAIL;
+}
+
+static const fs_file_ext_vtable_t s_file_ext_vtable = {.pread = fs_os_file_pread,
+                                                       .pwrite = fs_os_file_pwrite,
+                                                       .allocate = fs_os_file_allocate};
+
 typedef struct _fs_dir_spiffs_t {
   fs_dir_t fs_dir;
   spiffs_DIR dir;
@@ -201,7 +291,7 @@ static fs_file_t* fs_file_create(void) {
  *
  *
  */
-static int mode_from_str(fs_t* fs, const char* filename, const char* mode) {
+static int mode_from_str(const char* filename, const char* mode) {
   if (tk_str_eq(mode, "r") || tk_str_eq(mode, "rb")) {
     /* "r"	read: Open file for input operations. The file must exist. */
     return SPIFFS_RDONLY;
@@ -209,20 +299,15 @@ static int mode_from_str(fs_t* fs, const char* filename, const char* mode) {
     /* "w"	write: Create an empty file for output operations. If a file with
      * the same name already exists, its contents are discarded and the file is
      * treated as a new empty file. */
-    if (fs_file_exist(fs, filename)) {
-      fs_remove_file(fs, filename);
-    }
+    /* 删除原来的文件(连同文件头)再创建，不存在时SPIFFS_remove只查找一次。 */
+    SPIFFS_remove(sfs, filename);
     return SPIFFS_WRONLY | SPIFFS_CREAT;
   } else if (tk_str_eq(mode, "a")) {
     /* "a"	append: Open file for output at the end of a file. Output operations
      * always write data at the end of the file, expanding it. Repositioning
      * operations (fseek, fsetpos, rewind) are ignored. The file is created if
      * it does not exist. */
-    if (fs_file_exist(fs, filename)) {
-      return SPIFFS_APPEND | SPIFFS_WRONLY;
-    } else {
-      return SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_WRONLY;
-    }
+    return SPIFFS_CREAT | SPIFFS_APPEND | SPIFFS_WRONLY;
   } else if (tk_str_eq(mode, "r+") || tk_str_eq(mode, "rb+")) {
     /* "r+"	read/update: Open a file for update (both for input and output).
      * The file must exist. */
@@ -231,9 +316,7 @@ static int mode_from_str(fs_t* fs, const char* filename, const char* mode) {
     /* "w+"	write/update: Create an empty file and open it for update (both for
      * input and output). If a file with the same name already exists its
      * contents are discarded and the file is treated as a new empty file.*/
-    if (fs_file_exist(fs, filename)) {
-      fs_remove_file(fs, filename);
-    }
+    SPIFFS_remove(sfs, filename);
     return SPIFFS_RDWR | SPIFFS_CREAT;
   } else if (tk_str_eq(mode, "a+")) {
     /* "a+"	append/update: Open a file for update (both for input and output)
@@ -241,11 +324,7 @@ static int mode_from_str(fs_t* fs, const char* filename, const char* mode) {
      * Repositioning operations (fseek, fsetpos, rewind) affects the next input
      * operations, but output operations move the position back to the end of
      * file. The file is created if it does not exist. */
-    if (fs_file_exist(fs, filename)) {
-      return SPIFFS_RDWR | SPIFFS_APPEND;
-    } else {
-      return SPIFFS_RDWR | SPIFFS_CREAT | SPIFFS_APPEND;
-    }
+    return SPIFFS_RDWR | SPIFFS_CREAT | SPIFFS_APPEND;
   } else {
     return SPIFFS_CREAT | SPIFFS_RDWR;
   }
@@ -256,7 +335,7 @@ static fs_file_t* fs_os_open_file(fs_t* fs, const char* name, const char* mode)
   fs_file_spiffs_t* spiff = (fs_file_spiffs_t*)file;
   return_value_if_fail(file != NULL, NULL);
 
-  spiff->file = SPIFFS_open(sfs, name, mode_from_str(fs, name, mode), 0);
+  spiff->file = SPIFFS_open(sfs, name, mode_from_str(name, mode), 0);
 
   if (spiff->file >= 0) {
     return file;
@@ -287,7 +366,7 @@ static ret_t fs_os_file_rename(fs_t* fs, const char* name, const char* new_name)
 static const fs_dir_vtable_t s_dir_vtable = {
     .read = fs_os_dir_read, .rewind = fs_os_dir_rewind, .close = fs_os_dir_close};
 
-fs_dir_t* fs_dir_create(void) {
+static fs_dir_t* fs_dir_create(void) {
   fs_dir_t* d = NULL;
   fs_dir_spiffs_t* fdir = TKMEM_ZALLOC(fs_dir_spiffs_t);
   if (fdir != NULL) {
@@ -298,7 +377,7 @@ fs_dir_t* fs_dir_create(void) {
   return d;
 }
 
-fs_dir_t* fs_os_open_dir(fs_t* fs, const char* name) {
+static fs_dir_t* fs_os_open_dir(fs_t* fs, const char* name) {
   fs_dir_t* dir = NULL;
   spiffs_DIR* dp = NULL;
   return_value_if_fail(name != NULL, NULL);
@@ -348,13 +427,20 @@ static int32_t fs_os_get_file_size(fs_t* fs, const char* name) {
 
 static ret_t fs_os_get_disk_info(fs_t* fs, const char* volume, int32_t* free_kb,
                                  int32_t* total_kb) {
-  /*TODO*/
+  u32_t total = 0;
+  u32_t used = 0;
+  return_value_if_fail(free_kb != NULL && total_kb != NULL, RET_BAD_PARAMS);
+
   *free_kb = 0;
   *total_kb = 0;
-  (void)fs;
-  assert(!"fs_os_get_disk_info not supported yet");
+  if (SPIFFS_info(sfs, &total, &used) != SPIFFS_OK) {
+    return RET_FAIL;
+  }
 
-  return RET_NOT_IMPL;
+  *total_kb = total / 1024;
+  *free_kb = (total > used ? total - used : 0) / 1024;
+
+  return RET_OK;
 }
 
 static ret_t fs_os_get_exe(fs_t* fs, char path[MAX_PATH + 1]) {
@@ -411,13 +497,130 @@ static const fs_t s_os_fs = {.open_file = fs_os_open_file,
 
 ret_t os_fs_spiffs_set(spiffs* fs) {
   sfs = fs;
+  s_gc_step_us = 0;
 
   return RET_OK;
 }
 
+ret_t os_fs_spiffs_get_stats(os_fs_spiffs_stats_t* stats) {
+  u32_t i = 0;
+  u32_t total = 0;
+  u32_t used = 0;
+  u32_t data_pages = 0;
+  spiffs_fd* fds = NULL;
+  return_value_if_fail(sfs != NULL && stats != NULL, RET_BAD_PARAMS);
+
+  memset(stats, 0x00, sizeof(*stats));
+  if (SPIFFS_info(sfs, &total, &used) != SPIFFS_OK) {
+    return RET_FAIL;
+  }
+
+  stats->total_bytes = total;
+  stats->used_bytes = used;
+  stats->page_size = SPIFFS_CFG_LOG_PAGE_SZ(sfs);
+  stats->pages_allocated = sfs->stats_p_allocated;
+  stats->pages_deleted = sfs->stats_p_deleted;
+  data_pages = sfs->block_count * SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(sfs);
+  if (data_pages > stats->pages_allocated + stats->pages_deleted) {
+    stats->pages_free = data_pages - stats->pages_allocated - stats->pages_deleted;
+  }
+  stats->blocks_free = sfs->free_blocks;
+  stats->blocks_total = sfs->block_count;
+  stats->max_erase_count = sfs->max_erase_count;
+#if SPIFFS_GC_STATS
+  stats->gc_runs = sfs->stats_gc_runs;
+  stats->erases = sfs->stats_erases;
+#endif /*SPIFFS_GC_STATS*/
+#if SPIFFS_CACHE && SPIFFS_CACHE_STATS
+  stats->cache_hits = sfs->cache_hits;
+  stats->cache_misses = sfs->cache_misses;
+  if (stats->cache_hits + stats->cache_misses > 0) {
+    stats->cache_hit_permille = (uint32_t)((uint64_t)stats->cache_hits * 1000 /
+                                           (stats->cache_hits + stats->cache_misses));
+  }
+#endif /*SPIFFS_CACHE && SPIFFS_CACHE_STATS*/
+
+  fds = (spiffs_fd*)sfs->fd_space;
+  stats->fds_total = sfs->fd_count;
+  for (i = 0; i < sfs->fd_count; i++) {
+    if (fds[i].file_nbr != 0) {
+      stats->fds_used++;
+    }
+  }
+
+  return RET_OK;
+}
+
+ret_t os_fs_spiffs_reset_stats(void) {
+  return_value_if_fail(sfs != NULL, RET_BAD_PARAMS);
+
+#if SPIFFS_GC_STATS
+  sfs->stats_gc_runs = 0;
+  sfs->stats_erases = 0;
+#endif /*SPIFFS_GC_STATS*/
+#if SPIFFS_CACHE && SPIFFS_CACHE_STATS
+  sfs->cache_hits = 0;
+  sfs->cache_misses = 0;
+#endif /*SPIFFS_CACHE && SPIFFS_CACHE_STATS*/
+
+  return RET_OK;
+}
+
+typedef struct _os_fs_spiffs_gc_ctx_t {
+  /*时间用完的时刻*/
+  uint64_t end;
+  /*已经回收的块数*/
+  uint32_t blocks;
+  /*剩余的时间不够回收一个块*/
+  bool_t timeout;
+  /*SPIFFS_gc_step的返回值，0表示不需要再回收。*/
+  s32_t ret;
+} os_fs_spiffs_gc_ctx_t;
+
+/*
+ * 加锁后回收一个块。回收一个块的耗时的估计值(s_gc_step_us)取最近的最大值，每回收一个块衰减1/8。
+ * 本次调用还没有回收任何块就因为时间不够返回时也衰减1/8，一次很慢的回收之后估计值会逐渐回落。
+ */
+static ret_t os_fs_spiffs_gc_one_block(void* ctx) {
+  uint64_t start = time_now_us();
+  os_fs_spiffs_gc_ctx_t* gc = (os_fs_spiffs_gc_ctx_t*)ctx;
+
+  if (sfs->free_blocks >= OS_FS_SPIFFS_GC_FREE_BLOCKS || sfs->stats_p_deleted == 0) {
+    gc->ret = 0;
+  } else if (start + s_gc_step_us > gc->end) {
+    if (gc->blocks == 0) {
+      s_gc_step_us -= s_gc_step_us / 8;
+    }
+    gc->timeout = TRUE;
+  } else {
+    gc->ret = SPIFFS_gc_step(sfs, OS_FS_SPIFFS_GC_FREE_BLOCKS);
+    s_gc_step_us = tk_max(time_now_us() - start, s_gc_step_us - s_gc_step_us / 8);
+    gc->blocks++;
+  }
+
+  return gc->ret < 0 ? RET_FAIL : RET_OK;
+}
+
+ret_t os_fs_spiffs_gc_step(uint32_t budget_us) {
+  os_fs_spiffs_gc_ctx_t gc = {0, 0, FALSE, 1};
+  return_value_if_fail(sfs != NULL, RET_BAD_PARAMS);
+
+  gc.end = time_now_us() + budget_us;
+  do {
+    if (fs_mt_exec_exclusive(os_fs_spiffs(), os_fs_spiffs_gc_one_block, &gc) != RET_OK) {
+      return RET_FAIL;
+    }
+  } while (gc.ret > 0 && !gc.timeout);
+
+  return gc.ret == 0 ? RET_OK : RET_TIMEOUT;
+}
+
 fs_t* os_fs_spiffs(void) {
+  fs_file_ext_register(&s_file_vtable, &s_file_ext_vtable);
 #ifdef WITH_FS_MT
-  return fs_mt_wrap((fs_t*)&s_os_fs);
+  static fs_t* s_os_fs_mt = NULL;
+
+  return fs_mt_wrap_once(&s_os_fs_mt, (fs_t*)&s_os_fs);
 #else
   return (fs_t*)&s_os_fs;
 #endif/*WITH_FS_MT*/
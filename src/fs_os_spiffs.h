@@ -0,0 +1,206 @@
+/**
+ * File:   fs_os_spiffs.h
+ * Author: AWTK Develop Team
+ * Brief:  spiffs implemented fs
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_OS_SPIFFS_H
+#define TK_FS_OS_SPIFFS_H
+
+#include "tkc/fs.h"
+#include "spiffs/spiffs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * os_fs_spiffs_gc_step保持的空闲块数。
+ * spiffs在空闲块不超过3个时在写入时同步回收。保持5个空闲块时，
+ * 两次调用os_fs_spiffs_gc_step之间写入的数据不超过一个块，写入就不会被回收阻塞。
+ */
+#ifndef OS_FS_SPIFFS_GC_FREE_BLOCKS
+#define OS_FS_SPIFFS_GC_FREE_BLOCKS 5
+#endif /*OS_FS_SPIFFS_GC_FREE_BLOCKS*/
+
+/**
+ * @class os_fs_spiffs_stats_t
+ * spiffs的运行统计信息，用于调整缓存(cache)和文件描述符(fds)的大小。
+ *
+ * > 没有打开SPIFFS_CACHE_STATS/SPIFFS_GC_STATS时，相应的计数为0。
+ */
+typedef struct _os_fs_spiffs_stats_t {
+  /**
+   * @property {uint32_t} total_bytes
+   * @annotation ["readable"]
+   * 文件系统的容量(SPIFFS_info)。
+   */
+  uint32_t total_bytes;
+  /**
+   * @property {uint32_t} used_bytes
+   * @annotation ["readable"]
+   * 已经使用的空间(SPIFFS_info)。
+   */
+  uint32_t used_bytes;
+  /**
+   * @property {uint32_t} page_size
+   * @annotation ["readable"]
+   * 逻辑页的大小。
+   */
+  uint32_t page_size;
+  /**
+   * @property {uint32_t} pages_allocated
+   * @annotation ["readable"]
+   * 正在使用的页数。
+   */
+  uint32_t pages_allocated;
+  /**
+   * @property {uint32_t} pages_deleted
+   * @annotation ["readable"]
+   * 已删除但还没有回收的页数。
+   */
+  uint32_t pages_deleted;
+  /**
+   * @property {uint32_t} pages_free
+   * @annotation ["readable"]
+   * 空闲的页数(不包括查找表占用的页)。
+   */
+  uint32_t pages_free;
+  /**
+   * @property {uint32_t} blocks_free
+   * @annotation ["readable"]
+   * 空闲(已擦除)的块数。
+   */
+  uint32_t blocks_free;
+  /**
+   * @property {uint32_t} blocks_total
+   * @annotation ["readable"]
+   * 总的块数。
+   */
+  uint32_t blocks_total;
+  /**
+   * @property {uint32_t} gc_runs
+   * @annotation ["readable"]
+   * 垃圾回收的次数。
+   */
+  uint32_t gc_runs;
+  /**
+   * @property {uint32_t} erases
+   * @annotation ["readable"]
+   * 挂载后擦除块的次数。
+   */
+  uint32_t erases;
+  /**
+   * @property {uint32_t} max_erase_count
+   * @annotation ["readable"]
+   * 块的擦除计数的最大值(spiffs用于磨损均衡，会回绕)。
+   */
+  uint32_t max_erase_count;
+  /**
+   * @property {uint32_t} cache_hits
+   * @annotation ["readable"]
+   * 缓存命中的次数。
+   */
+  uint32_t cache_hits;
+  /**
+   * @property {uint32_t} cache_misses
+   * @annotation ["readable"]
+   * 缓存没有命中的次数。
+   */
+  uint32_t cache_misses;
+  /**
+   * @property {uint32_t} cache_hit_permille
+   * @annotation ["readable"]
+   * 缓存命中率(千分比)。
+   */
+  uint32_t cache_hit_permille;
+  /**
+   * @property {uint32_t} fds_total
+   * @annotation ["readable"]
+   * 文件描述符的个数。
+   */
+  uint32_t fds_total;
+  /**
+   * @property {uint32_t} fds_used
+   * @annotation ["readable"]
+   * 正在使用的文件描述符个数。
+   */
+  uint32_t fds_used;
+} os_fs_spiffs_stats_t;
+
+/**
+ * @method os_fs_spiffs
+ * 获取spiffs实现的fs对象。
+ * @annotation ["global"]
+ *
+ * @return {fs_t*} 返回fs对象。
+ */
+fs_t* os_fs_spiffs(void);
+
+/**
+ * @method os_fs_spiffs_set
+ * 设置已经挂载的spiffs对象。
+ * @annotation ["global"]
+ * @param {spiffs*} fs spiffs对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_spiffs_set(spiffs* fs);
+
+/**
+ * @method os_fs_spiffs_get_stats
+ * 获取spiffs的运行统计信息。
+ * > 计数器直接从spiffs对象中读取，不加锁，其它线程同时访问文件系统时只是近似值。
+ * @annotation ["global"]
+ * @param {os_fs_spiffs_stats_t*} stats 用于返回统计信息。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_spiffs_get_stats(os_fs_spiffs_stats_t* stats);
+
+/**
+ * @method os_fs_spiffs_reset_stats
+ * 清空缓存命中、垃圾回收和擦除的计数。
+ * @annotation ["global"]
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t os_fs_spiffs_reset_stats(void);
+
+/**
+ * @method os_fs_spiffs_gc_step
+ * 在空闲时做有限的垃圾回收，每次回收一个块(搬移块中有效的页再擦除)，直到有
+ * OS_FS_SPIFFS_GC_FREE_BLOCKS个空闲块、没有可以回收的页或者用完指定的时间。
+ * 剩余的时间不够回收一个块(按之前回收一个块的耗时估计)时不开始回收，所以单次调用不会明显超时，
+ * 时间比回收一个块还短时不做任何回收(第一次回收之前没有估计值，至少回收一个块)。
+ * 估计值保存在spiffs对象中(挂载时清零)，取最近的最大值，每回收一个块衰减1/8，
+ * 因为时间不够而没有回收时也衰减1/8，偶尔一次很慢的回收之后，时间较短的调用仍然可以逐渐恢复回收。
+ *
+ * 空闲时(如GUI的idle或者定时器中)反复调用，写入时就不需要同步回收，
+ * 只有空间真的不够时才在写入时回收。
+ * > 每回收一个块通过fs_mt_exec_exclusive加锁一次(是否需要回收也在加锁后判断)，
+ * 其它线程的调用最多等待回收一个块的时间。
+ * @annotation ["global"]
+ * @param {uint32_t} budget_us 可以使用的时间(微秒)。
+ *
+ * @return {ret_t} 返回RET_OK表示不需要再回收，返回RET_TIMEOUT表示时间用完了但还可以继续回收，
+ * 其它值表示失败。
+ */
+ret_t os_fs_spiffs_gc_step(uint32_t budget_us);
+
+END_C_DECLS
+
+#endif /*TK_FS_OS_SPIFFS_H*/
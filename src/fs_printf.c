@@ -0,0 +1,515 @@
+/**
+ * File:   fs_printf.c
+ * Author: AWTK Develop Team
+ * Brief:  streaming printf for fs_file_t
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include "fs_printf.h"
+
+#define FLAG_LEFT 0x01
+#define FLAG_PLUS 0x02
+#define FLAG_SPACE 0x04
+#define FLAG_ALT 0x08
+#define FLAG_ZERO 0x10
+
+typedef enum _len_mod_t {
+  LEN_NONE = 0,
+  LEN_HH,
+  LEN_H,
+  LEN_L,
+  LEN_LL,
+  LEN_J,
+  LEN_Z,
+  LEN_T,
+  LEN_LD
+} len_mod_t;
+
+typedef struct _fs_printf_out_t {
+  fs_file_t* file;
+  fs_file_write_t write;
+  int32_t total;
+  bool_t failed;
+  uint32_t size;
+  char buff[FS_PRINTF_CHUNK_SIZE];
+} fs_printf_out_t;
+
+static ret_t fs_printf_out_write(fs_printf_out_t* out, const char* data, uint32_t size) {
+  while (size > 0 && !out->failed) {
+    int32_t ret = out->write(out->file, data, size);
+    if (ret <= 0) {
+      out->failed = TRUE;
+      break;
+    }
+
+    out->total += ret;
+    data += ret;
+    size -= ret;
+  }
+
+  return out->failed ? RET_FAIL : RET_OK;
+}
+
+static ret_t fs_printf_out_flush(fs_printf_out_t* out) {
+  ret_t ret = RET_OK;
+
+  if (out->size > 0) {
+    ret = fs_printf_out_write(out, out->buff, out->size);
+    out->size = 0;
+  }
+
+  return ret;
+}
+
+static ret_t fs_printf_out_put(fs_printf_out_t* out, const char* data, uint32_t size) {
+  if (out->failed) {
+    return RET_FAIL;
+  }
+
+  if (size >= sizeof(out->buff)) {
+    /*大块数据不经过输出块，直接写出。*/
+    if (fs_printf_out_flush(out) != RET_OK) {
+      return RET_FAIL;
+    }
+
+    return fs_printf_out_write(out, data, size);
+  }
+
+  while (size > 0) {
+    uint32_t n = tk_min(size, sizeof(out->buff) - out->size);
+
+    memcpy(out->buff + out->size, data, n);
+    out->size += n;
+    data += n;
+    size -= n;
+
+    if (out->size == sizeof(out->buff) && fs_printf_out_flush(out) != RET_OK) {
+      return RET_FAIL;
+    }
+  }
+
+  return RET_OK;
+}
+
+static ret_t fs_printf_out_pad(fs_printf_out_t* out, char c, int32_t n) {
+  while (n > 0 && !out->failed) {
+    uint32_t size = tk_min((uint32_t)n, sizeof(out->buff) - out->size);
+
+    memset(out->buff + out->size, c, size);
+    out->size += size;
+    n -= size;
+
+    if (out->size == sizeof(out->buff)) {
+      fs_printf_out_flush(out);
+    }
+  }
+
+  return out->failed ? RET_FAIL : RET_OK;
+}
+
+static ret_t fs_printf_out_field(fs_printf_out_t* out, uint32_t flags, int32_t width,
+                                 const char* prefix, uint32_t prefix_len, int32_t zeros,
+                                 const char* body, uint32_t body_len) {
+  int32_t pad = width - (int32_t)(prefix_len + body_len) - zeros;
+
+  if (!(flags & FLAG_LEFT)) {
+    fs_printf_out_pad(out, ' ', pad);
+  }
+
+  fs_printf_out_put(out, prefix, prefix_len);
+  fs_printf_out_pad(out, '0', zeros);
+  fs_printf_out_put(out, body, body_len);
+
+  if (flags & FLAG_LEFT) {
+    fs_printf_out_pad(out, ' ', pad);
+  }
+
+  return out->failed ? RET_FAIL : RET_OK;
+}
+
+static ret_t fs_printf_out_int(fs_printf_out_t* out, uint32_t flags, int32_t width,
+                               int32_t precision, uintmax_t value, bool_t negative, char conv) {
+  char digits[3 * sizeof(uintmax_t) + 1];
+  char prefix[3];
+  int32_t zeros = 0;
+  uint32_t prefix_len = 0;
+  uint32_t len = 0;
+  uint32_t base = 10;
+  bool_t is_zero = value == 0;
+  const char* hex = conv == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+
+  if (conv == 'o') {
+    base = 8;
+  } else if (conv == 'x' || conv == 'X' || conv == 'p') {
+    base = 16;
+  }
+
+  while (value > 0) {
+    digits[sizeof(digits) - 1 - len] = hex[value % base];
+    value /= base;
+    len++;
+  }
+
+  if (len == 0 && precision != 0) {
+    digits[sizeof(digits) - 1] = '0';
+    len = 1;
+  }
+
+  if (negative) {
+    prefix[prefix_len++] = '-';
+  } else if (flags & FLAG_PLUS) {
+    prefix[prefix_len++] = '+';
+  } else if (flags & FLAG_SPACE) {
+    prefix[prefix_len++] = ' ';
+  }
+
+  if (conv == 'p' || ((flags & FLAG_ALT) && (conv == 'x' || conv == 'X') && !is_zero)) {
+    prefix[prefix_len++] = '0';
+    prefix[prefix_len++] = conv == 'X' ? 'X' : 'x';
+  }
+
+  if (precision > (int32_t)len) {
+    zeros = precision - len;
+  } else if ((flags & FLAG_ALT) && conv == 'o' &&
+             (len == 0 || digits[sizeof(digits) - len] != '0')) {
+    zeros = 1;
+  }
+
+  if ((flags & FLAG_ZERO) && !(flags & FLAG_LEFT) && precision < 0) {
+    int32_t n = width - (int32_t)(prefix_len + len);
+    zeros = tk_max(zeros, n);
+  }
+
+  return fs_printf_out_field(out, flags, width, prefix, prefix_len, zeros,
+                             digits + sizeof(digits) - len, len);
+}
+
+static int32_t fs_printf_format_float(char* buff, uint32_t size, const char* spec,
+                                      int32_t precision, double value) {
+  if (precision >= 0) {
+    return tk_snprintf(buff, size, spec, precision, value);
+  } else {
+    return tk_snprintf(buff, size, spec, value);
+  }
+}
+
+static ret_t fs_printf_out_float_str(fs_printf_out_t* out, uint32_t flags, int32_t width,
+                                     const char* buff, int32_t n) {
+  int32_t zeros = 0;
+  uint32_t prefix_len = 0;
+
+  if (buff[0] == '-' || buff[0] == '+' || buff[0] == ' ') {
+    prefix_len = 1;
+  }
+
+  /*inf/nan不补0。*/
+  if ((flags & FLAG_ZERO) && !(flags & FLAG_LEFT) && n > (int32_t)prefix_len &&
+      buff[prefix_len] >= '0' && buff[prefix_len] <= '9') {
+    zeros = width - n;
+  }
+
+  return fs_printf_out_field(out, flags, width, buff, prefix_len, zeros, buff + prefix_len,
+                             n - prefix_len);
+}
+
+static ret_t fs_printf_out_float(fs_printf_out_t* out, uint32_t flags, int32_t width,
+                                 int32_t precision, double value, char conv) {
+  char spec[16];
+  char buff[FS_PRINTF_FLOAT_SIZE];
+  uint32_t i = 0;
+  int32_t n = 0;
+
+  /*宽度由本函数处理，tk_snprintf只负责一个数字本身。*/
+  spec[i++] = '%';
+  if (flags & FLAG_PLUS) spec[i++] = '+';
+  if (flags & FLAG_SPACE) spec[i++] = ' ';
+  if (flags & FLAG_ALT) spec[i++] = '#';
+  if (precision >= 0) {
+    spec[i++] = '.';
+    spec[i++] = '*';
+  }
+  spec[i++] = conv;
+  spec[i] = '\0';
+
+  n = fs_printf_format_float(buff, sizeof(buff), spec, precision, value);
+  return_value_if_fail(n >= 0, RET_FAIL);
+
+  /*%f输出很大的数时可能超过FS_PRINTF_FLOAT_SIZE，改用堆上的缓冲区，不截断。*/
+  if (n >= (int32_t)sizeof(buff)) {
+    ret_t ret = RET_FAIL;
+    char* str = TKMEM_ALLOC(n + 1);
+    return_value_if_fail(str != NULL, RET_OOM);
+
+    if (fs_printf_format_float(str, n + 1, spec, precision, value) == n) {
+      ret = fs_printf_out_float_str(out, flags, width, str, n);
+    }
+    TKMEM_FREE(str);
+
+    return ret;
+  }
+
+  return fs_printf_out_float_str(out, flags, width, buff, n);
+}
+
+int32_t fs_file_vprintf_stream(fs_file_t* file, fs_file_write_t write, const char* format,
+                               va_list args) {
+  const char* p = format;
+  fs_printf_out_t out;
+  return_value_if_fail(file != NULL && write != NULL && format != NULL, -1);
+
+  out.file = file;
+  out.write = write;
+  out.total = 0;
+  out.failed = FALSE;
+  out.size = 0;
+
+  while (*p && !out.failed) {
+    uint32_t flags = 0;
+    int32_t width = 0;
+    int32_t precision = -1;
+    len_mod_t len_mod = LEN_NONE;
+    const char* start = p;
+
+    while (*p && *p != '%') {
+      p++;
+    }
+
+    if (p > start) {
+      fs_printf_out_put(&out, start, p - start);
+      continue;
+    }
+
+    start = p++;
+    for (;; p++) {
+      if (*p == '-') {
+        flags |= FLAG_LEFT;
+      } else if (*p == '+') {
+        flags |= FLAG_PLUS;
+      } else if (*p == ' ') {
+        flags |= FLAG_SPACE;
+      } else if (*p == '#') {
+        flags |= FLAG_ALT;
+      } else if (*p == '0') {
+        flags |= FLAG_ZERO;
+      } else {
+        break;
+      }
+    }
+
+    if (*p == '*') {
+      width = va_arg(args, int);
+      if (width < 0) {
+        flags |= FLAG_LEFT;
+        width = -width;
+      }
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9') {
+        width = width * 10 + (*p++ - '0');
+      }
+    }
+
+    if (*p == '.') {
+      p++;
+      precision = 0;
+      if (*p == '*') {
+        precision = va_arg(args, int);
+        if (precision < 0) {
+          precision = -1;
+        }
+        p++;
+      } else {
+        while (*p >= '0' && *p <= '9') {
+          precision = precision * 10 + (*p++ - '0');
+        }
+      }
+    }
+
+    switch (*p) {
+      case 'h': {
+        p++;
+        len_mod = LEN_H;
+        if (*p == 'h') {
+          p++;
+          len_mod = LEN_HH;
+        }
+        break;
+      }
+      case 'l': {
+        p++;
+        len_mod = LEN_L;
+        if (*p == 'l') {
+          p++;
+          len_mod = LEN_LL;
+        }
+        break;
+      }
+      case 'j': {
+        p++;
+        len_mod = LEN_J;
+        break;
+      }
+      case 'z': {
+        p++;
+        len_mod = LEN_Z;
+        break;
+      }
+      case 't': {
+        p++;
+        len_mod = LEN_T;
+        break;
+      }
+      case 'L': {
+        p++;
+        len_mod = LEN_LD;
+        break;
+      }
+      default:
+        break;
+    }
+
+    switch (*p) {
+      case 'd':
+      case 'i': {
+        intmax_t v = 0;
+        if (len_mod == LEN_LL) {
+          v = va_arg(args, long long);
+        } else if (len_mod == LEN_L) {
+          v = va_arg(args, long);
+        } else if (len_mod == LEN_J) {
+          v = va_arg(args, intmax_t);
+        } else if (len_mod == LEN_Z || len_mod == LEN_T) {
+          v = va_arg(args, ptrdiff_t);
+        } else {
+          v = va_arg(args, int);
+          if (len_mod == LEN_HH) {
+            v = (signed char)v;
+          } else if (len_mod == LEN_H) {
+            v = (short)v;
+          }
+        }
+
+        fs_printf_out_int(&out, flags, width, precision,
+                          v < 0 ? (uintmax_t)0 - (uintmax_t)v : (uintmax_t)v, v < 0, 'd');
+        break;
+      }
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X': {
+        uintmax_t v = 0;
+        if (len_mod == LEN_LL) {
+          v = va_arg(args, unsigned long long);
+        } else if (len_mod == LEN_L) {
+          v = va_arg(args, unsigned long);
+        } else if (len_mod == LEN_J) {
+          v = va_arg(args, uintmax_t);
+        } else if (len_mod == LEN_Z || len_mod == LEN_T) {
+          v = va_arg(args, size_t);
+        } else {
+          v = va_arg(args, unsigned int);
+          if (len_mod == LEN_HH) {
+            v = (unsigned char)v;
+          } else if (len_mod == LEN_H) {
+            v = (unsigned short)v;
+          }
+        }
+
+        fs_printf_out_int(&out, flags & ~(FLAG_PLUS | FLAG_SPACE), width, precision, v, FALSE,
+                          *p);
+        break;
+      }
+      case 'p': {
+        void* v = va_arg(args, void*);
+        fs_printf_out_int(&out, flags & ~(FLAG_PLUS | FLAG_SPACE), width, precision,
+                          (uintmax_t)(uintptr_t)v, FALSE, 'p');
+        break;
+      }
+      case 'c': {
+        char c = (char)va_arg(args, int);
+        fs_printf_out_field(&out, flags, width, NULL, 0, 0, &c, 1);
+        break;
+      }
+      case 's': {
+        uint32_t len = 0;
+        const char* str = va_arg(args, const char*);
+
+        if (str == NULL) {
+          str = "(null)";
+        }
+
+        if (precision >= 0) {
+          while (len < (uint32_t)precision && str[len]) {
+            len++;
+          }
+        } else {
+          len = strlen(str);
+        }
+
+        fs_printf_out_field(&out, flags, width, NULL, 0, 0, str, len);
+        break;
+      }
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        double v = 0;
+        if (len_mod == LEN_LD) {
+          v = (double)va_arg(args, long double);
+        } else {
+          v = va_arg(args, double);
+        }
+
+        fs_printf_out_float(&out, flags, width, precision, v, *p);
+        break;
+      }
+      case '%': {
+        fs_printf_out_put(&out, "%", 1);
+        break;
+      }
+      case '\0': {
+        /*格式不完整，原样输出。*/
+        fs_printf_out_put(&out, start, p - start);
+        continue;
+      }
+      default: {
+        /*不支持的格式，原样输出。*/
+        fs_printf_out_put(&out, start, p - start + 1);
+        break;
+      }
+    }
+
+    p++;
+  }
+
+  fs_printf_out_flush(&out);
+
+  if (out.failed && out.total == 0) {
+    return -1;
+  }
+
+  return out.total;
+}
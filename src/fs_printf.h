@@ -0,0 +1,65 @@
+﻿/**
+ * File:   fs_printf.h
+ * Author: AWTK Develop Team
+ * Brief:  streaming printf for fs_file_t
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_PRINTF_H
+#define TK_FS_PRINTF_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 输出块的大小。短于该长度的一行只会调用一次write。
+ */
+#ifndef FS_PRINTF_CHUNK_SIZE
+#define FS_PRINTF_CHUNK_SIZE 256
+#endif /*FS_PRINTF_CHUNK_SIZE*/
+
+/**
+ * 格式化单个浮点数的栈上缓冲区的长度(浮点数借助tk_snprintf格式化)，更长的结果改用堆上的缓冲区。
+ */
+#ifndef FS_PRINTF_FLOAT_SIZE
+#define FS_PRINTF_FLOAT_SIZE 128
+#endif /*FS_PRINTF_FLOAT_SIZE*/
+
+/**
+ * @method fs_file_vprintf_stream
+ * 流式格式化输出。
+ * 结果先写入栈上的输出块，块满时调用write写出，长字符串参数直接写出，不经过拷贝。
+ * 输出长度没有限制。只有单个浮点数的结果超过FS_PRINTF_FLOAT_SIZE时(如%f输出很大的数或者精度很大)，
+ * 才临时分配一块堆内存来格式化这个数，其它情况不分配堆内存。
+ *
+ * 支持的格式：%d %i %u %o %x %X %c %s %p %f %F %e %E %g %G %a %A %%，
+ * 以及标志(-+ #0)、宽度、精度(支持*)和长度修饰(hh h l ll j z t L)。
+ * @annotation ["global"]
+ * @param {fs_file_t*} file 传给write的文件对象。
+ * @param {fs_file_write_t} write 写函数。
+ * @param {const char*} format 格式字符串。
+ * @param {va_list} args 参数。
+ *
+ * @return {int32_t} 返回实际写入的字节数，写入失败且没有写入任何数据时返回-1。
+ */
+int32_t fs_file_vprintf_stream(fs_file_t* file, fs_file_write_t write, const char* format,
+                               va_list args);
+
+END_C_DECLS
+
+#endif /*TK_FS_PRINTF_H*/
@@ -0,0 +1,86 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "fs_printf.h"
+
+#define LINES_NR 10000
+#define BURSTS_NR 10
+
+extern fs_t* os_fs_posix(void);
+
+/*原来的实现：格式化到256字节的栈缓冲区，再写一次。*/
+static int32_t legacy_printf(fs_file_t* file, const char* format, ...) {
+  int32_t n = 0;
+  va_list args;
+  char buffer[256] = {0};
+
+  va_start(args, format);
+  n = tk_vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  return_value_if_fail(n >= 0, 0);
+
+  return fs_file_write(file, buffer, tk_min(n, (int32_t)sizeof(buffer) - 1));
+}
+
+static int32_t stream_printf(fs_file_t* file, const char* format, ...) {
+  int32_t n = 0;
+  va_list args;
+
+  va_start(args, format);
+  n = fs_file_vprintf_stream(file, fs_file_write, format, args);
+  va_end(args);
+
+  return n;
+}
+
+typedef int32_t (*bench_printf_t)(fs_file_t* file, const char* format, ...);
+
+static void bench_run(fs_t* fs, const char* name, bench_printf_t bench_printf,
+                      const char* msg) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint64_t bytes = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+
+  for (j = 0; j < BURSTS_NR; j++) {
+    fs_file_t* fp = fs_open_file(fs, "fs_printf_bench.log", "wb");
+    assert(fp != NULL);
+
+    start = time_now_us();
+    for (i = 0; i < LINES_NR; i++) {
+      bytes += bench_printf(fp, "[%u] %s:%d %s value=%08x ratio=%.3f\n", i, __FILE__, __LINE__,
+                            msg, i * 2654435761u, i / 7.0);
+    }
+    cost += time_now_us() - start;
+
+    fs_file_close(fp);
+  }
+
+  log_debug("%s\t%u\t%llu\t%llu\n", name, (uint32_t)strlen(msg),
+            (unsigned long long)(bytes / BURSTS_NR), (unsigned long long)(cost / BURSTS_NR));
+  fs_remove_file(fs, "fs_printf_bench.log");
+}
+
+int main(int argc, char* argv[]) {
+  char long_msg[600];
+  fs_t* fs = os_fs_posix();
+  platform_prepare();
+
+  memset(long_msg, 'L', sizeof(long_msg) - 1);
+  long_msg[sizeof(long_msg) - 1] = '\0';
+
+  log_debug("path\tmsg_len\tbytes/burst\tus/burst(%u lines)\n", LINES_NR);
+  bench_run(fs, "legacy", legacy_printf, "short message");
+  bench_run(fs, "stream", stream_printf, "short message");
+  /*legacy会截断到255字节。*/
+  bench_run(fs, "legacy", legacy_printf, long_msg);
+  bench_run(fs, "stream", stream_printf, long_msg);
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "fs_printf.h"
+
+typedef struct _mem_file_t {
+  fs_file_t fs_file;
+  str_t str;
+  uint32_t writes;
+} mem_file_t;
+
+static int32_t mem_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+  mem_file_t* mem = (mem_file_t*)file;
+
+  mem->writes++;
+  str_append_with_len(&(mem->str), (const char*)buffer, size);
+
+  return size;
+}
+
+static int32_t mem_printf(mem_file_t* mem, const char* format, ...) {
+  int32_t ret = 0;
+  va_list args;
+
+  str_clear(&(mem->str));
+  mem->writes = 0;
+  va_start(args, format);
+  ret = fs_file_vprintf_stream((fs_file_t*)mem, mem_file_write, format, args);
+  va_end(args);
+
+  return ret;
+}
+
+#define CHECK(fmt, ...)                                                  \
+  do {                                                                   \
+    char expected[1024];                                                  \
+    int32_t n = tk_snprintf(expected, sizeof(expected), fmt, __VA_ARGS__); \
+    assert(mem_printf(&mem, fmt, __VA_ARGS__) == n);                     \
+    if (strcmp(mem.str.str, expected) != 0) {                            \
+      log_debug("\"%s\": \"%s\" != \"%s\"\n", fmt, mem.str.str, expected); \
+      assert(!"mismatch");                                               \
+    }                                                                    \
+  } while (0)
+
+int main(int argc, char* argv[]) {
+  mem_file_t mem;
+  char line[2048];
+  platform_prepare();
+
+  memset(&mem, 0x00, sizeof(mem));
+  str_init(&(mem.str), 1024);
+
+  CHECK("%s", "hello");
+  CHECK("[%d|%i|%u]", -123, 456, 789u);
+  CHECK("[%5d|%-5d|%05d|%+d|% d]", 42, 42, -42, 42, 42);
+  CHECK("[%.3d|%8.3d|%-8.3d|%.0d]", 7, -7, 7, 0);
+  CHECK("[%x|%X|%#x|%#X|%#o|%o|%#x]", 255, 255, 255, 255, 8, 8, 0);
+  CHECK("[%08x|%-8x|%#010x]", 0xbeef, 0xbeef, 0xbeef);
+  CHECK("[%hhd|%hd|%hhu|%hu]", 300, 70000, 300, 70000);
+  CHECK("[%ld|%lu|%lld|%llu]", -1L, 2UL, -9000000000LL, 18000000000ULL);
+  CHECK("[%zu|%jd]", (size_t)12345, (intmax_t)-5);
+  CHECK("[%c|%3c|%-3c]", 'a', 'b', 'c');
+  CHECK("[%10s|%-10s|%.2s|%*s|%-*.*s]", "abc", "abc", "abc", 6, "x", 6, 2, "xyz");
+  CHECK("[%f|%.2f|%10.3f|%-10.1f|%+.1e|%g|%G]", 3.14159, 2.5, -1.0, 0.25, 12345.678, 0.0001,
+        1e20);
+  CHECK("[%08.2f|%+08.2f|% f|%#.0f]", -3.5, 3.5, 1.0, 2.0);
+  /*超过FS_PRINTF_FLOAT_SIZE的浮点数不会被截断。*/
+  CHECK("[%f|%-320f|%.150f]", 1e300, -1e300, 1.0 / 3);
+  CHECK("[%d%%|%%%s]", 50, "x");
+  CHECK("%s=%d, %s=%s", "a", 1, "b", "two");
+
+  /*超过输出块的长行不会被截断。*/
+  memset(line, 'x', sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  assert(mem_printf(&mem, "<%s>%d", line, 1) == (int32_t)sizeof(line) + 2);
+  assert(mem.str.size == sizeof(line) + 2);
+  assert(mem.str.str[0] == '<' && mem.str.str[sizeof(line)] == '>');
+
+  assert(mem_printf(&mem, "%2000d|", 1) == 2001);
+  assert(mem.str.str[1998] == ' ' && mem.str.str[1999] == '1');
+
+  /*短行只写一次。*/
+  assert(mem_printf(&mem, "%s:%d\n", "short line", 1) == 13);
+  assert(mem.writes == 1);
+
+  str_reset(&(mem.str));
+  log_debug("fs_printf_test done\n");
+
+  return 0;
+}
@@ -0,0 +1,518 @@
+/**
+ * File:   fs_ring_log.c
+ * Author: AWTK Develop Team
+ * Brief:  append-only log stored in a preallocated ring file
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include <stddef.h>
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include "fs_file_ext.h"
+#include "fs_ring_log.h"
+
+#define FS_RING_LOG_MAGIC 0x474f4c52 /*RLOG*/
+#define FS_RING_LOG_SLOT_SIZE (FS_RING_LOG_HEADER_SIZE / 2)
+/*记录放不下时写在数据区末尾的回绕标记，读到它时回到数据区的开始。*/
+#define FS_RING_LOG_WRAP 0xffffffff
+
+/*
+ * 文件头：两个槽交替写入，打开时使用校验正确且gen较大的一个。
+ * head/tail为数据区中的偏移，used为从head到tail(循环)的字节数，用于区分空和满。
+ */
+typedef struct _fs_ring_log_header_t {
+  uint32_t magic;
+  uint32_t capacity;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t used;
+  uint32_t count;
+  uint32_t gen;
+  uint32_t check;
+} fs_ring_log_header_t;
+
+struct _fs_ring_log_t {
+  fs_file_t* file;
+  fs_ring_log_header_t header;
+  bool_t dirty;
+
+  /*
+   * disk为文件中的文件头，synced为其中还没有丢弃的记录(丢弃记录时head一起前进)。
+   * 写缓冲区写入文件时要覆盖disk中的记录时，先把synced作为文件头写入并同步，
+   * 掉电后文件头中不会有已经被覆盖的记录。
+   */
+  fs_ring_log_header_t disk;
+  fs_ring_log_header_t synced;
+  fs_ring_log_stats_t stats;
+
+  /*
+   * 还没有写入文件的记录(数据区中从wbuf_start开始的连续wbuf_len个字节)。
+   * 相邻的小记录合并为一次写，spiffs修改页中的一部分时要复制整个页，逐条写入时写放大很大。
+   */
+  uint8_t wbuf[FS_RING_LOG_WRITE_BUFFER_SIZE];
+  uint32_t wbuf_start;
+  uint32_t wbuf_len;
+
+  /*遍历时存放记录内容*/
+  uint8_t* buff;
+  uint32_t buff_size;
+};
+
+/*FNV-1a*/
+static uint32_t fs_ring_log_checksum(const fs_ring_log_header_t* header) {
+  uint32_t i = 0;
+  uint32_t hash = 2166136261u;
+  const uint8_t* p = (const uint8_t*)header;
+
+  for (i = 0; i < offsetof(fs_ring_log_header_t, check); i++) {
+    hash = (hash ^ p[i]) * 16777619u;
+  }
+
+  return hash;
+}
+
+static ret_t fs_ring_log_pwrite(fs_ring_log_t* log, const void* data, uint32_t size,
+                                uint32_t offset) {
+  log->stats.written += size;
+
+  return fs_file_pwrite(log->file, data, size, FS_RING_LOG_HEADER_SIZE + offset) == (int32_t)size
+             ? RET_OK
+             : RET_FAIL;
+}
+
+static ret_t fs_ring_log_pread(fs_ring_log_t* log, void* data, uint32_t size, uint32_t offset) {
+  return fs_file_pread(log->file, data, size, FS_RING_LOG_HEADER_SIZE + offset) == (int32_t)size
+             ? RET_OK
+             : RET_FAIL;
+}
+
+/*把header写入文件头的另一个槽，成功后为文件中的文件头。*/
+static ret_t fs_ring_log_write_header(fs_ring_log_t* log, const fs_ring_log_header_t* header) {
+  fs_ring_log_header_t h = *header;
+  uint32_t offset = (log->header.gen + 1) % 2 * FS_RING_LOG_SLOT_SIZE;
+
+  h.gen = ++log->header.gen;
+  h.check = fs_ring_log_checksum(&h);
+  log->stats.written += sizeof(h);
+  if (fs_file_pwrite(log->file, &h, sizeof(h), offset) != sizeof(h)) {
+    return RET_FAIL;
+  }
+  log->disk = h;
+
+  return RET_OK;
+}
+
+static bool_t fs_ring_log_overlap(uint32_t start1, uint32_t end1, uint32_t start2, uint32_t end2) {
+  return start1 < end2 && start2 < end1;
+}
+
+/*数据区中的[start, end)是否和文件头中的记录重叠。*/
+static bool_t fs_ring_log_overlap_disk(fs_ring_log_t* log, uint32_t start, uint32_t end) {
+  const fs_ring_log_header_t* disk = &(log->disk);
+
+  if (disk->used == 0) {
+    return FALSE;
+  }
+  if (disk->head + disk->used <= disk->capacity) {
+    return fs_ring_log_overlap(start, end, disk->head, disk->head + disk->used);
+  }
+
+  return fs_ring_log_overlap(start, end, disk->head, disk->capacity) ||
+         fs_ring_log_overlap(start, end, 0, disk->head + disk->used - disk->capacity);
+}
+
+/*读取pos处的记录长度，pos处是回绕(剩余空间不够放长度字段或者是回绕标记)时返回FS_RING_LOG_WRAP。*/
+static ret_t fs_ring_log_read_size(fs_ring_log_t* log, uint32_t pos, uint32_t* size) {
+  if (log->header.capacity - pos < FS_RING_LOG_RECORD_HEADER_SIZE) {
+    *size = FS_RING_LOG_WRAP;
+    return RET_OK;
+  }
+
+  return fs_ring_log_pread(log, size, sizeof(*size), pos);
+}
+
+/*读取header中最早的记录，返回要跳过的字节数，以及是一条记录还是回绕时跳过的空间。*/
+static ret_t fs_ring_log_peek_head(fs_ring_log_t* log, const fs_ring_log_header_t* header,
+                                   uint32_t* skip, bool_t* record) {
+  uint32_t size = 0;
+
+  return_value_if_fail(fs_ring_log_read_size(log, header->head, &size) == RET_OK, RET_FAIL);
+  *record = size != FS_RING_LOG_WRAP;
+  if (*record) {
+    *skip = FS_RING_LOG_RECORD_HEADER_SIZE + size;
+    return_value_if_fail(*skip <= header->used && header->count > 0, RET_FAIL);
+  } else {
+    *skip = header->capacity - header->head;
+  }
+
+  return RET_OK;
+}
+
+static void fs_ring_log_skip_head(fs_ring_log_header_t* header, uint32_t skip, bool_t record) {
+  header->used -= tk_min(skip, header->used);
+  header->head = (header->head + skip) % header->capacity;
+  if (record) {
+    header->count--;
+  }
+  if (header->count == 0) {
+    header->used = 0;
+    header->tail = header->head;
+  }
+}
+
+/*
+ * 写入文件头时让end之后留出至少1/8容量的空闲空间(不够时从最早的记录开始跳过)，
+ * 之后追加的记录写入这些空间时不会覆盖文件头中的记录，不用再写文件头。
+ * 跳过的记录在内存中还在，只是掉电时会和没有同步的记录一起丢失。
+ */
+static ret_t fs_ring_log_skip_ahead(fs_ring_log_t* log, fs_ring_log_header_t* header,
+                                    uint32_t end) {
+  bool_t record = FALSE;
+  uint32_t skip = 0;
+  uint32_t ahead = header->capacity / 8;
+
+  end %= header->capacity;
+  while (header->used > 0 && (header->head + header->capacity - end) % header->capacity < ahead) {
+    return_value_if_fail(fs_ring_log_peek_head(log, header, &skip, &record) == RET_OK, RET_FAIL);
+    fs_ring_log_skip_head(header, skip, record);
+  }
+
+  return RET_OK;
+}
+
+/*写缓冲区要覆盖文件头中的记录时，先写入一个去掉这些记录的文件头并同步。*/
+static ret_t fs_ring_log_protect(fs_ring_log_t* log, uint32_t end) {
+  fs_ring_log_header_t header = log->synced;
+
+  return_value_if_fail(fs_ring_log_skip_ahead(log, &header, end) == RET_OK, RET_FAIL);
+  return_value_if_fail(fs_ring_log_write_header(log, &header) == RET_OK, RET_FAIL);
+  log->synced = header;
+
+  return fs_file_sync(log->file);
+}
+
+/*写入内存中的文件头(写缓冲区已经写入文件)，之后的记录都在文件中。*/
+static ret_t fs_ring_log_write_current_header(fs_ring_log_t* log) {
+  fs_ring_log_header_t header = log->header;
+
+  return_value_if_fail(fs_ring_log_skip_ahead(log, &header, header.tail) == RET_OK, RET_FAIL);
+  return_value_if_fail(fs_ring_log_write_header(log, &header) == RET_OK, RET_FAIL);
+  log->synced = header;
+  log->dirty = FALSE;
+
+  return RET_OK;
+}
+
+static ret_t fs_ring_log_flush(fs_ring_log_t* log) {
+  uint32_t len = log->wbuf_len;
+
+  log->wbuf_len = 0;
+  if (len == 0) {
+    return RET_OK;
+  }
+
+  if (fs_ring_log_overlap_disk(log, log->wbuf_start, log->wbuf_start + len)) {
+    return_value_if_fail(fs_ring_log_protect(log, log->wbuf_start + len) == RET_OK, RET_FAIL);
+  }
+
+  return fs_ring_log_pwrite(log, log->wbuf, len, log->wbuf_start);
+}
+
+/*
+ * 把数据放到写缓冲区中，和缓冲区中的数据不相邻时先写入文件。缓冲区只存放文件中一个对齐的块，
+ * 写满一个块时整块写入，fatfs可以直接写扇区，不用留下写了一部分的扇区，之后读取head时再写一次。
+ */
+static ret_t fs_ring_log_put(fs_ring_log_t* log, const void* data, uint32_t size, uint32_t pos) {
+  const uint8_t* p = (const uint8_t*)data;
+
+  if (log->wbuf_len > 0 && log->wbuf_start + log->wbuf_len != pos) {
+    return_value_if_fail(fs_ring_log_flush(log) == RET_OK, RET_FAIL);
+  }
+
+  while (size > 0) {
+    uint32_t offset = (FS_RING_LOG_HEADER_SIZE + pos) % sizeof(log->wbuf);
+    uint32_t n = tk_min(size, sizeof(log->wbuf) - offset);
+
+    if (log->wbuf_len == 0) {
+      log->wbuf_start = pos;
+    }
+    memcpy(log->wbuf + log->wbuf_len, p, n);
+    log->wbuf_len += n;
+    if (offset + n == sizeof(log->wbuf)) {
+      return_value_if_fail(fs_ring_log_flush(log) == RET_OK, RET_FAIL);
+    }
+
+    p += n;
+    pos += n;
+    size -= n;
+  }
+
+  return RET_OK;
+}
+
+static bool_t fs_ring_log_header_is_valid(const fs_ring_log_header_t* header,
+                                          uint32_t capacity) {
+  return header->magic == FS_RING_LOG_MAGIC && header->check == fs_ring_log_checksum(header) &&
+         header->capacity == capacity && header->head < capacity && header->tail < capacity &&
+         header->used <= capacity;
+}
+
+static ret_t fs_ring_log_load(fs_ring_log_t* log, uint32_t capacity) {
+  uint32_t i = 0;
+  bool_t found = FALSE;
+  fs_ring_log_header_t header;
+
+  if (fs_file_size(log->file) < FS_RING_LOG_HEADER_SIZE + capacity) {
+    return RET_NOT_FOUND;
+  }
+
+  for (i = 0; i < 2; i++) {
+    if (fs_file_pread(log->file, &header, sizeof(header), i * FS_RING_LOG_SLOT_SIZE) !=
+        sizeof(header)) {
+      return RET_FAIL;
+    }
+    if (fs_ring_log_header_is_valid(&header, capacity) &&
+        (!found || header.gen > log->header.gen)) {
+      log->header = header;
+      found = TRUE;
+    }
+  }
+  log->disk = log->header;
+  log->synced = log->header;
+
+  return found ? RET_OK : RET_NOT_FOUND;
+}
+
+static ret_t fs_ring_log_create(fs_ring_log_t* log, fs_t* fs, const char* filename,
+                                uint32_t capacity) {
+  ret_t ret = RET_OK;
+  uint32_t size = FS_RING_LOG_HEADER_SIZE + capacity;
+
+  log->file = fs_open_file(fs, filename, "wb+");
+  return_value_if_fail(log->file != NULL, RET_FAIL);
+
+  /*spiffs预先分配不改变文件大小，再用truncate把文件补到需要的大小。*/
+  ret = fs_file_allocate(log->file, size);
+  if (ret != RET_OK && ret != RET_NOT_IMPL) {
+    return RET_FAIL;
+  }
+  if (fs_file_truncate(log->file, size) != RET_OK || fs_file_size(log->file) != size) {
+    return RET_FAIL;
+  }
+
+  memset(&(log->header), 0x00, sizeof(log->header));
+  log->header.magic = FS_RING_LOG_MAGIC;
+  log->header.capacity = capacity;
+  if (fs_ring_log_write_current_header(log) != RET_OK) {
+    return RET_FAIL;
+  }
+
+  return fs_file_sync(log->file);
+}
+
+fs_ring_log_t* fs_ring_log_open(fs_t* fs, const char* filename, uint32_t capacity) {
+  ret_t ret = RET_NOT_FOUND;
+  fs_ring_log_t* log = NULL;
+  return_value_if_fail(fs != NULL && filename != NULL, NULL);
+  return_value_if_fail(capacity > 2 * FS_RING_LOG_RECORD_HEADER_SIZE, NULL);
+
+  log = TKMEM_ZALLOC(fs_ring_log_t);
+  return_value_if_fail(log != NULL, NULL);
+
+  log->file = fs_open_file(fs, filename, "rb+");
+  if (log->file != NULL) {
+    ret = fs_ring_log_load(log, capacity);
+    if (ret != RET_OK) {
+      fs_file_close(log->file);
+      log->file = NULL;
+    }
+  }
+
+  if (ret != RET_OK && fs_ring_log_create(log, fs, filename, capacity) != RET_OK) {
+    if (log->file != NULL) {
+      fs_file_close(log->file);
+    }
+    TKMEM_FREE(log);
+    return NULL;
+  }
+  log->stats.capacity = capacity;
+
+  return log;
+}
+
+/*丢弃最早的一条记录(或者head处回绕时跳过的空间)。*/
+static ret_t fs_ring_log_drop_head(fs_ring_log_t* log) {
+  uint32_t skip = 0;
+  bool_t record = FALSE;
+  fs_ring_log_header_t* header = &(log->header);
+
+  if (header->head >= log->wbuf_start && header->head < log->wbuf_start + log->wbuf_len) {
+    return_value_if_fail(fs_ring_log_flush(log) == RET_OK, RET_FAIL);
+  }
+  return_value_if_fail(fs_ring_log_peek_head(log, header, &skip, &record) == RET_OK, RET_FAIL);
+  if (record) {
+    log->stats.dropped++;
+  }
+
+  /*synced中最早的记录也是这条记录时一起丢弃(synced可能已经跳过了更多的记录)。*/
+  if (log->synced.used > 0 && log->synced.head == header->head) {
+    fs_ring_log_skip_head(&(log->synced), skip, record);
+  }
+  fs_ring_log_skip_head(header, skip, record);
+
+  return RET_OK;
+}
+
+ret_t fs_ring_log_append(fs_ring_log_t* log, const void* data, uint32_t size) {
+  uint32_t skip = 0;
+  uint32_t need = 0;
+  fs_ring_log_header_t* header = NULL;
+  return_value_if_fail(log != NULL && (data != NULL || size == 0), RET_BAD_PARAMS);
+
+  header = &(log->header);
+  need = FS_RING_LOG_RECORD_HEADER_SIZE + size;
+  return_value_if_fail(size < FS_RING_LOG_WRAP && need <= header->capacity, RET_BAD_PARAMS);
+
+  /*空闲的空间是从tail到head的连续区域，从head开始丢弃记录直到放得下，全部丢弃后从头开始写。*/
+  while (TRUE) {
+    if (header->used == 0) {
+      header->head = 0;
+      header->tail = 0;
+    }
+
+    skip = header->tail + need > header->capacity ? header->capacity - header->tail : 0;
+    if (header->capacity - header->used >= skip + need) {
+      break;
+    }
+    return_value_if_fail(fs_ring_log_drop_head(log) == RET_OK, RET_FAIL);
+  }
+
+  if (skip > 0) {
+    if (skip >= FS_RING_LOG_RECORD_HEADER_SIZE) {
+      uint32_t wrap = FS_RING_LOG_WRAP;
+      return_value_if_fail(fs_ring_log_put(log, &wrap, sizeof(wrap), header->tail) == RET_OK,
+                           RET_FAIL);
+    }
+    header->used += skip;
+    header->tail = 0;
+  }
+
+  return_value_if_fail(fs_ring_log_put(log, &size, sizeof(size), header->tail) == RET_OK,
+                       RET_FAIL);
+  if (size > 0) {
+    return_value_if_fail(
+        fs_ring_log_put(log, data, size, header->tail + FS_RING_LOG_RECORD_HEADER_SIZE) == RET_OK,
+        RET_FAIL);
+  }
+
+  header->used += need;
+  header->count++;
+  header->tail = (header->tail + need) % header->capacity;
+  log->stats.appended += size;
+  log->dirty = TRUE;
+
+  return RET_OK;
+}
+
+ret_t fs_ring_log_foreach(fs_ring_log_t* log, fs_ring_log_on_record_t on_record, void* ctx) {
+  uint32_t i = 0;
+  uint32_t pos = 0;
+  return_value_if_fail(log != NULL && on_record != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(fs_ring_log_flush(log) == RET_OK, RET_FAIL);
+
+  pos = log->header.head;
+  for (i = 0; i < log->header.count; i++) {
+    uint32_t size = 0;
+
+    return_value_if_fail(fs_ring_log_read_size(log, pos, &size) == RET_OK, RET_FAIL);
+    if (size == FS_RING_LOG_WRAP) {
+      pos = 0;
+      return_value_if_fail(fs_ring_log_read_size(log, pos, &size) == RET_OK, RET_FAIL);
+    }
+    return_value_if_fail(size <= log->header.capacity - pos - FS_RING_LOG_RECORD_HEADER_SIZE,
+                         RET_FAIL);
+
+    if (size > log->buff_size) {
+      uint8_t* buff = TKMEM_REALLOCT(uint8_t, log->buff, size);
+      return_value_if_fail(buff != NULL, RET_OOM);
+      log->buff = buff;
+      log->buff_size = size;
+    }
+    if (size > 0) {
+      return_value_if_fail(
+          fs_ring_log_pread(log, log->buff, size, pos + FS_RING_LOG_RECORD_HEADER_SIZE) == RET_OK,
+          RET_FAIL);
+    }
+
+    if (on_record(ctx, log->buff, size) == RET_STOP) {
+      break;
+    }
+    pos = (pos + FS_RING_LOG_RECORD_HEADER_SIZE + size) % log->header.capacity;
+  }
+
+  return RET_OK;
+}
+
+ret_t fs_ring_log_clear(fs_ring_log_t* log) {
+  return_value_if_fail(log != NULL, RET_BAD_PARAMS);
+
+  log->wbuf_len = 0;
+  log->header.head = 0;
+  log->header.tail = 0;
+  log->header.used = 0;
+  log->header.count = 0;
+
+  return fs_ring_log_write_current_header(log);
+}
+
+ret_t fs_ring_log_sync(fs_ring_log_t* log) {
+  return_value_if_fail(log != NULL, RET_BAD_PARAMS);
+
+  if (fs_ring_log_flush(log) != RET_OK) {
+    return RET_FAIL;
+  }
+  if (log->dirty && fs_ring_log_write_current_header(log) != RET_OK) {
+    return RET_FAIL;
+  }
+
+  return fs_file_sync(log->file);
+}
+
+ret_t fs_ring_log_get_stats(fs_ring_log_t* log, fs_ring_log_stats_t* stats) {
+  return_value_if_fail(log != NULL && stats != NULL, RET_BAD_PARAMS);
+
+  *stats = log->stats;
+  stats->used = log->header.used;
+  stats->count = log->header.count;
+
+  return RET_OK;
+}
+
+ret_t fs_ring_log_close(fs_ring_log_t* log) {
+  ret_t ret = RET_OK;
+  return_value_if_fail(log != NULL, RET_BAD_PARAMS);
+
+  ret = fs_ring_log_sync(log);
+  fs_file_close(log->file);
+  if (log->buff != NULL) {
+    TKMEM_FREE(log->buff);
+  }
+  TKMEM_FREE(log);
+
+  return ret;
+}
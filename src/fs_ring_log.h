@@ -0,0 +1,186 @@
+/**
+ * File:   fs_ring_log.h
+ * Author: AWTK Develop Team
+ * Brief:  append-only log stored in a preallocated ring file
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_RING_LOG_H
+#define TK_FS_RING_LOG_H
+
+#include "tkc/fs.h"
+
+BEGIN_C_DECLS
+
+/**
+ * 文件头的大小(两份头部交替写入，写入一份的过程中掉电时还有另一份可用)。
+ */
+#define FS_RING_LOG_HEADER_SIZE 64
+
+/**
+ * 每条记录前面的长度字段的大小。
+ */
+#define FS_RING_LOG_RECORD_HEADER_SIZE 4
+
+/**
+ * 写缓冲区的大小，追加的记录先放在缓冲区中，写满文件中对齐的一块或者同步时才写入文件。
+ * 最好是扇区(fatfs)的整数倍。
+ */
+#ifndef FS_RING_LOG_WRITE_BUFFER_SIZE
+#define FS_RING_LOG_WRITE_BUFFER_SIZE 512
+#endif /*FS_RING_LOG_WRITE_BUFFER_SIZE*/
+
+/**
+ * 遍历记录的回调函数，返回RET_STOP时停止遍历。
+ * data只在回调函数中有效。
+ */
+typedef ret_t (*fs_ring_log_on_record_t)(void* ctx, const void* data, uint32_t size);
+
+/**
+ * @class fs_ring_log_stats_t
+ * 环形日志的统计信息。
+ */
+typedef struct _fs_ring_log_stats_t {
+  /**
+   * @property {uint32_t} capacity
+   * @annotation ["readable"]
+   * 数据区的大小(字节)。
+   */
+  uint32_t capacity;
+  /**
+   * @property {uint32_t} used
+   * @annotation ["readable"]
+   * 数据区中已经使用的大小(包括记录的长度字段和回绕时末尾跳过的空间)。
+   */
+  uint32_t used;
+  /**
+   * @property {uint32_t} count
+   * @annotation ["readable"]
+   * 记录的条数。
+   */
+  uint32_t count;
+  /**
+   * @property {uint64_t} dropped
+   * @annotation ["readable"]
+   * 为了腾出空间丢弃的旧记录的条数。
+   */
+  uint64_t dropped;
+  /**
+   * @property {uint64_t} appended
+   * @annotation ["readable"]
+   * 追加的记录内容的字节数。
+   */
+  uint64_t appended;
+  /**
+   * @property {uint64_t} written
+   * @annotation ["readable"]
+   * 写入文件的字节数(包括长度字段、回绕标记和文件头)，written/appended为文件一级的写放大。
+   */
+  uint64_t written;
+} fs_ring_log_stats_t;
+
+/**
+ * @class fs_ring_log_t
+ * 环形日志。
+ *
+ * 日志保存在一个预先分配的定长文件中：文件头记录最早的记录(head)和写入位置(tail)，
+ * 记录依次追加到tail，到达末尾时回绕到数据区的开始，空间不够时丢弃最早的记录。
+ * 文件创建之后大小不再变化，不需要像删除重建的日志那样反复分配和释放空间。
+ *
+ * 追加的记录先放在写缓冲区中，文件头在fs_ring_log_sync/fs_ring_log_close时写入，
+ * 写缓冲区要覆盖文件头中的记录时先写入去掉这些记录的文件头。
+ * 写入文件头时空闲空间不到容量的1/8时，文件头中跳过最早的一些记录，留出1/8的空闲空间，
+ * 之后追加时不用每次都写文件头。掉电时丢失上次同步之后追加的记录和这些跳过的记录，
+ * 文件头中的记录都是完整的。
+ * > 文件中的整数按本机字节序保存。不是线程安全的，多个线程使用时由调用者加锁。
+ */
+typedef struct _fs_ring_log_t fs_ring_log_t;
+
+/**
+ * @method fs_ring_log_open
+ * 打开环形日志。文件不存在、格式不对或者容量不同时重新创建(用fs_file_allocate预先分配)。
+ * @annotation ["constructor"]
+ * @param {fs_t*} fs fs对象。
+ * @param {const char*} filename 文件名。
+ * @param {uint32_t} capacity 数据区的大小(字节)，文件大小为capacity+FS_RING_LOG_HEADER_SIZE。
+ *
+ * @return {fs_ring_log_t*} 返回环形日志对象，失败返回NULL。
+ */
+fs_ring_log_t* fs_ring_log_open(fs_t* fs, const char* filename, uint32_t capacity);
+
+/**
+ * @method fs_ring_log_append
+ * 追加一条记录，空间不够时丢弃最早的记录。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ * @param {const void*} data 记录的内容。
+ * @param {uint32_t} size 记录的长度(加上FS_RING_LOG_RECORD_HEADER_SIZE后不能超过容量)。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_append(fs_ring_log_t* log, const void* data, uint32_t size);
+
+/**
+ * @method fs_ring_log_foreach
+ * 从最早的记录开始依次遍历所有记录。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ * @param {fs_ring_log_on_record_t} on_record 回调函数。
+ * @param {void*} ctx 回调函数的上下文。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_foreach(fs_ring_log_t* log, fs_ring_log_on_record_t on_record, void* ctx);
+
+/**
+ * @method fs_ring_log_clear
+ * 清除所有记录(只写文件头)。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_clear(fs_ring_log_t* log);
+
+/**
+ * @method fs_ring_log_sync
+ * 写入文件头并同步文件，之前追加的记录在掉电后不会丢失。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_sync(fs_ring_log_t* log);
+
+/**
+ * @method fs_ring_log_get_stats
+ * 获取统计信息。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ * @param {fs_ring_log_stats_t*} stats 用于返回统计信息。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_get_stats(fs_ring_log_t* log, fs_ring_log_stats_t* stats);
+
+/**
+ * @method fs_ring_log_close
+ * 同步并关闭环形日志。
+ * @param {fs_ring_log_t*} log 环形日志对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_ring_log_close(fs_ring_log_t* log);
+
+END_C_DECLS
+
+#endif /*TK_FS_RING_LOG_H*/
@@ -0,0 +1,345 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "ff.h"
+#include "tkc/fs.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "spiffs/spiffs.h"
+#include "fatfs/diskio_dev.h"
+#include "fatfs/diskio_ramdisk.h"
+#include "fs_os_spiffs.h"
+#include "fs_ring_log.h"
+
+/*
+ * 环形日志的功能测试，以及在fatfs(RAM disk)和spiffs(RAM flash)上和删除重建的日志比较写放大：
+ * 追加相同的记录(每LOG_SYNC_EVERY条同步一次)，统计设备上实际写入(和擦除)的字节数。
+ * 每个文件系统输出一行JSON，wa为写入设备的字节数/追加的记录内容的字节数。
+ */
+
+#define LOG_CAPACITY (16 * 1024)
+#define LOG_RECORDS 2000
+#define LOG_SYNC_EVERY 16
+#define SPIFFS_FLASH_SIZE (128 * 1024)
+
+extern fs_t* os_fs_fatfs(void);
+s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size);
+void fs_ram_get_stats(uint64_t* written, uint64_t* erased);
+
+typedef struct _check_ctx_t {
+  uint32_t next;
+  uint32_t count;
+} check_ctx_t;
+
+/*记录的内容为序号加上由序号决定长度的填充。*/
+static uint32_t make_record(uint8_t* buff, uint32_t seq) {
+  uint32_t size = sizeof(seq) + seq % 61 + 40;
+
+  memcpy(buff, &seq, sizeof(seq));
+  memset(buff + sizeof(seq), (uint8_t)seq, size - sizeof(seq));
+
+  return size;
+}
+
+static ret_t check_record(void* ctx, const void* data, uint32_t size) {
+  uint32_t seq = 0;
+  uint8_t buff[128];
+  check_ctx_t* check = (check_ctx_t*)ctx;
+
+  memcpy(&seq, data, sizeof(seq));
+  assert(check->count == 0 || seq == check->next);
+  assert(size == make_record(buff, seq) && memcmp(buff, data, size) == 0);
+  check->next = seq + 1;
+  check->count++;
+
+  return RET_OK;
+}
+
+static ret_t stop_record(void* ctx, const void* data, uint32_t size) {
+  (*(uint32_t*)ctx)++;
+
+  return RET_STOP;
+}
+
+static void check_log(fs_ring_log_t* log, uint32_t last) {
+  check_ctx_t check = {0, 0};
+  fs_ring_log_stats_t stats;
+
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(fs_ring_log_foreach(log, check_record, &check) == RET_OK);
+  assert(check.count == stats.count);
+  assert(check.count == 0 || check.next == last);
+}
+
+static void test_basic(fs_t* fs, const char* filename) {
+  uint32_t i = 0;
+  uint32_t n = 0;
+  uint8_t buff[128];
+  fs_ring_log_stats_t stats;
+  fs_ring_log_t* log = fs_ring_log_open(fs, filename, 1024);
+
+  assert(log != NULL);
+  assert(fs_get_file_size(fs, filename) == 1024 + FS_RING_LOG_HEADER_SIZE);
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(stats.capacity == 1024 && stats.count == 0 && stats.used == 0);
+  assert(fs_ring_log_append(log, buff, 1024) == RET_BAD_PARAMS);
+
+  for (i = 0; i < 5; i++) {
+    assert(fs_ring_log_append(log, buff, make_record(buff, i)) == RET_OK);
+  }
+  check_log(log, 5);
+  assert(fs_ring_log_foreach(log, stop_record, &n) == RET_OK && n == 1);
+  assert(fs_ring_log_close(log) == RET_OK);
+
+  /*重新打开后记录还在，继续追加直到回绕多次。*/
+  log = fs_ring_log_open(fs, filename, 1024);
+  assert(log != NULL);
+  check_log(log, 5);
+  for (i = 5; i < 200; i++) {
+    assert(fs_ring_log_append(log, buff, make_record(buff, i)) == RET_OK);
+    check_log(log, i + 1);
+  }
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(stats.dropped > 0 && stats.count + stats.dropped == 200);
+  assert(stats.used <= stats.capacity && stats.count > 5);
+  assert(fs_ring_log_append(log, NULL, 0) == RET_OK);
+  assert(fs_ring_log_close(log) == RET_OK);
+  assert(fs_get_file_size(fs, filename) == 1024 + FS_RING_LOG_HEADER_SIZE);
+
+  log = fs_ring_log_open(fs, filename, 1024);
+  assert(log != NULL);
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(stats.count > 5);
+  assert(fs_ring_log_clear(log) == RET_OK);
+  check_log(log, 0);
+  assert(fs_ring_log_append(log, buff, make_record(buff, 7)) == RET_OK);
+  check_log(log, 8);
+  assert(fs_ring_log_close(log) == RET_OK);
+
+  /*容量不同时重新创建。*/
+  log = fs_ring_log_open(fs, filename, 2048);
+  assert(log != NULL);
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(stats.count == 0 && stats.capacity == 2048);
+  assert(fs_ring_log_close(log) == RET_OK);
+  assert(fs_get_file_size(fs, filename) == 2048 + FS_RING_LOG_HEADER_SIZE);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+/*
+ * 同步之后继续追加(写缓冲区写入文件时覆盖了文件头中的记录)但没有同步，这时掉电(用另一个对象打开)，
+ * 文件头中的记录都完好，并且正好是同步时的记录。
+ */
+static void test_reopen_unsynced(fs_t* fs, const char* filename) {
+  uint32_t i = 0;
+  uint8_t buff[128];
+  check_ctx_t check = {0, 0};
+  fs_ring_log_stats_t stats;
+  fs_ring_log_t* crashed = NULL;
+  fs_ring_log_t* log = fs_ring_log_open(fs, filename, 4096);
+
+  assert(log != NULL);
+  for (i = 0; i < 200; i++) {
+    assert(fs_ring_log_append(log, buff, make_record(buff, i)) == RET_OK);
+  }
+  assert(fs_ring_log_sync(log) == RET_OK);
+  for (i = 200; i < 230; i++) {
+    assert(fs_ring_log_append(log, buff, make_record(buff, i)) == RET_OK);
+  }
+
+  crashed = fs_ring_log_open(fs, filename, 4096);
+  assert(crashed != NULL);
+  assert(fs_ring_log_get_stats(crashed, &stats) == RET_OK);
+  assert(fs_ring_log_foreach(crashed, check_record, &check) == RET_OK);
+  assert(check.count == stats.count);
+  assert(check.count == 0 || check.next == 200);
+  assert(fs_ring_log_close(crashed) == RET_OK);
+
+  assert(fs_ring_log_close(log) == RET_OK);
+  log = fs_ring_log_open(fs, filename, 4096);
+  assert(log != NULL);
+  check_log(log, 230);
+  assert(fs_ring_log_close(log) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+typedef void (*device_stats_t)(uint64_t* written, uint64_t* erased);
+
+/*写满LOG_CAPACITY/2时删除旧的备份文件，把当前文件改名为备份，再创建新的文件。*/
+static uint64_t append_rotate(fs_t* fs, const char* filename, const char* backup) {
+  uint32_t i = 0;
+  uint32_t size = 0;
+  uint8_t buff[128];
+  uint64_t appended = 0;
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+
+  assert(fp != NULL);
+  for (i = 0; i < LOG_RECORDS; i++) {
+    if (size + sizeof(buff) > LOG_CAPACITY / 2) {
+      fs_file_close(fp);
+      if (fs_file_exist(fs, backup)) {
+        assert(fs_remove_file(fs, backup) == RET_OK);
+      }
+      assert(fs_file_rename(fs, filename, backup) == RET_OK);
+      fp = fs_open_file(fs, filename, "wb");
+      assert(fp != NULL);
+      size = 0;
+    }
+
+    size += make_record(buff, i);
+    appended += make_record(buff, i);
+    assert(fs_file_write(fp, buff, make_record(buff, i)) == make_record(buff, i));
+    if ((i + 1) % LOG_SYNC_EVERY == 0) {
+      assert(fs_file_sync(fp) == RET_OK);
+    }
+  }
+  fs_file_close(fp);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+  assert(fs_remove_file(fs, backup) == RET_OK);
+
+  return appended;
+}
+
+static uint64_t append_ring(fs_t* fs, const char* filename) {
+  uint32_t i = 0;
+  uint8_t buff[128];
+  fs_ring_log_stats_t stats;
+  fs_ring_log_t* log = fs_ring_log_open(fs, filename, LOG_CAPACITY);
+
+  assert(log != NULL);
+  for (i = 0; i < LOG_RECORDS; i++) {
+    assert(fs_ring_log_append(log, buff, make_record(buff, i)) == RET_OK);
+    if ((i + 1) % LOG_SYNC_EVERY == 0) {
+      assert(fs_ring_log_sync(log) == RET_OK);
+    }
+  }
+  check_log(log, LOG_RECORDS);
+  assert(fs_ring_log_get_stats(log, &stats) == RET_OK);
+  assert(fs_ring_log_close(log) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+
+  return stats.appended;
+}
+
+/*返回环形日志写入设备的字节数是否比删除重建的少。*/
+static bool_t test_write_amp(fs_t* fs, const char* name, const char* prefix,
+                             device_stats_t device_stats) {
+  uint64_t appended = 0;
+  uint64_t written[3];
+  uint64_t erased[3];
+  char filename[MAX_PATH + 1];
+  char backup[MAX_PATH + 1];
+
+  tk_snprintf(filename, MAX_PATH, "%slog.txt", prefix);
+  tk_snprintf(backup, MAX_PATH, "%slog.1.txt", prefix);
+  device_stats(written, erased);
+  appended = append_rotate(fs, filename, backup);
+  device_stats(written + 1, erased + 1);
+
+  tk_snprintf(filename, MAX_PATH, "%sring.log", prefix);
+  assert(append_ring(fs, filename) == appended);
+  device_stats(written + 2, erased + 2);
+
+  printf("{\"fs\":\"%s\",\"sync_every\":%d,\"appended\":%llu,\"rotate_written\":%llu,"
+         "\"rotate_erased\":%llu,\"rotate_wa\":%.2f,\"ring_written\":%llu,"
+         "\"ring_erased\":%llu,\"ring_wa\":%.2f}\n",
+         name, LOG_SYNC_EVERY, (unsigned long long)appended,
+         (unsigned long long)(written[1] - written[0]), (unsigned long long)(erased[1] - erased[0]),
+         (double)(written[1] - written[0]) / appended,
+         (unsigned long long)(written[2] - written[1]), (unsigned long long)(erased[2] - erased[1]),
+         (double)(written[2] - written[1]) / appended);
+  fflush(stdout);
+
+  return written[2] - written[1] < written[1] - written[0];
+}
+
+/*统计写入RAM disk的字节数的驱动，包装在RAM disk驱动的前面。*/
+typedef struct _counting_dev_t {
+  diskio_dev_t dev;
+  uint64_t written;
+} counting_dev_t;
+
+static counting_dev_t s_counting_dev;
+
+static DSTATUS counting_status(diskio_dev_t* dev) {
+  return dev->impl->status(dev->impl);
+}
+
+static DSTATUS counting_initialize(diskio_dev_t* dev) {
+  return dev->impl->initialize(dev->impl);
+}
+
+static DRESULT counting_read(diskio_dev_t* dev, BYTE* buff, DWORD sector, UINT count) {
+  return dev->impl->read(dev->impl, buff, sector, count);
+}
+
+static DRESULT counting_write(diskio_dev_t* dev, const BYTE* buff, DWORD sector, UINT count) {
+  WORD ss = 0;
+
+  dev->impl->ioctl(dev->impl, GET_SECTOR_SIZE, &ss);
+  ((counting_dev_t*)dev)->written += (uint64_t)count * ss;
+
+  return dev->impl->write(dev->impl, buff, sector, count);
+}
+
+static DRESULT counting_ioctl(diskio_dev_t* dev, BYTE cmd, void* buff) {
+  return dev->impl->ioctl(dev->impl, cmd, buff);
+}
+
+static void fatfs_device_stats(uint64_t* written, uint64_t* erased) {
+  *written = s_counting_dev.written;
+  *erased = 0;
+}
+
+static void test_fatfs(void) {
+  FATFS fatfs;
+  BYTE work[FF_MAX_SS];
+  fs_t* fs = os_fs_fatfs();
+
+  s_counting_dev.dev.status = counting_status;
+  s_counting_dev.dev.initialize = counting_initialize;
+  s_counting_dev.dev.read = counting_read;
+  s_counting_dev.dev.write = counting_write;
+  s_counting_dev.dev.ioctl = counting_ioctl;
+  s_counting_dev.dev.impl = ramdisk_get_dev(0);
+  assert(diskio_set_dev(0, &(s_counting_dev.dev)) == RES_OK);
+
+  assert(f_mkfs("0:", FM_FAT, 0, work, sizeof(work)) == FR_OK);
+  assert(f_mount(&fatfs, "0:", 0) == FR_OK);
+
+  test_basic(fs, "0:/basic.log");
+  test_reopen_unsynced(fs, "0:/crash.log");
+  assert(test_write_amp(fs, "fatfs", "0:/", fatfs_device_stats));
+
+  assert(f_mount(0, "0:", 0) == FR_OK);
+  assert(diskio_set_dev(0, NULL) == RES_OK);
+}
+
+static void test_spiffs(void) {
+  spiffs myfs;
+  static uint8_t flash[SPIFFS_FLASH_SIZE];
+
+  memset(flash, 0xff, sizeof(flash));
+  if (fs_mount_ram(&myfs, flash, sizeof(flash)) != 0) {
+    assert(SPIFFS_format(&myfs) == 0);
+    assert(fs_mount_ram(&myfs, flash, sizeof(flash)) == 0);
+  }
+  os_fs_spiffs_set(&myfs);
+
+  test_basic(os_fs_spiffs(), "basic.log");
+  test_reopen_unsynced(os_fs_spiffs(), "crash.log");
+  /*spiffs覆盖写时要复制整页(copy-on-write)，环形日志写入的字节数反而更多，只输出不比较。*/
+  test_write_amp(os_fs_spiffs(), "spiffs", "", fs_ram_get_stats);
+
+  SPIFFS_unmount(&myfs);
+}
+
+int main(int argc, char* argv[]) {
+  platform_prepare();
+
+  test_fatfs();
+  test_spiffs();
+
+  return 0;
+}
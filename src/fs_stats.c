@@ -0,0 +1,711 @@
+/**
+ * File:   fs_stats.c
+ * Author: AWTK Develop Team
+ * Brief:  per-operation counters and latency histograms of fs
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include "tkc/mutex.h"
+#include "tkc/time_now.h"
+#include <stdarg.h>
+#include "fs_stats.h"
+#include "fs_printf.h"
+#include "fs_file_ext.h"
+
+#if defined(__GNUC__) && defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && \
+    __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#define FS_STATS_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define FS_STATS_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define FS_STATS_SUB(p, v) __atomic_fetch_sub((p), (v), __ATOMIC_RELAXED)
+#define FS_STATS_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define FS_STATS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define FS_STATS_CAS(p, expected, v) \
+  __atomic_compare_exchange_n((p), (expected), (v), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define FS_STATS_LOCK(sfs)
+#define FS_STATS_UNLOCK(sfs)
+#else
+/*没有无锁的64位原子操作时，计数器只在FS_STATS_LOCK和FS_STATS_UNLOCK之间读写。*/
+#define FS_STATS_WITH_MUTEX 1
+#define FS_STATS_ADD(p, v) (*(p) += (v))
+#define FS_STATS_FETCH_ADD(p, v) ((*(p) += (v)) - (v))
+#define FS_STATS_SUB(p, v) (*(p) -= (v))
+#define FS_STATS_LOAD(p) (*(p))
+#define FS_STATS_STORE(p, v) (*(p) = (v))
+#define FS_STATS_CAS(p, expected, v) \
+  (*(p) == *(expected) ? (*(p) = (v), TRUE) : (*(expected) = *(p), FALSE))
+#define FS_STATS_LOCK(sfs) tk_mutex_lock((sfs)->mutex)
+#define FS_STATS_UNLOCK(sfs) tk_mutex_unlock((sfs)->mutex)
+#endif
+
+typedef struct _fs_stats_fs_t {
+  fs_t fs;
+  fs_t* impl;
+  uint32_t open_nr;
+  uint32_t sample_mask;
+  fs_stats_t stats;
+#ifdef FS_STATS_WITH_MUTEX
+  tk_mutex_t* mutex;
+#endif /*FS_STATS_WITH_MUTEX*/
+} fs_stats_fs_t;
+
+typedef struct _fs_stats_file_t {
+  fs_file_t fs_file;
+  fs_stats_fs_t* sfs;
+} fs_stats_file_t;
+
+typedef struct _fs_stats_dir_t {
+  fs_dir_t fs_dir;
+  fs_stats_fs_t* sfs;
+} fs_stats_dir_t;
+
+#define FS_STATS_NOT_SAMPLED ((uint64_t)-1)
+#define FS_STATS_OP(sfs, op) (&((sfs)->stats.ops[op]))
+#define FS_STATS_FILE_FS(file) (((fs_stats_file_t*)(file))->sfs)
+#define FS_STATS_DIR_FS(dir) (((fs_stats_dir_t*)(dir))->sfs)
+
+/*计数后决定是否对本次调用计时，返回开始的时间。*/
+static uint64_t fs_stats_begin(fs_stats_fs_t* sfs, fs_stats_op_t op) {
+  uint64_t n = 0;
+
+  FS_STATS_LOCK(sfs);
+  n = FS_STATS_FETCH_ADD(&(FS_STATS_OP(sfs, op)->calls), 1);
+  FS_STATS_UNLOCK(sfs);
+
+  return ((uint32_t)n & sfs->sample_mask) == 0 ? time_now_us() : FS_STATS_NOT_SAMPLED;
+}
+
+static void fs_stats_end(fs_stats_fs_t* sfs, fs_stats_op_t op, uint64_t start, bool_t failed,
+                         int64_t bytes) {
+  fs_stats_op_info_t* info = FS_STATS_OP(sfs, op);
+
+  FS_STATS_LOCK(sfs);
+  if (failed) {
+    FS_STATS_ADD(&(info->errors), 1);
+  }
+  if (bytes > 0) {
+    FS_STATS_ADD(&(info->bytes), (uint64_t)bytes);
+  }
+
+  if (start != FS_STATS_NOT_SAMPLED) {
+    uint64_t us = time_now_us() - start;
+    fs_latency_t* latency = &(info->latency);
+    uint64_t max = FS_STATS_LOAD(&(latency->max));
+
+    FS_STATS_ADD(&(latency->count), 1);
+    FS_STATS_ADD(&(latency->sum), us);
+    FS_STATS_ADD(&(latency->buckets[fs_latency_bucket_of(us)]), 1);
+    /*CAS失败时max被更新为当前值，重新比较。*/
+    while (us > max && !FS_STATS_CAS(&(latency->max), &max, us)) {
+    }
+  }
+  FS_STATS_UNLOCK(sfs);
+}
+
+static int32_t fs_stats_file_read(fs_file_t* file, void* buffer, uint32_t size) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_READ);
+  int32_t result = fs_file_read((fs_file_t*)(file->data), buffer, size);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_READ, start, result < 0, result);
+
+  return result;
+}
+
+static int32_t fs_stats_file_write(fs_file_t* file, const void* buffer, uint32_t size) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITE);
+  int32_t result = fs_file_write((fs_file_t*)(file->data), buffer, size);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITE, start, result < 0, result);
+
+  return result;
+}
+
+static int32_t fs_stats_file_printf(fs_file_t* file, const char* const format, va_list args) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITE);
+  int32_t result = fs_file_vprintf_stream((fs_file_t*)(file->data), fs_file_write, format, args);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITE, start, result < 0, result);
+
+  return result;
+}
+
+static ret_t fs_stats_file_seek(fs_file_t* file, int32_t offset) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_SEEK);
+  ret_t result = fs_file_seek((fs_file_t*)(file->data), offset);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_SEEK, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static int64_t fs_stats_file_tell(fs_file_t* file) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_TELL);
+  int64_t result = fs_file_tell((fs_file_t*)(file->data));
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_TELL, start, result < 0, 0);
+
+  return result;
+}
+
+static int64_t fs_stats_file_size(fs_file_t* file) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_SIZE);
+  int64_t result = fs_file_size((fs_file_t*)(file->data));
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_SIZE, start, result < 0, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_stat(fs_file_t* file, fs_stat_info_t* fst) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_FSTAT);
+  ret_t result = fs_file_stat((fs_file_t*)(file->data), fst);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_FSTAT, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_sync(fs_file_t* file) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_SYNC);
+  ret_t result = fs_file_sync((fs_file_t*)(file->data));
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_SYNC, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_truncate(fs_file_t* file, int32_t size) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_TRUNCATE);
+  ret_t result = fs_file_truncate((fs_file_t*)(file->data), size);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_TRUNCATE, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static bool_t fs_stats_file_eof(fs_file_t* file) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_EOF);
+  bool_t result = fs_file_eof((fs_file_t*)(file->data));
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_EOF, start, FALSE, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_map(fs_file_t* file, const void** data, uint32_t* size) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_MAP);
+  ret_t result = fs_file_map((fs_file_t*)(file->data), data, size);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_MAP, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static int32_t fs_stats_file_borrow(fs_file_t* file, uint32_t size, void* scratch,
+                                    const void** data) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_BORROW);
+  int32_t result = fs_file_borrow((fs_file_t*)(file->data), size, scratch, data);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_BORROW, start, result < 0, result);
+
+  return result;
+}
+
+static ret_t fs_stats_file_release(fs_file_t* file, const void* data) {
+  return fs_file_release((fs_file_t*)(file->data), data);
+}
+
+static int32_t fs_stats_file_readv(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_READV);
+  int32_t result = fs_file_readv((fs_file_t*)(file->data), iov, iovcnt);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_READV, start, result < 0, result);
+
+  return result;
+}
+
+static int32_t fs_stats_file_writev(fs_file_t* file, const fs_iovec_t* iov, uint32_t iovcnt) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITEV);
+  int32_t result = fs_file_writev((fs_file_t*)(file->data), iov, iovcnt);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_WRITEV, start, result < 0, result);
+
+  return result;
+}
+
+static int32_t fs_stats_file_pread(fs_file_t* file, void* buffer, uint32_t size,
+                                   uint64_t offset) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_PREAD);
+  int32_t result = fs_file_pread((fs_file_t*)(file->data), buffer, size, offset);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_PREAD, start, result < 0, result);
+
+  return result;
+}
+
+static int32_t fs_stats_file_pwrite(fs_file_t* file, const void* buffer, uint32_t size,
+                                    uint64_t offset) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_PWRITE);
+  int32_t result = fs_file_pwrite((fs_file_t*)(file->data), buffer, size, offset);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_PWRITE, start, result < 0, result);
+
+  return result;
+}
+
+static ret_t fs_stats_file_allocate(fs_file_t* file, uint64_t size) {
+  uint64_t start = fs_stats_begin(FS_STATS_FILE_FS(file), FS_STATS_OP_ALLOCATE);
+  ret_t result = fs_file_allocate((fs_file_t*)(file->data), size);
+  fs_stats_end(FS_STATS_FILE_FS(file), FS_STATS_OP_ALLOCATE, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_close(fs_file_t* file) {
+  fs_stats_fs_t* sfs = FS_STATS_FILE_FS(file);
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_CLOSE);
+  ret_t result = fs_file_close((fs_file_t*)(file->data));
+
+  TKMEM_FREE(file);
+  FS_STATS_LOCK(sfs);
+  FS_STATS_SUB(&(sfs->open_nr), 1);
+  FS_STATS_UNLOCK(sfs);
+  fs_stats_end(sfs, FS_STATS_OP_CLOSE, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_dir_rewind(fs_dir_t* dir) {
+  uint64_t start = fs_stats_begin(FS_STATS_DIR_FS(dir), FS_STATS_OP_DIR_REWIND);
+  ret_t result = fs_dir_rewind((fs_dir_t*)(dir->data));
+  fs_stats_end(FS_STATS_DIR_FS(dir), FS_STATS_OP_DIR_REWIND, start, result != RET_OK, 0);
+
+  return result;
+}
+
+/*读到目录末尾也返回失败，不计入错误次数。*/
+static ret_t fs_stats_dir_read(fs_dir_t* dir, fs_item_t* item) {
+  uint64_t start = fs_stats_begin(FS_STATS_DIR_FS(dir), FS_STATS_OP_DIR_READ);
+  ret_t result = fs_dir_read((fs_dir_t*)(dir->data), item);
+  fs_stats_end(FS_STATS_DIR_FS(dir), FS_STATS_OP_DIR_READ, start, FALSE, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_dir_close(fs_dir_t* dir) {
+  fs_stats_fs_t* sfs = FS_STATS_DIR_FS(dir);
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_DIR_CLOSE);
+  ret_t result = fs_dir_close((fs_dir_t*)(dir->data));
+
+  TKMEM_FREE(dir);
+  FS_STATS_LOCK(sfs);
+  FS_STATS_SUB(&(sfs->open_nr), 1);
+  FS_STATS_UNLOCK(sfs);
+  fs_stats_end(sfs, FS_STATS_OP_DIR_CLOSE, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static const fs_file_vtable_t s_file_vtable = {.read = fs_stats_file_read,
+                                               .write = fs_stats_file_write,
+                                               .printf = fs_stats_file_printf,
+                                               .seek = fs_stats_file_seek,
+                                               .tell = fs_stats_file_tell,
+                                               .size = fs_stats_file_size,
+                                               .stat = fs_stats_file_stat,
+                                               .sync = fs_stats_file_sync,
+                                               .truncate = fs_stats_file_truncate,
+                                               .eof = fs_stats_file_eof,
+                                               .close = fs_stats_file_close};
+
+static const fs_file_ext_vtable_t s_file_ext_vtable = {.map = fs_stats_file_map,
+                                                       .borrow = fs_stats_file_borrow,
+                                                       .release = fs_stats_file_release,
+                                                       .readv = fs_stats_file_readv,
+                                                       .writev = fs_stats_file_writev,
+                                                       .pread = fs_stats_file_pread,
+                                                       .pwrite = fs_stats_file_pwrite,
+                                                       .allocate = fs_stats_file_allocate};
+
+static const fs_dir_vtable_t s_dir_vtable = {
+    .read = fs_stats_dir_read, .rewind = fs_stats_dir_rewind, .close = fs_stats_dir_close};
+
+static fs_file_t* fs_stats_open_file(fs_t* fs, const char* name, const char* mode) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OPEN);
+  fs_stats_file_t* sfile = NULL;
+  fs_file_t* impl = fs_open_file(sfs->impl, name, mode);
+
+  if (impl != NULL) {
+    sfile = TKMEM_ZALLOC(fs_stats_file_t);
+    if (sfile != NULL) {
+      sfile->fs_file.vt = &s_file_vtable;
+      sfile->fs_file.data = impl;
+      sfile->sfs = sfs;
+      FS_STATS_LOCK(sfs);
+  FS_STATS_ADD(&(sfs->open_nr), 1);
+  FS_STATS_UNLOCK(sfs);
+    } else {
+      fs_file_close(impl);
+    }
+  }
+  fs_stats_end(sfs, FS_STATS_OP_OPEN, start, sfile == NULL, 0);
+
+  return (fs_file_t*)sfile;
+}
+
+static ret_t fs_stats_remove_file(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_REMOVE_FILE);
+  ret_t result = fs_remove_file(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_REMOVE_FILE, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static bool_t fs_stats_file_exist(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_FILE_EXIST);
+  bool_t result = fs_file_exist(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_FILE_EXIST, start, FALSE, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_file_rename(fs_t* fs, const char* name, const char* new_name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_FILE_RENAME);
+  ret_t result = fs_file_rename(sfs->impl, name, new_name);
+  fs_stats_end(sfs, FS_STATS_OP_FILE_RENAME, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static fs_dir_t* fs_stats_open_dir(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OPEN_DIR);
+  fs_stats_dir_t* sdir = NULL;
+  fs_dir_t* impl = fs_open_dir(sfs->impl, name);
+
+  if (impl != NULL) {
+    sdir = TKMEM_ZALLOC(fs_stats_dir_t);
+    if (sdir != NULL) {
+      sdir->fs_dir.vt = &s_dir_vtable;
+      sdir->fs_dir.data = impl;
+      sdir->sfs = sfs;
+      FS_STATS_LOCK(sfs);
+  FS_STATS_ADD(&(sfs->open_nr), 1);
+  FS_STATS_UNLOCK(sfs);
+    } else {
+      fs_dir_close(impl);
+    }
+  }
+  fs_stats_end(sfs, FS_STATS_OP_OPEN_DIR, start, sdir == NULL, 0);
+
+  return (fs_dir_t*)sdir;
+}
+
+static ret_t fs_stats_remove_dir(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_REMOVE_DIR);
+  ret_t result = fs_remove_dir(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_REMOVE_DIR, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_create_dir(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_CREATE_DIR);
+  ret_t result = fs_create_dir(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_CREATE_DIR, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static bool_t fs_stats_dir_exist(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_DIR_EXIST);
+  bool_t result = fs_dir_exist(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_DIR_EXIST, start, FALSE, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_dir_rename(fs_t* fs, const char* name, const char* new_name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_DIR_RENAME);
+  ret_t result = fs_dir_rename(sfs->impl, name, new_name);
+  fs_stats_end(sfs, FS_STATS_OP_DIR_RENAME, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static int32_t fs_stats_get_file_size(fs_t* fs, const char* name) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_GET_FILE_SIZE);
+  int32_t result = fs_get_file_size(sfs->impl, name);
+  fs_stats_end(sfs, FS_STATS_OP_GET_FILE_SIZE, start, result < 0, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_get_disk_info(fs_t* fs, const char* volume, int32_t* free_kb,
+                                    int32_t* total_kb) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_GET_DISK_INFO);
+  ret_t result = fs_get_disk_info(sfs->impl, volume, free_kb, total_kb);
+  fs_stats_end(sfs, FS_STATS_OP_GET_DISK_INFO, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_get_exe(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OTHER);
+  ret_t result = fs_get_exe(sfs->impl, path);
+  fs_stats_end(sfs, FS_STATS_OP_OTHER, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_get_user_storage_path(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OTHER);
+  ret_t result = fs_get_user_storage_path(sfs->impl, path);
+  fs_stats_end(sfs, FS_STATS_OP_OTHER, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_get_temp_path(fs_t* fs, char path[MAX_PATH + 1]) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OTHER);
+  ret_t result = fs_get_temp_path(sfs->impl, path);
+  fs_stats_end(sfs, FS_STATS_OP_OTHER, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_get_cwd(fs_t* fs, char cwd[MAX_PATH + 1]) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_OTHER);
+  ret_t result = fs_get_cwd(sfs->impl, cwd);
+  fs_stats_end(sfs, FS_STATS_OP_OTHER, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static ret_t fs_stats_stat(fs_t* fs, const char* name, fs_stat_info_t* fst) {
+  fs_stats_fs_t* sfs = (fs_stats_fs_t*)fs;
+  uint64_t start = fs_stats_begin(sfs, FS_STATS_OP_STAT);
+  ret_t result = fs_stat(sfs->impl, name, fst);
+  fs_stats_end(sfs, FS_STATS_OP_STAT, start, result != RET_OK, 0);
+
+  return result;
+}
+
+static const fs_t s_fs_stats_vtable = {.open_file = fs_stats_open_file,
+                                       .remove_file = fs_stats_remove_file,
+                                       .file_exist = fs_stats_file_exist,
+                                       .file_rename = fs_stats_file_rename,
+
+                                       .open_dir = fs_stats_open_dir,
+                                       .remove_dir = fs_stats_remove_dir,
+                                       .create_dir = fs_stats_create_dir,
+                                       .dir_exist = fs_stats_dir_exist,
+                                       .dir_rename = fs_stats_dir_rename,
+
+                                       .get_file_size = fs_stats_get_file_size,
+                                       .get_disk_info = fs_stats_get_disk_info,
+                                       .get_cwd = fs_stats_get_cwd,
+                                       .get_exe = fs_stats_get_exe,
+                                       .get_user_storage_path = fs_stats_get_user_storage_path,
+                                       .get_temp_path = fs_stats_get_temp_path,
+                                       .stat = fs_stats_stat};
+
+static fs_stats_fs_t* fs_stats_cast(fs_t* fs) {
+  return_value_if_fail(fs != NULL && fs->open_file == fs_stats_open_file, NULL);
+
+  return (fs_stats_fs_t*)fs;
+}
+
+fs_t* fs_stats_wrap(fs_t* impl) {
+  fs_stats_fs_t* sfs = NULL;
+  return_value_if_fail(impl != NULL, NULL);
+
+  sfs = TKMEM_ZALLOC(fs_stats_fs_t);
+  return_value_if_fail(sfs != NULL, NULL);
+
+#ifdef FS_STATS_WITH_MUTEX
+  sfs->mutex = tk_mutex_create();
+  if (sfs->mutex == NULL) {
+    TKMEM_FREE(sfs);
+    return NULL;
+  }
+#endif /*FS_STATS_WITH_MUTEX*/
+
+  fs_file_ext_register(&s_file_vtable, &s_file_ext_vtable);
+  sfs->fs = s_fs_stats_vtable;
+  sfs->impl = impl;
+
+  return (fs_t*)sfs;
+}
+
+fs_t* fs_stats_unwrap(fs_t* fs) {
+  fs_t* impl = NULL;
+  uint32_t open_nr = 0;
+  fs_stats_fs_t* sfs = fs_stats_cast(fs);
+  return_value_if_fail(sfs != NULL, NULL);
+
+  FS_STATS_LOCK(sfs);
+  open_nr = FS_STATS_LOAD(&(sfs->open_nr));
+  FS_STATS_UNLOCK(sfs);
+  return_value_if_fail(open_nr == 0, NULL);
+
+  impl = sfs->impl;
+#ifdef FS_STATS_WITH_MUTEX
+  tk_mutex_destroy(sfs->mutex);
+#endif /*FS_STATS_WITH_MUTEX*/
+  TKMEM_FREE(sfs);
+
+  return impl;
+}
+
+ret_t fs_stats_set_sample_rate(fs_t* fs, uint32_t rate) {
+  fs_stats_fs_t* sfs = fs_stats_cast(fs);
+  return_value_if_fail(sfs != NULL, RET_BAD_PARAMS);
+  return_value_if_fail(rate > 0 && (rate & (rate - 1)) == 0, RET_BAD_PARAMS);
+
+  sfs->sample_mask = rate - 1;
+
+  return RET_OK;
+}
+
+ret_t fs_stats_snapshot(fs_t* fs, fs_stats_t* stats) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  fs_stats_fs_t* sfs = fs_stats_cast(fs);
+  return_value_if_fail(sfs != NULL && stats != NULL, RET_BAD_PARAMS);
+
+  FS_STATS_LOCK(sfs);
+  for (i = 0; i < FS_STATS_OP_NR; i++) {
+    fs_stats_op_info_t* src = FS_STATS_OP(sfs, i);
+    fs_stats_op_info_t* dst = stats->ops + i;
+
+    dst->calls = FS_STATS_LOAD(&(src->calls));
+    dst->errors = FS_STATS_LOAD(&(src->errors));
+    dst->bytes = FS_STATS_LOAD(&(src->bytes));
+    dst->latency.count = FS_STATS_LOAD(&(src->latency.count));
+    dst->latency.sum = FS_STATS_LOAD(&(src->latency.sum));
+    dst->latency.max = FS_STATS_LOAD(&(src->latency.max));
+    for (j = 0; j < FS_LATENCY_BUCKETS_NR; j++) {
+      dst->latency.buckets[j] = FS_STATS_LOAD(&(src->latency.buckets[j]));
+    }
+  }
+  FS_STATS_UNLOCK(sfs);
+
+  return RET_OK;
+}
+
+ret_t fs_stats_reset(fs_t* fs) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  fs_stats_fs_t* sfs = fs_stats_cast(fs);
+  return_value_if_fail(sfs != NULL, RET_BAD_PARAMS);
+
+  FS_STATS_LOCK(sfs);
+  for (i = 0; i < FS_STATS_OP_NR; i++) {
+    fs_stats_op_info_t* info = FS_STATS_OP(sfs, i);
+
+    FS_STATS_STORE(&(info->calls), 0);
+    FS_STATS_STORE(&(info->errors), 0);
+    FS_STATS_STORE(&(info->bytes), 0);
+    FS_STATS_STORE(&(info->latency.count), 0);
+    FS_STATS_STORE(&(info->latency.sum), 0);
+    FS_STATS_STORE(&(info->latency.max), 0);
+    for (j = 0; j < FS_LATENCY_BUCKETS_NR; j++) {
+      FS_STATS_STORE(&(info->latency.buckets[j]), 0);
+    }
+  }
+  FS_STATS_UNLOCK(sfs);
+
+  return RET_OK;
+}
+
+static const char* s_op_names[FS_STATS_OP_NR] = {
+    "open",          "read",       "write",       "seek",      "tell",       "size",
+    "fstat",         "sync",       "truncate",    "eof",       "close",      "map",
+    "borrow",        "readv",      "writev",      "pread",     "pwrite",     "allocate",
+    "remove_file",   "file_exist", "file_rename", "open_dir",  "dir_read",   "dir_rewind",
+    "dir_close",     "remove_dir", "create_dir",  "dir_exist", "dir_rename", "get_file_size",
+    "get_disk_info", "stat",       "other"};
+
+const char* fs_stats_op_name(fs_stats_op_t op) {
+  return_value_if_fail(op < FS_STATS_OP_NR, NULL);
+
+  return s_op_names[op];
+}
+
+static ret_t fs_stats_append_field(str_t* str, const char* name, uint64_t value) {
+  str_append_char(str, '"');
+  str_append(str, name);
+  str_append(str, "\":");
+
+  return str_append_uint64(str, value);
+}
+
+ret_t fs_stats_to_json(const fs_stats_t* stats, str_t* str) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  bool_t first = TRUE;
+  return_value_if_fail(stats != NULL && str != NULL, RET_BAD_PARAMS);
+
+  str_append_char(str, '{');
+  for (i = 0; i < FS_STATS_OP_NR; i++) {
+    uint32_t buckets_nr = FS_LATENCY_BUCKETS_NR;
+    const fs_stats_op_info_t* info = stats->ops + i;
+    const fs_latency_t* latency = &(info->latency);
+
+    if (info->calls == 0) {
+      continue;
+    }
+
+    while (buckets_nr > 0 && latency->buckets[buckets_nr - 1] == 0) {
+      buckets_nr--;
+    }
+
+    if (!first) {
+      str_append_char(str, ',');
+    }
+    first = FALSE;
+
+    str_append_char(str, '"');
+    str_append(str, s_op_names[i]);
+    str_append(str, "\":{");
+    fs_stats_append_field(str, "calls", info->calls);
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "samples", latency->count);
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "errors", info->errors);
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "bytes", info->bytes);
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "avg_us", fs_latency_avg(latency));
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "p50_us", fs_latency_percentile(latency, 500));
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "p99_us", fs_latency_percentile(latency, 990));
+    str_append_char(str, ',');
+    fs_stats_append_field(str, "max_us", latency->max);
+    str_append(str, ",\"buckets\":[");
+    for (j = 0; j < buckets_nr; j++) {
+      if (j > 0) {
+        str_append_char(str, ',');
+      }
+      str_append_uint64(str, latency->buckets[j]);
+    }
+    str_append(str, "]}");
+  }
+
+  return str_append_char(str, '}');
+}
@@ -0,0 +1,343 @@
+/**
+ * File:   fs_stats.h
+ * Author: AWTK Develop Team
+ * Brief:  per-operation counters and latency histograms of fs
+ *
+ * Copyright (c) 2026 - 2026 Guangzhou ZHIYUAN Electronics Co.,Ltd.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * License file for more details.
+ *
+ */
+
+/**
+ * History:
+ * ================================================================
+ * 2026-10-17 agent <agent@local> created
+ *
+ */
+
+#ifndef TK_FS_STATS_H
+#define TK_FS_STATS_H
+
+#include "tkc/fs.h"
+#include "tkc/str.h"
+#include "fs_latency.h"
+
+BEGIN_C_DECLS
+
+/**
+ * @enum fs_stats_op_t
+ * @prefix FS_STATS_OP_
+ * 统计的操作。
+ */
+typedef enum _fs_stats_op_t {
+  /**
+   * @const FS_STATS_OP_OPEN
+   * 打开文件。
+   */
+  FS_STATS_OP_OPEN = 0,
+  /**
+   * @const FS_STATS_OP_READ
+   * 读取数据。
+   */
+  FS_STATS_OP_READ,
+  /**
+   * @const FS_STATS_OP_WRITE
+   * 写入数据(包括printf)。
+   */
+  FS_STATS_OP_WRITE,
+  /**
+   * @const FS_STATS_OP_SEEK
+   * 定位读写指针。
+   */
+  FS_STATS_OP_SEEK,
+  /**
+   * @const FS_STATS_OP_TELL
+   * 获取读写指针。
+   */
+  FS_STATS_OP_TELL,
+  /**
+   * @const FS_STATS_OP_SIZE
+   * 获取打开文件的大小。
+   */
+  FS_STATS_OP_SIZE,
+  /**
+   * @const FS_STATS_OP_FSTAT
+   * 获取打开文件的信息。
+   */
+  FS_STATS_OP_FSTAT,
+  /**
+   * @const FS_STATS_OP_SYNC
+   * 同步文件。
+   */
+  FS_STATS_OP_SYNC,
+  /**
+   * @const FS_STATS_OP_TRUNCATE
+   * 截断文件。
+   */
+  FS_STATS_OP_TRUNCATE,
+  /**
+   * @const FS_STATS_OP_EOF
+   * 判断是否到文件末尾。
+   */
+  FS_STATS_OP_EOF,
+  /**
+   * @const FS_STATS_OP_CLOSE
+   * 关闭文件。
+   */
+  FS_STATS_OP_CLOSE,
+  /**
+   * @const FS_STATS_OP_MAP
+   * fs_file_map。
+   */
+  FS_STATS_OP_MAP,
+  /**
+   * @const FS_STATS_OP_BORROW
+   * fs_file_borrow。
+   */
+  FS_STATS_OP_BORROW,
+  /**
+   * @const FS_STATS_OP_READV
+   * fs_file_readv。
+   */
+  FS_STATS_OP_READV,
+  /**
+   * @const FS_STATS_OP_WRITEV
+   * fs_file_writev。
+   */
+  FS_STATS_OP_WRITEV,
+  /**
+   * @const FS_STATS_OP_PREAD
+   * fs_file_pread。
+   */
+  FS_STATS_OP_PREAD,
+  /**
+   * @const FS_STATS_OP_PWRITE
+   * fs_file_pwrite。
+   */
+  FS_STATS_OP_PWRITE,
+  /**
+   * @const FS_STATS_OP_ALLOCATE
+   * fs_file_allocate。
+   */
+  FS_STATS_OP_ALLOCATE,
+  /**
+   * @const FS_STATS_OP_REMOVE_FILE
+   * 删除文件。
+   */
+  FS_STATS_OP_REMOVE_FILE,
+  /**
+   * @const FS_STATS_OP_FILE_EXIST
+   * 判断文件是否存在。
+   */
+  FS_STATS_OP_FILE_EXIST,
+  /**
+   * @const FS_STATS_OP_FILE_RENAME
+   * 文件改名。
+   */
+  FS_STATS_OP_FILE_RENAME,
+  /**
+   * @const FS_STATS_OP_OPEN_DIR
+   * 打开目录。
+   */
+  FS_STATS_OP_OPEN_DIR,
+  /**
+   * @const FS_STATS_OP_DIR_READ
+   * 读取目录项。
+   */
+  FS_STATS_OP_DIR_READ,
+  /**
+   * @const FS_STATS_OP_DIR_REWIND
+   * 重置目录的读取位置。
+   */
+  FS_STATS_OP_DIR_REWIND,
+  /**
+   * @const FS_STATS_OP_DIR_CLOSE
+   * 关闭目录。
+   */
+  FS_STATS_OP_DIR_CLOSE,
+  /**
+   * @const FS_STATS_OP_REMOVE_DIR
+   * 删除目录。
+   */
+  FS_STATS_OP_REMOVE_DIR,
+  /**
+   * @const FS_STATS_OP_CREATE_DIR
+   * 创建目录。
+   */
+  FS_STATS_OP_CREATE_DIR,
+  /**
+   * @const FS_STATS_OP_DIR_EXIST
+   * 判断目录是否存在。
+   */
+  FS_STATS_OP_DIR_EXIST,
+  /**
+   * @const FS_STATS_OP_DIR_RENAME
+   * 目录改名。
+   */
+  FS_STATS_OP_DIR_RENAME,
+  /**
+   * @const FS_STATS_OP_GET_FILE_SIZE
+   * 获取文件大小。
+   */
+  FS_STATS_OP_GET_FILE_SIZE,
+  /**
+   * @const FS_STATS_OP_GET_DISK_INFO
+   * 获取磁盘空间。
+   */
+  FS_STATS_OP_GET_DISK_INFO,
+  /**
+   * @const FS_STATS_OP_STAT
+   * 获取文件信息。
+   */
+  FS_STATS_OP_STAT,
+  /**
+   * @const FS_STATS_OP_OTHER
+   * 其它操作(获取当前目录、可执行文件、用户目录和临时目录的路径)。
+   */
+  FS_STATS_OP_OTHER,
+  /**
+   * @const FS_STATS_OP_NR
+   * 操作的个数。
+   */
+  FS_STATS_OP_NR
+} fs_stats_op_t;
+
+/**
+ * @class fs_stats_op_info_t
+ * 一种操作的统计信息。
+ */
+typedef struct _fs_stats_op_info_t {
+  /**
+   * @property {uint64_t} calls
+   * @annotation ["readable"]
+   * 调用的次数。
+   */
+  uint64_t calls;
+  /**
+   * @property {uint64_t} errors
+   * @annotation ["readable"]
+   * 失败的次数。
+   */
+  uint64_t errors;
+  /**
+   * @property {uint64_t} bytes
+   * @annotation ["readable"]
+   * 读写的字节数。
+   */
+  uint64_t bytes;
+  /**
+   * @property {fs_latency_t} latency
+   * @annotation ["readable"]
+   * 延迟的直方图，latency.count为计时的次数(见fs_stats_set_sample_rate)。
+   */
+  fs_latency_t latency;
+} fs_stats_op_info_t;
+
+/**
+ * @class fs_stats_t
+ * fs_stats_wrap包装的fs的统计信息。
+ */
+typedef struct _fs_stats_t {
+  /**
+   * @property {fs_stats_op_info_t*} ops
+   * @annotation ["readable"]
+   * 各个操作的统计信息，用fs_stats_op_t作为下标。
+   */
+  fs_stats_op_info_t ops[FS_STATS_OP_NR];
+} fs_stats_t;
+
+/**
+ * @method fs_stats_wrap
+ * 包装fs，统计每种操作的调用次数、读写的字节数、失败次数和延迟。
+ *
+ * 计数器用原子操作更新，不加锁，可以在产品中一直开启。每次调用的额外开销主要是两次取时间，
+ * 取时间较慢的平台可以用fs_stats_set_sample_rate只对部分调用计时。
+ * > 编译器不支持无锁的64位原子操作时，计数器改用每个包装对象的互斥锁保护，计数仍然准确，但每次调用多两次加锁。
+ * @annotation ["global"]
+ * @param {fs_t*} impl 被包装的fs对象(可以是fs_mt_wrap返回的对象)。
+ *
+ * @return {fs_t*} 返回包装后的fs对象。
+ */
+fs_t* fs_stats_wrap(fs_t* impl);
+
+/**
+ * @method fs_stats_unwrap
+ * 销毁包装对象，返回被包装的fs对象。
+ * > 还有打开的文件或目录时返回NULL。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_stats_wrap返回的对象。
+ *
+ * @return {fs_t*} 返回被包装的fs对象。
+ */
+fs_t* fs_stats_unwrap(fs_t* fs);
+
+/**
+ * @method fs_stats_set_sample_rate
+ * 设置计时的频率：每种操作每rate次调用计时一次，缺省为1(每次都计时)。
+ * > 调用次数、字节数和失败次数总是完整统计。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_stats_wrap返回的对象。
+ * @param {uint32_t} rate 频率，必须是2的幂。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_stats_set_sample_rate(fs_t* fs, uint32_t rate);
+
+/**
+ * @method fs_stats_snapshot
+ * 获取统计信息的快照。
+ * > 每个计数器单独读取，其它线程同时调用时各个计数器之间不保证完全一致。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_stats_wrap返回的对象。
+ * @param {fs_stats_t*} stats 用于返回统计信息。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_stats_snapshot(fs_t* fs, fs_stats_t* stats);
+
+/**
+ * @method fs_stats_reset
+ * 清空统计信息。
+ * @annotation ["global"]
+ * @param {fs_t*} fs fs_stats_wrap返回的对象。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_stats_reset(fs_t* fs);
+
+/**
+ * @method fs_stats_op_name
+ * 获取操作的名称。
+ * @annotation ["global"]
+ * @param {fs_stats_op_t} op 操作。
+ *
+ * @return {const char*} 返回操作的名称(如"read")。
+ */
+const char* fs_stats_op_name(fs_stats_op_t op);
+
+/**
+ * @method fs_stats_to_json
+ * 把统计信息转换成JSON(追加到str中)，没有调用过的操作不输出。如：
+ *
+ * ```json
+ * {"read":{"calls":2,"samples":2,"errors":0,"bytes":8192,"avg_us":3,"p50_us":3,"p99_us":7,
+ *  "max_us":5,"buckets":[0,0,1,1]}}
+ * ```
+ *
+ * samples为计时的次数，延迟的统计只包括计时的调用。
+ * buckets[i](i>0)为延迟在[2^(i-1), 2^i)微秒之间的次数，buckets[0]为延迟不到1微秒的次数。
+ * @annotation ["global"]
+ * @param {const fs_stats_t*} stats 统计信息。
+ * @param {str_t*} str 用于返回JSON。
+ *
+ * @return {ret_t} 返回RET_OK表示成功，否则表示失败。
+ */
+ret_t fs_stats_to_json(const fs_stats_t* stats, str_t* str);
+
+END_C_DECLS
+
+#endif /*TK_FS_STATS_H*/
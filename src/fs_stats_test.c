@@ -0,0 +1,169 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/str.h"
+#include "tkc/utils.h"
+#include "tkc/thread.h"
+#include "tkc/platform.h"
+#include "fs_stats.h"
+#include "fs_file_ext.h"
+
+#define THREADS_NR 4
+#define WRITES_NR 1000
+
+extern fs_t* os_fs_posix(void);
+
+static void test_basic(fs_t* fs) {
+  uint32_t i = 0;
+  str_t str;
+  char buff[32];
+  fs_item_t item;
+  fs_stats_t stats;
+  fs_dir_t* dir = NULL;
+  fs_file_t* fp = NULL;
+
+  fp = fs_open_file(fs, "stats.txt", "wb+");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, "hello", 5) == 5);
+  assert(fs_file_printf(fp, "%d", 123) == 3);
+  assert(fs_file_pwrite(fp, "H", 1, 0) == 1);
+  assert(fs_file_seek(fp, 0) == RET_OK);
+  assert(fs_file_read(fp, buff, sizeof(buff)) == 8);
+  assert(memcmp(buff, "Hello123", 8) == 0);
+  assert(fs_stats_unwrap(fs) == NULL);
+  fs_file_close(fp);
+
+  assert(fs_open_file(fs, "not_exist/stats.txt", "rb") == NULL);
+  assert(fs_get_file_size(fs, "stats.txt") == 8);
+
+  dir = fs_open_dir(fs, ".");
+  assert(dir != NULL);
+  while (fs_dir_read(dir, &item) == RET_OK && item.name[0] != '\0') {
+  }
+  fs_dir_close(dir);
+  assert(fs_remove_file(fs, "stats.txt") == RET_OK);
+
+  assert(fs_stats_snapshot(fs, &stats) == RET_OK);
+  assert(stats.ops[FS_STATS_OP_OPEN].calls == 2);
+  assert(stats.ops[FS_STATS_OP_OPEN].errors == 1);
+  assert(stats.ops[FS_STATS_OP_WRITE].calls == 2);
+  assert(stats.ops[FS_STATS_OP_WRITE].bytes == 8);
+  assert(stats.ops[FS_STATS_OP_PWRITE].bytes == 1);
+  assert(stats.ops[FS_STATS_OP_READ].calls == 1);
+  assert(stats.ops[FS_STATS_OP_READ].bytes == 8);
+  assert(stats.ops[FS_STATS_OP_SEEK].calls == 1);
+  assert(stats.ops[FS_STATS_OP_CLOSE].calls == 1);
+  assert(stats.ops[FS_STATS_OP_GET_FILE_SIZE].calls == 1);
+  assert(stats.ops[FS_STATS_OP_OPEN_DIR].calls == 1);
+  assert(stats.ops[FS_STATS_OP_DIR_READ].calls > 0);
+  assert(stats.ops[FS_STATS_OP_DIR_READ].errors == 0);
+  assert(stats.ops[FS_STATS_OP_DIR_CLOSE].calls == 1);
+  assert(stats.ops[FS_STATS_OP_REMOVE_FILE].calls == 1);
+  assert(stats.ops[FS_STATS_OP_STAT].calls == 0);
+
+  str_init(&str, 0);
+  assert(fs_stats_to_json(&stats, &str) == RET_OK);
+  assert(strstr(str.str, "\"open\":{\"calls\":2,\"samples\":2,\"errors\":1,\"bytes\":0,") != NULL);
+  assert(strstr(str.str, "\"write\":{\"calls\":2,\"samples\":2,\"errors\":0,\"bytes\":8,") != NULL);
+  assert(strstr(str.str, "\"stat\"") == NULL);
+  assert(str.str[0] == '{' && str.str[str.size - 1] == '}');
+  str_reset(&str);
+
+  assert(fs_stats_reset(fs) == RET_OK);
+  assert(fs_stats_snapshot(fs, &stats) == RET_OK);
+  assert(stats.ops[FS_STATS_OP_OPEN].calls == 0);
+  assert(stats.ops[FS_STATS_OP_WRITE].bytes == 0);
+
+  str_init(&str, 0);
+  assert(fs_stats_to_json(&stats, &str) == RET_OK);
+  assert(strcmp(str.str, "{}") == 0);
+  str_reset(&str);
+
+  /*每4次调用计时一次。*/
+  assert(fs_stats_set_sample_rate(fs, 3) == RET_BAD_PARAMS);
+  assert(fs_stats_set_sample_rate(fs, 4) == RET_OK);
+  assert(fs_stats_reset(fs) == RET_OK);
+  assert(fs_file_exist(fs, "stats.txt") == FALSE);
+  for (i = 0; i < 7; i++) {
+    assert(fs_dir_exist(fs, ".") == TRUE);
+  }
+  assert(fs_stats_snapshot(fs, &stats) == RET_OK);
+  assert(stats.ops[FS_STATS_OP_DIR_EXIST].calls == 7);
+  assert(stats.ops[FS_STATS_OP_DIR_EXIST].latency.count == 2);
+  assert(stats.ops[FS_STATS_OP_FILE_EXIST].latency.count == 1);
+  assert(fs_stats_set_sample_rate(fs, 1) == RET_OK);
+
+  assert(strcmp(fs_stats_op_name(FS_STATS_OP_PREAD), "pread") == 0);
+  assert(strcmp(fs_stats_op_name(FS_STATS_OP_OTHER), "other") == 0);
+}
+
+typedef struct _thread_ctx_t {
+  fs_t* fs;
+  uint32_t id;
+} thread_ctx_t;
+
+static void* write_thread(void* args) {
+  uint32_t i = 0;
+  char filename[MAX_PATH + 1];
+  thread_ctx_t* ctx = (thread_ctx_t*)args;
+  fs_file_t* fp = NULL;
+
+  tk_snprintf(filename, MAX_PATH, "stats%u.bin", ctx->id);
+  fp = fs_open_file(ctx->fs, filename, "wb");
+  assert(fp != NULL);
+  for (i = 0; i < WRITES_NR; i++) {
+    assert(fs_file_write(fp, "ab", 2) == 2);
+  }
+  fs_file_close(fp);
+  assert(fs_remove_file(ctx->fs, filename) == RET_OK);
+
+  return NULL;
+}
+
+/*多个线程同时调用，计数不丢失。*/
+static void test_threads(fs_t* fs) {
+  uint32_t i = 0;
+  fs_stats_t stats;
+  thread_ctx_t ctx[THREADS_NR];
+  tk_thread_t* threads[THREADS_NR];
+
+  assert(fs_stats_reset(fs) == RET_OK);
+  for (i = 0; i < THREADS_NR; i++) {
+    ctx[i].fs = fs;
+    ctx[i].id = i;
+    threads[i] = tk_thread_create(write_thread, ctx + i);
+    tk_thread_start(threads[i]);
+  }
+
+  for (i = 0; i < THREADS_NR; i++) {
+    tk_thread_join(threads[i]);
+    tk_thread_destroy(threads[i]);
+  }
+
+  assert(fs_stats_snapshot(fs, &stats) == RET_OK);
+  assert(stats.ops[FS_STATS_OP_WRITE].calls == THREADS_NR * WRITES_NR);
+  assert(stats.ops[FS_STATS_OP_WRITE].bytes == THREADS_NR * WRITES_NR * 2);
+  assert(stats.ops[FS_STATS_OP_WRITE].latency.count == THREADS_NR * WRITES_NR);
+  assert(stats.ops[FS_STATS_OP_OPEN].calls == THREADS_NR);
+  assert(stats.ops[FS_STATS_OP_CLOSE].calls == THREADS_NR);
+}
+
+int main(int argc, char* argv[]) {
+  fs_t* fs = NULL;
+  fs_t* impl = os_fs_posix();
+  platform_prepare();
+
+  fs = fs_stats_wrap(impl);
+  assert(fs != NULL);
+
+  test_basic(fs);
+#ifdef WITH_FS_MT
+  test_threads(fs);
+#endif /*WITH_FS_MT*/
+
+  assert(fs_stats_unwrap(fs) == impl);
+
+  return 0;
+}
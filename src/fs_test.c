@@ -3,6 +3,7 @@
 #include "tkc/utils.h"
 #include "tkc/thread.h"
 #include "tkc/platform.h"
+#include "fs_file_ext.h"
 #define NR 50
 #define TEST_DATA "hello"
 
@@ -79,3 +80,299 @@ void test_fs_wait(void) {
     log_debug("%u stop\n", i);
   }
 }
+
+#define BORROW_FILE_SIZE 3000
+#define BORROW_BYTE(i) ((uint8_t)((i)*7 % 251))
+
+/*以mode打开文件，用不同长度借用整个文件并与写入的内容比较，返回直接借到(没有拷贝到scratch)的次数。*/
+uint32_t test_fs_borrow(fs_t* fs, const char* filename, const char* mode) {
+  uint32_t i = 0;
+  uint32_t pos = 0;
+  uint32_t lent = 0;
+  uint8_t buff[BORROW_FILE_SIZE];
+  uint8_t scratch[BORROW_FILE_SIZE];
+  static const uint32_t sizes[] = {1, 7, 100, 513, 2000};
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+  assert(fp != NULL);
+
+  for (i = 0; i < BORROW_FILE_SIZE; i++) {
+    buff[i] = BORROW_BYTE(i);
+  }
+  assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+  assert(fs_file_close(fp) == RET_OK);
+
+  fp = fs_open_file(fs, filename, mode);
+  assert(fp != NULL);
+  for (i = 0; pos < BORROW_FILE_SIZE; i++) {
+    const void* data = NULL;
+    int32_t ret = fs_file_borrow(fp, sizes[i % ARRAY_SIZE(sizes)], scratch, &data);
+    assert(ret > 0 && data != NULL);
+    assert(memcmp(data, buff + pos, ret) == 0);
+    if (data != scratch) {
+      lent++;
+    }
+    assert(fs_file_release(fp, data) == RET_OK);
+    pos += ret;
+    assert(fs_file_tell(fp) == pos);
+  }
+
+  /*到达文件末尾后返回0。*/
+  {
+    const void* data = NULL;
+    assert(fs_file_borrow(fp, 10, scratch, &data) == 0);
+    assert(fs_file_release(fp, data) == RET_OK);
+  }
+
+  /*借用与普通的读和seek交替。*/
+  {
+    uint8_t c = 0;
+    const void* data = NULL;
+    assert(fs_file_seek(fp, 1001) == RET_OK);
+    assert(fs_file_read(fp, &c, 1) == 1 && c == BORROW_BYTE(1001));
+    assert(fs_file_borrow(fp, 3, scratch, &data) == 3);
+    assert(memcmp(data, buff + 1002, 3) == 0);
+    assert(fs_file_release(fp, data) == RET_OK);
+    assert(fs_file_read(fp, &c, 1) == 1 && c == BORROW_BYTE(1005));
+  }
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+
+  return lent;
+}
+
+/*writev/readv与逐块读写的结果一致。*/
+void test_fs_iovec(fs_t* fs, const char* filename) {
+  char buff[32];
+  char head[4] = {'H', 'E', 'A', 'D'};
+  char body[10] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  char crc[2] = {'C', 'C'};
+  char rhead[4], rbody[10], rcrc[8];
+  fs_iovec_t wiov[3] = {{head, sizeof(head)}, {body, sizeof(body)}, {crc, sizeof(crc)}};
+  fs_iovec_t riov[3] = {{rhead, sizeof(rhead)}, {rbody, sizeof(rbody)}, {rcrc, sizeof(rcrc)}};
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+  assert(fp != NULL);
+
+  assert(fs_file_writev(fp, wiov, 3) == 16);
+  assert(fs_file_writev(fp, wiov, 3) == 16);
+  assert(fs_file_writev(fp, wiov, 0) == 0);
+  assert(fs_file_tell(fp) == 32);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_get_file_size(fs, filename) == 32);
+
+  fp = fs_open_file(fs, filename, "rb");
+  assert(fp != NULL);
+  assert(fs_file_read(fp, buff, 16) == 16);
+  assert(memcmp(buff, "HEAD0123456789CC", 16) == 0);
+
+  /*最后一块只读到部分数据。*/
+  assert(fs_file_readv(fp, riov, 3) == 16);
+  assert(memcmp(rhead, head, sizeof(head)) == 0);
+  assert(memcmp(rbody, body, sizeof(body)) == 0);
+  assert(memcmp(rcrc, crc, sizeof(crc)) == 0);
+  assert(fs_file_readv(fp, riov, 3) == 0);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+/*pread/pwrite不改变文件的当前位置。*/
+void test_fs_pread(fs_t* fs, const char* filename) {
+  char buff[16];
+  fs_file_t* fp = fs_open_file(fs, filename, "wb+");
+  assert(fp != NULL);
+
+  assert(fs_file_write(fp, "0123456789", 10) == 10);
+  assert(fs_file_seek(fp, 2) == RET_OK);
+  assert(fs_file_pwrite(fp, "ab", 2, 5) == 2);
+  assert(fs_file_tell(fp) == 2);
+  assert(fs_file_pread(fp, buff, 4, 4) == 4);
+  assert(memcmp(buff, "4ab7", 4) == 0);
+  assert(fs_file_tell(fp) == 2);
+  assert(fs_file_pread(fp, buff, sizeof(buff), 8) == 2);
+  assert(memcmp(buff, "89", 2) == 0);
+  assert(fs_file_pread(fp, buff, sizeof(buff), 100) == 0);
+  assert(fs_file_tell(fp) == 2);
+
+  /*在文件末尾追加。*/
+  assert(fs_file_pwrite(fp, "XY", 2, 10) == 2);
+  assert(fs_file_tell(fp) == 2);
+  assert(fs_file_read(fp, buff, sizeof(buff)) == 10);
+  assert(memcmp(buff, "234ab789XY", 10) == 0);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+/*在文件末尾之后pwrite，中间的空洞读出为0(先写入非0的数据再截断，让空洞落在有旧数据的位置)。*/
+void test_fs_pwrite_gap(fs_t* fs, const char* filename) {
+  uint32_t i = 0;
+  uint8_t buff[1200];
+  fs_file_t* fp = fs_open_file(fs, filename, "wb+");
+  assert(fp != NULL);
+
+  memset(buff, 0xa5, sizeof(buff));
+  memcpy(buff, "0123", 4);
+  assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+  assert(fs_file_truncate(fp, 4) == RET_OK);
+  assert(fs_file_seek(fp, 4) == RET_OK);
+
+  assert(fs_file_pwrite(fp, "XY", 2, 1100) == 2);
+  assert(fs_file_tell(fp) == 4);
+  assert(fs_file_size(fp) == 1102);
+  assert(fs_file_pread(fp, buff, sizeof(buff), 0) == 1102);
+  assert(memcmp(buff, "0123", 4) == 0);
+  for (i = 4; i < 1100; i++) {
+    assert(buff[i] == 0);
+  }
+  assert(memcmp(buff + 1100, "XY", 2) == 0);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+/*
+ * 预先分配的部分读出为0(先写入数据再截短，让新分配的部分落在旧数据上)。
+ * 预先分配后顺序写入，写完的大小和内容正确。size不大于文件大小时什么也不做。
+ */
+void test_fs_allocate(fs_t* fs, const char* filename, uint32_t size) {
+  uint32_t i = 0;
+  uint32_t end = 0;
+  uint8_t buff[256];
+  fs_file_t* fp = fs_open_file(fs, filename, "wb+");
+  assert(fp != NULL);
+
+  memset(buff, 0xa5, sizeof(buff));
+  for (i = 0; i < size; i += sizeof(buff)) {
+    assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+  }
+  assert(fs_file_truncate(fp, 4) == RET_OK);
+  assert(fs_file_seek(fp, 2) == RET_OK);
+  assert(fs_file_allocate(fp, size) == RET_OK);
+  assert(fs_file_tell(fp) == 2);
+  /*spiffs预先分配时不改变文件大小。*/
+  end = (uint32_t)fs_file_size(fp);
+  assert(end == size || end == 4);
+  assert(fs_file_seek(fp, 4) == RET_OK);
+  for (i = 4; i < end; i += sizeof(buff)) {
+    uint32_t n = tk_min(sizeof(buff), end - i);
+    assert(fs_file_read(fp, buff, n) == n);
+    assert(buff[0] == 0 && buff[n - 1] == 0);
+  }
+  assert(fs_file_truncate(fp, 0) == RET_OK);
+  assert(fs_file_seek(fp, 0) == RET_OK);
+
+  assert(fs_file_allocate(fp, size) == RET_OK);
+  assert(fs_file_tell(fp) == 0);
+  for (i = 0; i < size; i += sizeof(buff)) {
+    memset(buff, (uint8_t)(i / sizeof(buff)), sizeof(buff));
+    assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+  }
+  assert(fs_file_size(fp) == size);
+  assert(fs_file_allocate(fp, size / 2) == RET_OK);
+  assert(fs_file_size(fp) == size);
+
+  assert(fs_file_seek(fp, 0) == RET_OK);
+  for (i = 0; i < size; i += sizeof(buff)) {
+    assert(fs_file_read(fp, buff, sizeof(buff)) == sizeof(buff));
+    assert(buff[0] == (uint8_t)(i / sizeof(buff)) && buff[sizeof(buff) - 1] == buff[0]);
+  }
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+/*截断到任意大小：变小时保留前面的内容，变大时补0，读写位置不变。*/
+void test_fs_truncate(fs_t* fs, const char* filename, uint32_t size) {
+  uint32_t i = 0;
+  uint8_t buff[256];
+  uint32_t half = size / 2 + 3;
+  fs_file_t* fp = fs_open_file(fs, filename, "wb+");
+  assert(fp != NULL);
+
+  for (i = 0; i < size; i++) {
+    buff[i % sizeof(buff)] = (uint8_t)(i % 251);
+    if ((i + 1) % sizeof(buff) == 0 || i + 1 == size) {
+      uint32_t n = i % sizeof(buff) + 1;
+      assert(fs_file_write(fp, buff, n) == n);
+    }
+  }
+  assert(fs_file_size(fp) == size);
+
+  assert(fs_file_seek(fp, 5) == RET_OK);
+  assert(fs_file_truncate(fp, half) == RET_OK);
+  assert(fs_file_size(fp) == half);
+  assert(fs_file_tell(fp) == 5);
+  assert(fs_file_truncate(fp, size + 100) == RET_OK);
+  assert(fs_file_size(fp) == size + 100);
+  assert(fs_file_tell(fp) == 5);
+
+  assert(fs_file_seek(fp, 0) == RET_OK);
+  for (i = 0; i < size + 100; i++) {
+    if (i % sizeof(buff) == 0) {
+      uint32_t n = tk_min(sizeof(buff), size + 100 - i);
+      assert(fs_file_read(fp, buff, n) == n);
+    }
+    assert(buff[i % sizeof(buff)] == (i < half ? (uint8_t)(i % 251) : 0));
+  }
+
+  assert(fs_file_truncate(fp, 0) == RET_OK);
+  assert(fs_file_size(fp) == 0);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
+
+#define PREAD_FILE_SIZE (16 * 1024)
+#define PREAD_THREADS_NR 4
+#define PREAD_TIMES 500
+
+static fs_file_t* s_pread_file = NULL;
+
+static void* pread_thread(void* args) {
+  uint32_t i = 0;
+  uint32_t seed = (uint32_t)tk_pointer_to_int(args) * 7919 + 1;
+
+  for (i = 0; i < PREAD_TIMES; i++) {
+    uint32_t j = 0;
+    uint8_t buff[64];
+    uint32_t offset = 0;
+
+    seed = seed * 1103515245 + 12345;
+    offset = (seed >> 8) % (PREAD_FILE_SIZE - sizeof(buff));
+    assert(fs_file_pread(s_pread_file, buff, sizeof(buff), offset) == sizeof(buff));
+    for (j = 0; j < sizeof(buff); j++) {
+      assert(buff[j] == (uint8_t)((offset + j) % 251));
+    }
+  }
+
+  return NULL;
+}
+
+/*多个线程共享同一个文件对象随机读取。*/
+void test_fs_pread_threads(fs_t* fs, const char* filename) {
+  uint32_t i = 0;
+  uint8_t buff[256];
+  tk_thread_t* readers[PREAD_THREADS_NR];
+  fs_file_t* fp = fs_open_file(fs, filename, "wb");
+  assert(fp != NULL);
+
+  for (i = 0; i < PREAD_FILE_SIZE; i++) {
+    buff[i % sizeof(buff)] = (uint8_t)(i % 251);
+    if ((i + 1) % sizeof(buff) == 0) {
+      assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+    }
+  }
+  assert(fs_file_close(fp) == RET_OK);
+
+  s_pread_file = fs_open_file(fs, filename, "rb");
+  assert(s_pread_file != NULL);
+  for (i = 0; i < ARRAY_SIZE(readers); i++) {
+    readers[i] = tk_thread_create(pread_thread, tk_pointer_from_int(i));
+    tk_thread_set_stack_size(readers[i], 0xc000);
+    tk_thread_start(readers[i]);
+  }
+
+  for (i = 0; i < ARRAY_SIZE(readers); i++) {
+    tk_thread_join(readers[i]);
+    tk_thread_destroy(readers[i]);
+  }
+  assert(fs_file_tell(s_pread_file) == 0);
+  assert(fs_file_close(s_pread_file) == RET_OK);
+  s_pread_file = NULL;
+  assert(fs_remove_file(fs, filename) == RET_OK);
+}
@@ -0,0 +1,233 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "fs_file_ext.h"
+#include "fs_os_posix.h"
+
+#define RECORDS_NR 20000
+#define RECORD_SIZE 32
+#define ASSET_SIZE (1024 * 1024)
+#define ASSET_LOADS_NR 200
+
+typedef struct _io_count_t {
+  uint64_t syscr;
+  uint64_t syscw;
+} io_count_t;
+
+/*Linux下从/proc/self/io读取进程的read/write系统调用次数，其它平台返回0。*/
+static void io_count_get(io_count_t* count) {
+  char line[128];
+  FILE* fp = fopen("/proc/self/io", "r");
+
+  memset(count, 0x00, sizeof(*count));
+  if (fp == NULL) {
+    return;
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    unsigned long long v = 0;
+    if (sscanf(line, "syscr: %llu", &v) == 1) {
+      count->syscr = v;
+    } else if (sscanf(line, "syscw: %llu", &v) == 1) {
+      count->syscw = v;
+    }
+  }
+  fclose(fp);
+}
+
+static void bench_write(fs_t* fs, const char* mode) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+  io_count_t c1, c2;
+  char record[RECORD_SIZE];
+  fs_file_t* fp = fs_open_file(fs, "posix_bench.dat", mode);
+  assert(fp != NULL);
+
+  memset(record, 'r', sizeof(record));
+  io_count_get(&c1);
+  start = time_now_us();
+  for (i = 0; i < RECORDS_NR; i++) {
+    assert(fs_file_write(fp, record, sizeof(record)) == sizeof(record));
+  }
+  assert(fs_file_sync(fp) == RET_OK);
+  cost = time_now_us() - start;
+  io_count_get(&c2);
+  fs_file_close(fp);
+
+  log_debug("write\t%s\t%u\t%llu\t%llu\n", mode, RECORDS_NR,
+            (unsigned long long)(c2.syscw - c1.syscw), (unsigned long long)cost);
+}
+
+static void bench_read(fs_t* fs, const char* mode) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+  io_count_t c1, c2;
+  char record[RECORD_SIZE];
+  fs_file_t* fp = fs_open_file(fs, "posix_bench.dat", mode);
+  assert(fp != NULL);
+
+  io_count_get(&c1);
+  start = time_now_us();
+  for (i = 0; i < RECORDS_NR; i++) {
+    assert(fs_file_read(fp, record, sizeof(record)) == sizeof(record));
+  }
+  cost = time_now_us() - start;
+  io_count_get(&c2);
+  fs_file_close(fp);
+
+  log_debug("read\t%s\t%u\t%llu\t%llu\n", mode, RECORDS_NR,
+            (unsigned long long)(c2.syscr - c1.syscr), (unsigned long long)cost);
+}
+
+static ret_t write_file(fs_t* fs, const char* name, const void* data, uint32_t size) {
+  fs_file_t* file = fs_open_file(fs, name, "wb");
+  return_value_if_fail(file != NULL, RET_FAIL);
+
+  if (fs_file_write(file, data, size) != (int32_t)size) {
+    fs_file_close(file);
+    return RET_FAIL;
+  }
+
+  return fs_file_close(file);
+}
+
+static void bench_borrow(fs_t* fs, const char* mode) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+  uint32_t sum = 0;
+  io_count_t c1, c2;
+  char scratch[RECORD_SIZE];
+  fs_file_t* fp = fs_open_file(fs, "posix_bench.dat", mode);
+  assert(fp != NULL);
+
+  io_count_get(&c1);
+  start = time_now_us();
+  for (i = 0; i < RECORDS_NR; i++) {
+    const void* data = NULL;
+    assert(fs_file_borrow(fp, sizeof(scratch), scratch, &data) == sizeof(scratch));
+    sum += ((const uint8_t*)data)[0];
+    fs_file_release(fp, data);
+  }
+  cost = time_now_us() - start;
+  io_count_get(&c2);
+  fs_file_close(fp);
+
+  log_debug("borrow\t%s\t%u\t%llu\t%llu\t(%u)\n", mode, RECORDS_NR,
+            (unsigned long long)(c2.syscr - c1.syscr), (unsigned long long)cost, sum);
+}
+
+/*追加由头部、内容和校验组成的小记录，对比逐块写和writev。*/
+static void bench_append(fs_t* fs, const char* mode, bool_t vectored) {
+  uint32_t i = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+  io_count_t c1, c2;
+  char head[8];
+  char body[RECORD_SIZE];
+  char crc[4];
+  fs_iovec_t iov[3] = {{head, sizeof(head)}, {body, sizeof(body)}, {crc, sizeof(crc)}};
+  fs_file_t* fp = fs_open_file(fs, "posix_bench.log", mode);
+  assert(fp != NULL);
+
+  memset(head, 'h', sizeof(head));
+  memset(body, 'b', sizeof(body));
+  memset(crc, 'c', sizeof(crc));
+  io_count_get(&c1);
+  start = time_now_us();
+  for (i = 0; i < RECORDS_NR; i++) {
+    if (vectored) {
+      assert(fs_file_writev(fp, iov, ARRAY_SIZE(iov)) == sizeof(head) + sizeof(body) + sizeof(crc));
+    } else {
+      assert(fs_file_write(fp, head, sizeof(head)) == sizeof(head));
+      assert(fs_file_write(fp, body, sizeof(body)) == sizeof(body));
+      assert(fs_file_write(fp, crc, sizeof(crc)) == sizeof(crc));
+    }
+  }
+  assert(fs_file_sync(fp) == RET_OK);
+  cost = time_now_us() - start;
+  io_count_get(&c2);
+  fs_file_close(fp);
+  fs_remove_file(fs, "posix_bench.log");
+
+  log_debug("append\t%s%s\t%u\t%llu\t%llu\n", mode, vectored ? "+v" : "", RECORDS_NR,
+            (unsigned long long)(c2.syscw - c1.syscw), (unsigned long long)cost);
+}
+
+/*模拟加载资源：每次打开文件并读取全部内容，统计校验和防止被优化掉。*/
+static void bench_load_asset(fs_t* fs, const char* name, bool_t use_map) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t sum = 0;
+  uint64_t start = 0;
+  uint64_t cost = 0;
+  io_count_t c1, c2;
+  uint8_t* buff = TKMEM_ALLOC(ASSET_SIZE);
+  assert(buff != NULL);
+
+  io_count_get(&c1);
+  start = time_now_us();
+  for (i = 0; i < ASSET_LOADS_NR; i++) {
+    const void* data = NULL;
+    uint32_t size = 0;
+    fs_file_t* fp = fs_open_file(fs, name, use_map ? "rbM" : "rb");
+    assert(fp != NULL);
+
+    if (fs_file_map(fp, &data, &size) != RET_OK) {
+      assert(fs_file_read(fp, buff, ASSET_SIZE) == ASSET_SIZE);
+      data = buff;
+      size = ASSET_SIZE;
+    }
+    for (j = 0; j < size; j += 4096) {
+      sum += ((const uint8_t*)data)[j];
+    }
+    fs_file_close(fp);
+  }
+  cost = time_now_us() - start;
+  io_count_get(&c2);
+  TKMEM_FREE(buff);
+
+  log_debug("load\t%s\t%u\t%llu\t%llu\t(%u)\n", use_map ? "mmap" : "read", ASSET_LOADS_NR,
+            (unsigned long long)(c2.syscr - c1.syscr), (unsigned long long)cost, sum);
+}
+
+int main(int argc, char* argv[]) {
+  fs_t* fs = os_fs_posix();
+  platform_prepare();
+
+  log_debug("op\tmode\trecords\tsyscalls\tus\n");
+  bench_write(fs, "wb");
+  bench_write(fs, "wbB");
+  bench_read(fs, "rb");
+  bench_read(fs, "rbB");
+  bench_borrow(fs, "rbB");
+  bench_borrow(fs, "rbM");
+
+  fs_remove_file(fs, "posix_bench.dat");
+
+  bench_append(fs, "ab", FALSE);
+  bench_append(fs, "ab", TRUE);
+  bench_append(fs, "abB", FALSE);
+  bench_append(fs, "abB", TRUE);
+
+  {
+    uint8_t* asset = TKMEM_ALLOC(ASSET_SIZE);
+    assert(asset != NULL);
+    memset(asset, 'a', ASSET_SIZE);
+    assert(write_file(fs, "posix_bench.asset", asset, ASSET_SIZE) == RET_OK);
+    TKMEM_FREE(asset);
+  }
+  bench_load_asset(fs, "posix_bench.asset", FALSE);
+  bench_load_asset(fs, "posix_bench.asset", TRUE);
+  fs_remove_file(fs, "posix_bench.asset");
+
+  return 0;
+}
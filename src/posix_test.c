@@ -6,8 +6,246 @@
 #include "tkc/utils.h"
 #include "tkc/thread.h"
 #include "tkc/platform.h"
+#include "fs_mt.h"
+#include "fs_file_ext.h"
+#include "fs_os_posix.h"
 
-extern fs_t* os_fs_posix(void);
+static void test_buffered(fs_t* fs) {
+  int32_t i = 0;
+  char buff[64];
+  fs_file_t* file = NULL;
+
+  assert(os_fs_posix_set_buffer_size(16, 16) == RET_OK);
+  file = fs_open_file(fs, "buffered.txt", "wb+B");
+  assert(file != NULL);
+
+  for (i = 0; i < 10; i++) {
+    assert(fs_file_write(file, "0123456789", 10) == 10);
+    assert(fs_file_tell(file) == (i + 1) * 10);
+  }
+  assert(fs_file_size(file) == 100);
+  assert(fs_file_printf(file, "%s", "tail") == 4);
+  assert(fs_file_tell(file) == 104);
+
+  /*读写交替，位置保持一致。*/
+  assert(fs_file_seek(file, 5) == RET_OK);
+  assert(fs_file_read(file, buff, 3) == 3);
+  assert(memcmp(buff, "567", 3) == 0);
+  assert(fs_file_tell(file) == 8);
+  assert(fs_file_write(file, "ab", 2) == 2);
+  assert(fs_file_tell(file) == 10);
+  assert(fs_file_read(file, buff, 4) == 4);
+  assert(memcmp(buff, "0123", 4) == 0);
+  assert(fs_file_seek(file, 2) == RET_OK);
+  assert(fs_file_read(file, buff, 10) == 10);
+  assert(memcmp(buff, "234567ab01", 10) == 0);
+
+  assert(fs_file_seek(file, 100) == RET_OK);
+  memset(buff, 0x00, sizeof(buff));
+  assert(fs_file_read(file, buff, sizeof(buff)) == 4);
+  assert(strcmp(buff, "tail") == 0);
+  assert(fs_file_sync(file) == RET_OK);
+  assert(fs_file_close(file) == RET_OK);
+  assert(fs_get_file_size(fs, "buffered.txt") == 104);
+
+  file = fs_open_file(fs, "buffered.txt", "aB");
+  assert(file != NULL);
+  assert(fs_file_write(file, "!", 1) == 1);
+  assert(fs_file_close(file) == RET_OK);
+  assert(fs_get_file_size(fs, "buffered.txt") == 105);
+
+  assert(fs_remove_file(fs, "buffered.txt") == RET_OK);
+  assert(os_fs_posix_set_buffer_size(FS_OS_POSIX_READ_AHEAD_SIZE,
+                                     FS_OS_POSIX_WRITE_BEHIND_SIZE) == RET_OK);
+}
+
+static ret_t write_file(fs_t* fs, const char* name, const void* data, uint32_t size) {
+  fs_file_t* file = fs_open_file(fs, name, "wb");
+  return_value_if_fail(file != NULL, RET_FAIL);
+
+  if (fs_file_write(file, data, size) != (int32_t)size) {
+    fs_file_close(file);
+    return RET_FAIL;
+  }
+
+  return fs_file_close(file);
+}
+
+static void test_map(fs_t* fs) {
+  char buff[64];
+  uint32_t size = 0;
+  const void* data = NULL;
+  fs_file_t* file = NULL;
+
+  assert(write_file(fs, "map.txt", "0123456789abcdef", 16) == RET_OK);
+
+  /*小于阈值的文件不映射。*/
+  assert(os_fs_posix_set_mmap_threshold(32) == RET_OK);
+  file = fs_open_file(fs, "map.txt", "rbM");
+  assert(file != NULL);
+  assert(fs_file_map(file, &data, &size) == RET_NOT_IMPL);
+  assert(fs_file_close(file) == RET_OK);
+
+  /*没有"M"标志时不映射。*/
+  assert(os_fs_posix_set_mmap_threshold(16) == RET_OK);
+  file = fs_open_file(fs, "map.txt", "rb");
+  assert(file != NULL);
+  assert(fs_file_map(file, &data, &size) == RET_NOT_IMPL);
+  assert(fs_file_close(file) == RET_OK);
+
+  file = fs_open_file(fs, "map.txt", "rbM");
+  assert(file != NULL);
+  assert(fs_file_map(file, &data, &size) == RET_OK);
+  assert(size == 16 && memcmp(data, "0123456789abcdef", 16) == 0);
+
+  assert(fs_file_size(file) == 16);
+  assert(fs_file_read(file, buff, 4) == 4);
+  assert(memcmp(buff, "0123", 4) == 0);
+  assert(fs_file_tell(file) == 4);
+  assert(fs_file_seek(file, 10) == RET_OK);
+  assert(fs_file_read(file, buff, sizeof(buff)) == 6);
+  assert(memcmp(buff, "abcdef", 6) == 0);
+  assert(fs_file_eof(file));
+  assert(fs_file_read(file, buff, sizeof(buff)) == 0);
+  assert(fs_file_write(file, "x", 1) < 0);
+  assert(fs_file_close(file) == RET_OK);
+
+  /*写方式打开不映射。*/
+  file = fs_open_file(fs, "map.txt", "rb+M");
+  assert(file != NULL);
+  assert(fs_file_map(file, &data, &size) == RET_NOT_IMPL);
+  assert(fs_file_close(file) == RET_OK);
+
+#ifdef WITH_FS_MT
+  {
+    fs_t* mt = fs_mt_wrap(fs);
+    file = fs_open_file(mt, "map.txt", "rM");
+    assert(file != NULL);
+    assert(fs_file_map(file, &data, &size) == RET_OK);
+    assert(size == 16 && memcmp(data, "0123", 4) == 0);
+    assert(fs_file_close(file) == RET_OK);
+    assert(fs_mt_unwrap(mt) == fs);
+  }
+#endif /*WITH_FS_MT*/
+
+  assert(fs_remove_file(fs, "map.txt") == RET_OK);
+  assert(os_fs_posix_set_mmap_threshold(FS_OS_POSIX_MMAP_THRESHOLD) == RET_OK);
+}
+
+extern uint32_t test_fs_borrow(fs_t* fs, const char* filename, const char* mode);
+extern void test_fs_iovec(fs_t* fs, const char* filename);
+extern void test_fs_pread(fs_t* fs, const char* filename);
+extern void test_fs_pwrite_gap(fs_t* fs, const char* filename);
+extern void test_fs_allocate(fs_t* fs, const char* filename, uint32_t size);
+extern void test_fs_truncate(fs_t* fs, const char* filename, uint32_t size);
+extern void test_fs_pread_threads(fs_t* fs, const char* filename);
+
+static void test_borrow(fs_t* fs) {
+  /*不带缓冲区时拷贝到scratch中。*/
+  assert(os_fs_posix_set_mmap_threshold(0) == RET_OK);
+  assert(test_fs_borrow(fs, "borrow.bin", "rb") == 0);
+
+  /*预读缓冲区。*/
+  assert(test_fs_borrow(fs, "borrow.bin", "rbB") > 0);
+
+  /*内存映射。*/
+  assert(os_fs_posix_set_mmap_threshold(1) == RET_OK);
+  assert(test_fs_borrow(fs, "borrow.bin", "rbM") > 0);
+  assert(os_fs_posix_set_mmap_threshold(FS_OS_POSIX_MMAP_THRESHOLD) == RET_OK);
+}
+
+#ifdef WITH_FS_MT
+static void* borrow_other_thread(void* args) {
+  fs_t* mt = (fs_t*)args;
+  fs_file_t* fp = fs_open_file(mt, "borrow_other.bin", "wb");
+
+  assert(fp != NULL);
+  assert(fs_file_write(fp, "abc", 3) == 3);
+  assert(fs_file_close(fp) == RET_OK);
+  assert(fs_file_exist(mt, "borrow_other.bin"));
+
+  return NULL;
+}
+
+#define WRAP_ONCE_THREADS_NR 8
+static fs_t* s_wrap_once_mt = NULL;
+static fs_t* s_wrap_once_results[WRAP_ONCE_THREADS_NR];
+
+static void* wrap_once_thread(void* args) {
+  int32_t i = tk_pointer_to_int(args);
+  s_wrap_once_results[i] = fs_mt_wrap_once(&s_wrap_once_mt, os_fs_posix());
+
+  return NULL;
+}
+
+/*多个线程同时第一次调用fs_mt_wrap_once，得到的是同一个包装对象。*/
+static void test_mt_wrap_once(void) {
+  int32_t i = 0;
+  tk_thread_t* threads[WRAP_ONCE_THREADS_NR];
+
+  for (i = 0; i < WRAP_ONCE_THREADS_NR; i++) {
+    threads[i] = tk_thread_create(wrap_once_thread, tk_pointer_from_int(i));
+    assert(threads[i] != NULL);
+  }
+  for (i = 0; i < WRAP_ONCE_THREADS_NR; i++) {
+    assert(tk_thread_start(threads[i]) == RET_OK);
+  }
+  for (i = 0; i < WRAP_ONCE_THREADS_NR; i++) {
+    assert(tk_thread_join(threads[i]) == RET_OK);
+    tk_thread_destroy(threads[i]);
+  }
+
+  assert(s_wrap_once_mt != NULL && s_wrap_once_mt != os_fs_posix());
+  for (i = 0; i < WRAP_ONCE_THREADS_NR; i++) {
+    assert(s_wrap_once_results[i] == s_wrap_once_mt);
+  }
+  assert(fs_mt_wrap_once(&s_wrap_once_mt, os_fs_posix()) == s_wrap_once_mt);
+  assert(fs_mt_unwrap(s_wrap_once_mt) == os_fs_posix());
+}
+
+/*借用期间，本线程和其它线程都可以访问其它文件和名字空间，全局模式下也不会死锁。*/
+static void test_mt_borrow(fs_t* fs, fs_mt_lock_mode_t mode) {
+  uint8_t buff[4];
+  uint8_t scratch[16];
+  const void* data = NULL;
+  fs_file_t* fp = NULL;
+  fs_file_t* other = NULL;
+  tk_thread_t* thread = NULL;
+  fs_t* mt = fs_mt_wrap(fs);
+
+  assert(mt != NULL && fs_mt_set_lock_mode(mt, mode) == RET_OK);
+  fp = fs_open_file(mt, "borrow_mt.bin", "wb");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, "0123456789", 10) == 10);
+  assert(fs_file_close(fp) == RET_OK);
+
+  fp = fs_open_file(mt, "borrow_mt.bin", "rbB");
+  assert(fp != NULL);
+  assert(fs_file_borrow(fp, 4, scratch, &data) == 4);
+  assert(memcmp(data, "0123", 4) == 0);
+
+  assert(fs_file_exist(mt, "borrow_mt.bin"));
+  other = fs_open_file(mt, "borrow_mt.bin", "rb");
+  assert(other != NULL);
+  assert(fs_file_read(other, buff, 4) == 4 && memcmp(buff, "0123", 4) == 0);
+  assert(fs_file_close(other) == RET_OK);
+
+  thread = tk_thread_create(borrow_other_thread, mt);
+  assert(thread != NULL);
+  assert(tk_thread_start(thread) == RET_OK);
+  assert(tk_thread_join(thread) == RET_OK);
+  tk_thread_destroy(thread);
+
+  assert(memcmp(data, "0123", 4) == 0);
+  assert(fs_file_release(fp, data) == RET_OK);
+  assert(fs_file_read(fp, buff, 2) == 2 && memcmp(buff, "45", 2) == 0);
+  assert(fs_file_close(fp) == RET_OK);
+
+  assert(fs_remove_file(mt, "borrow_mt.bin") == RET_OK);
+  assert(fs_remove_file(mt, "borrow_other.bin") == RET_OK);
+  assert(fs_mt_unwrap(mt) == fs);
+}
+#endif /*WITH_FS_MT*/
 
 int main(int argc, char* argv[]) {
   fs_t* fs = os_fs_posix();
@@ -72,6 +310,36 @@ int main(int argc, char* argv[]) {
   assert(fs_dir_exist(fs, "test/test2") == FALSE);
 
   assert(fs_remove_dir(fs, "test") == RET_OK);
+  test_buffered(fs);
+  test_map(fs);
+  test_borrow(fs);
+  test_fs_iovec(fs, "iovec.bin");
+  test_fs_pread(fs, "pread.bin");
+  test_fs_pwrite_gap(fs, "gap.bin");
+  test_fs_allocate(fs, "allocate.bin", 64 * 1024);
+  test_fs_truncate(fs, "truncate.bin", 64 * 1024);
+  test_fs_pread_threads(fs, "pread.bin");
+
+#ifdef WITH_FS_MT
+  test_mt_wrap_once();
+  test_mt_borrow(fs, FS_MT_LOCK_GLOBAL);
+  test_mt_borrow(fs, FS_MT_LOCK_PER_FILE);
+  {
+    fs_t* fs1 = fs_mt_wrap(fs);
+    fs_t* fs2 = fs_mt_wrap(fs);
+    assert(fs1 != NULL && fs2 != NULL && fs1 != fs2);
+
+    file = fs_open_file(fs1, "test.txt", "wb+");
+    assert(file != NULL);
+    assert(fs_file_exist(fs2, "test.txt") == TRUE);
+    assert(fs_mt_unwrap(fs1) == NULL);
+    fs_file_close(file);
+    assert(fs_remove_file(fs2, "test.txt") == RET_OK);
+
+    assert(fs_mt_unwrap(fs1) == fs);
+    assert(fs_mt_unwrap(fs2) == fs);
+  }
+#endif /*WITH_FS_MT*/
   str_reset(&str);
   return 0;
 }
@@ -319,6 +319,33 @@ typedef int32_t s32_t;
 #define SPIFFS_IX_MAP                         1
 #endif
 
+// Enable this to be able to keep a copy of the object lookup pages in memory
+// provided by user, see SPIFFS_lu_mirror. Searching for files, free pages and
+// object ids will then read the copy instead of scanning the lookup pages of
+// every block on the medium. The copy is updated on every write to and erase
+// of a lookup page.
+#ifndef SPIFFS_LU_MIRROR
+#define SPIFFS_LU_MIRROR                      1
+#endif
+
+// Enable this to be able to keep a hash table from file names to object index
+// header pages in memory provided by user, see SPIFFS_name_index. Opening,
+// stating and removing files by name will then look up the table instead of
+// reading the object index header of every file on the medium.
+#ifndef SPIFFS_NAME_INDEX
+#define SPIFFS_NAME_INDEX                     1
+#endif
+
+// Enable this to be able to keep the number of used and deleted pages and the
+// erase age of every block in memory provided by user, see SPIFFS_gc_heap,
+// ordered as a binary heap on the garbage collection score. Picking a block to
+// garbage collect will then take the top of the heap instead of scanning the
+// lookup pages of every block, and considers all blocks instead of the ones
+// fitting in the candidate list in the work buffer.
+#ifndef SPIFFS_GC_HEAP
+#define SPIFFS_GC_HEAP                        1
+#endif
+
 // By default SPIFFS in some cases relies on the property of NOR flash that bits
 // cannot be set from 0 to 1 by writing and that controllers will ignore such
 // bit changes. This results in fewer reads as SPIFFS can in some cases perform
@@ -228,6 +228,30 @@ typedef struct {
 #endif
 } spiffs_config;
 
+#if SPIFFS_NAME_INDEX
+/* name index entry, see SPIFFS_name_index */
+typedef struct {
+  // hash of the file name
+  u32_t hash;
+  // object id without index flag, SPIFFS_OBJ_ID_FREE for an empty slot
+  spiffs_obj_id obj_id;
+  // page index of the object index header
+  spiffs_page_ix pix;
+} spiffs_name_index_entry;
+#endif
+
+#if SPIFFS_GC_HEAP
+/* per block summary for garbage collection, see SPIFFS_gc_heap */
+typedef struct {
+  // value of gc_erase_seq when the block was last erased
+  u32_t seq;
+  // number of used pages
+  u16_t used;
+  // number of deleted pages
+  u16_t deleted;
+} spiffs_gc_block;
+#endif
+
 typedef struct spiffs_t {
   // file system configuration
   spiffs_config cfg;
@@ -268,6 +292,8 @@ typedef struct spiffs_t {
 
 #if SPIFFS_GC_STATS
   u32_t stats_gc_runs;
+  // number of blocks erased since mount
+  u32_t stats_erases;
 #endif
 
 #if SPIFFS_CACHE
@@ -281,6 +307,38 @@ typedef struct spiffs_t {
 #endif
 #endif
 
+#if SPIFFS_LU_MIRROR
+  // copy of the object lookup entries of the first lu_mirror_blocks blocks
+  spiffs_obj_id *lu_mirror;
+  // number of blocks in lookup mirror
+  u32_t lu_mirror_blocks;
+#endif
+
+#if SPIFFS_NAME_INDEX
+  // hash table from file names to object index header pages
+  spiffs_name_index_entry *name_index;
+  // name index slot of every object, keyed by object id
+  u32_t *name_index_ids;
+  // number of slots in name index
+  u32_t name_index_slots;
+  // number of used slots in name index
+  u32_t name_index_count;
+  // set when a file could not be added to a full name index, or the index may
+  // miss a file; names not in the index are then searched on the medium
+  u8_t name_index_overflow;
+#endif
+
+#if SPIFFS_GC_HEAP
+  // page counts and erase sequence of every block
+  spiffs_gc_block *gc_blocks;
+  // block indices as a binary max heap on the garbage collection score
+  spiffs_block_ix *gc_heap;
+  // position of every block in gc_heap
+  spiffs_block_ix *gc_heap_pos;
+  // number of erased blocks, the erase age of a block is gc_erase_seq - seq
+  u32_t gc_erase_seq;
+#endif
+
   // check callback function
   spiffs_check_callback check_cb_f;
   // file callback function
@@ -385,7 +443,8 @@ s32_t SPIFFS_probe_fs(spiffs_config *config);
  * @param fd_space      memory for file descriptors
  * @param fd_space_size memory size of file descriptors
  * @param cache         memory for cache, may be null
- * @param cache_size    memory size of cache
+ * @param cache_size    memory size of cache, all of it is used for cache pages,
+ *                      see SPIFFS_buffer_bytes_for_cache
  * @param check_cb_f    callback function for reporting during consistency checks
  */
 s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
@@ -496,6 +555,16 @@ s32_t SPIFFS_remove(spiffs *fs, const char *path);
  */
 s32_t SPIFFS_fremove(spiffs *fs, spiffs_file fh);
 
+/**
+ * Truncates a file by filehandle. The file must be opened for writing.
+ * Only shrinks the file, a size larger than the current size is a no-op.
+ * The file offset is moved to the new end if it was beyond it.
+ * @param fs            the file system struct
+ * @param fh            the filehandle of the file to truncate
+ * @param size          the new size of the file
+ */
+s32_t SPIFFS_ftruncate(spiffs *fs, spiffs_file fh, u32_t size);
+
 /**
  * Gets file status by path
  * @param fs            the file system struct
@@ -674,6 +743,26 @@ s32_t SPIFFS_gc_quick(spiffs *fs, u16_t max_free_pages);
  */
 s32_t SPIFFS_gc(spiffs *fs, u32_t size);
 
+/**
+ * Does a bounded amount of garbage collection: reclaims at most one block.
+ * A block with only deleted pages is erased, otherwise the block the garbage
+ * collector would pick is cleaned by moving its used pages, and erased.
+ * Nothing is done if there already are min_free_blocks free blocks, or if
+ * there are no deleted pages.
+ *
+ * Calling this repeatedly when the system is idle keeps enough free blocks
+ * for writes to skip the synchronous garbage collection, which otherwise may
+ * move and erase up to SPIFFS_GC_MAX_RUNS blocks within a single write.
+ * Writes collect when there are 3 free blocks or less, so min_free_blocks
+ * should be 4 plus the number of blocks written between two calls.
+ *
+ * Returns 1 if a block was erased, 0 if nothing was done, or an error.
+ *
+ * @param fs              the file system struct
+ * @param min_free_blocks number of free blocks to keep
+ */
+s32_t SPIFFS_gc_step(spiffs *fs, u32_t min_free_blocks);
+
 /**
  * Check if EOF reached.
  * @param fs            the file system struct
@@ -782,6 +871,97 @@ s32_t SPIFFS_ix_map_entries_to_bytes(spiffs *fs, u32_t map_page_ix_entries);
 
 #endif // SPIFFS_IX_MAP
 
+#if SPIFFS_LU_MIRROR
+/**
+ * Keeps a copy of the object lookup entries in given memory, so that
+ * searching for files (SPIFFS_open, SPIFFS_stat), free pages and object ids
+ * reads memory instead of the lookup pages of every block on the medium.
+ * The copy is read from the medium once when calling this function, and is
+ * updated on every write to and erase of a lookup page afterwards.
+ * If the buffer is too small to hold the entries of all blocks, only the
+ * first blocks that fit are mirrored, the rest are still read from medium.
+ * The memory is owned by spiffs until the mirror is removed by calling this
+ * function with a NULL buffer, or until unmount.
+ * Must be invoked after mount.
+ * @param fs      the file system struct
+ * @param buf     the buffer for the mirror, or NULL to remove the mirror
+ * @param size    size of the buffer in bytes, see SPIFFS_lu_mirror_bytes
+ * @return        number of mirrored blocks, or error
+ */
+s32_t SPIFFS_lu_mirror(spiffs *fs, void *buf, u32_t size);
+
+/**
+ * Utility function to get number of bytes a mirror buffer must have in order
+ * to mirror the object lookup entries of all blocks.
+ * Must be invoked after mount.
+ * @param fs      the file system struct
+ * @return        needed number of bytes for SPIFFS_lu_mirror
+ */
+s32_t SPIFFS_lu_mirror_bytes(spiffs *fs);
+#endif // SPIFFS_LU_MIRROR
+
+#if SPIFFS_NAME_INDEX
+/**
+ * Keeps a hash table from file names to object index header pages in given
+ * memory, so that finding a file by name (SPIFFS_open, SPIFFS_stat,
+ * SPIFFS_remove, SPIFFS_rename) reads one object index header instead of the
+ * object index headers of all files on the medium, and a name that does not
+ * exist is reported without reading the medium at all.
+ * The table is built when calling this function, and is updated when files
+ * are created, renamed, moved or removed afterwards.
+ * If the table gets too full, files not in the table are found by searching
+ * the medium as without the table.
+ * The memory is owned by spiffs until the index is removed by calling this
+ * function with a NULL buffer, or until unmount.
+ * Must be invoked after mount.
+ * @param fs      the file system struct
+ * @param buf     the buffer for the table, or NULL to remove the index
+ * @param size    size of the buffer in bytes, see SPIFFS_name_index_bytes
+ * @return        number of indexed files, or error
+ */
+s32_t SPIFFS_name_index(spiffs *fs, void *buf, u32_t size);
+
+/**
+ * Utility function to get number of bytes a name index buffer must have in
+ * order to index given number of files.
+ * @param fs      the file system struct
+ * @param files   number of files
+ * @return        needed number of bytes for SPIFFS_name_index
+ */
+s32_t SPIFFS_name_index_bytes(spiffs *fs, u32_t files);
+#endif // SPIFFS_NAME_INDEX
+
+#if SPIFFS_GC_HEAP
+/**
+ * Keeps the number of used and deleted pages and the erase age of every block
+ * in given memory, ordered as a binary heap on the score the garbage collector
+ * gives blocks (see SPIFFS_GC_HEUR_W_DELET, SPIFFS_GC_HEUR_W_USED and
+ * SPIFFS_GC_HEUR_W_ERASE_AGE). The garbage collector then picks the block
+ * with the best score from the top of the heap instead of reading the lookup
+ * pages of all blocks, which matters on large file systems with many blocks.
+ * The summaries are read from the medium once when calling this function, and
+ * are updated on every write to a lookup page and every block erase
+ * afterwards. When the file system is crammed, the garbage collector ignores
+ * erase ages and scans all blocks as without the heap.
+ * The memory is owned by spiffs until the heap is removed by calling this
+ * function with a NULL buffer, or until unmount.
+ * Must be invoked after mount.
+ * @param fs      the file system struct
+ * @param buf     the buffer for the heap, or NULL to remove the heap
+ * @param size    size of the buffer in bytes, see SPIFFS_gc_heap_bytes
+ * @return        number of blocks in the heap, 0 if the buffer is too small
+ *                to hold all blocks, or error
+ */
+s32_t SPIFFS_gc_heap(spiffs *fs, void *buf, u32_t size);
+
+/**
+ * Utility function to get number of bytes a gc heap buffer must have.
+ * Must be invoked after mount.
+ * @param fs      the file system struct
+ * @return        needed number of bytes for SPIFFS_gc_heap
+ */
+s32_t SPIFFS_gc_heap_bytes(spiffs *fs);
+#endif // SPIFFS_GC_HEAP
 
 #if SPIFFS_TEST_VISUALISATION
 /**
@@ -10,20 +10,82 @@
 
 #if SPIFFS_CACHE
 
+// returns cache page header for given cache page index, or null for none
+static spiffs_cache_page *spiffs_cache_hdr(spiffs *fs, spiffs_cache *cache, u16_t ix) {
+  return ix == SPIFFS_CACHE_IX_NONE ? 0 : spiffs_get_cache_page_hdr(fs, cache, ix);
+}
+
+static u8_t spiffs_cache_page_used(spiffs_cache *cache, int ix) {
+  return (cache->cpage_use_map[ix >> 5] & (1u << (ix & 31))) != 0;
+}
+
+// hash bucket for given page index, fibonacci hashing spreads the block aligned
+// lookup pages over all buckets
+static u16_t *spiffs_cache_bucket(spiffs_cache *cache, spiffs_page_ix pix) {
+  return &cache->hash[((u32_t)pix * 0x9e3779b1u) >> (32 - cache->hash_bits)];
+}
+
+// links cache page first in given list
+static void spiffs_cache_list_push(spiffs *fs, spiffs_cache *cache,
+    u16_t *head, u16_t *tail, spiffs_cache_page *cp) {
+  spiffs_cache_page *first = spiffs_cache_hdr(fs, cache, *head);
+  cp->prev = SPIFFS_CACHE_IX_NONE;
+  cp->next = *head;
+  if (first) {
+    first->prev = cp->ix;
+  } else {
+    *tail = cp->ix;
+  }
+  *head = cp->ix;
+}
+
+// unlinks cache page from given list
+static void spiffs_cache_list_unlink(spiffs *fs, spiffs_cache *cache,
+    u16_t *head, u16_t *tail, spiffs_cache_page *cp) {
+  spiffs_cache_page *prev = spiffs_cache_hdr(fs, cache, cp->prev);
+  spiffs_cache_page *next = spiffs_cache_hdr(fs, cache, cp->next);
+  if (prev) {
+    prev->next = cp->next;
+  } else {
+    *head = cp->next;
+  }
+  if (next) {
+    next->prev = cp->prev;
+  } else {
+    *tail = cp->prev;
+  }
+  cp->prev = SPIFFS_CACHE_IX_NONE;
+  cp->next = SPIFFS_CACHE_IX_NONE;
+}
+
+static void spiffs_cache_hash_remove(spiffs *fs, spiffs_cache *cache, spiffs_cache_page *cp) {
+  u16_t *link = spiffs_cache_bucket(cache, cp->pix);
+  while (*link != SPIFFS_CACHE_IX_NONE) {
+    spiffs_cache_page *cur = spiffs_get_cache_page_hdr(fs, cache, *link);
+    if (cur == cp) {
+      *link = cp->hash_next;
+      break;
+    }
+    link = &cur->hash_next;
+  }
+  cp->hash_next = SPIFFS_CACHE_IX_NONE;
+}
+
 // returns cached page for give page index, or null if no such cached page
 static spiffs_cache_page *spiffs_cache_page_get(spiffs *fs, spiffs_page_ix pix) {
   spiffs_cache *cache = spiffs_get_cache(fs);
-  if ((cache->cpage_use_map & cache->cpage_use_mask) == 0) return 0;
-  int i;
-  for (i = 0; i < cache->cpage_count; i++) {
-    spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, cache, i);
-    if ((cache->cpage_use_map & (1<<i)) &&
-        (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) == 0 &&
-        cp->pix == pix ) {
-      //SPIFFS_CACHE_DBG("CACHE_GET: have cache page "_SPIPRIi" for "_SPIPRIpg"\n", i, pix);
-      cp->last_access = cache->last_access;
+  if (cache->lru_head == SPIFFS_CACHE_IX_NONE) return 0;
+  spiffs_cache_page *cp = spiffs_cache_hdr(fs, cache, *spiffs_cache_bucket(cache, pix));
+  while (cp) {
+    if (cp->pix == pix) {
+      //SPIFFS_CACHE_DBG("CACHE_GET: have cache page "_SPIPRIi" for "_SPIPRIpg"\n", cp->ix, pix);
+      if (cache->lru_head != cp->ix) {
+        spiffs_cache_list_unlink(fs, cache, &cache->lru_head, &cache->lru_tail, cp);
+        spiffs_cache_list_push(fs, cache, &cache->lru_head, &cache->lru_tail, cp);
+      }
       return cp;
     }
+    cp = spiffs_cache_hdr(fs, cache, cp->hash_next);
   }
   //SPIFFS_CACHE_DBG("CACHE_GET: no cache for "_SPIPRIpg"\n", pix);
   return 0;
@@ -34,7 +96,7 @@ static s32_t spiffs_cache_page_free(spiffs *fs, int ix, u8_t write_back) {
   s32_t res = SPIFFS_OK;
   spiffs_cache *cache = spiffs_get_cache(fs);
   spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, cache, ix);
-  if (cache->cpage_use_map & (1<<ix)) {
+  if (spiffs_cache_page_used(cache, ix)) {
     if (write_back &&
         (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) == 0 &&
         (cp->flags & SPIFFS_CACHE_FLAG_DIRTY)) {
@@ -46,61 +108,56 @@ static s32_t spiffs_cache_page_free(spiffs *fs, int ix, u8_t write_back) {
 #if SPIFFS_CACHE_WR
     if (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) {
       SPIFFS_CACHE_DBG("CACHE_FREE: free cache page "_SPIPRIi" objid "_SPIPRIid"\n", ix, cp->obj_id);
+      spiffs_cache_list_unlink(fs, cache, &cache->wr_head, &cache->wr_tail, cp);
     } else
 #endif
     {
       SPIFFS_CACHE_DBG("CACHE_FREE: free cache page "_SPIPRIi" pix "_SPIPRIpg"\n", ix, cp->pix);
+      spiffs_cache_list_unlink(fs, cache, &cache->lru_head, &cache->lru_tail, cp);
+      spiffs_cache_hash_remove(fs, cache, cp);
     }
-    cache->cpage_use_map &= ~(1 << ix);
+    cache->cpage_use_map[ix >> 5] &= ~(1u << (ix & 31));
+    cache->cpage_used--;
     cp->flags = 0;
   }
 
   return res;
 }
 
-// removes the oldest accessed cached page
-static s32_t spiffs_cache_page_remove_oldest(spiffs *fs, u8_t flag_mask, u8_t flags) {
-  s32_t res = SPIFFS_OK;
+// removes the least recently used read cache page, write cache pages are
+// released by their file descriptors
+static s32_t spiffs_cache_page_remove_oldest(spiffs *fs) {
   spiffs_cache *cache = spiffs_get_cache(fs);
 
-  if ((cache->cpage_use_map & cache->cpage_use_mask) != cache->cpage_use_mask) {
-    // at least one free cpage
+  if (cache->cpage_used < cache->cpage_count ||
+      cache->lru_tail == SPIFFS_CACHE_IX_NONE) {
+    // at least one free cpage, or only write cache pages
     return SPIFFS_OK;
   }
 
-  // all busy, scan thru all to find the cpage which has oldest access
-  int i;
-  int cand_ix = -1;
-  u32_t oldest_val = 0;
-  for (i = 0; i < cache->cpage_count; i++) {
-    spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, cache, i);
-    if ((cache->last_access - cp->last_access) > oldest_val &&
-        (cp->flags & flag_mask) == flags) {
-      oldest_val = cache->last_access - cp->last_access;
-      cand_ix = i;
-    }
-  }
-
-  if (cand_ix >= 0) {
-    res = spiffs_cache_page_free(fs, cand_ix, 1);
-  }
-
-  return res;
+  return spiffs_cache_page_free(fs, cache->lru_tail, 1);
 }
 
-// allocates a new cached page and returns it, or null if all cache pages are busy
+// allocates a new cached page and returns it, or null if all cache pages are busy.
+// the caller links it into the lru list or the write page list
 static spiffs_cache_page *spiffs_cache_page_allocate(spiffs *fs) {
   spiffs_cache *cache = spiffs_get_cache(fs);
-  if (cache->cpage_use_map == 0xffffffff) {
+  if (cache->cpage_used >= cache->cpage_count) {
     // out of cache memory
     return 0;
   }
-  int i;
-  for (i = 0; i < cache->cpage_count; i++) {
-    if ((cache->cpage_use_map & (1<<i)) == 0) {
+  int w;
+  for (w = 0; w < (cache->cpage_count + 31) / 32; w++) {
+    u32_t free_bits = ~cache->cpage_use_map[w];
+    if (free_bits) {
+      int i = w * 32;
+      while ((free_bits & 1) == 0) {
+        free_bits >>= 1;
+        i++;
+      }
       spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, cache, i);
-      cache->cpage_use_map |= (1<<i);
-      cp->last_access = cache->last_access;
+      cache->cpage_use_map[w] |= 1u << (i & 31);
+      cache->cpage_used++;
       //SPIFFS_CACHE_DBG("CACHE_ALLO: allocated cache page "_SPIPRIi"\n", i);
       return cp;
     }
@@ -131,13 +188,11 @@ s32_t spiffs_phys_rd(
   s32_t res = SPIFFS_OK;
   spiffs_cache *cache = spiffs_get_cache(fs);
   spiffs_cache_page *cp =  spiffs_cache_page_get(fs, SPIFFS_PADDR_TO_PAGE(fs, addr));
-  cache->last_access++;
   if (cp) {
     // we've already got one, you see
 #if SPIFFS_CACHE_STATS
     fs->cache_hits++;
 #endif
-    cp->last_access = cache->last_access;
     u8_t *mem =  spiffs_get_cache_page(fs, cache, cp->ix);
     _SPIFFS_MEMCPY(dst, &mem[SPIFFS_PADDR_TO_PAGE_OFFSET(fs, addr)], len);
   } else {
@@ -150,12 +205,17 @@ s32_t spiffs_phys_rd(
 #endif
     // this operation will always free one cache page (unless all already free),
     // the result code stems from the write operation of the possibly freed cache page
-    res = spiffs_cache_page_remove_oldest(fs, SPIFFS_CACHE_FLAG_TYPE_WR, 0);
+    res = spiffs_cache_page_remove_oldest(fs);
 
     cp = spiffs_cache_page_allocate(fs);
     if (cp) {
+      u16_t *bucket;
       cp->flags = SPIFFS_CACHE_FLAG_WRTHRU;
       cp->pix = SPIFFS_PADDR_TO_PAGE(fs, addr);
+      bucket = spiffs_cache_bucket(cache, cp->pix);
+      cp->hash_next = *bucket;
+      *bucket = cp->ix;
+      spiffs_cache_list_push(fs, cache, &cache->lru_head, &cache->lru_tail, cp);
       SPIFFS_CACHE_DBG("CACHE_ALLO: allocated cache page "_SPIPRIi" for pix "_SPIPRIpg "\n", cp->ix, cp->pix);
 
       s32_t res2 = SPIFFS_HAL_READ(fs,
@@ -207,9 +267,6 @@ s32_t spiffs_phys_wr(
     u8_t *mem =  spiffs_get_cache_page(fs, cache, cp->ix);
     _SPIFFS_MEMCPY(&mem[SPIFFS_PADDR_TO_PAGE_OFFSET(fs, addr)], src, len);
 
-    cache->last_access++;
-    cp->last_access = cache->last_access;
-
     if (cp->flags & SPIFFS_CACHE_FLAG_WRTHRU) {
       // page is being updated, no write-cache, just pass thru
       return SPIFFS_HAL_WRITE(fs, addr, len, src);
@@ -226,20 +283,13 @@ s32_t spiffs_phys_wr(
 // returns the cache page that this fd refers, or null if no cache page
 spiffs_cache_page *spiffs_cache_page_get_by_fd(spiffs *fs, spiffs_fd *fd) {
   spiffs_cache *cache = spiffs_get_cache(fs);
+  spiffs_cache_page *cp = spiffs_cache_hdr(fs, cache, cache->wr_head);
 
-  if ((cache->cpage_use_map & cache->cpage_use_mask) == 0) {
-    // all cpages free, no cpage cannot be assigned to obj_id
-    return 0;
-  }
-
-  int i;
-  for (i = 0; i < cache->cpage_count; i++) {
-    spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, cache, i);
-    if ((cache->cpage_use_map & (1<<i)) &&
-        (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) &&
-        cp->obj_id == fd->obj_id) {
+  while (cp) {
+    if (cp->obj_id == fd->obj_id) {
       return cp;
     }
+    cp = spiffs_cache_hdr(fs, cache, cp->next);
   }
 
   return 0;
@@ -250,15 +300,17 @@ spiffs_cache_page *spiffs_cache_page_get_by_fd(spiffs *fs, spiffs_fd *fd) {
 spiffs_cache_page *spiffs_cache_page_allocate_by_fd(spiffs *fs, spiffs_fd *fd) {
   // before this function is called, it is ensured that there is no already existing
   // cache page with same object id
-  spiffs_cache_page_remove_oldest(fs, SPIFFS_CACHE_FLAG_TYPE_WR, 0);
+  spiffs_cache_page_remove_oldest(fs);
   spiffs_cache_page *cp = spiffs_cache_page_allocate(fs);
   if (cp == 0) {
     // could not get cache page
     return 0;
   }
 
+  spiffs_cache *cache = spiffs_get_cache(fs);
   cp->flags = SPIFFS_CACHE_FLAG_TYPE_WR;
   cp->obj_id = fd->obj_id;
+  spiffs_cache_list_push(fs, cache, &cache->wr_head, &cache->wr_tail, cp);
   fd->cache_page = cp;
   SPIFFS_CACHE_DBG("CACHE_ALLO: allocated cache page "_SPIPRIi" for fd "_SPIPRIfd ":"_SPIPRIid "\n", cp->ix, fd->file_nbr, fd->obj_id);
   return cp;
@@ -282,37 +334,61 @@ void spiffs_cache_fd_release(spiffs *fs, spiffs_cache_page *cp) {
 
 #endif
 
+static u32_t spiffs_cache_hash_bits(u32_t num_pages) {
+  u32_t bits = 1;
+  while ((1u << bits) < num_pages) {
+    bits++;
+  }
+  return bits;
+}
+
+// returns the cache buffer size for given number of cache pages: the pages,
+// followed by the use map and the hash buckets, rounded up to pointer size as
+// SPIFFS_mount trims the cache size
+u32_t spiffs_cache_bytes(spiffs *fs, u32_t num_pages) {
+  u32_t sz = sizeof(spiffs_cache) + num_pages * SPIFFS_CACHE_PAGE_SIZE(fs) +
+      (num_pages + 31) / 32 * sizeof(u32_t) +
+      (1u << spiffs_cache_hash_bits(num_pages)) * sizeof(u16_t);
+  return (sz + sizeof(void*) - 1) & ~(u32_t)(sizeof(void*) - 1);
+}
+
 // initializes the cache
 void spiffs_cache_init(spiffs *fs) {
   if (fs->cache == 0) return;
   u32_t sz = fs->cache_size;
-  u32_t cache_mask = 0;
   int i;
-  int cache_entries =
-      (sz - sizeof(spiffs_cache)) / (SPIFFS_CACHE_PAGE_SIZE(fs));
-  if (cache_entries <= 0) return;
-
-  for (i = 0; i < cache_entries; i++) {
-    cache_mask <<= 1;
-    cache_mask |= 1;
+  if (sz < sizeof(spiffs_cache)) return;
+  u32_t cache_entries = (sz - sizeof(spiffs_cache)) / (SPIFFS_CACHE_PAGE_SIZE(fs));
+  if (cache_entries >= SPIFFS_CACHE_IX_NONE) {
+    cache_entries = SPIFFS_CACHE_IX_NONE - 1;
   }
-
-  spiffs_cache cache;
-  memset(&cache, 0, sizeof(spiffs_cache));
-  cache.cpage_count = cache_entries;
-  cache.cpages = (u8_t *)((u8_t *)fs->cache + sizeof(spiffs_cache));
-
-  cache.cpage_use_map = 0xffffffff;
-  cache.cpage_use_mask = cache_mask;
-  _SPIFFS_MEMCPY(fs->cache, &cache, sizeof(spiffs_cache));
+  while (cache_entries > 0 && spiffs_cache_bytes(fs, cache_entries) > sz) {
+    cache_entries--;
+  }
+  if (cache_entries == 0) return;
 
   spiffs_cache *c = spiffs_get_cache(fs);
+  memset(c, 0, sizeof(spiffs_cache));
+  c->cpage_count = cache_entries;
+  c->cpages = (u8_t *)((u8_t *)fs->cache + sizeof(spiffs_cache));
+  c->cpage_use_map = (u32_t *)(c->cpages + cache_entries * SPIFFS_CACHE_PAGE_SIZE(fs));
+  c->hash_bits = spiffs_cache_hash_bits(cache_entries);
+  c->hash = (u16_t *)(c->cpage_use_map + (cache_entries + 31) / 32);
+  c->lru_head = c->lru_tail = SPIFFS_CACHE_IX_NONE;
+  c->wr_head = c->wr_tail = SPIFFS_CACHE_IX_NONE;
 
   memset(c->cpages, 0, c->cpage_count * SPIFFS_CACHE_PAGE_SIZE(fs));
+  // bits past the last cache page are marked as used and never allocated
+  memset(c->cpage_use_map, 0, (cache_entries + 31) / 32 * sizeof(u32_t));
+  if (cache_entries & 31) {
+    c->cpage_use_map[cache_entries / 32] = ~((1u << (cache_entries & 31)) - 1);
+  }
+  memset(c->hash, 0xff, (1u << c->hash_bits) * sizeof(u16_t));
 
-  c->cpage_use_map &= ~(c->cpage_use_mask);
-  for (i = 0; i < cache.cpage_count; i++) {
-    spiffs_get_cache_page_hdr(fs, c, i)->ix = i;
+  for (i = 0; i < c->cpage_count; i++) {
+    spiffs_cache_page *cp = spiffs_get_cache_page_hdr(fs, c, i);
+    cp->ix = i;
+    cp->prev = cp->next = cp->hash_next = SPIFFS_CACHE_IX_NONE;
   }
 }
 
@@ -34,7 +34,6 @@ s32_t spiffs_gc_quick(
   s32_t res = SPIFFS_OK;
   u32_t blocks = fs->block_count;
   spiffs_block_ix cur_block = 0;
-  u32_t cur_block_addr = 0;
   int cur_entry = 0;
   spiffs_obj_id *obj_lu_buf = (spiffs_obj_id *)fs->lu_work;
 
@@ -55,8 +54,7 @@ s32_t spiffs_gc_quick(
     // check each object lookup page
     while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
       int entry_offset = obj_lookup_page * entries_per_page;
-      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-          0, cur_block_addr + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+      res = _spiffs_rd_lu_page(fs, cur_block, obj_lookup_page, fs->lu_work);
       // check each entry
       while (res == SPIFFS_OK &&
           cur_entry - entry_offset < entries_per_page &&
@@ -95,7 +93,6 @@ s32_t spiffs_gc_quick(
 
     cur_entry = 0;
     cur_block++;
-    cur_block_addr += SPIFFS_CFG_LOG_BLOCK_SZ(fs);
   } // per block
 
   if (res == SPIFFS_OK) {
@@ -195,6 +192,52 @@ s32_t spiffs_gc_check(
   return res;
 }
 
+// Reclaims at most one block, for incremental garbage collection when the
+// system is idle. A block with only deleted pages is erased directly, else the
+// candidate spiffs_gc_check would pick is cleaned and erased. Returns 1 if a
+// block was erased, 0 if there already are min_free_blocks free blocks or
+// there are no deleted pages to reclaim.
+s32_t spiffs_gc_step(
+    spiffs *fs,
+    u32_t min_free_blocks) {
+  s32_t res;
+  spiffs_block_ix *cands;
+  int count;
+
+  if (fs->free_blocks >= min_free_blocks || fs->stats_p_deleted == 0) {
+    return 0;
+  }
+
+  res = spiffs_gc_quick(fs, 0);
+  if (res != SPIFFS_ERR_NO_DELETED_BLOCKS) {
+    SPIFFS_CHECK_RES(res);
+    return 1;
+  }
+
+  res = spiffs_gc_find_candidate(fs, &cands, &count, 0);
+  SPIFFS_CHECK_RES(res);
+  if (count == 0) {
+    return 0;
+  }
+#if SPIFFS_GC_STATS
+  fs->stats_gc_runs++;
+#endif
+  spiffs_block_ix cand = cands[0];
+  SPIFFS_GC_DBG("gc_step: cleaning block "_SPIPRIbl"\n", cand);
+  fs->cleaning = 1;
+  res = spiffs_gc_clean(fs, cand);
+  fs->cleaning = 0;
+  SPIFFS_CHECK_RES(res);
+
+  res = spiffs_gc_erase_page_stats(fs, cand);
+  SPIFFS_CHECK_RES(res);
+
+  res = spiffs_gc_erase_block(fs, cand);
+  SPIFFS_CHECK_RES(res);
+
+  return 1;
+}
+
 // Updates page statistics for a block that is about to be erased
 s32_t spiffs_gc_erase_page_stats(
     spiffs *fs,
@@ -210,8 +253,7 @@ s32_t spiffs_gc_erase_page_stats(
   // check each object lookup page
   while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
     int entry_offset = obj_lookup_page * entries_per_page;
-    res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-        0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+    res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
     // check each entry
     while (res == SPIFFS_OK &&
         cur_entry - entry_offset < entries_per_page && cur_entry < (int)(SPIFFS_PAGES_PER_BLOCK(fs)-SPIFFS_OBJ_LOOKUP_PAGES(fs))) {
@@ -232,6 +274,194 @@ s32_t spiffs_gc_erase_page_stats(
   return res;
 }
 
+#if SPIFFS_GC_HEAP
+// Compares the garbage collection scores of two blocks as
+// spiffs_gc_find_candidate computes them when the fs is not crammed. Only the
+// difference of erase ages is needed, which does not change when other blocks
+// are erased. Ties go to the lower block index, as in the candidate scan.
+// Returns nonzero if block a is the better candidate.
+static int spiffs_gc_heap_better(
+    spiffs *fs,
+    spiffs_block_ix a,
+    spiffs_block_ix b) {
+  spiffs_gc_block *ba = &fs->gc_blocks[a];
+  spiffs_gc_block *bb = &fs->gc_blocks[b];
+  // erase age of a minus erase age of b, bounded as the erase age in the scan
+  s32_t age_diff = (s32_t)(bb->seq - ba->seq);
+  age_diff = MAX(-(s32_t)SPIFFS_OBJ_ID_FREE, MIN((s32_t)SPIFFS_OBJ_ID_FREE, age_diff));
+  s32_t diff =
+      ((s32_t)ba->deleted - (s32_t)bb->deleted) * SPIFFS_GC_HEUR_W_DELET +
+      ((s32_t)ba->used - (s32_t)bb->used) * SPIFFS_GC_HEUR_W_USED +
+      age_diff * SPIFFS_GC_HEUR_W_ERASE_AGE;
+  return diff > 0 || (diff == 0 && a < b);
+}
+
+static void spiffs_gc_heap_set(
+    spiffs *fs,
+    u32_t pos,
+    spiffs_block_ix bix) {
+  fs->gc_heap[pos] = bix;
+  fs->gc_heap_pos[bix] = pos;
+}
+
+// Moves the block at given position down until its children are not better
+static void spiffs_gc_heap_down(
+    spiffs *fs,
+    u32_t pos) {
+  spiffs_block_ix bix = fs->gc_heap[pos];
+
+  while (1) {
+    u32_t child = pos * 2 + 1;
+    if (child >= fs->block_count) break;
+    if (child + 1 < fs->block_count &&
+        spiffs_gc_heap_better(fs, fs->gc_heap[child + 1], fs->gc_heap[child])) {
+      child++;
+    }
+    if (!spiffs_gc_heap_better(fs, fs->gc_heap[child], bix)) break;
+    spiffs_gc_heap_set(fs, pos, fs->gc_heap[child]);
+    pos = child;
+  }
+  spiffs_gc_heap_set(fs, pos, bix);
+}
+
+// Restores the heap order after the score of given block changed
+static void spiffs_gc_heap_fix(
+    spiffs *fs,
+    spiffs_block_ix bix) {
+  u32_t pos = fs->gc_heap_pos[bix];
+
+  while (pos > 0 && spiffs_gc_heap_better(fs, bix, fs->gc_heap[(pos - 1) / 2])) {
+    spiffs_gc_heap_set(fs, pos, fs->gc_heap[(pos - 1) / 2]);
+    pos = (pos - 1) / 2;
+  }
+  spiffs_gc_heap_set(fs, pos, bix);
+  spiffs_gc_heap_down(fs, pos);
+}
+
+// Reads the page counts and erase counts of all blocks from the lookup pages
+// and orders the blocks as a heap
+s32_t spiffs_gc_heap_build(
+    spiffs *fs) {
+  s32_t res = SPIFFS_OK;
+  spiffs_obj_id *obj_lu_buf = (spiffs_obj_id *)fs->lu_work;
+  int entries_per_page = (SPIFFS_CFG_LOG_PAGE_SZ(fs) / sizeof(spiffs_obj_id));
+  spiffs_block_ix bix;
+
+  fs->gc_erase_seq = 0;
+  for (bix = 0; res == SPIFFS_OK && bix < fs->block_count; bix++) {
+    spiffs_gc_block *blk = &fs->gc_blocks[bix];
+    int obj_lookup_page;
+    int cur_entry = 0;
+
+    blk->used = 0;
+    blk->deleted = 0;
+    for (obj_lookup_page = 0;
+        res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs);
+        obj_lookup_page++) {
+      int entry_offset = obj_lookup_page * entries_per_page;
+      res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
+      while (res == SPIFFS_OK &&
+          cur_entry - entry_offset < entries_per_page &&
+          cur_entry < (int)(SPIFFS_PAGES_PER_BLOCK(fs)-SPIFFS_OBJ_LOOKUP_PAGES(fs))) {
+        spiffs_obj_id obj_id = obj_lu_buf[cur_entry-entry_offset];
+        if (obj_id == SPIFFS_OBJ_ID_DELETED) {
+          blk->deleted++;
+        } else if (obj_id != SPIFFS_OBJ_ID_FREE) {
+          blk->used++;
+        }
+        cur_entry++;
+      }
+    }
+    SPIFFS_CHECK_RES(res);
+
+    spiffs_obj_id erase_count;
+    res = _spiffs_rd(fs, SPIFFS_OP_C_READ | SPIFFS_OP_T_OBJ_LU2, 0,
+        SPIFFS_ERASE_COUNT_PADDR(fs, bix),
+        sizeof(spiffs_obj_id), (u8_t *)&erase_count);
+    SPIFFS_CHECK_RES(res);
+
+    // same erase age as in spiffs_gc_find_candidate
+    spiffs_obj_id erase_age;
+    if (fs->max_erase_count > erase_count) {
+      erase_age = fs->max_erase_count - erase_count;
+    } else {
+      erase_age = SPIFFS_OBJ_ID_FREE - (erase_count - fs->max_erase_count);
+    }
+    blk->seq = fs->gc_erase_seq - erase_age;
+    spiffs_gc_heap_set(fs, bix, bix);
+  }
+
+  for (bix = fs->block_count / 2; bix > 0; bix--) {
+    spiffs_gc_heap_down(fs, bix - 1);
+  }
+  return res;
+}
+
+// Counts the lookup entries changed by a write to the medium, before the
+// write. Entries go from free to used or deleted, and from used to deleted.
+void spiffs_gc_heap_lu_wr(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len,
+    const u8_t *src) {
+  u32_t lu_size = SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) * sizeof(spiffs_obj_id);
+  u32_t end;
+
+  if (fs->gc_blocks == 0 || addr < SPIFFS_CFG_PHYS_ADDR(fs)) return;
+  addr -= SPIFFS_CFG_PHYS_ADDR(fs);
+  end = addr + len;
+  // lookup entries are written one whole entry at a time
+  addr = (addr + sizeof(spiffs_obj_id) - 1) & ~(sizeof(spiffs_obj_id) - 1);
+  while (addr + sizeof(spiffs_obj_id) <= end) {
+    spiffs_block_ix bix = addr / SPIFFS_CFG_LOG_BLOCK_SZ(fs);
+    u32_t offs = addr % SPIFFS_CFG_LOG_BLOCK_SZ(fs);
+    if (bix >= fs->block_count) break;
+    if (offs >= lu_size) {
+      // skip to the lookup entries of next block
+      addr += SPIFFS_CFG_LOG_BLOCK_SZ(fs) - offs;
+      continue;
+    }
+    spiffs_obj_id old_id;
+    spiffs_obj_id new_id;
+#if SPIFFS_LU_MIRROR
+    if (bix < fs->lu_mirror_blocks) {
+      old_id = fs->lu_mirror[bix * SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) + offs / sizeof(spiffs_obj_id)];
+    } else
+#endif
+    if (SPIFFS_HAL_READ(fs, SPIFFS_CFG_PHYS_ADDR(fs) + addr, sizeof(spiffs_obj_id),
+        (u8_t *)&old_id) != SPIFFS_OK) {
+      old_id = SPIFFS_OBJ_ID_DELETED;
+    }
+    _SPIFFS_MEMCPY(&new_id, src + (addr - (end - len)), sizeof(spiffs_obj_id));
+    new_id &= old_id;
+    if (new_id != old_id && old_id != SPIFFS_OBJ_ID_DELETED) {
+      spiffs_gc_block *blk = &fs->gc_blocks[bix];
+      if (old_id != SPIFFS_OBJ_ID_FREE) {
+        blk->used--;
+      }
+      if (new_id == SPIFFS_OBJ_ID_DELETED) {
+        blk->deleted++;
+      } else {
+        blk->used++;
+      }
+      spiffs_gc_heap_fix(fs, bix);
+    }
+    addr += sizeof(spiffs_obj_id);
+  }
+}
+
+// Resets the page counts and erase age of an erased block
+void spiffs_gc_heap_erased(
+    spiffs *fs,
+    spiffs_block_ix bix) {
+  if (fs->gc_blocks == 0) return;
+  fs->gc_blocks[bix].used = 0;
+  fs->gc_blocks[bix].deleted = 0;
+  fs->gc_blocks[bix].seq = fs->gc_erase_seq++;
+  spiffs_gc_heap_fix(fs, bix);
+}
+#endif // SPIFFS_GC_HEAP
+
 // Finds block candidates to erase
 s32_t spiffs_gc_find_candidate(
     spiffs *fs,
@@ -241,10 +471,19 @@ s32_t spiffs_gc_find_candidate(
   s32_t res = SPIFFS_OK;
   u32_t blocks = fs->block_count;
   spiffs_block_ix cur_block = 0;
-  u32_t cur_block_addr = 0;
   spiffs_obj_id *obj_lu_buf = (spiffs_obj_id *)fs->lu_work;
   int cur_entry = 0;
 
+#if SPIFFS_GC_HEAP
+  // the best block is on top of the heap, unless erase age is to be ignored
+  if (fs->gc_blocks && !fs_crammed) {
+    *block_candidates = (spiffs_block_ix *)fs->work;
+    (*block_candidates)[0] = fs->gc_heap[0];
+    *candidate_count = 1;
+    return SPIFFS_OK;
+  }
+#endif
+
   // using fs->work area as sorted candidate memory, (spiffs_block_ix)cand_bix/(s32_t)score
   int max_candidates = MIN(fs->block_count, (SPIFFS_CFG_LOG_PAGE_SZ(fs)-8)/(sizeof(spiffs_block_ix) + sizeof(s32_t)));
   *candidate_count = 0;
@@ -270,8 +509,7 @@ s32_t spiffs_gc_find_candidate(
     // check each object lookup page
     while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
       int entry_offset = obj_lookup_page * entries_per_page;
-      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-          0, cur_block_addr + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+      res = _spiffs_rd_lu_page(fs, cur_block, obj_lookup_page, fs->lu_work);
       // check each entry
       while (res == SPIFFS_OK &&
           cur_entry - entry_offset < entries_per_page &&
@@ -338,7 +576,6 @@ s32_t spiffs_gc_find_candidate(
 
     cur_entry = 0;
     cur_block++;
-    cur_block_addr += SPIFFS_CFG_LOG_BLOCK_SZ(fs);
   } // per block
 
   return res;
@@ -407,9 +644,7 @@ s32_t spiffs_gc_clean(spiffs *fs, spiffs_block_ix bix) {
     // check each object lookup page
     while (scan && res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
       int entry_offset = obj_lookup_page * entries_per_page;
-      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-          0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page),
-          SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+      res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
       // check each object lookup entry
       while (scan && res == SPIFFS_OK &&
           cur_entry - entry_offset < entries_per_page && cur_entry < (int)(SPIFFS_PAGES_PER_BLOCK(fs)-SPIFFS_OBJ_LOOKUP_PAGES(fs))) {
@@ -449,9 +684,7 @@ s32_t spiffs_gc_clean(spiffs *fs, spiffs_block_ix bix) {
                 SPIFFS_GC_DBG("gc_clean: MOVE_DATA move objix "_SPIPRIid":"_SPIPRIsp" page "_SPIPRIpg" to "_SPIPRIpg"\n", gc.cur_obj_id, p_hdr.span_ix, cur_pix, new_data_pix);
                 SPIFFS_CHECK_RES(res);
                 // move wipes obj_lu, reload it
-                res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-                    0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page),
-                    SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+                res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
                 SPIFFS_CHECK_RES(res);
               } else {
                 // page is deleted but not deleted in lookup, scrap it -
@@ -494,9 +727,7 @@ s32_t spiffs_gc_clean(spiffs *fs, spiffs_block_ix bix) {
               spiffs_cb_object_event(fs, (spiffs_page_object_ix *)&p_hdr,
                   SPIFFS_EV_IX_MOV, obj_id, p_hdr.span_ix, new_pix, 0);
               // move wipes obj_lu, reload it
-              res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-                  0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page),
-                  SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+              res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
               SPIFFS_CHECK_RES(res);
             } else {
               // page is deleted but not deleted in lookup, scrap it -
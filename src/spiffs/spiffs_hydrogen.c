@@ -18,7 +18,7 @@ u32_t SPIFFS_buffer_bytes_for_filedescs(spiffs *fs, u32_t num_descs) {
 }
 #if SPIFFS_CACHE
 u32_t SPIFFS_buffer_bytes_for_cache(spiffs *fs, u32_t num_pages) {
-  return sizeof(spiffs_cache) + num_pages * (sizeof(spiffs_cache_page) + SPIFFS_CFG_LOG_PAGE_SZ(fs));
+  return spiffs_cache_bytes(fs, num_pages);
 }
 #endif
 #endif
@@ -118,7 +118,7 @@ s32_t SPIFFS_mount(spiffs *fs, spiffs_config *config, u8_t *work,
 
 #if SPIFFS_CACHE
   fs->cache = cache;
-  fs->cache_size = (cache_size > (SPIFFS_CFG_LOG_PAGE_SZ(fs)*32)) ? SPIFFS_CFG_LOG_PAGE_SZ(fs)*32 : cache_size;
+  fs->cache_size = cache_size;
   spiffs_cache_init(fs);
 #endif
 
@@ -167,6 +167,17 @@ void SPIFFS_unmount(spiffs *fs) {
       spiffs_fd_return(fs, cur_fd->file_nbr);
     }
   }
+#if SPIFFS_LU_MIRROR
+  fs->lu_mirror = 0;
+  fs->lu_mirror_blocks = 0;
+#endif
+#if SPIFFS_NAME_INDEX
+  fs->name_index = 0;
+  fs->name_index_slots = 0;
+#endif
+#if SPIFFS_GC_HEAP
+  fs->gc_blocks = 0;
+#endif
   fs->mounted = 0;
 
   SPIFFS_UNLOCK(fs);
@@ -724,6 +735,51 @@ s32_t SPIFFS_fremove(spiffs *fs, spiffs_file fh) {
 #endif // SPIFFS_READ_ONLY
 }
 
+s32_t SPIFFS_ftruncate(spiffs *fs, spiffs_file fh, u32_t size) {
+  SPIFFS_API_DBG("%s "_SPIPRIfd " "_SPIPRIi "\n", __func__, fh, size);
+#if SPIFFS_READ_ONLY
+  (void)fs; (void)fh; (void)size;
+  return SPIFFS_ERR_RO_NOT_IMPL;
+#else
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  spiffs_fd *fd;
+  s32_t res;
+  fh = SPIFFS_FH_UNOFFS(fs, fh);
+  res = spiffs_fd_get(fs, fh, &fd);
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+
+  if ((fd->flags & SPIFFS_O_WRONLY) == 0) {
+    res = SPIFFS_ERR_NOT_WRITABLE;
+    SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  }
+
+#if SPIFFS_CACHE_WR
+  res = spiffs_fflush_cache(fs, fh);
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+#endif
+
+  u32_t file_size = fd->size == SPIFFS_UNDEFINED_LEN ? 0 : fd->size;
+  if (size < file_size) {
+    res = spiffs_object_truncate(fd, size, 0);
+    SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+
+    // index pages after the new end are gone, restart the cursor from the header
+    fd->cursor_objix_spix = 0;
+    fd->cursor_objix_pix = fd->objix_hdr_pix;
+    if (fd->fdoffset > size) {
+      fd->fdoffset = size;
+    }
+  }
+
+  SPIFFS_UNLOCK(fs);
+
+  return 0;
+#endif // SPIFFS_READ_ONLY
+}
+
 static s32_t spiffs_stat_pix(spiffs *fs, spiffs_page_ix pix, spiffs_file fh, spiffs_stat *s) {
   (void)fh;
   spiffs_page_object_ix_header objix_hdr;
@@ -1115,6 +1171,18 @@ s32_t SPIFFS_check(spiffs *fs) {
 
   res = spiffs_obj_lu_scan(fs);
 
+#if SPIFFS_NAME_INDEX
+  // the checks repair pages without object events
+  if (res == SPIFFS_OK && fs->name_index) {
+    res = spiffs_name_index_build(fs);
+  }
+#endif
+#if SPIFFS_GC_HEAP
+  if (res == SPIFFS_OK && fs->gc_blocks) {
+    res = spiffs_gc_heap_build(fs);
+  }
+#endif
+
   SPIFFS_UNLOCK(fs);
   return res;
 #endif // SPIFFS_READ_ONLY
@@ -1184,6 +1252,25 @@ s32_t SPIFFS_gc(spiffs *fs, u32_t size) {
 #endif // SPIFFS_READ_ONLY
 }
 
+s32_t SPIFFS_gc_step(spiffs *fs, u32_t min_free_blocks) {
+  SPIFFS_API_DBG("%s "_SPIPRIi "\n", __func__, min_free_blocks);
+#if SPIFFS_READ_ONLY
+  (void)fs; (void)min_free_blocks;
+  return SPIFFS_ERR_RO_NOT_IMPL;
+#else
+  s32_t res;
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  res = spiffs_gc_step(fs, min_free_blocks);
+
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  SPIFFS_UNLOCK(fs);
+  return res;
+#endif // SPIFFS_READ_ONLY
+}
+
 s32_t SPIFFS_eof(spiffs *fs, spiffs_file fh) {
   SPIFFS_API_DBG("%s "_SPIPRIfd "\n", __func__, fh);
   s32_t res;
@@ -1375,6 +1462,137 @@ s32_t SPIFFS_ix_map_entries_to_bytes(spiffs *fs, u32_t map_page_ix_entries) {
 
 #endif // SPIFFS_IX_MAP
 
+#if SPIFFS_LU_MIRROR
+s32_t SPIFFS_lu_mirror(spiffs *fs, void *buf, u32_t size) {
+  SPIFFS_API_DBG("%s "_SPIPRIi "\n", __func__, size);
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  s32_t res = SPIFFS_OK;
+  u32_t lu_size = SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) * sizeof(spiffs_obj_id);
+  u8_t *buf_8 = (u8_t *)buf;
+
+  fs->lu_mirror = 0;
+  fs->lu_mirror_blocks = 0;
+  if (buf_8) {
+    // align mirror pointer to object id size
+    u8_t addr_lsb = ((u8_t)(intptr_t)buf_8) & (sizeof(spiffs_obj_id)-1);
+    if (addr_lsb) {
+      buf_8 += sizeof(spiffs_obj_id) - addr_lsb;
+      size = size > sizeof(spiffs_obj_id) - addr_lsb ? size - (sizeof(spiffs_obj_id) - addr_lsb) : 0;
+    }
+    fs->lu_mirror = (spiffs_obj_id *)buf_8;
+    fs->lu_mirror_blocks = MIN(size / lu_size, fs->block_count);
+    res = spiffs_lu_mirror_build(fs);
+    if (res != SPIFFS_OK) {
+      fs->lu_mirror = 0;
+      fs->lu_mirror_blocks = 0;
+    }
+  }
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  SPIFFS_UNLOCK(fs);
+
+  return (s32_t)fs->lu_mirror_blocks;
+}
+
+s32_t SPIFFS_lu_mirror_bytes(spiffs *fs) {
+  SPIFFS_API_CHECK_CFG(fs);
+  return fs->block_count * SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) * sizeof(spiffs_obj_id);
+}
+#endif // SPIFFS_LU_MIRROR
+
+#if SPIFFS_NAME_INDEX
+s32_t SPIFFS_name_index(spiffs *fs, void *buf, u32_t size) {
+  SPIFFS_API_DBG("%s "_SPIPRIi "\n", __func__, size);
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  s32_t res = SPIFFS_OK;
+  u8_t *buf_8 = (u8_t *)buf;
+
+  fs->name_index = 0;
+  fs->name_index_slots = 0;
+  fs->name_index_count = 0;
+  if (buf_8) {
+    // align table pointer to pointer size byte boundary
+    u8_t ptr_size = sizeof(void*);
+    u8_t addr_lsb = ((u8_t)(intptr_t)buf_8) & (ptr_size-1);
+    if (addr_lsb) {
+      buf_8 += ptr_size - addr_lsb;
+      size = size > (u32_t)(ptr_size - addr_lsb) ? size - (ptr_size - addr_lsb) : 0;
+    }
+    // entries first, then the slot of every object keyed by object id
+    u32_t slots = size / (sizeof(spiffs_name_index_entry) + sizeof(u32_t));
+    if (slots > 0) {
+      fs->name_index = (spiffs_name_index_entry *)buf_8;
+      fs->name_index_ids = (u32_t *)(buf_8 + slots * sizeof(spiffs_name_index_entry));
+      fs->name_index_slots = slots;
+      res = spiffs_name_index_build(fs);
+      if (res != SPIFFS_OK) {
+        fs->name_index = 0;
+        fs->name_index_slots = 0;
+        fs->name_index_count = 0;
+      }
+    }
+  }
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  SPIFFS_UNLOCK(fs);
+
+  return (s32_t)fs->name_index_count;
+}
+
+s32_t SPIFFS_name_index_bytes(spiffs *fs, u32_t files) {
+  SPIFFS_API_CHECK_CFG(fs);
+  // two slots per file, the table is considered full at three quarters
+  return (files * 2 + 1) * (sizeof(spiffs_name_index_entry) + sizeof(u32_t));
+}
+#endif // SPIFFS_NAME_INDEX
+
+#if SPIFFS_GC_HEAP
+s32_t SPIFFS_gc_heap(spiffs *fs, void *buf, u32_t size) {
+  SPIFFS_API_DBG("%s "_SPIPRIi "\n", __func__, size);
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  s32_t res = SPIFFS_OK;
+  u8_t *buf_8 = (u8_t *)buf;
+
+  fs->gc_blocks = 0;
+  if (buf_8) {
+    // align summaries to u32_t boundary
+    u8_t addr_lsb = ((u8_t)(intptr_t)buf_8) & (sizeof(u32_t)-1);
+    if (addr_lsb) {
+      buf_8 += sizeof(u32_t) - addr_lsb;
+      size = size > sizeof(u32_t) - addr_lsb ? size - (sizeof(u32_t) - addr_lsb) : 0;
+    }
+    if (size >= fs->block_count * (sizeof(spiffs_gc_block) + 2 * sizeof(spiffs_block_ix))) {
+      fs->gc_heap = (spiffs_block_ix *)(buf_8 + fs->block_count * sizeof(spiffs_gc_block));
+      fs->gc_heap_pos = fs->gc_heap + fs->block_count;
+      // set last, writes update the heap once gc_blocks is set
+      fs->gc_blocks = (spiffs_gc_block *)buf_8;
+      res = spiffs_gc_heap_build(fs);
+      if (res != SPIFFS_OK) {
+        fs->gc_blocks = 0;
+      }
+    }
+  }
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  SPIFFS_UNLOCK(fs);
+
+  return fs->gc_blocks ? (s32_t)fs->block_count : 0;
+}
+
+s32_t SPIFFS_gc_heap_bytes(spiffs *fs) {
+  SPIFFS_API_CHECK_CFG(fs);
+  // one extra u32_t for aligning the buffer
+  return fs->block_count * (sizeof(spiffs_gc_block) + 2 * sizeof(spiffs_block_ix)) +
+      sizeof(u32_t);
+}
+#endif // SPIFFS_GC_HEAP
+
 #if SPIFFS_TEST_VISUALISATION
 s32_t SPIFFS_vis(spiffs *fs) {
   s32_t res = SPIFFS_OK;
@@ -1393,8 +1611,7 @@ s32_t SPIFFS_vis(spiffs *fs) {
 
     while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
       int entry_offset = obj_lookup_page * entries_per_page;
-      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-          0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+      res = _spiffs_rd_lu_page(fs, bix, obj_lookup_page, fs->lu_work);
       // check each entry
       while (res == SPIFFS_OK &&
           cur_entry - entry_offset < entries_per_page && cur_entry < (int)(SPIFFS_PAGES_PER_BLOCK(fs)-SPIFFS_OBJ_LOOKUP_PAGES(fs))) {
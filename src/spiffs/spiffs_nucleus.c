@@ -79,6 +79,109 @@ s32_t spiffs_phys_wr(
 
 #endif
 
+#if SPIFFS_LU_MIRROR
+// Applies a write (src) or an erase (src == 0) of the medium to the parts of
+// the lookup mirror it covers. Writes can only clear bits, as on NOR flash.
+static void spiffs_lu_mirror_update(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len,
+    const u8_t *src) {
+  u32_t lu_size = SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) * sizeof(spiffs_obj_id);
+  u32_t end;
+
+  if (fs->lu_mirror == 0 || addr < SPIFFS_CFG_PHYS_ADDR(fs)) return;
+  addr -= SPIFFS_CFG_PHYS_ADDR(fs);
+  end = addr + len;
+  while (addr < end) {
+    spiffs_block_ix bix = addr / SPIFFS_CFG_LOG_BLOCK_SZ(fs);
+    u32_t offs = addr % SPIFFS_CFG_LOG_BLOCK_SZ(fs);
+    u32_t n = MIN(end - addr, SPIFFS_CFG_LOG_BLOCK_SZ(fs) - offs);
+    if (bix >= fs->lu_mirror_blocks) break;
+    if (offs < lu_size) {
+      u8_t *mem = (u8_t *)fs->lu_mirror + bix * lu_size + offs;
+      u32_t cnt = MIN(n, lu_size - offs);
+      if (src) {
+        u32_t i;
+        for (i = 0; i < cnt; i++) {
+          mem[i] &= src[i];
+        }
+      } else {
+        memset(mem, 0xff, cnt);
+      }
+    }
+    if (src) src += n;
+    addr += n;
+  }
+}
+
+s32_t spiffs_lu_mirror_hal_erase(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len) {
+  s32_t res = _SPIFFS_HAL_ERASE(fs, addr, len);
+  if (res == SPIFFS_OK) {
+    spiffs_lu_mirror_update(fs, addr, len, 0);
+  }
+  return res;
+}
+
+// reads the lookup entries of the mirrored blocks from the medium
+s32_t spiffs_lu_mirror_build(
+    spiffs *fs) {
+  s32_t res = SPIFFS_OK;
+  u32_t lu_size = SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) * sizeof(spiffs_obj_id);
+  spiffs_block_ix bix;
+
+  for (bix = 0; res == SPIFFS_OK && bix < fs->lu_mirror_blocks; bix++) {
+    res = SPIFFS_HAL_READ(fs, SPIFFS_BLOCK_TO_PADDR(fs, bix), lu_size,
+        (u8_t *)fs->lu_mirror + bix * lu_size);
+  }
+  return res;
+}
+
+// Reads given object lookup page of given block into dst, from the mirror if
+// the block is mirrored. For the last lookup page, only the lookup entries are
+// copied from the mirror, not the erase count and magic.
+s32_t spiffs_obj_lu_rd_page(
+    spiffs *fs,
+    spiffs_block_ix bix,
+    int lu_page,
+    u8_t *dst) {
+  if (bix < fs->lu_mirror_blocks) {
+    int entries_per_page = (SPIFFS_CFG_LOG_PAGE_SZ(fs) / sizeof(spiffs_obj_id));
+    int entry_offset = lu_page * entries_per_page;
+    int entries = MIN(entries_per_page, (int)SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) - entry_offset);
+    _SPIFFS_MEMCPY(dst, &fs->lu_mirror[bix * SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) + entry_offset],
+        entries * sizeof(spiffs_obj_id));
+    return SPIFFS_OK;
+  }
+  return _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
+      0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, lu_page),
+      SPIFFS_CFG_LOG_PAGE_SZ(fs), dst);
+}
+#endif // SPIFFS_LU_MIRROR
+
+#if SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+s32_t spiffs_lu_hal_wr(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len,
+    u8_t *src) {
+#if SPIFFS_GC_HEAP
+  // needs the lookup entries before the write
+  spiffs_gc_heap_lu_wr(fs, addr, len, src);
+#endif
+  s32_t res = _SPIFFS_HAL_WRITE(fs, addr, len, src);
+#if SPIFFS_LU_MIRROR
+  if (res == SPIFFS_OK) {
+    spiffs_lu_mirror_update(fs, addr, len, src);
+  }
+#endif
+  return res;
+}
+#endif // SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+
 #if !SPIFFS_READ_ONLY
 s32_t spiffs_phys_cpy(
     spiffs *fs,
@@ -135,7 +238,6 @@ s32_t spiffs_obj_lu_find_entry_visitor(
   s32_t res = SPIFFS_OK;
   s32_t entry_count = fs->block_count * SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs);
   spiffs_block_ix cur_block = starting_block;
-  u32_t cur_block_addr = starting_block * SPIFFS_CFG_LOG_BLOCK_SZ(fs);
 
   spiffs_obj_id *obj_lu_buf = (spiffs_obj_id *)fs->lu_work;
   int cur_entry = starting_lu_entry;
@@ -145,14 +247,12 @@ s32_t spiffs_obj_lu_find_entry_visitor(
   if (cur_entry > (int)SPIFFS_OBJ_LOOKUP_MAX_ENTRIES(fs) - 1) {
     cur_entry = 0;
     cur_block++;
-    cur_block_addr = cur_block * SPIFFS_CFG_LOG_BLOCK_SZ(fs);
     if (cur_block >= fs->block_count) {
       if (flags & SPIFFS_VIS_NO_WRAP) {
         return SPIFFS_VIS_END;
       } else {
         // block wrap
         cur_block = 0;
-        cur_block_addr = 0;
       }
     }
   }
@@ -163,8 +263,7 @@ s32_t spiffs_obj_lu_find_entry_visitor(
     // check each object lookup page
     while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
       int entry_offset = obj_lookup_page * entries_per_page;
-      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-          0, cur_block_addr + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+      res = _spiffs_rd_lu_page(fs, cur_block, obj_lookup_page, fs->lu_work);
       // check each entry
       while (res == SPIFFS_OK &&
           cur_entry - entry_offset < entries_per_page && // for non-last obj lookup pages
@@ -183,8 +282,7 @@ s32_t spiffs_obj_lu_find_entry_visitor(
                 user_var_p);
             if (res == SPIFFS_VIS_COUNTINUE || res == SPIFFS_VIS_COUNTINUE_RELOAD) {
               if (res == SPIFFS_VIS_COUNTINUE_RELOAD) {
-                res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
-                    0, cur_block_addr + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+                res = _spiffs_rd_lu_page(fs, cur_block, obj_lookup_page, fs->lu_work);
                 SPIFFS_CHECK_RES(res);
               }
               res = SPIFFS_OK;
@@ -205,14 +303,12 @@ s32_t spiffs_obj_lu_find_entry_visitor(
     } // per object lookup page
     cur_entry = 0;
     cur_block++;
-    cur_block_addr += SPIFFS_CFG_LOG_BLOCK_SZ(fs);
     if (cur_block >= fs->block_count) {
       if (flags & SPIFFS_VIS_NO_WRAP) {
         return SPIFFS_VIS_END;
       } else {
         // block wrap
         cur_block = 0;
-        cur_block_addr = 0;
       }
     }
   } // per block
@@ -239,6 +335,12 @@ s32_t spiffs_erase_block(
     size -= SPIFFS_CFG_PHYS_ERASE_SZ(fs);
   }
   fs->free_blocks++;
+#if SPIFFS_GC_STATS
+  fs->stats_erases++;
+#endif
+#if SPIFFS_GC_HEAP
+  spiffs_gc_heap_erased(fs, bix);
+#endif
 
   // register erase count for this block
   res = _spiffs_wr(fs, SPIFFS_OP_C_WRTHRU | SPIFFS_OP_T_OBJ_LU2, 0,
@@ -1141,6 +1243,13 @@ void spiffs_cb_object_event(
 
 #endif
 
+#if SPIFFS_NAME_INDEX
+  // object index header events, gc moves of headers do not always carry the index flag
+  if (spix == 0) {
+    spiffs_name_index_event(fs, ev, obj_id, (const spiffs_page_object_ix_header *)objix, new_pix);
+  }
+#endif
+
   // callback to user if object index header
   if (fs->file_cb_f && spix == 0 && (obj_id_raw & SPIFFS_OBJ_ID_IX_FLAG)) {
     spiffs_fileop_type op;
@@ -1706,6 +1815,19 @@ s32_t spiffs_object_find_object_index_header_by_name(
   spiffs_block_ix bix;
   int entry;
 
+#if SPIFFS_NAME_INDEX
+  if (fs->name_index) {
+    spiffs_page_ix found_pix;
+    res = spiffs_name_index_find(fs, name, &found_pix);
+    if (res == SPIFFS_OK && pix) {
+      *pix = found_pix;
+    }
+    if (res != SPIFFS_VIS_END) {
+      return res;
+    }
+  }
+#endif
+
   res = spiffs_obj_lu_find_entry_visitor(fs,
       fs->cursor_block_ix,
       fs->cursor_obj_lu_entry,
@@ -2235,7 +2357,7 @@ s32_t spiffs_obj_lu_find_free_obj_id(spiffs *fs, spiffs_obj_id *obj_id, const u8
 }
 #endif // !SPIFFS_READ_ONLY
 
-#if SPIFFS_TEMPORAL_FD_CACHE
+#if SPIFFS_TEMPORAL_FD_CACHE || SPIFFS_NAME_INDEX
 // djb2 hash
 static u32_t spiffs_hash(spiffs *fs, const u8_t *name) {
   (void)fs;
@@ -2249,6 +2371,239 @@ static u32_t spiffs_hash(spiffs *fs, const u8_t *name) {
 }
 #endif
 
+#if SPIFFS_NAME_INDEX
+// The name index is a hash table with linear probing, keyed by the hash of the
+// name. Entries found by hash are confirmed by reading the object index header,
+// so hash collisions and stale entries never give a wrong result.
+// A second table of the same size, keyed by object id, holds the slot of every
+// object in the first table, so that object events find their entry directly.
+
+#define SPIFFS_NAME_INDEX_NO_SLOT ((u32_t)-1)
+
+// returns the id table slot of given object, or -1
+static s32_t spiffs_name_index_find_id(
+    spiffs *fs,
+    spiffs_obj_id obj_id) {
+  u32_t i = obj_id % fs->name_index_slots;
+  while (fs->name_index_ids[i] != SPIFFS_NAME_INDEX_NO_SLOT) {
+    if (fs->name_index[fs->name_index_ids[i]].obj_id == obj_id) {
+      return (s32_t)i;
+    }
+    i = (i + 1) % fs->name_index_slots;
+  }
+  return -1;
+}
+
+// empties given id table slot, moving back following entries of the probe sequence
+static void spiffs_name_index_remove_id(
+    spiffs *fs,
+    u32_t i) {
+  u32_t next = i;
+  fs->name_index_ids[i] = SPIFFS_NAME_INDEX_NO_SLOT;
+  while (1) {
+    next = (next + 1) % fs->name_index_slots;
+    u32_t slot = fs->name_index_ids[next];
+    if (slot == SPIFFS_NAME_INDEX_NO_SLOT) break;
+    u32_t home = fs->name_index[slot].obj_id % fs->name_index_slots;
+    u8_t keep = i <= next ? (home > i && home <= next) : (home > i || home <= next);
+    if (!keep) {
+      fs->name_index_ids[i] = slot;
+      fs->name_index_ids[next] = SPIFFS_NAME_INDEX_NO_SLOT;
+      i = next;
+    }
+  }
+}
+
+// empties given slot, moving back following entries of the probe sequence
+static void spiffs_name_index_remove_slot(
+    spiffs *fs,
+    u32_t slot) {
+  u32_t next = slot;
+  s32_t id_ix = spiffs_name_index_find_id(fs, fs->name_index[slot].obj_id);
+  if (id_ix >= 0) {
+    spiffs_name_index_remove_id(fs, (u32_t)id_ix);
+  }
+  fs->name_index[slot].obj_id = SPIFFS_OBJ_ID_FREE;
+  fs->name_index_count--;
+  while (1) {
+    next = (next + 1) % fs->name_index_slots;
+    spiffs_name_index_entry *e = &fs->name_index[next];
+    if (e->obj_id == SPIFFS_OBJ_ID_FREE) break;
+    u32_t home = e->hash % fs->name_index_slots;
+    // the entry can move to the empty slot unless its home is cyclically in (slot, next]
+    u8_t keep = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+    if (!keep) {
+      id_ix = spiffs_name_index_find_id(fs, e->obj_id);
+      if (id_ix >= 0) {
+        fs->name_index_ids[id_ix] = slot;
+      }
+      fs->name_index[slot] = *e;
+      e->obj_id = SPIFFS_OBJ_ID_FREE;
+      slot = next;
+    }
+  }
+}
+
+// returns the slot of given object, or -1
+static s32_t spiffs_name_index_find_obj(
+    spiffs *fs,
+    spiffs_obj_id obj_id) {
+  s32_t id_ix = spiffs_name_index_find_id(fs, obj_id);
+  return id_ix < 0 ? -1 : (s32_t)fs->name_index_ids[id_ix];
+}
+
+// adds an object to the name index, or updates it if it is already there
+static void spiffs_name_index_put(
+    spiffs *fs,
+    u32_t hash,
+    spiffs_obj_id obj_id,
+    spiffs_page_ix pix) {
+  u32_t i;
+  s32_t slot = spiffs_name_index_find_obj(fs, obj_id);
+  if (slot >= 0) {
+    if (fs->name_index[slot].hash == hash) {
+      fs->name_index[slot].pix = pix;
+      return;
+    }
+    // renamed
+    spiffs_name_index_remove_slot(fs, (u32_t)slot);
+  }
+  // keep at least one quarter of the slots free for short probe sequences
+  if ((fs->name_index_count + 1) * 4 > fs->name_index_slots * 3) {
+    fs->name_index_overflow = 1;
+    return;
+  }
+  slot = (s32_t)(hash % fs->name_index_slots);
+  while (fs->name_index[slot].obj_id != SPIFFS_OBJ_ID_FREE) {
+    slot = (s32_t)((slot + 1) % fs->name_index_slots);
+  }
+  fs->name_index[slot].hash = hash;
+  fs->name_index[slot].obj_id = obj_id;
+  fs->name_index[slot].pix = pix;
+  fs->name_index_count++;
+  i = obj_id % fs->name_index_slots;
+  while (fs->name_index_ids[i] != SPIFFS_NAME_INDEX_NO_SLOT) {
+    i = (i + 1) % fs->name_index_slots;
+  }
+  fs->name_index_ids[i] = (u32_t)slot;
+}
+
+static u8_t spiffs_name_index_hdr_valid(
+    const spiffs_page_object_ix_header *objix_hdr) {
+  return objix_hdr->p_hdr.span_ix == 0 &&
+      (objix_hdr->p_hdr.flags & (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_FINAL | SPIFFS_PH_FLAG_IXDELE)) ==
+          (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_IXDELE);
+}
+
+static s32_t spiffs_name_index_build_v(
+    spiffs *fs,
+    spiffs_obj_id obj_id,
+    spiffs_block_ix bix,
+    int ix_entry,
+    const void *user_const_p,
+    void *user_var_p) {
+  (void)user_const_p;
+  (void)user_var_p;
+  s32_t res;
+  spiffs_page_object_ix_header objix_hdr;
+  spiffs_page_ix pix = SPIFFS_OBJ_LOOKUP_ENTRY_TO_PIX(fs, bix, ix_entry);
+  if (obj_id == SPIFFS_OBJ_ID_FREE || obj_id == SPIFFS_OBJ_ID_DELETED ||
+      (obj_id & SPIFFS_OBJ_ID_IX_FLAG) == 0) {
+    return SPIFFS_VIS_COUNTINUE;
+  }
+  res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU2 | SPIFFS_OP_C_READ,
+      0, SPIFFS_PAGE_TO_PADDR(fs, pix), sizeof(spiffs_page_object_ix_header), (u8_t *)&objix_hdr);
+  SPIFFS_CHECK_RES(res);
+  if (spiffs_name_index_hdr_valid(&objix_hdr)) {
+    spiffs_name_index_put(fs, spiffs_hash(fs, objix_hdr.name), obj_id & ~SPIFFS_OBJ_ID_IX_FLAG, pix);
+  }
+  return SPIFFS_VIS_COUNTINUE;
+}
+
+// fills the name index from the object index headers on the medium
+s32_t spiffs_name_index_build(
+    spiffs *fs) {
+  u32_t i;
+  s32_t res;
+  for (i = 0; i < fs->name_index_slots; i++) {
+    fs->name_index[i].obj_id = SPIFFS_OBJ_ID_FREE;
+    fs->name_index_ids[i] = SPIFFS_NAME_INDEX_NO_SLOT;
+  }
+  fs->name_index_count = 0;
+  fs->name_index_overflow = 0;
+  res = spiffs_obj_lu_find_entry_visitor(fs, 0, 0, SPIFFS_VIS_NO_WRAP, 0,
+      spiffs_name_index_build_v, 0, 0, 0, 0);
+  if (res == SPIFFS_VIS_END) res = SPIFFS_OK;
+  return res;
+}
+
+// Finds object index header page by name in the name index. Returns
+// SPIFFS_ERR_NOT_FOUND if the name surely does not exist, or SPIFFS_VIS_END if
+// the medium must be searched (index overflowed, or a stale entry was met).
+s32_t spiffs_name_index_find(
+    spiffs *fs,
+    const u8_t name[SPIFFS_OBJ_NAME_LEN],
+    spiffs_page_ix *pix) {
+  s32_t res;
+  u32_t hash = spiffs_hash(fs, name);
+  u32_t slot = hash % fs->name_index_slots;
+  u8_t search = fs->name_index_overflow;
+  spiffs_page_object_ix_header objix_hdr;
+
+  while (fs->name_index[slot].obj_id != SPIFFS_OBJ_ID_FREE) {
+    spiffs_name_index_entry *e = &fs->name_index[slot];
+    if (e->hash == hash) {
+      res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU2 | SPIFFS_OP_C_READ,
+          0, SPIFFS_PAGE_TO_PADDR(fs, e->pix), sizeof(spiffs_page_object_ix_header), (u8_t *)&objix_hdr);
+      SPIFFS_CHECK_RES(res);
+      if (spiffs_name_index_hdr_valid(&objix_hdr) &&
+          (objix_hdr.p_hdr.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG) == e->obj_id) {
+        if (strcmp((const char*)name, (char*)objix_hdr.name) == 0) {
+          *pix = e->pix;
+          return SPIFFS_OK;
+        }
+      } else {
+        search = 1;
+      }
+    }
+    slot = (slot + 1) % fs->name_index_slots;
+  }
+  return search ? SPIFFS_VIS_END : SPIFFS_ERR_NOT_FOUND;
+}
+
+// keeps the name index up to date on object index header events
+void spiffs_name_index_event(
+    spiffs *fs,
+    int ev,
+    spiffs_obj_id obj_id,
+    const spiffs_page_object_ix_header *objix_hdr,
+    spiffs_page_ix new_pix) {
+  s32_t slot;
+  if (fs->name_index == 0) return;
+  if (ev == SPIFFS_EV_IX_NEW) {
+    if (objix_hdr) {
+      spiffs_name_index_put(fs, spiffs_hash(fs, objix_hdr->name), obj_id, new_pix);
+    }
+    return;
+  }
+  slot = spiffs_name_index_find_obj(fs, obj_id);
+  if (slot < 0) return;
+  if (ev == SPIFFS_EV_IX_DEL) {
+    if (fs->name_index[slot].pix == new_pix) {
+      spiffs_name_index_remove_slot(fs, (u32_t)slot);
+    } else {
+      // another header of the object was deleted, e.g. a stale copy scrapped by
+      // garbage collection; keep the entry but no longer trust a miss
+      fs->name_index_overflow = 1;
+    }
+  } else if (ev == SPIFFS_EV_IX_UPD_HDR && objix_hdr) {
+    spiffs_name_index_put(fs, spiffs_hash(fs, objix_hdr->name), obj_id, new_pix);
+  } else {
+    fs->name_index[slot].pix = new_pix;
+  }
+}
+#endif // SPIFFS_NAME_INDEX
+
 s32_t spiffs_fd_find_new(spiffs *fs, spiffs_fd **fd, const char *name) {
 #if SPIFFS_TEMPORAL_FD_CACHE
   u32_t i;
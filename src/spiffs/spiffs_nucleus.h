@@ -358,24 +358,42 @@
 
 #if SPIFFS_HAL_CALLBACK_EXTRA
 
-#define SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
+#define _SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
   (_fs)->cfg.hal_write_f((_fs), (_paddr), (_len), (_src))
 #define SPIFFS_HAL_READ(_fs, _paddr, _len, _dst) \
   (_fs)->cfg.hal_read_f((_fs), (_paddr), (_len), (_dst))
-#define SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
+#define _SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
   (_fs)->cfg.hal_erase_f((_fs), (_paddr), (_len))
 
 #else // SPIFFS_HAL_CALLBACK_EXTRA
 
-#define SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
+#define _SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
   (_fs)->cfg.hal_write_f((_paddr), (_len), (_src))
 #define SPIFFS_HAL_READ(_fs, _paddr, _len, _dst) \
   (_fs)->cfg.hal_read_f((_paddr), (_len), (_dst))
-#define SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
+#define _SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
   (_fs)->cfg.hal_erase_f((_paddr), (_len))
 
 #endif // SPIFFS_HAL_CALLBACK_EXTRA
 
+#if SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+// writes also update the lookup mirror and the gc heap
+#define SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
+  spiffs_lu_hal_wr((_fs), (_paddr), (_len), (_src))
+#else
+#define SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src) \
+  _SPIFFS_HAL_WRITE(_fs, _paddr, _len, _src)
+#endif // SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+
+#if SPIFFS_LU_MIRROR
+// erases also update the lookup mirror
+#define SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
+  spiffs_lu_mirror_hal_erase((_fs), (_paddr), (_len))
+#else
+#define SPIFFS_HAL_ERASE(_fs, _paddr, _len) \
+  _SPIFFS_HAL_ERASE(_fs, _paddr, _len)
+#endif // SPIFFS_LU_MIRROR
+
 #if SPIFFS_CACHE
 
 #define SPIFFS_CACHE_FLAG_DIRTY       (1<<0)
@@ -397,14 +415,21 @@
 #define spiffs_get_cache_page(fs, c, ix) \
   ((u8_t *)(&((c)->cpages[(ix) * SPIFFS_CACHE_PAGE_SIZE(fs)])) + sizeof(spiffs_cache_page))
 
+// no cache page, ends lru lists and hash chains
+#define SPIFFS_CACHE_IX_NONE          ((u16_t)-1)
+
 // cache page struct
 typedef struct {
   // cache flags
   u8_t flags;
   // cache page index
-  u8_t ix;
-  // last access of this cache page
-  u32_t last_access;
+  u16_t ix;
+  // previous and next cache page in the lru list (read pages) or in the
+  // write page list
+  u16_t prev;
+  u16_t next;
+  // next read cache page in the same hash bucket
+  u16_t hash_next;
   union {
     // type read cache
     struct {
@@ -427,11 +452,21 @@ typedef struct {
 
 // cache struct
 typedef struct {
-  u8_t cpage_count;
-  u32_t last_access;
-  u32_t cpage_use_map;
-  u32_t cpage_use_mask;
+  u16_t cpage_count;
+  u16_t cpage_used;
+  // read cache pages, most recently used first
+  u16_t lru_head;
+  u16_t lru_tail;
+  // write cache pages
+  u16_t wr_head;
+  u16_t wr_tail;
+  // log2 of number of hash buckets
+  u8_t hash_bits;
   u8_t *cpages;
+  // one bit per cache page, set when in use
+  u32_t *cpage_use_map;
+  // first read cache page for each pix hash bucket
+  u16_t *hash;
 } spiffs_cache;
 
 #endif
@@ -534,6 +569,17 @@ typedef s32_t (*spiffs_visitor_f)(spiffs *fs, spiffs_obj_id id, spiffs_block_ix
     spiffs_phys_wr((fs), (addr), (len), (src))
 #endif
 
+// reads given object lookup page of given block into dst
+#if SPIFFS_LU_MIRROR
+#define _spiffs_rd_lu_page(fs, bix, lu_page, dst) \
+    spiffs_obj_lu_rd_page((fs), (bix), (lu_page), (dst))
+#else
+#define _spiffs_rd_lu_page(fs, bix, lu_page, dst) \
+    _spiffs_rd((fs), SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ, 0, \
+        (bix) * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, lu_page), \
+        SPIFFS_CFG_LOG_PAGE_SZ(fs), (dst))
+#endif
+
 #ifndef MIN
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif
@@ -589,6 +635,62 @@ s32_t spiffs_erase_block(
     spiffs *fs,
     spiffs_block_ix bix);
 
+#if SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+s32_t spiffs_lu_hal_wr(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len,
+    u8_t *src);
+#endif // SPIFFS_LU_MIRROR || SPIFFS_GC_HEAP
+
+#if SPIFFS_LU_MIRROR
+s32_t spiffs_lu_mirror_hal_erase(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len);
+
+s32_t spiffs_lu_mirror_build(
+    spiffs *fs);
+
+s32_t spiffs_obj_lu_rd_page(
+    spiffs *fs,
+    spiffs_block_ix bix,
+    int lu_page,
+    u8_t *dst);
+#endif // SPIFFS_LU_MIRROR
+
+#if SPIFFS_NAME_INDEX
+s32_t spiffs_name_index_build(
+    spiffs *fs);
+
+s32_t spiffs_name_index_find(
+    spiffs *fs,
+    const u8_t name[SPIFFS_OBJ_NAME_LEN],
+    spiffs_page_ix *pix);
+
+void spiffs_name_index_event(
+    spiffs *fs,
+    int ev,
+    spiffs_obj_id obj_id,
+    const spiffs_page_object_ix_header *objix_hdr,
+    spiffs_page_ix new_pix);
+#endif // SPIFFS_NAME_INDEX
+
+#if SPIFFS_GC_HEAP
+s32_t spiffs_gc_heap_build(
+    spiffs *fs);
+
+void spiffs_gc_heap_lu_wr(
+    spiffs *fs,
+    u32_t addr,
+    u32_t len,
+    const u8_t *src);
+
+void spiffs_gc_heap_erased(
+    spiffs *fs,
+    spiffs_block_ix bix);
+#endif // SPIFFS_GC_HEAP
+
 #if SPIFFS_USE_MAGIC && SPIFFS_USE_MAGIC_LENGTH
 s32_t spiffs_probe(
     spiffs_config *cfg);
@@ -763,6 +865,10 @@ s32_t spiffs_gc_clean(
 s32_t spiffs_gc_quick(
     spiffs *fs, u16_t max_free_pages);
 
+s32_t spiffs_gc_step(
+    spiffs *fs,
+    u32_t min_free_blocks);
+
 // ---------------
 
 s32_t spiffs_fd_find_new(
@@ -787,6 +893,10 @@ void spiffs_fd_temporal_cache_rehash(
 #endif
 
 #if SPIFFS_CACHE
+u32_t spiffs_cache_bytes(
+    spiffs *fs,
+    u32_t num_pages);
+
 void spiffs_cache_init(
     spiffs *fs);
 
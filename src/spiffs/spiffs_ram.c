@@ -1,8 +1,16 @@
 #include "spiffs.h"
+#include "tkc/time_now.h"
 #include <assert.h>
 
 static u8_t* s_flash;
 static uint32_t s_flash_size;
+/*读取的字节数，用于测量查找的开销。*/
+static uint64_t s_read;
+/*写入和擦除的字节数，用于测量写放大。*/
+static uint64_t s_written;
+static uint64_t s_erased;
+/*每次擦除的延迟(微秒)，用于模拟flash擦除的耗时。*/
+static uint32_t s_erase_delay_us;
 
 static s32_t _read(
 #if SPIFFS_HAL_CALLBACK_EXTRA
@@ -11,6 +19,7 @@ static s32_t _read(
     u32_t addr, u32_t size, u8_t* dst) {
   assert((addr + size) <= s_flash_size);
   memcpy(dst, s_flash + addr, size);
+  s_read += size;
   return 0;
 }
 
@@ -22,6 +31,7 @@ static s32_t _write(
   int i;
   assert((addr + size) <= s_flash_size);
   memcpy(s_flash + addr, src, size);
+  s_written += size;
 
   return 0;
 }
@@ -32,6 +42,12 @@ static s32_t _erase(
     u32_t addr, u32_t size) {
   assert((addr + size) <= s_flash_size);
   memset(s_flash + addr, 0xff, size);
+  s_erased += size;
+  if (s_erase_delay_us > 0) {
+    uint64_t end = time_now_us() + s_erase_delay_us;
+    while (time_now_us() < end) {
+    }
+  }
   return 0;
 }
 
@@ -43,13 +59,18 @@ static void spiffs_check_cb_f(
   return;
 }
 
-static u8_t _fds[64];
-static u8_t _work[512];
+static u8_t _fds[256];
+/*两个逻辑页的大小。*/
+static u8_t _work[2 * 512];
 static u8_t _cache[4096];
-static u32_t _fds_sz = 64;
-static u32_t _cache_sz = 4096;
+static u32_t _fds_sz = 256;
+/*挂载时使用的缓存，缺省为_cache。*/
+static u8_t* s_cache = _cache;
+static u32_t s_cache_sz = sizeof(_cache);
 
-s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size) {
+/*按指定的块大小、擦除大小和页大小(不超过512)挂载。*/
+s32_t fs_mount_ram_cfg(spiffs* fs, void* start_addr, uint32_t size, uint32_t block_size,
+                       uint32_t erase_size, uint32_t page_size) {
   spiffs_config c;
 
   memset(&c, 0x00, sizeof(c));
@@ -61,12 +82,40 @@ s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size) {
   c.hal_write_f = _write;
 
 #if SPIFFS_SINGLETON == 0
-  c.phys_erase_block = 512;
-  c.log_block_size = 1024;
-  c.log_page_size = 256;
+  c.phys_erase_block = erase_size;
+  c.log_block_size = block_size;
+  c.log_page_size = page_size;
   c.phys_size = size;
   c.phys_addr = 0;
 #endif
 
-  return SPIFFS_mount(fs, &c, _work, _fds, _fds_sz, _cache, _cache_sz, spiffs_check_cb_f);
+  return SPIFFS_mount(fs, &c, _work, _fds, _fds_sz, s_cache, s_cache_sz, spiffs_check_cb_f);
+}
+
+s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size) {
+  return fs_mount_ram_cfg(fs, start_addr, size, 1024, 512, 256);
+}
+
+/*按NOR flash常用的64K块挂载，用于模拟大容量的flash。*/
+s32_t fs_mount_ram_large(spiffs* fs, void* start_addr, uint32_t size) {
+  return fs_mount_ram_cfg(fs, start_addr, size, 64 * 1024, 64 * 1024, 256);
+}
+
+uint64_t fs_ram_get_read_bytes(void) {
+  return s_read;
+}
+
+void fs_ram_get_stats(uint64_t* written, uint64_t* erased) {
+  *written = s_written;
+  *erased = s_erased;
+}
+
+void fs_ram_set_erase_delay(uint32_t us) {
+  s_erase_delay_us = us;
+}
+
+/*设置之后挂载时使用的缓存，cache为NULL时恢复缺省的缓存。*/
+void fs_ram_set_cache(void* cache, uint32_t size) {
+  s_cache = cache != NULL ? (u8_t*)cache : _cache;
+  s_cache_sz = cache != NULL ? size : sizeof(_cache);
 }
@@ -0,0 +1,439 @@
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif /*WIN32_LEAN_AND_MEAN*/
+
+#include "tkc/fs.h"
+#include "tkc/mem.h"
+#include "tkc/utils.h"
+#include "tkc/platform.h"
+#include "tkc/time_now.h"
+#include "spiffs/spiffs.h"
+#include "spiffs/spiffs_nucleus.h"
+#include "fs_os_spiffs.h"
+#include "fs_latency.h"
+
+/*
+ * 比较不同大小的flash(64K的块，256字节的页)上有64个和1000个文件时按文件名查找的耗时，
+ * 分别在不加速(none)、使用查找表的内存镜像(lu_mirror，SPIFFS_lu_mirror)、
+ * 使用文件名索引(name_index，SPIFFS_name_index)和两者都使用(both)时，每种操作输出一行JSON：
+ * open: 打开并关闭一个已有的文件。
+ * stat: 获取一个已有的文件的信息。
+ * exist_miss: 判断一个不存在的文件是否存在(需要查找所有的文件)。
+ * flash_bytes_per_op为每次操作从flash读取的字节数，在SPI flash上读取的耗时和它成正比。
+ *
+ * 最大的flash大小(MB)可以用参数指定，缺省为16M。
+ *
+ * 然后在1M的flash上反复重写一组文件(每次擦除延迟BENCH_ERASE_DELAY_US)，比较只在写入时同步回收(sync)
+ * 和每次重写之后用os_fs_spiffs_gc_step在空闲时回收(step)时，每次写入的延迟分布(gc_write)。
+ *
+ * 最后在16M的flash上(512字节的页，4K和64K两种块大小)写满一半之后反复重写文件，比较垃圾回收扫描所有块的查找表
+ * 和用SPIFFS_gc_heap从堆顶选择块时的重写速度和每次回收从flash读取的字节数(gc_rewrite)。
+ *
+ * 最后在4M的flash上写入一组只读的资源文件，缓存从8页增加到2048页时，随机打开并读完一个文件的速度、
+ * 缓存的命中率和每次从flash读取的字节数(cache_read)。
+ */
+
+#define DEFAULT_FLASH_MB 16
+#define BENCH_ROUNDS 200
+
+#define BENCH_ERASE_DELAY_US 20000
+#define BENCH_GC_FILES 16
+#define BENCH_GC_FILE_SIZE (32 * 1024)
+#define BENCH_GC_WRITE_SIZE 4096
+#define BENCH_GC_REWRITES 200
+#define BENCH_GC_IDLE_US (3 * BENCH_ERASE_DELAY_US)
+
+#define BENCH_HEAP_FLASH_MB 16
+/*spiffs的页号是16位的，16M的flash用512字节的页。*/
+#define BENCH_HEAP_PAGE_SIZE 512
+#define BENCH_HEAP_FILE_SIZE (32 * 1024)
+/*spiffs每次写入最多回收SPIFFS_GC_MAX_RUNS个块，4K的块时每次写入不能太多。*/
+#define BENCH_HEAP_WRITE_SIZE 1024
+#define BENCH_HEAP_REWRITES 256
+
+#define BENCH_CACHE_FLASH_MB 4
+#define BENCH_CACHE_FILES 64
+#define BENCH_CACHE_FILE_SIZE 4096
+#define BENCH_CACHE_READ_SIZE 1024
+#define BENCH_CACHE_OPS 2000
+
+s32_t fs_mount_ram_large(spiffs* fs, void* start_addr, uint32_t size);
+s32_t fs_mount_ram_cfg(spiffs* fs, void* start_addr, uint32_t size, uint32_t block_size,
+                       uint32_t erase_size, uint32_t page_size);
+uint64_t fs_ram_get_read_bytes(void);
+void fs_ram_set_erase_delay(uint32_t us);
+void fs_ram_set_cache(void* cache, uint32_t size);
+
+typedef enum _bench_op_t { BENCH_OPEN = 0, BENCH_STAT, BENCH_EXIST_MISS } bench_op_t;
+
+static const char* s_op_names[] = {"open", "stat", "exist_miss"};
+
+typedef enum _bench_accel_t {
+  BENCH_NONE = 0,
+  BENCH_LU_MIRROR = 1,
+  BENCH_NAME_INDEX = 2,
+  BENCH_BOTH = 3
+} bench_accel_t;
+
+static const char* s_accel_names[] = {"none", "lu_mirror", "name_index", "both"};
+
+static const uint32_t s_files[] = {64, 1000};
+
+static const uint32_t s_cache_pages[] = {8, 32, 128, 512, 2048};
+
+static uint32_t s_seed = 1;
+
+static uint32_t bench_rand(void) {
+  s_seed = s_seed * 1103515245 + 12345;
+
+  return (s_seed >> 16) & 0x7fff;
+}
+
+static void bench_op(fs_t* fs, uint32_t flash_mb, uint32_t files, bench_accel_t accel,
+                     uint32_t ram_bytes, bench_op_t op) {
+  uint32_t i = 0;
+  char name[32];
+  fs_stat_info_t st;
+  uint64_t start = 0;
+  uint64_t us = 0;
+  uint64_t read_bytes = fs_ram_get_read_bytes();
+
+  start = time_now_us();
+  for (i = 0; i < BENCH_ROUNDS; i++) {
+    tk_snprintf(name, sizeof(name), "file%u.bin", (i * 7) % files);
+    if (op == BENCH_OPEN) {
+      fs_file_t* fp = fs_open_file(fs, name, "rb");
+      assert(fp != NULL);
+      fs_file_close(fp);
+    } else if (op == BENCH_STAT) {
+      assert(fs_stat(fs, name, &st) == RET_OK);
+    } else {
+      assert(!fs_file_exist(fs, "missing.bin"));
+    }
+  }
+  us = tk_max(time_now_us() - start, 1);
+  read_bytes = fs_ram_get_read_bytes() - read_bytes;
+
+  printf("{\"fs\":\"spiffs\",\"flash_mb\":%u,\"files\":%u,\"accel\":\"%s\",\"ram_bytes\":%u,"
+         "\"test\":\"%s\",\"ops\":%u,\"us_per_op\":%.3f,\"flash_bytes_per_op\":%llu}\n",
+         flash_mb, files, s_accel_names[accel], ram_bytes, s_op_names[op], BENCH_ROUNDS,
+         (double)us / BENCH_ROUNDS, (unsigned long long)(read_bytes / BENCH_ROUNDS));
+  fflush(stdout);
+}
+
+static void bench_ops(spiffs* sfs, uint32_t flash_mb, uint32_t files, bench_accel_t accel) {
+  uint32_t ram_bytes = 0;
+  uint32_t mirror_bytes = SPIFFS_lu_mirror_bytes(sfs);
+  uint32_t index_bytes = SPIFFS_name_index_bytes(sfs, files);
+  void* mirror = TKMEM_ALLOC(mirror_bytes);
+  void* index = TKMEM_ALLOC(index_bytes);
+  fs_t* fs = os_fs_spiffs();
+
+  assert(mirror != NULL && index != NULL);
+  if (accel & BENCH_LU_MIRROR) {
+    assert(SPIFFS_lu_mirror(sfs, mirror, mirror_bytes) == (s32_t)sfs->block_count);
+    ram_bytes += mirror_bytes;
+  }
+  if (accel & BENCH_NAME_INDEX) {
+    assert(SPIFFS_name_index(sfs, index, index_bytes) == (s32_t)files);
+    ram_bytes += index_bytes;
+  }
+
+  bench_op(fs, flash_mb, files, accel, ram_bytes, BENCH_OPEN);
+  bench_op(fs, flash_mb, files, accel, ram_bytes, BENCH_STAT);
+  bench_op(fs, flash_mb, files, accel, ram_bytes, BENCH_EXIST_MISS);
+
+  SPIFFS_lu_mirror(sfs, NULL, 0);
+  SPIFFS_name_index(sfs, NULL, 0);
+  TKMEM_FREE(index);
+  TKMEM_FREE(mirror);
+}
+
+static void bench_flash(uint32_t flash_mb, uint32_t files) {
+  uint32_t i = 0;
+  char name[32];
+  spiffs sfs;
+  fs_file_t* fp = NULL;
+  uint32_t size = flash_mb * 1024 * 1024;
+  uint8_t* flash = (uint8_t*)TKMEM_ALLOC(size);
+  fs_t* fs = os_fs_spiffs();
+
+  assert(flash != NULL);
+  memset(flash, 0xff, size);
+  if (fs_mount_ram_large(&sfs, flash, size) != 0) {
+    assert(SPIFFS_format(&sfs) == 0);
+    assert(fs_mount_ram_large(&sfs, flash, size) == 0);
+  }
+  os_fs_spiffs_set(&sfs);
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "file%u.bin", i);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, name, strlen(name)) == strlen(name));
+    fs_file_close(fp);
+  }
+
+  for (i = BENCH_NONE; i <= BENCH_BOTH; i++) {
+    bench_ops(&sfs, flash_mb, files, (bench_accel_t)i);
+  }
+
+  SPIFFS_unmount(&sfs);
+  TKMEM_FREE(flash);
+}
+
+static void bench_gc_rewrite(fs_t* fs, uint32_t index, fs_latency_t* latency) {
+  uint32_t i = 0;
+  char name[32];
+  uint64_t start = 0;
+  fs_file_t* fp = NULL;
+  static uint8_t s_buff[BENCH_GC_WRITE_SIZE];
+
+  tk_snprintf(name, sizeof(name), "gc%u.bin", index);
+  start = time_now_us();
+  fp = fs_open_file(fs, name, "wb");
+  assert(fp != NULL);
+  fs_latency_add(latency, time_now_us() - start);
+
+  for (i = 0; i < BENCH_GC_FILE_SIZE / BENCH_GC_WRITE_SIZE; i++) {
+    start = time_now_us();
+    assert(fs_file_write(fp, s_buff, sizeof(s_buff)) == sizeof(s_buff));
+    fs_latency_add(latency, time_now_us() - start);
+  }
+  fs_file_close(fp);
+}
+
+static void bench_gc(bool_t step) {
+  uint32_t i = 0;
+  spiffs sfs;
+  uint32_t steps = 0;
+  uint64_t step_us = 0;
+  fs_latency_t latency;
+  uint32_t size = 1024 * 1024;
+  uint8_t* flash = (uint8_t*)TKMEM_ALLOC(size);
+  fs_t* fs = os_fs_spiffs();
+
+  assert(flash != NULL);
+  memset(flash, 0xff, size);
+  if (fs_mount_ram_large(&sfs, flash, size) != 0) {
+    assert(SPIFFS_format(&sfs) == 0);
+    assert(fs_mount_ram_large(&sfs, flash, size) == 0);
+  }
+  os_fs_spiffs_set(&sfs);
+
+  fs_latency_init(&latency);
+  for (i = 0; i < BENCH_GC_FILES; i++) {
+    bench_gc_rewrite(fs, i, &latency);
+  }
+
+  fs_ram_set_erase_delay(BENCH_ERASE_DELAY_US);
+  fs_latency_init(&latency);
+  for (i = 0; i < BENCH_GC_REWRITES; i++) {
+    bench_gc_rewrite(fs, (i * 7) % BENCH_GC_FILES, &latency);
+    if (step) {
+      uint64_t start = time_now_us();
+      ret_t ret = os_fs_spiffs_gc_step(BENCH_GC_IDLE_US);
+      assert(ret == RET_OK || ret == RET_TIMEOUT);
+      step_us += time_now_us() - start;
+      steps++;
+    }
+  }
+  fs_ram_set_erase_delay(0);
+
+  printf("{\"fs\":\"spiffs\",\"test\":\"gc_write\",\"gc\":\"%s\",\"erase_us\":%u,"
+         "\"idle_us\":%u,\"ops\":%llu,\"p50_us\":%llu,\"p99_us\":%llu,\"max_us\":%llu,"
+         "\"gc_steps\":%u,\"gc_step_us\":%llu}\n",
+         step ? "step" : "sync", BENCH_ERASE_DELAY_US, step ? BENCH_GC_IDLE_US : 0,
+         (unsigned long long)latency.count,
+         (unsigned long long)fs_latency_percentile(&latency, 500),
+         (unsigned long long)fs_latency_percentile(&latency, 990),
+         (unsigned long long)latency.max, steps, (unsigned long long)step_us);
+  fflush(stdout);
+
+  SPIFFS_unmount(&sfs);
+  TKMEM_FREE(flash);
+}
+
+static void bench_heap_write(fs_t* fs, uint32_t index) {
+  uint32_t i = 0;
+  char name[32];
+  fs_file_t* fp = NULL;
+  static uint8_t s_buff[BENCH_HEAP_WRITE_SIZE];
+
+  tk_snprintf(name, sizeof(name), "heap%u.bin", index);
+  fp = fs_open_file(fs, name, "wb");
+  assert(fp != NULL);
+  for (i = 0; i < BENCH_HEAP_FILE_SIZE / BENCH_HEAP_WRITE_SIZE; i++) {
+    assert(fs_file_write(fp, s_buff, sizeof(s_buff)) == sizeof(s_buff));
+  }
+  fs_file_close(fp);
+}
+
+static void bench_gc_heap(uint32_t block_size, bool_t heap) {
+  uint32_t i = 0;
+  spiffs sfs;
+  u32_t total = 0;
+  u32_t used = 0;
+  uint32_t files = 0;
+  uint32_t gc_runs = 0;
+  uint32_t heap_bytes = 0;
+  uint64_t us = 0;
+  uint64_t start = 0;
+  uint64_t read_bytes = 0;
+  void* heap_buff = NULL;
+  uint32_t size = BENCH_HEAP_FLASH_MB * 1024 * 1024;
+  uint8_t* flash = (uint8_t*)TKMEM_ALLOC(size);
+  fs_t* fs = os_fs_spiffs();
+
+  assert(flash != NULL);
+  memset(flash, 0xff, size);
+  if (fs_mount_ram_cfg(&sfs, flash, size, block_size, block_size, BENCH_HEAP_PAGE_SIZE) != 0) {
+    assert(SPIFFS_format(&sfs) == 0);
+    assert(fs_mount_ram_cfg(&sfs, flash, size, block_size, block_size, BENCH_HEAP_PAGE_SIZE) == 0);
+  }
+  os_fs_spiffs_set(&sfs);
+
+  if (heap) {
+    heap_bytes = SPIFFS_gc_heap_bytes(&sfs);
+    heap_buff = TKMEM_ALLOC(heap_bytes);
+    assert(heap_buff != NULL);
+    assert(SPIFFS_gc_heap(&sfs, heap_buff, heap_bytes) == (s32_t)sfs.block_count);
+  }
+
+  assert(SPIFFS_info(&sfs, &total, &used) == 0);
+  while (used < total / 2) {
+    bench_heap_write(fs, files++);
+    assert(SPIFFS_info(&sfs, &total, &used) == 0);
+  }
+
+  gc_runs = sfs.stats_gc_runs;
+  read_bytes = fs_ram_get_read_bytes();
+  start = time_now_us();
+  for (i = 0; i < BENCH_HEAP_REWRITES; i++) {
+    bench_heap_write(fs, (i * 7) % files);
+  }
+  us = tk_max(time_now_us() - start, 1);
+  read_bytes = fs_ram_get_read_bytes() - read_bytes;
+  gc_runs = tk_max(sfs.stats_gc_runs - gc_runs, 1);
+
+  printf("{\"fs\":\"spiffs\",\"test\":\"gc_rewrite\",\"flash_mb\":%u,\"blocks\":%u,"
+         "\"gc_heap\":%d,\"heap_bytes\":%u,\"bytes\":%u,\"us\":%llu,\"mb_s\":%.2f,"
+         "\"gc_runs\":%u,\"flash_bytes_per_gc\":%llu}\n",
+         BENCH_HEAP_FLASH_MB, sfs.block_count, heap ? 1 : 0, heap_bytes,
+         BENCH_HEAP_REWRITES * BENCH_HEAP_FILE_SIZE, (unsigned long long)us,
+         (double)BENCH_HEAP_REWRITES * BENCH_HEAP_FILE_SIZE / us, gc_runs,
+         (unsigned long long)(read_bytes / gc_runs));
+  fflush(stdout);
+
+  SPIFFS_unmount(&sfs);
+  TKMEM_FREE(heap_buff);
+  TKMEM_FREE(flash);
+}
+
+static void bench_cache_read_files(spiffs* sfs, uint32_t pages) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  char name[32];
+  uint64_t us = 0;
+  uint64_t start = 0;
+  uint64_t read_bytes = 0;
+  fs_file_t* fp = NULL;
+  fs_t* fs = os_fs_spiffs();
+  static uint8_t s_buff[BENCH_CACHE_READ_SIZE];
+
+  sfs->cache_hits = 0;
+  sfs->cache_misses = 0;
+  read_bytes = fs_ram_get_read_bytes();
+  start = time_now_us();
+  for (i = 0; i < BENCH_CACHE_OPS; i++) {
+    tk_snprintf(name, sizeof(name), "asset%u.bin", bench_rand() % BENCH_CACHE_FILES);
+    fp = fs_open_file(fs, name, "rb");
+    assert(fp != NULL);
+    for (j = 0; j < BENCH_CACHE_FILE_SIZE / BENCH_CACHE_READ_SIZE; j++) {
+      assert(fs_file_read(fp, s_buff, sizeof(s_buff)) == sizeof(s_buff));
+    }
+    fs_file_close(fp);
+  }
+  us = tk_max(time_now_us() - start, 1);
+  read_bytes = fs_ram_get_read_bytes() - read_bytes;
+
+  printf("{\"fs\":\"spiffs\",\"test\":\"cache_read\",\"flash_mb\":%u,\"files\":%u,"
+         "\"cache_pages\":%u,\"ops\":%u,\"us\":%llu,\"mb_s\":%.2f,\"hit_permille\":%u,"
+         "\"flash_bytes_per_op\":%llu}\n",
+         BENCH_CACHE_FLASH_MB, BENCH_CACHE_FILES, pages, BENCH_CACHE_OPS,
+         (unsigned long long)us, (double)BENCH_CACHE_OPS * BENCH_CACHE_FILE_SIZE / us,
+         (uint32_t)((uint64_t)sfs->cache_hits * 1000 /
+                    tk_max(sfs->cache_hits + sfs->cache_misses, 1)),
+         (unsigned long long)(read_bytes / BENCH_CACHE_OPS));
+  fflush(stdout);
+}
+
+static void bench_cache_read(void) {
+  uint32_t i = 0;
+  spiffs sfs;
+  char name[32];
+  fs_file_t* fp = NULL;
+  uint32_t size = BENCH_CACHE_FLASH_MB * 1024 * 1024;
+  uint8_t* flash = (uint8_t*)TKMEM_ALLOC(size);
+  fs_t* fs = os_fs_spiffs();
+  static uint8_t s_buff[BENCH_CACHE_FILE_SIZE];
+
+  assert(flash != NULL);
+  memset(flash, 0xff, size);
+  if (fs_mount_ram_large(&sfs, flash, size) != 0) {
+    assert(SPIFFS_format(&sfs) == 0);
+    assert(fs_mount_ram_large(&sfs, flash, size) == 0);
+  }
+  os_fs_spiffs_set(&sfs);
+
+  for (i = 0; i < BENCH_CACHE_FILES; i++) {
+    tk_snprintf(name, sizeof(name), "asset%u.bin", i);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, s_buff, sizeof(s_buff)) == sizeof(s_buff));
+    fs_file_close(fp);
+  }
+
+  for (i = 0; i < ARRAY_SIZE(s_cache_pages); i++) {
+    uint32_t bytes = spiffs_cache_bytes(&sfs, s_cache_pages[i]);
+    void* cache = TKMEM_ALLOC(bytes);
+
+    assert(cache != NULL);
+    SPIFFS_unmount(&sfs);
+    fs_ram_set_cache(cache, bytes);
+    assert(fs_mount_ram_large(&sfs, flash, size) == 0);
+    assert(spiffs_get_cache(&sfs)->cpage_count == s_cache_pages[i]);
+    bench_cache_read_files(&sfs, s_cache_pages[i]);
+    SPIFFS_unmount(&sfs);
+    fs_ram_set_cache(NULL, 0);
+    TKMEM_FREE(cache);
+  }
+
+  TKMEM_FREE(flash);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t i = 0;
+  uint32_t flash_mb = 1;
+  uint32_t max_mb = argc > 1 ? tk_atoi(argv[1]) : DEFAULT_FLASH_MB;
+
+  platform_prepare();
+
+  for (flash_mb = 1; flash_mb <= max_mb; flash_mb *= 4) {
+    for (i = 0; i < ARRAY_SIZE(s_files); i++) {
+      bench_flash(flash_mb, s_files[i]);
+    }
+  }
+
+  bench_gc(FALSE);
+  bench_gc(TRUE);
+
+  bench_gc_heap(4 * 1024, FALSE);
+  bench_gc_heap(4 * 1024, TRUE);
+  bench_gc_heap(64 * 1024, FALSE);
+  bench_gc_heap(64 * 1024, TRUE);
+
+  bench_cache_read();
+
+  return 0;
+}
@@ -3,11 +3,473 @@
 #endif /*WIN32_LEAN_AND_MEAN*/
 
 #include "tkc/fs.h"
+#include "tkc/utils.h"
 #include "spiffs/spiffs.h"
+#include "spiffs/spiffs_nucleus.h"
+#include "fs_os_spiffs.h"
 
-extern fs_t* os_fs_spiffs(void);
-extern ret_t os_fs_spiffs_set(spiffs* fs);
 s32_t fs_mount_ram(spiffs* fs, void* start_addr, uint32_t size);
+void fs_ram_set_erase_delay(uint32_t us);
+void fs_ram_set_cache(void* cache, uint32_t size);
+extern uint32_t test_fs_borrow(fs_t* fs, const char* filename, const char* mode);
+extern void test_fs_iovec(fs_t* fs, const char* filename);
+extern void test_fs_pread(fs_t* fs, const char* filename);
+extern void test_fs_allocate(fs_t* fs, const char* filename, uint32_t size);
+extern void test_fs_truncate(fs_t* fs, const char* filename, uint32_t size);
+
+/*查找表的镜像和flash中的查找表一致。*/
+static void check_lu_mirror(spiffs* sfs, const uint8_t* mirror, uint32_t blocks,
+                            const uint8_t* flash) {
+  uint32_t i = 0;
+  uint32_t lu_size = SPIFFS_lu_mirror_bytes(sfs) / sfs->block_count;
+
+  for (i = 0; i < blocks; i++) {
+    assert(memcmp(mirror + i * lu_size, flash + i * sfs->cfg.log_block_size, lu_size) == 0);
+  }
+}
+
+static void test_lu_mirror(spiffs* sfs, fs_t* fs, const uint8_t* flash) {
+  uint32_t i = 0;
+  uint32_t blocks = 0;
+  char name[32];
+  static uint16_t mirror[1024];
+  fs_file_t* fp = NULL;
+  fs_stat_info_t st;
+
+  assert(SPIFFS_lu_mirror_bytes(sfs) <= sizeof(mirror));
+  blocks = SPIFFS_lu_mirror(sfs, mirror, SPIFFS_lu_mirror_bytes(sfs) / 2);
+  assert(blocks > 0 && blocks < sfs->block_count);
+  blocks = SPIFFS_lu_mirror(sfs, mirror, sizeof(mirror));
+  assert(blocks == sfs->block_count);
+  check_lu_mirror(sfs, (const uint8_t*)mirror, blocks, flash);
+
+  /*创建、覆盖和删除文件(包括垃圾回收)之后，镜像仍然和flash一致，查找的结果也相同。*/
+  for (i = 0; i < 64; i++) {
+    tk_snprintf(name, sizeof(name), "mirror%u.bin", i % 8);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, flash, strlen(name) + i) == strlen(name) + i);
+    fs_file_close(fp);
+    assert(fs_stat(fs, name, &st) == RET_OK && st.size == strlen(name) + i);
+    if (i % 3 == 0) {
+      assert(fs_remove_file(fs, name) == RET_OK);
+      assert(!fs_file_exist(fs, name));
+    }
+  }
+  check_lu_mirror(sfs, (const uint8_t*)mirror, blocks, flash);
+
+  for (i = 0; i < 8; i++) {
+    tk_snprintf(name, sizeof(name), "mirror%u.bin", i);
+    if (fs_file_exist(fs, name)) {
+      assert(fs_remove_file(fs, name) == RET_OK);
+    }
+  }
+  assert(SPIFFS_lu_mirror(sfs, NULL, 0) == 0);
+}
+
+/*按名字查找的结果和不用索引时相同：创建、改名、删除和垃圾回收之后都能找到正确的文件。*/
+static void test_name_index_files(fs_t* fs, uint32_t files) {
+  uint32_t i = 0;
+  char name[32];
+  char new_name[32];
+  fs_file_t* fp = NULL;
+  fs_stat_info_t st;
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "index%u.bin", i);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, name, i) == i);
+    fs_file_close(fp);
+  }
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "index%u.bin", i);
+    assert(fs_stat(fs, name, &st) == RET_OK && st.size == i);
+    if (i % 2) {
+      tk_snprintf(new_name, sizeof(new_name), "renamed%u.bin", i);
+      assert(fs_file_rename(fs, name, new_name) == RET_OK);
+      assert(!fs_file_exist(fs, name));
+      assert(fs_stat(fs, new_name, &st) == RET_OK && st.size == i);
+    }
+  }
+  assert(!fs_file_exist(fs, "missing.bin"));
+
+  /*反复覆盖写让垃圾回收移动文件头。*/
+  for (i = 0; i < files * 4; i++) {
+    tk_snprintf(name, sizeof(name), "index%u.bin", (i % files) & ~1);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, name, i % 200) == i % 200);
+    fs_file_close(fp);
+  }
+
+  for (i = 0; i < files; i++) {
+    if (i % 2) {
+      tk_snprintf(name, sizeof(name), "renamed%u.bin", i);
+    } else {
+      tk_snprintf(name, sizeof(name), "index%u.bin", i);
+    }
+    assert(fs_file_exist(fs, name));
+    assert(fs_remove_file(fs, name) == RET_OK);
+    assert(!fs_file_exist(fs, name));
+  }
+}
+
+static uint32_t count_dir_entries(fs_t* fs, const char* name) {
+  uint32_t nr = 0;
+  fs_item_t item;
+  fs_dir_t* dir = fs_open_dir(fs, "/");
+
+  assert(dir != NULL);
+  while (fs_dir_read(dir, &item) == RET_OK && item.name[0] != '\0') {
+    if (tk_str_eq(item.name, name) || (item.name[0] == '/' && tk_str_eq(item.name + 1, name))) {
+      nr++;
+    }
+  }
+  fs_dir_close(dir);
+
+  return nr;
+}
+
+/*垃圾回收之后按名字查找仍然正确；回收丢弃文件头的过期副本时，不能删掉活动文件头的索引项，
+ *否则用创建模式打开会再创建一个同名文件。*/
+static void test_name_index_gc(spiffs* sfs, fs_t* fs, uint32_t files) {
+  uint32_t i = 0;
+  char name[32];
+  fs_file_t* fp = NULL;
+  fs_stat_info_t st;
+  spiffs_stat s;
+  spiffs_page_ix pix = 0;
+  u32_t gc_runs = sfs->stats_gc_runs;
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "gc%u.bin", i);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, name, i) == i);
+    fs_file_close(fp);
+  }
+
+  for (i = 0; sfs->stats_gc_runs < gc_runs + 4; i++) {
+    assert(i < 10000);
+    tk_snprintf(name, sizeof(name), "gc%u.bin", i % files);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, name, (i % files) + 100) == (i % files) + 100);
+    fs_file_close(fp);
+  }
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "gc%u.bin", i);
+    assert(fs_stat(fs, name, &st) == RET_OK);
+    assert(count_dir_entries(fs, name) == 1);
+
+    /*模拟回收丢弃了这个文件头的一个过期副本。*/
+    assert(SPIFFS_stat(sfs, name, &s) == SPIFFS_OK);
+    assert(spiffs_object_find_object_index_header_by_name(sfs, (const u8_t*)name, &pix) ==
+           SPIFFS_OK);
+    spiffs_name_index_event(sfs, SPIFFS_EV_IX_DEL, s.obj_id & ~SPIFFS_OBJ_ID_IX_FLAG, NULL,
+                            pix + 1);
+
+    assert(fs_file_exist(fs, name));
+    fp = fs_open_file(fs, name, "ab");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, "x", 1) == 1);
+    fs_file_close(fp);
+    assert(count_dir_entries(fs, name) == 1);
+    assert(!fs_file_exist(fs, "missing.bin"));
+  }
+
+  for (i = 0; i < files; i++) {
+    tk_snprintf(name, sizeof(name), "gc%u.bin", i);
+    assert(fs_remove_file(fs, name) == RET_OK);
+    assert(!fs_file_exist(fs, name));
+    assert(count_dir_entries(fs, name) == 0);
+  }
+}
+
+static void test_name_index(spiffs* sfs, fs_t* fs) {
+  fs_file_t* fp = NULL;
+  static uint8_t index[1024];
+
+  fp = fs_open_file(fs, "existing.bin", "wb");
+  assert(fp != NULL);
+  fs_file_close(fp);
+
+  assert(SPIFFS_name_index_bytes(sfs, 16) <= sizeof(index));
+  assert(SPIFFS_name_index(sfs, index, SPIFFS_name_index_bytes(sfs, 16)) == 1);
+  assert(fs_file_exist(fs, "existing.bin"));
+  test_name_index_files(fs, 16);
+
+  /*索引太小时，没有加入索引的文件仍然能找到。*/
+  assert(SPIFFS_name_index(sfs, index, SPIFFS_name_index_bytes(sfs, 2)) == 1);
+  test_name_index_files(fs, 16);
+  assert(fs_file_exist(fs, "existing.bin"));
+
+  assert(SPIFFS_name_index(sfs, index, SPIFFS_name_index_bytes(sfs, 16)) == 1);
+  test_name_index_gc(sfs, fs, 8);
+
+  assert(SPIFFS_name_index(sfs, NULL, 0) == 0);
+  assert(fs_remove_file(fs, "existing.bin") == RET_OK);
+}
+
+/*反复重写文件，留下已删除的页。*/
+static void test_gc_make_garbage(spiffs* sfs, fs_t* fs) {
+  uint32_t i = 0;
+  fs_file_t* fp = NULL;
+  static uint8_t buff[3 * 1024];
+
+  for (i = 0; i < 8 && sfs->free_blocks >= OS_FS_SPIFFS_GC_FREE_BLOCKS; i++) {
+    fp = fs_open_file(fs, "garbage.bin", "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, buff, sizeof(buff)) == sizeof(buff));
+    fs_file_close(fp);
+  }
+  assert(sfs->free_blocks < OS_FS_SPIFFS_GC_FREE_BLOCKS && sfs->stats_p_deleted > 0);
+}
+
+static void test_gc_step(spiffs* sfs, fs_t* fs) {
+  uint32_t i = 0;
+  uint32_t free_blocks = 0;
+  fs_file_t* fp = NULL;
+  char buff[32];
+
+  fp = fs_open_file(fs, "keep.bin", "wb");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, "hello gc", 8) == 8);
+  fs_file_close(fp);
+
+  fs_ram_set_erase_delay(1000);
+  test_gc_make_garbage(sfs, fs);
+  assert(os_fs_spiffs_gc_step(0xffffffff) == RET_OK);
+  assert(sfs->free_blocks >= OS_FS_SPIFFS_GC_FREE_BLOCKS || sfs->stats_p_deleted == 0);
+  assert(os_fs_spiffs_gc_step(0) == RET_OK);
+
+  /*回收一个块的耗时(有擦除的延迟)超过时间限制时不开始回收。*/
+  test_gc_make_garbage(sfs, fs);
+  free_blocks = sfs->free_blocks;
+  assert(os_fs_spiffs_gc_step(500) == RET_TIMEOUT);
+  assert(sfs->free_blocks == free_blocks);
+  assert(os_fs_spiffs_gc_step(0xffffffff) == RET_OK);
+
+  /*一次很慢的回收之后，时间不够的调用让估计值逐渐回落，之后用较短的时间仍然能回收。*/
+  fs_ram_set_erase_delay(20000);
+  test_gc_make_garbage(sfs, fs);
+  assert(os_fs_spiffs_gc_step(0xffffffff) == RET_OK);
+  fs_ram_set_erase_delay(0);
+  test_gc_make_garbage(sfs, fs);
+  free_blocks = sfs->free_blocks;
+  assert(os_fs_spiffs_gc_step(2000) == RET_TIMEOUT);
+  assert(sfs->free_blocks == free_blocks);
+  for (i = 0; i < 100 && os_fs_spiffs_gc_step(2000) != RET_OK; i++) {
+  }
+  assert(i < 100);
+
+  memset(buff, 0x00, sizeof(buff));
+  fp = fs_open_file(fs, "keep.bin", "rb");
+  assert(fp != NULL);
+  assert(fs_file_read(fp, buff, sizeof(buff)) == 8);
+  assert(strcmp(buff, "hello gc") == 0);
+  fs_file_close(fp);
+  assert(fs_remove_file(fs, "keep.bin") == RET_OK);
+  assert(fs_remove_file(fs, "garbage.bin") == RET_OK);
+}
+
+/*堆顶的块和扫描所有块选出的候选块相同，每个块的统计和从flash重新读取的一致。*/
+static void check_gc_heap(spiffs* sfs) {
+  int count = 0;
+  uint32_t i = 0;
+  spiffs_block_ix* cands = NULL;
+  spiffs_gc_block* blocks = sfs->gc_blocks;
+  spiffs_block_ix top = sfs->gc_heap[0];
+  static spiffs_gc_block s_blocks[64];
+
+  assert(sfs->block_count <= ARRAY_SIZE(s_blocks));
+  memcpy(s_blocks, blocks, sfs->block_count * sizeof(spiffs_gc_block));
+
+  sfs->gc_blocks = NULL;
+  assert(spiffs_gc_find_candidate(sfs, &cands, &count, 0) == SPIFFS_OK);
+  assert(count > 0 && cands[0] == top);
+  sfs->gc_blocks = blocks;
+
+  assert(spiffs_gc_heap_build(sfs) == SPIFFS_OK);
+  assert(sfs->gc_heap[0] == top);
+  for (i = 0; i < sfs->block_count; i++) {
+    assert(blocks[i].used == s_blocks[i].used && blocks[i].deleted == s_blocks[i].deleted);
+    assert(blocks[i].seq - blocks[0].seq == s_blocks[i].seq - s_blocks[0].seq);
+  }
+}
+
+static void test_gc_heap(spiffs* sfs, fs_t* fs) {
+  uint32_t i = 0;
+  char name[32];
+  fs_file_t* fp = NULL;
+  uint32_t gc_runs = sfs->stats_gc_runs;
+  static uint8_t buff[2 * 1024];
+  static uint8_t heap[1024];
+  static uint8_t mirror[1024];
+
+  assert(SPIFFS_gc_heap(sfs, heap, SPIFFS_gc_heap_bytes(sfs) - sizeof(u32_t) - 1) == 0);
+  assert(SPIFFS_gc_heap_bytes(sfs) <= sizeof(heap));
+  assert(SPIFFS_gc_heap(sfs, heap, sizeof(heap)) == sfs->block_count);
+  check_gc_heap(sfs);
+
+  for (i = 0; i < 32; i++) {
+    /*后一半有查找表的镜像，写入前从镜像读取查找表的表项。*/
+    if (i == 16) {
+      assert(SPIFFS_lu_mirror(sfs, mirror, sizeof(mirror)) == sfs->block_count);
+    }
+    tk_snprintf(name, sizeof(name), "heap%u.bin", i % 4);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, buff, sizeof(buff) - i * 16) == sizeof(buff) - i * 16);
+    fs_file_close(fp);
+    check_gc_heap(sfs);
+  }
+  assert(sfs->stats_gc_runs > gc_runs);
+
+  for (i = 0; i < 4; i++) {
+    tk_snprintf(name, sizeof(name), "heap%u.bin", i);
+    assert(fs_remove_file(fs, name) == RET_OK);
+  }
+  check_gc_heap(sfs);
+  assert(SPIFFS_lu_mirror(sfs, NULL, 0) == 0);
+  assert(SPIFFS_gc_heap(sfs, NULL, 0) == 0);
+}
+
+/*LRU链表、写缓存链表、哈希链和使用位图记录的缓存页一致。*/
+static void check_cache(spiffs* sfs) {
+  uint32_t i = 0;
+  uint32_t lru = 0;
+  uint32_t wr = 0;
+  uint32_t hashed = 0;
+  uint32_t used = 0;
+  u16_t prev = SPIFFS_CACHE_IX_NONE;
+  spiffs_cache_page* cp = NULL;
+  spiffs_cache* cache = spiffs_get_cache(sfs);
+
+  for (i = cache->lru_head; i != SPIFFS_CACHE_IX_NONE; i = cp->next) {
+    cp = spiffs_get_cache_page_hdr(sfs, cache, i);
+    assert(cp->prev == prev && (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) == 0);
+    assert(cache->cpage_use_map[i / 32] & (1u << (i % 32)));
+    prev = i;
+    lru++;
+  }
+  assert(cache->lru_tail == prev);
+
+  prev = SPIFFS_CACHE_IX_NONE;
+  for (i = cache->wr_head; i != SPIFFS_CACHE_IX_NONE; i = cp->next) {
+    cp = spiffs_get_cache_page_hdr(sfs, cache, i);
+    assert(cp->prev == prev && (cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) != 0);
+    prev = i;
+    wr++;
+  }
+  assert(cache->wr_tail == prev);
+
+  for (i = 0; i < (1u << cache->hash_bits); i++) {
+    u16_t ix = cache->hash[i];
+    for (; ix != SPIFFS_CACHE_IX_NONE; ix = cp->hash_next) {
+      cp = spiffs_get_cache_page_hdr(sfs, cache, ix);
+      assert((cp->flags & SPIFFS_CACHE_FLAG_TYPE_WR) == 0);
+      hashed++;
+    }
+  }
+
+  for (i = 0; i < cache->cpage_count; i++) {
+    used += (cache->cpage_use_map[i / 32] >> (i % 32)) & 1;
+  }
+  assert(lru == hashed && lru + wr == used && used == cache->cpage_used);
+}
+
+/*超过32页(比flash的页数还多)的缓存：读写的内容正确，不会淘汰缓存页，第二遍读取基本都命中缓存。*/
+static void test_cache(spiffs* sfs, fs_t* fs, uint8_t* flash, uint32_t size) {
+  uint32_t i = 0;
+  uint32_t j = 0;
+  uint32_t hits[2];
+  uint32_t misses[2];
+  char name[32];
+  fs_file_t* fp = NULL;
+  static uint8_t buff[1024];
+  static uint8_t data[1024];
+  static uint32_t cache[96 * 80];
+
+  SPIFFS_unmount(sfs);
+  fs_ram_set_cache(cache, sizeof(cache));
+  assert(fs_mount_ram(sfs, flash, size) == 0);
+  assert(spiffs_get_cache(sfs)->cpage_count > sfs->cfg.phys_size / sfs->cfg.log_page_size);
+  assert(spiffs_cache_bytes(sfs, spiffs_get_cache(sfs)->cpage_count) <= sizeof(cache));
+
+  for (i = 0; i < 8; i++) {
+    memset(data, 'a' + i, sizeof(data));
+    tk_snprintf(name, sizeof(name), "cache%u.bin", i);
+    fp = fs_open_file(fs, name, "wb");
+    assert(fp != NULL);
+    assert(fs_file_write(fp, data, sizeof(data)) == sizeof(data));
+    fs_file_close(fp);
+    check_cache(sfs);
+  }
+
+  for (j = 0; j < 2; j++) {
+    hits[j] = sfs->cache_hits;
+    misses[j] = sfs->cache_misses;
+    for (i = 0; i < 8; i++) {
+      memset(data, 'a' + i, sizeof(data));
+      tk_snprintf(name, sizeof(name), "cache%u.bin", i);
+      fp = fs_open_file(fs, name, "rb");
+      assert(fp != NULL);
+      assert(fs_file_read(fp, buff, sizeof(buff)) == sizeof(buff));
+      assert(memcmp(buff, data, sizeof(data)) == 0);
+      fs_file_close(fp);
+    }
+    hits[j] = sfs->cache_hits - hits[j];
+    misses[j] = sfs->cache_misses - misses[j];
+    check_cache(sfs);
+  }
+  /*第一遍要读取所有的数据页，第二遍只有第一遍没有读过的页(比如按名字查找时读取的页)不在缓存中。*/
+  assert(spiffs_get_cache(sfs)->cpage_used < spiffs_get_cache(sfs)->cpage_count);
+  assert(misses[0] >= 8 * sizeof(data) / sfs->cfg.log_page_size);
+  assert(misses[1] * 4 < misses[0] && hits[1] > hits[0]);
+
+  for (i = 0; i < 8; i++) {
+    tk_snprintf(name, sizeof(name), "cache%u.bin", i);
+    assert(fs_remove_file(fs, name) == RET_OK);
+  }
+  check_cache(sfs);
+
+  SPIFFS_unmount(sfs);
+  fs_ram_set_cache(NULL, 0);
+  assert(fs_mount_ram(sfs, flash, size) == 0);
+  check_cache(sfs);
+}
+
+static void test_stats(fs_t* fs) {
+  int32_t free_kb = 0;
+  int32_t total_kb = 0;
+  fs_file_t* fp = NULL;
+  os_fs_spiffs_stats_t stats;
+
+  assert(fs_get_disk_info(fs, "/", &free_kb, &total_kb) == RET_OK);
+  assert(total_kb > 0 && free_kb <= total_kb);
+
+  assert(os_fs_spiffs_reset_stats() == RET_OK);
+  fp = fs_open_file(fs, "stats.bin", "wb+");
+  assert(fp != NULL);
+  assert(fs_file_write(fp, "hello", 5) == 5);
+  assert(os_fs_spiffs_get_stats(&stats) == RET_OK);
+  assert(stats.fds_used == 1 && stats.fds_total >= stats.fds_used);
+  fs_file_close(fp);
+
+  assert(os_fs_spiffs_get_stats(&stats) == RET_OK);
+  assert(stats.fds_used == 0);
+  assert(stats.total_bytes / 1024 == (uint32_t)total_kb);
+  assert(stats.used_bytes <= stats.total_bytes);
+  assert(stats.page_size > 0 && stats.pages_allocated > 0);
+  assert(stats.blocks_free <= stats.blocks_total);
+  assert(stats.cache_hits + stats.cache_misses > 0);
+  assert(stats.cache_hit_permille <= 1000);
+  assert(fs_remove_file(fs, "stats.bin") == RET_OK);
+}
 
 int main(int argc, char* argv[]) {
   spiffs myfs;
@@ -19,5 +481,18 @@ int main(int argc, char* argv[]) {
   fs_test_file(os_fs_spiffs());
 #endif/*WIN32*/
 
+  /*spiffs没有实现借用，数据总是拷贝到scratch中。*/
+  assert(test_fs_borrow(os_fs_spiffs(), "borrow.bin", "rb") == 0);
+  test_fs_iovec(os_fs_spiffs(), "iovec.bin");
+  test_fs_pread(os_fs_spiffs(), "pread.bin");
+  test_fs_allocate(os_fs_spiffs(), "allocate.bin", 4 * 1024);
+  test_fs_truncate(os_fs_spiffs(), "truncate.bin", 4 * 1024);
+  test_stats(os_fs_spiffs());
+  test_lu_mirror(&myfs, os_fs_spiffs(), flash);
+  test_name_index(&myfs, os_fs_spiffs());
+  test_gc_step(&myfs, os_fs_spiffs());
+  test_gc_heap(&myfs, os_fs_spiffs());
+  test_cache(&myfs, os_fs_spiffs(), flash, sizeof(flash));
+
   return 0;
 }